@@ -96,6 +96,7 @@ enum class AdpfVoteType : int32_t {
     GPU_LOAD_DOWN,
     GPU_LOAD_RESET,
     GPU_CAPACITY,
+    CPU_PREDICTED,
     VOTE_TYPE_SIZE
 };
 
@@ -119,6 +120,8 @@ constexpr const char *AdpfVoteTypeToStr(AdpfVoteType voteType) {
             return "GPU_LOAD_RESET";
         case AdpfVoteType::GPU_CAPACITY:
             return "GPU_CAPACITY";
+        case AdpfVoteType::CPU_PREDICTED:
+            return "CPU_PREDICTED";
         default:
             return "INVALID_VOTE";
     }
@@ -157,6 +160,10 @@ class Immobile {
 constexpr int kUclampMin = 0;
 constexpr int kUclampMax = 1024;
 
+// Handle of a timer armed on a PriorityQueueWorkerPool, 0 is never a valid handle
+using TimerHandle = uint64_t;
+constexpr TimerHandle kInvalidTimerHandle = 0;
+
 // For this FMQ, the first 2 bytes are write bytes, and the last 2 are
 // read bytes. There are 32 bits total per flag, and this is split between read
 // and write, allowing for 16 channels total. The first read bit corresponds to
@@ -22,6 +22,7 @@
 #include <string>
 
 #include "AdpfTypes.h"
+#include "SessionEventRecorder.h"
 
 namespace aidl {
 namespace google {
@@ -35,7 +36,7 @@ namespace pixel {
 // and is separate so that it can be used as a pointer for
 // easily passing to the pid function
 struct AppDescriptorTrace {
-    AppDescriptorTrace(const std::string &idString) {
+    AppDescriptorTrace(const std::string &idString) : events(idString) {
         using ::android::base::StringPrintf;
         trace_pid_err = StringPrintf("adpf.%s-%s", idString.c_str(), "pid.err");
         trace_pid_integral = StringPrintf("adpf.%s-%s", idString.c_str(), "pid.integral");
@@ -121,6 +122,10 @@ struct AppDescriptorTrace {
     std::string trace_gpu_capacity;
     std::string trace_game_mode_fps;
     std::string trace_game_mode_fps_jitters;
+
+    // Always-on binary record of the session, the counters above are only
+    // written while a trace is running
+    SessionEventRecorder events;
 };
 
 }  // namespace pixel
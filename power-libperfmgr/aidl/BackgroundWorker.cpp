@@ -19,6 +19,9 @@
 
 #include "BackgroundWorker.h"
 
+#include <algorithm>
+#include <bit>
+
 namespace aidl {
 namespace google {
 namespace hardware {
@@ -26,8 +29,231 @@ namespace power {
 namespace impl {
 namespace pixel {
 
+TimerWheel::TimerWheel(std::chrono::steady_clock::time_point epoch) : mEpoch(epoch) {
+    mHeads.fill(kNil);
+}
+
+uint64_t TimerWheel::toTick(std::chrono::steady_clock::time_point t) const {
+    if (t <= mEpoch) {
+        return 0;
+    }
+    // Round up so a timer never fires before its deadline
+    const auto sinceEpoch = t - mEpoch;
+    uint64_t tick = sinceEpoch / kTick;
+    if (sinceEpoch % kTick != std::chrono::steady_clock::duration::zero()) {
+        ++tick;
+    }
+    return tick;
+}
+
+std::chrono::steady_clock::time_point TimerWheel::toTime(uint64_t tick) const {
+    return mEpoch + static_cast<int64_t>(tick) * kTick;
+}
+
+uint32_t TimerWheel::find(TimerHandle handle) const {
+    if (handle == kInvalidTimerHandle) {
+        return kNil;
+    }
+    const uint32_t index = static_cast<uint32_t>(handle & UINT32_MAX) - 1;
+    const uint32_t generation = static_cast<uint32_t>(handle >> 32);
+    if (index >= mTimers.size() || mTimers[index].generation != generation ||
+        mTimers[index].list == kNoList) {
+        return kNil;
+    }
+    return index;
+}
+
+void TimerWheel::link(uint32_t index) {
+    Timer &timer = mTimers[index];
+    uint32_t list = kDueList;
+    if (timer.tick > mCurrentTick) {
+        uint64_t delta = timer.tick - mCurrentTick;
+        uint64_t tick = timer.tick;
+        if (delta >= kMaxDelta) {
+            // Park in the furthest slot, it is placed again when that cascades
+            delta = kMaxDelta - 1;
+            tick = mCurrentTick + delta;
+        }
+        uint32_t level = 0;
+        while (delta >= (uint64_t{1} << (kSlotBits * (level + 1)))) {
+            ++level;
+        }
+        const uint32_t slot = (tick >> (kSlotBits * level)) & kSlotMask;
+        list = level * kSlots + slot;
+        mOccupied[level] |= uint64_t{1} << slot;
+    }
+
+    timer.list = list;
+    timer.prev = kNil;
+    timer.next = mHeads[list];
+    if (timer.next != kNil) {
+        mTimers[timer.next].prev = index;
+    }
+    mHeads[list] = index;
+}
+
+void TimerWheel::unlink(uint32_t index) {
+    Timer &timer = mTimers[index];
+    if (timer.prev != kNil) {
+        mTimers[timer.prev].next = timer.next;
+    } else {
+        mHeads[timer.list] = timer.next;
+    }
+    if (timer.next != kNil) {
+        mTimers[timer.next].prev = timer.prev;
+    }
+    if (timer.list < kDueList && mHeads[timer.list] == kNil) {
+        mOccupied[timer.list / kSlots] &= ~(uint64_t{1} << (timer.list & kSlotMask));
+    }
+    timer.list = kNoList;
+}
+
+void TimerWheel::release(uint32_t index) {
+    Timer &timer = mTimers[index];
+    timer.list = kNoList;
+    // Invalidate outstanding handles of this timer
+    ++timer.generation;
+    mFreeTimers.push_back(index);
+    --mSize;
+}
+
+TimerHandle TimerWheel::arm(std::chrono::steady_clock::time_point deadline,
+                            int64_t templateQueueWorkerId, int64_t packageId) {
+    uint32_t index;
+    if (!mFreeTimers.empty()) {
+        index = mFreeTimers.back();
+        mFreeTimers.pop_back();
+    } else {
+        index = mTimers.size();
+        mTimers.emplace_back();
+    }
+    Timer &timer = mTimers[index];
+    timer.deadline = deadline;
+    timer.tick = toTick(deadline);
+    timer.templateQueueWorkerId = templateQueueWorkerId;
+    timer.packageId = packageId;
+    link(index);
+    ++mSize;
+    return (static_cast<uint64_t>(timer.generation) << 32) | (index + 1);
+}
+
+bool TimerWheel::rearm(TimerHandle handle, std::chrono::steady_clock::time_point deadline,
+                       int64_t *packageId) {
+    const uint32_t index = find(handle);
+    if (index == kNil) {
+        return false;
+    }
+    unlink(index);
+    mTimers[index].deadline = deadline;
+    mTimers[index].tick = toTick(deadline);
+    link(index);
+    if (packageId) {
+        *packageId = mTimers[index].packageId;
+    }
+    return true;
+}
+
+bool TimerWheel::cancel(TimerHandle handle, int64_t *packageId) {
+    const uint32_t index = find(handle);
+    if (index == kNil) {
+        return false;
+    }
+    unlink(index);
+    if (packageId) {
+        *packageId = mTimers[index].packageId;
+    }
+    release(index);
+    return true;
+}
+
+void TimerWheel::cascade(uint32_t level) {
+    if (level >= kLevels) {
+        return;
+    }
+    const uint32_t slot = (mCurrentTick >> (kSlotBits * level)) & kSlotMask;
+    if (slot == 0) {
+        // Higher level wrapped too, its timers may land in this slot
+        cascade(level + 1);
+    }
+    const uint32_t list = level * kSlots + slot;
+    uint32_t index = mHeads[list];
+    mHeads[list] = kNil;
+    mOccupied[level] &= ~(uint64_t{1} << slot);
+    while (index != kNil) {
+        const uint32_t next = mTimers[index].next;
+        link(index);
+        index = next;
+    }
+}
+
+void TimerWheel::collect(uint32_t list, std::vector<Expired> *expired) {
+    uint32_t index = mHeads[list];
+    mHeads[list] = kNil;
+    if (list < kDueList) {
+        mOccupied[list / kSlots] &= ~(uint64_t{1} << (list & kSlotMask));
+    }
+    while (index != kNil) {
+        const Timer &timer = mTimers[index];
+        const uint32_t next = timer.next;
+        expired->push_back({timer.deadline, timer.templateQueueWorkerId, timer.packageId});
+        release(index);
+        index = next;
+    }
+}
+
+void TimerWheel::advance(std::chrono::steady_clock::time_point now,
+                         std::vector<Expired> *expired) {
+    const size_t first = expired->size();
+    const uint64_t nowTick = now <= mEpoch ? 0 : (now - mEpoch) / kTick;
+    collect(kDueList, expired);
+    while (mCurrentTick < nowTick) {
+        if (mOccupied[0] == 0) {
+            // Nothing on the lowest level, skip to the tick before the next cascade
+            const uint64_t last = mCurrentTick | kSlotMask;
+            if (last >= nowTick) {
+                mCurrentTick = nowTick;
+                break;
+            }
+            mCurrentTick = last;
+        }
+        ++mCurrentTick;
+        if ((mCurrentTick & kSlotMask) == 0) {
+            cascade(1);
+        }
+        collect(mCurrentTick & kSlotMask, expired);
+    }
+    // Cascading may have found timers that are already due
+    collect(kDueList, expired);
+    std::sort(expired->begin() + first, expired->end(),
+              [](const Expired &a, const Expired &b) { return a.deadline < b.deadline; });
+}
+
+std::chrono::steady_clock::time_point TimerWheel::nextWakeup() const {
+    if (mSize == 0) {
+        return std::chrono::steady_clock::time_point::max();
+    }
+    if (mHeads[kDueList] != kNil) {
+        return toTime(mCurrentTick);
+    }
+    uint64_t next = UINT64_MAX;
+    for (uint32_t level = 0; level < kLevels; ++level) {
+        if (mOccupied[level] == 0) {
+            continue;
+        }
+        const uint32_t shift = kSlotBits * level;
+        const uint64_t current = mCurrentTick >> shift;
+        // Distance in slots to the next occupied slot after the current one
+        const uint64_t rotated =
+                std::rotr(mOccupied[level], static_cast<int>(current & kSlotMask) + 1);
+        const uint64_t distance = std::countr_zero(rotated) + 1;
+        next = std::min(next, (current + distance) << shift);
+    }
+    return toTime(next);
+}
+
 PriorityQueueWorkerPool::PriorityQueueWorkerPool(size_t threadCount,
-                                                 const std::string &threadNamePrefix) {
+                                                 const std::string &threadNamePrefix)
+    : mWheel(std::chrono::steady_clock::now()) {
     mRunning = true;
     mThreadPool.reserve(threadCount);
     for (size_t threadId = 0; threadId < threadCount; ++threadId) {
@@ -76,69 +302,76 @@ void PriorityQueueWorkerPool::removeCallback(int64_t templateQueueWorkerId) {
     mCallbackMap.erase(itr);
 }
 
-void PriorityQueueWorkerPool::schedule(int64_t templateQueueWorkerId, int64_t packageId,
-                                       std::chrono::steady_clock::time_point deadline) {
-    std::unique_lock<std::mutex> lock(mMutex);
-    mPackageQueue.emplace(deadline, templateQueueWorkerId, packageId);
-    mCv.notify_all();
+void PriorityQueueWorkerPool::wakeIfEarlier(std::chrono::steady_clock::time_point deadline) {
+    // Threads that are not waiting recompute their wakeup before waiting again
+    if (deadline < mWakeup) {
+        mWakeup = deadline;
+        mCv.notify_one();
+    }
 }
 
-void PriorityQueueWorkerPool::loop() {
-    Package package;
-    while (mRunning) {
-        std::unique_lock<std::mutex> lock(mMutex);
-        // Default to longest wait possible without overflowing if there is
-        // nothing to work on in the queue
-        std::chrono::steady_clock::time_point deadline =
-                std::chrono::steady_clock::time_point::max();
-
-        // Use next item to work on deadline if available
-        if (!mPackageQueue.empty()) {
-            deadline = mPackageQueue.top().deadline;
-        }
-
-        // Wait until signal or deadline
-        mCv.wait_until(lock, deadline, [&]() {
-            // Check if stop running requested, if so return now
-            if (!mRunning)
-                return true;
+TimerHandle PriorityQueueWorkerPool::schedule(int64_t templateQueueWorkerId, int64_t packageId,
+                                              std::chrono::steady_clock::time_point deadline) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    TimerHandle handle = mWheel.arm(deadline, templateQueueWorkerId, packageId);
+    wakeIfEarlier(deadline);
+    return handle;
+}
 
-            // Check if nothing in queue (e.g. spurious wakeup), wait as long as possible again
-            if (mPackageQueue.empty()) {
-                deadline = std::chrono::steady_clock::time_point::max();
-                return false;
-            }
+bool PriorityQueueWorkerPool::reschedule(TimerHandle handle,
+                                         std::chrono::steady_clock::time_point deadline,
+                                         int64_t *packageId) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mWheel.rearm(handle, deadline, packageId)) {
+        return false;
+    }
+    wakeIfEarlier(deadline);
+    return true;
+}
 
-            // Something in queue, use that as next deadline
-            deadline = mPackageQueue.top().deadline;
-            // Check if deadline is in the future still, continue waiting with updated deadline
-            if (deadline > std::chrono::steady_clock::now())
-                return false;
-            // Next work entry's deadline is in the past or exactly now, time to work on it
-            return true;
-        });
-
-        if (!mRunning)
-            break;
-        if (mPackageQueue.empty())
-            continue;
+bool PriorityQueueWorkerPool::cancel(TimerHandle handle, int64_t *packageId) {
+    // A later wakeup for a cancelled timer finds nothing due and sleeps again
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mWheel.cancel(handle, packageId);
+}
 
-        // Copy work entry from queue and unlock
-        package = mPackageQueue.top();
-        mPackageQueue.pop();
-        lock.unlock();
+void PriorityQueueWorkerPool::loop() {
+    std::vector<TimerWheel::Expired> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (mRunning) {
+                mWheel.advance(std::chrono::steady_clock::now(), &batch);
+                if (!batch.empty()) {
+                    break;
+                }
+                mWakeup = mWheel.nextWakeup();
+                if (mWakeup == std::chrono::steady_clock::time_point::max()) {
+                    mCv.wait(lock);
+                } else {
+                    mCv.wait_until(lock, mWakeup);
+                }
+            }
+            if (!mRunning) {
+                return;
+            }
+        }
 
-        // Find callback based on package's callback id
+        // Find callbacks based on packages' callback id
         {
             std::shared_lock<std::shared_mutex> lockCb(mSharedMutex);
-            auto callbackItr = mCallbackMap.find(package.templateQueueWorkerId);
-            if (callbackItr == mCallbackMap.end()) {
-                // Callback was removed before package could be worked on, that's ok just ignore
-                continue;
+            for (const auto &package : batch) {
+                auto callbackItr = mCallbackMap.find(package.templateQueueWorkerId);
+                if (callbackItr == mCallbackMap.end()) {
+                    // Callback was removed before package could be worked on, that's ok just
+                    // ignore
+                    continue;
+                }
+                // Exceptions disabled so no need to wrap this
+                callbackItr->second(package.packageId);
             }
-            // Exceptions disabled so no need to wrap this
-            callbackItr->second(package.packageId);
         }
+        batch.clear();
     }
 }
 
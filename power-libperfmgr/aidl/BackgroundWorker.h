@@ -16,15 +16,17 @@
 
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <mutex>
-#include <queue>
 #include <shared_mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "AdpfTypes.h"
 
@@ -35,7 +37,82 @@ namespace power {
 namespace impl {
 namespace pixel {
 
-// Background thread processing from priority queue based on time deadline
+// Hierarchical timer wheel with 1ms ticks. Arm, rearm and cancel are O(1), and
+// advancing visits only the slots whose time has come. Timers live in a slab
+// and handles carry a generation, so a handle of a timer that already expired
+// or was cancelled is rejected instead of touching a reused entry.
+// Not thread safe, PriorityQueueWorkerPool guards it with its mutex.
+class TimerWheel {
+  public:
+    static constexpr std::chrono::nanoseconds kTick = std::chrono::milliseconds(1);
+
+    struct Expired {
+        std::chrono::steady_clock::time_point deadline;
+        int64_t templateQueueWorkerId{0};
+        int64_t packageId{0};
+    };
+
+    explicit TimerWheel(std::chrono::steady_clock::time_point epoch);
+
+    TimerHandle arm(std::chrono::steady_clock::time_point deadline,
+                    int64_t templateQueueWorkerId, int64_t packageId);
+    // Move an armed timer, optionally returning its package id. Returns false
+    // if the timer already expired or was cancelled.
+    bool rearm(TimerHandle handle, std::chrono::steady_clock::time_point deadline,
+               int64_t *packageId = nullptr);
+    bool cancel(TimerHandle handle, int64_t *packageId = nullptr);
+    // Append timers due at or before now to expired, earliest deadline first
+    void advance(std::chrono::steady_clock::time_point now, std::vector<Expired> *expired);
+    // Time of the next tick that has work, time_point::max() if none is armed.
+    // Timers further out than the lowest level wake up early to cascade.
+    std::chrono::steady_clock::time_point nextWakeup() const;
+    size_t size() const { return mSize; }
+
+  private:
+    static constexpr uint32_t kSlotBits = 6;
+    static constexpr uint32_t kSlots = 1 << kSlotBits;
+    static constexpr uint32_t kSlotMask = kSlots - 1;
+    static constexpr uint32_t kLevels = 4;
+    // Furthest tick the top level can place, later timers are re-cascaded
+    static constexpr uint64_t kMaxDelta = uint64_t{1} << (kSlotBits * kLevels);
+    // List of timers that are already due
+    static constexpr uint32_t kDueList = kLevels * kSlots;
+    static constexpr uint32_t kNoList = kDueList + 1;
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    struct Timer {
+        std::chrono::steady_clock::time_point deadline;
+        uint64_t tick{0};
+        int64_t templateQueueWorkerId{0};
+        int64_t packageId{0};
+        uint32_t prev{kNil};
+        uint32_t next{kNil};
+        uint32_t list{kNoList};
+        uint32_t generation{0};
+    };
+
+    uint64_t toTick(std::chrono::steady_clock::time_point t) const;
+    std::chrono::steady_clock::time_point toTime(uint64_t tick) const;
+    // Return the slab index of an armed timer or kNil
+    uint32_t find(TimerHandle handle) const;
+    void link(uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    void cascade(uint32_t level);
+    void collect(uint32_t list, std::vector<Expired> *expired);
+
+    const std::chrono::steady_clock::time_point mEpoch;
+    uint64_t mCurrentTick{0};
+    std::vector<Timer> mTimers;
+    std::vector<uint32_t> mFreeTimers;
+    std::array<uint32_t, kDueList + 1> mHeads;
+    // Bitmap of non empty slots per level
+    std::array<uint64_t, kLevels> mOccupied{};
+    size_t mSize{0};
+};
+
+// Background thread processing timers based on time deadline. Everything that
+// expired by the time a thread wakes up is dispatched as one batch.
 // This class isn't meant to be used directly, use TemplatePriorityQueueWorker below
 class PriorityQueueWorkerPool {
   public:
@@ -50,8 +127,14 @@ class PriorityQueueWorkerPool {
     // Unmap callback id with callback function
     void removeCallback(int64_t templateQueueWorkerId);
     // Schedule work for specific worker id with package id to be run at time deadline
-    void schedule(int64_t templateQueueWorkerId, int64_t packageId,
-                  std::chrono::steady_clock::time_point deadline);
+    TimerHandle schedule(int64_t templateQueueWorkerId, int64_t packageId,
+                         std::chrono::steady_clock::time_point deadline);
+    // Move scheduled work to a new deadline. Returns false if it already ran
+    // or was cancelled.
+    bool reschedule(TimerHandle handle, std::chrono::steady_clock::time_point deadline,
+                    int64_t *packageId = nullptr);
+    // Drop scheduled work. Returns false if it already ran or was cancelled.
+    bool cancel(TimerHandle handle, int64_t *packageId = nullptr);
 
   private:
     // Thread coordination
@@ -60,22 +143,12 @@ class PriorityQueueWorkerPool {
     std::condition_variable mCv;
     std::vector<std::thread> mThreadPool;
     void loop();
+    // Wake a waiting thread if deadline is earlier than what it waits for
+    void wakeIfEarlier(std::chrono::steady_clock::time_point deadline);
 
-    // Work package with worker id to find correct callback in
-    struct Package {
-        Package() {}
-        Package(std::chrono::steady_clock::time_point pDeadline, int64_t pTemplateQueueWorkerId,
-                int64_t pPackageId)
-            : deadline(pDeadline),
-              templateQueueWorkerId(pTemplateQueueWorkerId),
-              packageId(pPackageId) {}
-        std::chrono::steady_clock::time_point deadline;
-        int64_t templateQueueWorkerId{0};
-        int64_t packageId{0};
-        // Sort time earliest first
-        bool operator<(const Package &p) const { return deadline > p.deadline; }
-    };
-    std::priority_queue<Package> mPackageQueue;
+    TimerWheel mWheel;
+    // Time the threads currently sleep until
+    std::chrono::steady_clock::time_point mWakeup{std::chrono::steady_clock::time_point::max()};
 
     // Callback management
     std::shared_mutex mSharedMutex;
@@ -103,14 +176,40 @@ class TemplatePriorityQueueWorker {
     // DTOR
     ~TemplatePriorityQueueWorker() { mWorker->removeCallback(mCallbackId); }
 
-    void schedule(const PACKAGE &package,
-                  std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now()) {
+    TimerHandle schedule(
+            const PACKAGE &package,
+            std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now()) {
+        int64_t packageId;
         {
             std::lock_guard<std::mutex> lock(mMutex);
-            ++mPackageIdCounter;
-            mPackages.emplace(mPackageIdCounter, package);
+            packageId = ++mPackageIdCounter;
+            mPackages.emplace(packageId, package);
+        }
+        return mWorker->schedule(mCallbackId, packageId, t);
+    }
+
+    // Replace the package and deadline of scheduled work. Returns false if the
+    // work already ran or was cancelled, schedule() it again in that case.
+    bool reschedule(TimerHandle handle, const PACKAGE &package,
+                    std::chrono::steady_clock::time_point t) {
+        // Held across both updates so the work cannot run with the old package
+        std::lock_guard<std::mutex> lock(mMutex);
+        int64_t packageId = 0;
+        if (!mWorker->reschedule(handle, t, &packageId)) {
+            return false;
+        }
+        mPackages[packageId] = package;
+        return true;
+    }
+
+    bool cancel(TimerHandle handle) {
+        int64_t packageId = 0;
+        if (!mWorker->cancel(handle, &packageId)) {
+            return false;
         }
-        mWorker->schedule(mCallbackId, mPackageIdCounter, t);
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPackages.erase(packageId);
+        return true;
     }
 
   private:
@@ -19,7 +19,10 @@
 
 #include "ChannelGroup.h"
 
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
 #include <gmock/gmock.h>
+#include <inttypes.h>
 #include <processgroup/processgroup.h>
 #include <sys/resource.h>
 #include <utils/SystemClock.h>
@@ -107,6 +110,121 @@ void ChannelGroup<PowerSessionManagerT, PowerHintSessionT>::getFlagDesc(
     *_return_desc = std::make_optional(mFlagQueue->dupeDesc());
 }
 
+template <class PowerSessionManagerT, class PowerHintSessionT>
+bool ChannelGroup<PowerSessionManagerT, PowerHintSessionT>::isCongested() const {
+    return mContention.load(std::memory_order_relaxed) > kCongestedContention;
+}
+
+template <class PowerSessionManagerT, class PowerHintSessionT>
+uint64_t ChannelGroup<PowerSessionManagerT, PowerHintSessionT>::getFalseWakeups() const {
+    return mFalseWakeups.load(std::memory_order_relaxed);
+}
+
+template <class PowerSessionManagerT, class PowerHintSessionT>
+void ChannelGroup<PowerSessionManagerT, PowerHintSessionT>::recordWakeup(size_t drainedChannels) {
+    mWakeups.fetch_add(1, std::memory_order_relaxed);
+    if (drainedChannels == 0) {
+        // Woken for channels that had nothing to read, or were already gone
+        mFalseWakeups.fetch_add(1, std::memory_order_relaxed);
+    } else if (drainedChannels > 1) {
+        // Channels drained after the first waited on the ones before them
+        mContendedWakeups.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Only this group's thread writes the average, so a load and store is enough
+    const uint32_t sample = drainedChannels > 1 ? kContentionScale : 0;
+    const uint32_t contention = mContention.load(std::memory_order_relaxed);
+    mContention.store(contention - contention / kContentionWeight + sample / kContentionWeight,
+                      std::memory_order_relaxed);
+}
+
+template <class PowerSessionManagerT, class PowerHintSessionT>
+void ChannelGroup<PowerSessionManagerT, PowerHintSessionT>::dumpToFd(int fd) const {
+    int32_t liveChannels;
+    {
+        std::scoped_lock lock(mGroupMutex);
+        liveChannels = mLiveChannels;
+    }
+    std::string buf = ::android::base::StringPrintf(
+            "ChannelGroup %" PRId32 " channels: %" PRId32 " wakeups: %" PRIu64
+            " false wakeups: %" PRIu64 " contended wakeups: %" PRIu64 " congested: %s"
+            " wake to dispatched latency: %s\n",
+            mGroupId, liveChannels, mWakeups.load(), mFalseWakeups.load(),
+            mContendedWakeups.load(), isCongested() ? "true" : "false",
+            mDispatchLatency.Dump().c_str());
+    if (!::android::base::WriteStringToFd(buf, fd)) {
+        ALOGE("Failed to dump ChannelGroup %" PRId32, mGroupId);
+    }
+}
+
+template <class PowerSessionManagerT, class PowerHintSessionT>
+void ChannelGroup<PowerSessionManagerT, PowerHintSessionT>::dispatchMessages(
+        ChannelQueue::MemTransaction &tx, size_t count,
+        std::vector<android::hardware::power::WorkDuration> *durations) {
+    // The client can still write to the slots while they are read, so each one
+    // is copied once and only the copy is checked and dispatched
+    ChannelMessage message;
+    size_t messageIndex = 0;
+    bool haveMessage = false;
+    while (!mDestructing) {
+        if (!haveMessage) {
+            if (messageIndex >= count) {
+                break;
+            }
+            message = *tx.getSlot(messageIndex++);
+        }
+        haveMessage = false;
+        auto sessionPtr = std::static_pointer_cast<PowerHintSessionT>(
+                PowerSessionManagerT::getInstance()->getSession(message.sessionID));
+        if (!sessionPtr) {
+            continue;
+        }
+        switch (message.data.getTag()) {
+            case Tag::hint: {
+                sessionPtr->sendHint(message.data.get<Tag::hint>());
+                break;
+            }
+            case Tag::targetDuration: {
+                sessionPtr->updateTargetWorkDuration(message.data.get<Tag::targetDuration>());
+                break;
+            }
+            case Tag::workDuration: {
+                const int32_t sessionID = message.sessionID;
+                durations->clear();
+                // Batch the durations that follow for the same session, the
+                // first message that does not belong is dispatched next
+                do {
+                    const auto &durationData = message.data.get<Tag::workDuration>();
+                    durations->emplace_back(WorkDuration{
+                            .timeStampNanos = message.timeStampNanos,
+                            .durationNanos = durationData.durationNanos,
+                            .cpuDurationNanos = durationData.cpuDurationNanos,
+                            .gpuDurationNanos = durationData.gpuDurationNanos,
+                            .workPeriodStartTimestampNanos =
+                                    durationData.workPeriodStartTimestampNanos});
+                    haveMessage = messageIndex < count;
+                    if (!haveMessage) {
+                        break;
+                    }
+                    message = *tx.getSlot(messageIndex++);
+                } while (!mDestructing && message.data.getTag() == Tag::workDuration &&
+                         message.sessionID == sessionID);
+                sessionPtr->reportActualWorkDuration(*durations);
+                break;
+            }
+            case Tag::mode: {
+                auto mode = message.data.get<Tag::mode>();
+                sessionPtr->setMode(mode.modeInt, mode.enabled);
+                break;
+            }
+            default: {
+                ALOGE("Invalid data tag sent: %s",
+                      std::to_string(static_cast<int>(message.data.getTag())).c_str());
+                break;
+            }
+        }
+    }
+}
+
 template <class PowerSessionManagerT, class PowerHintSessionT>
 void ChannelGroup<PowerSessionManagerT, PowerHintSessionT>::runChannelGroup() {
     EventFlag *flag;
@@ -119,99 +237,63 @@ void ChannelGroup<PowerSessionManagerT, PowerHintSessionT>::runChannelGroup() {
 
     uint32_t flagState = 0;
     static std::set<uid_t> blocklist = {};
-    std::vector<ChannelMessage> messages;
+    // Channels to drain this wake-up, held so a concurrent removeChannel()
+    // cannot free a queue while its slots are being read
+    std::array<std::shared_ptr<SessionChannel>, kMaxChannels> pending;
     std::vector<android::hardware::power::WorkDuration> durations;
     durations.reserve(kFMQQueueSize);
-    messages.reserve(kFMQQueueSize);
 
     while (!mDestructing) {
-        messages.clear();
         flag->wait(kWriteBits, &flagState, 0, true);
-        int64_t now = ::android::uptimeNanos();
+        const int64_t wakeNs = ::android::uptimeNanos();
         if (mDestructing) {
             return;
         }
+        size_t pendingCount = 0;
         {
             std::scoped_lock lock(mGroupMutex);
             // Get the rightmost nonzero bit, corresponding to the next active channel
-            for (int channelNum = std::countr_zero(flagState);
-                 channelNum < kMaxChannels && !mDestructing;
+            for (int channelNum = std::countr_zero(flagState); channelNum < kMaxChannels;
                  channelNum = std::countr_zero(flagState)) {
                 // Drop the lowest set write bit
                 flagState &= (flagState - 1);
-                auto &channel = mChannels[channelNum];
-                if (!channel || !channel->isValid()) {
-                    continue;
-                }
-                if (blocklist.contains(channel->getUid())) {
-                    continue;
-                }
-                int toRead = channel->getQueue()->availableToRead();
-                if (toRead <= 0) {
-                    continue;
-                }
-                messages.resize(toRead);
-                if (!channel->getQueue()->read(messages.data(), toRead)) {
-                    // stop messing with your buffer >:(
-                    blocklist.insert(channel->getUid());
-                    continue;
-                }
-                flag->wake(mChannels[channelNum]->getReadBitmask());
-                for (int messageIndex = 0; messageIndex < messages.size() && !mDestructing;
-                     ++messageIndex) {
-                    ChannelMessage &message = messages[messageIndex];
-                    auto sessionPtr = std::static_pointer_cast<PowerHintSessionT>(
-                            PowerSessionManagerT::getInstance()->getSession(message.sessionID));
-                    if (!sessionPtr) {
-                        continue;
-                    }
-                    switch (message.data.getTag()) {
-                        case Tag::hint: {
-                            sessionPtr->sendHint(message.data.get<Tag::hint>());
-                            break;
-                        }
-                        case Tag::targetDuration: {
-                            sessionPtr->updateTargetWorkDuration(
-                                    message.data.get<Tag::targetDuration>());
-                            break;
-                        }
-                        case Tag::workDuration: {
-                            durations.clear();
-                            for (; !mDestructing && messageIndex < messages.size() &&
-                                   messages[messageIndex].data.getTag() == Tag::workDuration &&
-                                   messages[messageIndex].sessionID == message.sessionID;
-                                 ++messageIndex) {
-                                ChannelMessage &currentMessage = messages[messageIndex];
-                                auto &durationData = currentMessage.data.get<Tag::workDuration>();
-                                durations.emplace_back(WorkDuration{
-                                        .timeStampNanos = currentMessage.timeStampNanos,
-                                        .durationNanos = durationData.durationNanos,
-                                        .cpuDurationNanos = durationData.cpuDurationNanos,
-                                        .gpuDurationNanos = durationData.gpuDurationNanos,
-                                        .workPeriodStartTimestampNanos =
-                                                durationData.workPeriodStartTimestampNanos});
-                            }
-                            if (!durations.empty()) {
-                                sessionPtr->reportActualWorkDuration(durations);
-                                // Decrement the message index so we don't skip the next item
-                                --messageIndex;
-                            }
-                            break;
-                        }
-                        case Tag::mode: {
-                            auto mode = message.data.get<Tag::mode>();
-                            sessionPtr->setMode(mode.modeInt, mode.enabled);
-                            break;
-                        }
-                        default: {
-                            ALOGE("Invalid data tag sent: %s",
-                                  std::to_string(static_cast<int>(message.data.getTag())).c_str());
-                            break;
-                        }
-                    }
+                if (mChannels[channelNum]) {
+                    pending[pendingCount++] = mChannels[channelNum];
                 }
             }
         }
+
+        size_t drainedChannels = 0;
+        for (size_t i = 0; i < pendingCount && !mDestructing; ++i) {
+            auto channel = std::move(pending[i]);
+            if (!channel->isValid() || blocklist.contains(channel->getUid())) {
+                continue;
+            }
+            ChannelQueue *queue = channel->getQueue();
+            const size_t toRead = queue->availableToRead();
+            if (toRead == 0) {
+                continue;
+            }
+            // Read the messages in place, the writer cannot reuse the slots
+            // until the read is committed
+            ChannelQueue::MemTransaction tx;
+            if (!queue->beginRead(toRead, &tx)) {
+                // stop messing with your buffer >:(
+                blocklist.insert(channel->getUid());
+                continue;
+            }
+            dispatchMessages(tx, toRead, &durations);
+            queue->commitRead(toRead);
+            flag->wake(channel->getReadBitmask());
+            ++drainedChannels;
+        }
+        for (size_t i = 0; i < pendingCount; ++i) {
+            pending[i].reset();
+        }
+        recordWakeup(drainedChannels);
+        if (drainedChannels > 0) {
+            mDispatchLatency.Add(std::chrono::nanoseconds(::android::uptimeNanos() - wakeNs));
+        }
     }
 }
 
@@ -19,11 +19,14 @@
 #pragma once
 
 #include <android-base/thread_annotations.h>
+#include <perfmgr/LatencyHistogram.h>
 
 #include <array>
+#include <atomic>
 #include <mutex>
 #include <optional>
 #include <thread>
+#include <vector>
 
 #include "AdpfTypes.h"
 #include "PowerHintSession.h"
@@ -50,9 +53,25 @@ class ChannelGroup : public Immobile {
     std::shared_ptr<SessionChannel> createChannel(int32_t tgid, int32_t uid) EXCLUDES(mGroupMutex);
     std::shared_ptr<SessionChannel> getChannel(int32_t slot) EXCLUDES(mGroupMutex);
     void getFlagDesc(std::optional<FlagQueueDesc> *_return_desc) const;
+    void dumpToFd(int fd) const EXCLUDES(mGroupMutex);
+    // True while most recent wake-ups had several channels to drain, so the
+    // channels queue behind each other on the group thread
+    bool isCongested() const;
+    uint64_t getFalseWakeups() const;
 
   private:
+    // Contention is an average over the last kContentionWeight or so wake-ups,
+    // in fixed point where kContentionScale means every wake-up was contended
+    static constexpr uint32_t kContentionScale = 1024;
+    static constexpr uint32_t kContentionWeight = 16;
+    static constexpr uint32_t kCongestedContention = kContentionScale / 4;
+
+    void recordWakeup(size_t drainedChannels);
     void runChannelGroup() EXCLUDES(mGroupMutex);
+    // Hand the messages of one read transaction to their sessions
+    void dispatchMessages(ChannelQueue::MemTransaction &tx, size_t count,
+                          std::vector<android::hardware::power::WorkDuration> *durations)
+            EXCLUDES(mGroupMutex);
 
     // Guard the number of channels with the global lock, so we only need one
     // lock in order to figure out where to insert new sessions, instead of getting
@@ -63,9 +82,16 @@ class ChannelGroup : public Immobile {
     // Tracks whether the group is currently being destructed, used to kill the helper thread
     bool mDestructing = false;
     // Used to guard items internal to the FMQ thread
-    std::mutex mGroupMutex;
+    mutable std::mutex mGroupMutex;
     std::array<std::shared_ptr<SessionChannel>, kMaxChannels> mChannels GUARDED_BY(mGroupMutex){};
     const std::shared_ptr<FlagQueue> mFlagQueue;
+    // Time from the event flag waking the group thread until every pending
+    // message has been handed to its session, uclamp included
+    ::android::perfmgr::LatencyHistogram mDispatchLatency;
+    std::atomic<uint64_t> mWakeups{0};
+    std::atomic<uint64_t> mFalseWakeups{0};
+    std::atomic<uint64_t> mContendedWakeups{0};
+    std::atomic<uint32_t> mContention{0};
 
     std::thread mGroupThread;
 };
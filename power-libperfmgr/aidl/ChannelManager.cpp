@@ -62,12 +62,16 @@ std::shared_ptr<SessionChannel> ChannelManager<ChannelGroupT>::getOrCreateChanne
         ChannelMapValue value{.value = channelIter->second};
         return mChannelGroups.at(value.groupId).getChannel(value.offset);
     }
-    // If channel does not exist, we need to create it
+    // If channel does not exist, we need to create it. Spread channels over
+    // the least loaded group that is not congested, so busy clients do not
+    // queue behind each other on one group thread.
     int32_t groupId = -1;
+    int32_t groupChannels = kMaxChannels;
     for (auto &&group : mChannelGroups) {
-        if (group.second.getChannelCount() < kMaxChannels) {
+        const int32_t channels = group.second.getChannelCount();
+        if (channels < groupChannels && !group.second.isCongested()) {
             groupId = group.first;
-            break;
+            groupChannels = channels;
         }
     }
     // No group was found, we need to make a new one
@@ -115,6 +119,14 @@ int ChannelManager<ChannelGroupT>::getChannelCount() {
     return out;
 }
 
+template <class ChannelGroupT>
+void ChannelManager<ChannelGroupT>::dumpToFd(int fd) {
+    std::scoped_lock lock{mChannelManagerMutex};
+    for (auto &&group : mChannelGroups) {
+        group.second.dumpToFd(fd);
+    }
+}
+
 template <class ChannelGroupT>
 ChannelManager<ChannelGroupT> *ChannelManager<ChannelGroupT>::getInstance() {
     static ChannelManager instance{};
@@ -33,6 +33,7 @@ class ChannelManager : public Immobile {
     bool getChannelConfig(int32_t tgid, int32_t uid, ChannelConfig *config);
     int getGroupCount();
     int getChannelCount();
+    void dumpToFd(int fd);
     // The instance of this class is actually owned by the PowerSessionManager singleton
     // This is mostly to reduce the number of singletons and make it simpler to mock
     static ChannelManager *getInstance();
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GpuVoteAggregator.h"
+
+#include <algorithm>
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+// Stale entries tolerated beyond twice the live ones before a rebuild
+static constexpr size_t kCompactSlack = 16;
+
+GpuVoteAggregator::GpuVoteAggregator(TimePoint start) : mStart(start) {}
+
+bool GpuVoteAggregator::lessCapacity(const Entry &lhs, const Entry &rhs) {
+    return lhs.capacity < rhs.capacity;
+}
+
+bool GpuVoteAggregator::isLive(const Entry &entry, TimePoint now) const {
+    auto it = mLive.find(entry.sessionId);
+    return it != mLive.end() && it->second == entry.generation && entry.expiry >= now;
+}
+
+std::optional<Cycles> GpuVoteAggregator::update(int64_t sessionId, Cycles capacity,
+                                                TimePoint expiry, TimePoint now,
+                                                Cycles hysteresis) {
+    ++mUpdates;
+    if (capacity > Cycles(0) && expiry >= now) {
+        const uint64_t generation = mNextGeneration++;
+        mLive[sessionId] = generation;
+        mHeap.push_back({capacity, expiry, sessionId, generation});
+        std::push_heap(mHeap.begin(), mHeap.end(), lessCapacity);
+        if (mHeap.size() > 2 * mLive.size() + kCompactSlack) {
+            compact(now);
+        }
+    } else {
+        mLive.erase(sessionId);
+    }
+    return decideWrite(now, hysteresis);
+}
+
+std::optional<Cycles> GpuVoteAggregator::remove(int64_t sessionId, TimePoint now,
+                                                Cycles hysteresis) {
+    if (mLive.erase(sessionId) == 0) {
+        return std::nullopt;
+    }
+    return decideWrite(now, hysteresis);
+}
+
+Cycles GpuVoteAggregator::aggregate(TimePoint now) {
+    while (!mHeap.empty() && !isLive(mHeap.front(), now)) {
+        const Entry &top = mHeap.front();
+        auto it = mLive.find(top.sessionId);
+        if (it != mLive.end() && it->second == top.generation) {
+            // The request in force for the session ran out
+            mLive.erase(it);
+        }
+        std::pop_heap(mHeap.begin(), mHeap.end(), lessCapacity);
+        mHeap.pop_back();
+    }
+    return mHeap.empty() ? Cycles(0) : mHeap.front().capacity;
+}
+
+std::optional<Cycles> GpuVoteAggregator::decideWrite(TimePoint now, Cycles hysteresis) {
+    const Cycles capacity = aggregate(now);
+    if (mWritten && capacity >= *mWritten && capacity <= *mWritten + hysteresis) {
+        return std::nullopt;
+    }
+    mWritten = capacity;
+    ++mWrites;
+    return capacity;
+}
+
+void GpuVoteAggregator::compact(TimePoint now) {
+    std::erase_if(mHeap, [&](const Entry &entry) {
+        if (isLive(entry, now)) {
+            return false;
+        }
+        auto it = mLive.find(entry.sessionId);
+        if (it != mLive.end() && it->second == entry.generation) {
+            mLive.erase(it);
+        }
+        return true;
+    });
+    std::make_heap(mHeap.begin(), mHeap.end(), lessCapacity);
+}
+
+void GpuVoteAggregator::dump(std::ostream &os, TimePoint now) const {
+    const double seconds = std::chrono::duration<double>(now - mStart).count();
+    const auto rate = [seconds](uint64_t count) { return seconds > 0 ? count / seconds : 0.0; };
+    os << "GPU capacity updates: " << mUpdates << " (" << rate(mUpdates) << "/s)"
+       << ", node writes: " << mWrites << " (" << rate(mWrites) << "/s)"
+       << ", aggregate: " << static_cast<int>(mWritten.value_or(Cycles(0)))
+       << ", sessions voting: " << mLive.size() << "\n";
+}
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
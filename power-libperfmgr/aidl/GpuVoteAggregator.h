@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "PhysicalQuantityTypes.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+// Keeps the largest GPU capacity requested across sessions as their votes
+// arrive and expire, and decides when the capacity node needs a write.
+//
+// Every request goes into a max-heap along with its expiry. An entry that
+// has expired, or that a newer request of the same session replaced, is
+// dropped when it reaches the top, so an update costs O(log n) instead of a
+// walk over every session.
+//
+// Not thread safe, callers serialize.
+class GpuVoteAggregator {
+  public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    explicit GpuVoteAggregator(TimePoint start = std::chrono::steady_clock::now());
+
+    // Set the capacity a session requests until expiry, Cycles(0) withdraws
+    // it. Returns the capacity to write if the aggregate dropped, or rose by
+    // more than hysteresis since the last write.
+    std::optional<Cycles> update(int64_t sessionId, Cycles capacity, TimePoint expiry,
+                                 TimePoint now, Cycles hysteresis);
+    std::optional<Cycles> remove(int64_t sessionId, TimePoint now, Cycles hysteresis);
+
+    // The largest request still in force at now
+    Cycles aggregate(TimePoint now);
+
+    uint64_t updates() const { return mUpdates; }
+    uint64_t writes() const { return mWrites; }
+
+    // Prints the update and write rates; before aggregation every update
+    // was a node write
+    void dump(std::ostream &os, TimePoint now) const;
+
+  private:
+    struct Entry {
+        Cycles capacity;
+        TimePoint expiry;
+        int64_t sessionId;
+        uint64_t generation;
+    };
+    static bool lessCapacity(const Entry &lhs, const Entry &rhs);
+
+    std::optional<Cycles> decideWrite(TimePoint now, Cycles hysteresis);
+    bool isLive(const Entry &entry, TimePoint now) const;
+    // Rebuild the heap from live entries once stale ones dominate it
+    void compact(TimePoint now);
+
+    std::vector<Entry> mHeap;
+    // Generation of the entry in force for each session with a request
+    std::unordered_map<int64_t, uint64_t> mLive;
+    uint64_t mNextGeneration{0};
+    std::optional<Cycles> mWritten;
+    uint64_t mUpdates{0};
+    uint64_t mWrites{0};
+    const TimePoint mStart;
+};
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
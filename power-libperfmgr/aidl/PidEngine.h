@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <perfmgr/AdpfConfig.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+// Constants of the PID controller for one ADPF profile and target duration.
+// Errors are fixed point in units of 100us, the same as the integral bounds.
+struct PidParams {
+    static constexpr int64_t kErrorUnitNs = 100000;
+    // Actual durations beyond this multiple of the target are reported as outliers.
+    static constexpr int64_t kOutlierTargetFactor = 20;
+
+    int64_t targetNs = 0;
+    int64_t dt = 0;
+    int64_t outlierNs = 0;
+    int64_t integralHigh = 0;
+    int64_t integralLow = 0;
+    uint64_t samplingWindowP = 0;
+    uint64_t samplingWindowI = 0;
+    uint64_t samplingWindowD = 0;
+    double pidPo = 0;
+    double pidI = 0;
+    double pidDo = 0;
+    double pidDu = 0;
+
+    static PidParams fromConfig(const ::android::perfmgr::AdpfConfig &config, int64_t targetNs) {
+        PidParams params;
+        params.targetNs = targetNs;
+        params.dt = targetNs / kErrorUnitNs;
+        params.outlierNs = targetNs * kOutlierTargetFactor;
+        params.integralHigh = config.getPidIHighDivI();
+        params.integralLow = config.getPidILowDivI();
+        params.samplingWindowP = config.mSamplingWindowP;
+        params.samplingWindowI = config.mSamplingWindowI;
+        params.samplingWindowD = config.mSamplingWindowD;
+        params.pidPo = config.mPidPo;
+        params.pidI = config.mPidI;
+        params.pidDo = config.mPidDo;
+        params.pidDu = config.mPidDu;
+        return params;
+    }
+};
+
+// Terms of one PID update, kept for tracing.
+struct PidOutput {
+    int64_t err = 0;
+    int64_t integral = 0;
+    int64_t derivative = 0;
+    int64_t pOut = 0;
+    int64_t iOut = 0;
+    int64_t dOut = 0;
+    int64_t output = 0;
+    // First actual duration beyond PidParams::outlierNs, or 0.
+    int64_t outlierNs = 0;
+};
+
+// PidEngine turns a batch of actual work durations into a boost output. It
+// does not allocate, log or trace, so it can be driven outside of a session.
+// The batch is consumed in separate passes so that the error sum runs as a
+// plain reduction:
+//  - P: sum of errors over the P window.
+//  - I: running integral clamped per sample; the only sequential pass.
+//  - D: the sum of successive error deltas telescopes to last - first.
+class PidEngine {
+  public:
+    // Recompute the constants only when the profile or the target changed.
+    void configure(const std::shared_ptr<::android::perfmgr::AdpfConfig> &config,
+                   int64_t targetNs) {
+        if (config == mConfig && targetNs == mParams.targetNs) {
+            return;
+        }
+        mConfig = config;
+        mParams = PidParams::fromConfig(*config, targetNs);
+    }
+
+    const PidParams &params() const { return mParams; }
+
+    // samples are WorkDuration like structs with durationNanos, or raw
+    // durations in ns. integral and previous carry the controller state across
+    // batches. pidPu is the gain used for negative errors, which heuristic
+    // boost may raise above the profile's value.
+    template <typename Sample>
+    PidOutput update(const Sample *samples, size_t count, double pidPu, int64_t *integral,
+                     int64_t *previous) const {
+        return update(mParams, samples, count, pidPu, integral, previous);
+    }
+
+    template <typename Sample>
+    static PidOutput update(const PidParams &params, const Sample *samples, size_t count,
+                            double pidPu, int64_t *integral, int64_t *previous) {
+        PidOutput out;
+        if (count == 0 || params.dt == 0) {
+            return out;
+        }
+        const int64_t length = static_cast<int64_t>(count);
+        const int64_t pStart = windowStart(params.samplingWindowP, length);
+        const int64_t iStart = windowStart(params.samplingWindowI, length);
+        const int64_t dStart = windowStart(params.samplingWindowD, length);
+        const int64_t start = std::min({pStart, iStart, dStart});
+        const int64_t targetNs = params.targetNs;
+
+        for (int64_t i = start; i < length; i++) {
+            if (std::abs(durationNs(samples[i])) > params.outlierNs) {
+                out.outlierNs = durationNs(samples[i]);
+                break;
+            }
+        }
+
+        int64_t errSum = 0;
+        for (int64_t i = pStart; i < length; i++) {
+            errSum += (durationNs(samples[i]) - targetNs) / PidParams::kErrorUnitNs;
+        }
+
+        int64_t integralError = *integral;
+        const int64_t dt = params.dt;
+        for (int64_t i = iStart; i < length; i++) {
+            integralError += (durationNs(samples[i]) - targetNs) / PidParams::kErrorUnitNs * dt;
+            integralError = std::max(params.integralLow,
+                                     std::min(params.integralHigh, integralError));
+        }
+
+        const int64_t lastError = (durationNs(samples[length - 1]) - targetNs) /
+                                  PidParams::kErrorUnitNs;
+        const int64_t errorBeforeD =
+                dStart > start ? (durationNs(samples[dStart - 1]) - targetNs) /
+                                         PidParams::kErrorUnitNs
+                               : *previous;
+        const int64_t derivativeSum = lastError - errorBeforeD;
+
+        *integral = integralError;
+        *previous = lastError;
+
+        out.err = errSum / (length - pStart);
+        out.integral = integralError;
+        out.derivative = derivativeSum / dt / (length - dStart);
+        out.pOut = static_cast<int64_t>((errSum > 0 ? params.pidPo : pidPu) * errSum /
+                                        (length - pStart));
+        out.iOut = static_cast<int64_t>(params.pidI * integralError);
+        out.dOut = static_cast<int64_t>((derivativeSum > 0 ? params.pidDo : params.pidDu) *
+                                        derivativeSum / dt / (length - dStart));
+        out.output = out.pOut + out.iOut + out.dOut;
+        return out;
+    }
+
+  private:
+    static int64_t windowStart(uint64_t window, int64_t length) {
+        return window == 0 || window > static_cast<uint64_t>(length)
+                       ? 0
+                       : length - static_cast<int64_t>(window);
+    }
+    static int64_t durationNs(int64_t sample) { return sample; }
+    template <typename Sample>
+    static int64_t durationNs(const Sample &sample) {
+        return sample.durationNanos;
+    }
+
+    std::shared_ptr<::android::perfmgr::AdpfConfig> mConfig;
+    PidParams mParams;
+};
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
@@ -32,6 +32,7 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <string_view>
 
 #include "AdpfTypes.h"
 #include "ChannelManager.h"
@@ -52,12 +53,12 @@ constexpr char kPowerHalStateProp[] = "vendor.powerhal.state";
 constexpr char kPowerHalAudioProp[] = "vendor.powerhal.audio";
 constexpr char kPowerHalRenderingProp[] = "vendor.powerhal.rendering";
 
-Power::Power(std::shared_ptr<DisplayLowPower> dlpw)
+Power::Power(std::shared_ptr<DisplayLowPower> dlpw, std::shared_ptr<DisplayEventLoop> loop)
     : mDisplayLowPower(dlpw),
       mInteractionHandler(nullptr),
       mVRModeOn(false),
       mSustainedPerfModeOn(false) {
-    mInteractionHandler = std::make_unique<InteractionHandler>();
+    mInteractionHandler = std::make_unique<InteractionHandler>(loop);
     mInteractionHandler->Init();
 
     std::string state = ::android::base::GetProperty(kPowerHalStateProp, "");
@@ -244,7 +245,24 @@ constexpr const char *boolToString(bool b) {
     return b ? "true" : "false";
 }
 
-binder_status_t Power::dump(int fd, const char **, uint32_t) {
+binder_status_t Power::dump(int fd, const char **args, uint32_t numArgs) {
+    // "dumpsys <service> --reload-adpf" swaps in the AdpfConfig section of the
+    // current config file without restarting the HAL.
+    if (numArgs == 1 && std::string_view(args[0]) == "--reload-adpf") {
+        bool reloaded = HintManager::GetInstance()->ReloadAdpfProfiles();
+        if (!::android::base::WriteStringToFd(
+                    reloaded ? "ADPF profiles reloaded\n" : "Failed to reload ADPF profiles\n",
+                    fd)) {
+            PLOG(ERROR) << "Failed to dump state to fd";
+        }
+        return reloaded ? STATUS_OK : STATUS_BAD_VALUE;
+    }
+    // "dumpsys <service> --adpf-events" writes the binary event record of
+    // every session instead of the text dump.
+    if (numArgs == 1 && std::string_view(args[0]) == "--adpf-events") {
+        PowerSessionManager<>::getInstance()->dumpEventsToFd(fd);
+        return STATUS_OK;
+    }
     std::string buf(::android::base::StringPrintf(
             "HintManager Running: %s\n"
             "VRMode: %s\n"
@@ -254,6 +272,8 @@ binder_status_t Power::dump(int fd, const char **, uint32_t) {
     // Dump nodes through libperfmgr
     HintManager::GetInstance()->DumpToFd(fd);
     PowerSessionManager<>::getInstance()->dumpToFd(fd);
+    ChannelManager<>::getInstance()->dumpToFd(fd);
+    mInteractionHandler->DumpToFd(fd);
     if (!::android::base::WriteStringToFd(buf, fd)) {
         PLOG(ERROR) << "Failed to dump state to fd";
     }
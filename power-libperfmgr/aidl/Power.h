@@ -35,7 +35,7 @@ namespace pixel {
 
 class Power : public ::aidl::android::hardware::power::BnPower {
   public:
-    Power(std::shared_ptr<DisplayLowPower> dlpw);
+    Power(std::shared_ptr<DisplayLowPower> dlpw, std::shared_ptr<DisplayEventLoop> loop);
     ndk::ScopedAStatus setMode(Mode type, bool enabled) override;
     ndk::ScopedAStatus isModeSupported(Mode type, bool *_aidl_return) override;
     ndk::ScopedAStatus setBoost(Boost type, int32_t durationMs) override;
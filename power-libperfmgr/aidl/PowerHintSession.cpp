@@ -33,9 +33,13 @@
 #include <atomic>
 
 #include "GpuCalculationHelpers.h"
+#include "utils/TgidTypeChecker.h"
+#if defined(ADPF_REPLAY_SIM)
+#include "tools/ReplaySim.h"
+#else
 #include "tests/mocks/MockHintManager.h"
 #include "tests/mocks/MockPowerSessionManager.h"
-#include "utils/TgidTypeChecker.h"
+#endif
 
 namespace aidl {
 namespace google {
@@ -56,10 +60,6 @@ namespace {
 
 static std::atomic<int64_t> sSessionIDCounter{0};
 
-static inline int64_t ns_to_100us(int64_t ns) {
-    return ns / 100000;
-}
-
 static constexpr int32_t kTargetDurationChangeThreshold = 30;  // Percentage change threshold
 static const char kHINTNAME_APP_FIRST_FRAME[] = "PER_ADPF_SESSION_FIRST_FRAME";
 static const char kHINTNAME_SYS_FIRST_FRAME[] = "ALL_ADPF_SESSIONS_FIRST_FRAME";
@@ -70,44 +70,7 @@ template <class HintManagerT, class PowerSessionManagerT>
 int64_t PowerHintSession<HintManagerT, PowerSessionManagerT>::convertWorkDurationToBoostByPid(
         const std::vector<WorkDuration> &actualDurations) {
     std::shared_ptr<AdpfConfig> adpfConfig = getAdpfProfile();
-    const nanoseconds &targetDuration = mDescriptor->targetNs;
-    int64_t &integral_error = mDescriptor->integral_error;
-    int64_t &previous_error = mDescriptor->previous_error;
-    uint64_t samplingWindowP = adpfConfig->mSamplingWindowP;
-    uint64_t samplingWindowI = adpfConfig->mSamplingWindowI;
-    uint64_t samplingWindowD = adpfConfig->mSamplingWindowD;
-    int64_t targetDurationNanos = static_cast<int64_t>(targetDuration.count());
-    int64_t length = actualDurations.size();
-    int64_t p_start =
-            samplingWindowP == 0 || samplingWindowP > length ? 0 : length - samplingWindowP;
-    int64_t i_start =
-            samplingWindowI == 0 || samplingWindowI > length ? 0 : length - samplingWindowI;
-    int64_t d_start =
-            samplingWindowD == 0 || samplingWindowD > length ? 0 : length - samplingWindowD;
-    int64_t dt = ns_to_100us(targetDurationNanos);
-    int64_t err_sum = 0;
-    int64_t derivative_sum = 0;
-    for (int64_t i = std::min({p_start, i_start, d_start}); i < length; i++) {
-        int64_t actualDurationNanos = actualDurations[i].durationNanos;
-        if (std::abs(actualDurationNanos) > targetDurationNanos * 20) {
-            ALOGW("The actual duration is way far from the target (%" PRId64 " >> %" PRId64 ")",
-                  actualDurationNanos, targetDurationNanos);
-        }
-        // PID control algorithm
-        int64_t error = ns_to_100us(actualDurationNanos - targetDurationNanos);
-        if (i >= d_start) {
-            derivative_sum += error - previous_error;
-        }
-        if (i >= p_start) {
-            err_sum += error;
-        }
-        if (i >= i_start) {
-            integral_error += error * dt;
-            integral_error = std::min(adpfConfig->getPidIHighDivI(), integral_error);
-            integral_error = std::max(adpfConfig->getPidILowDivI(), integral_error);
-        }
-        previous_error = error;
-    }
+    mPidEngine.configure(adpfConfig, mDescriptor->targetNs.count());
 
     auto pid_pu_active = adpfConfig->mPidPu;
     if (adpfConfig->mHeuristicBoostOn.has_value() && adpfConfig->mHeuristicBoostOn.value()) {
@@ -124,25 +87,31 @@ int64_t PowerHintSession<HintManagerT, PowerSessionManagerT>::convertWorkDuratio
         } else if (mJankyLevel == SessionJankyLevel::SEVERE) {
             pid_pu_active = hboostPidPu;
         }
-        ATRACE_INT(mAppDescriptorTrace->trace_hboost_pid_pu.c_str(), pid_pu_active * 100);
-    }
-    int64_t pOut = static_cast<int64_t>((err_sum > 0 ? adpfConfig->mPidPo : pid_pu_active) *
-                                        err_sum / (length - p_start));
-    int64_t iOut = static_cast<int64_t>(adpfConfig->mPidI * integral_error);
-    int64_t dOut =
-            static_cast<int64_t>((derivative_sum > 0 ? adpfConfig->mPidDo : adpfConfig->mPidDu) *
-                                 derivative_sum / dt / (length - d_start));
-
-    int64_t output = pOut + iOut + dOut;
-    ATRACE_INT(mAppDescriptorTrace->trace_pid_err.c_str(), err_sum / (length - p_start));
-    ATRACE_INT(mAppDescriptorTrace->trace_pid_integral.c_str(), integral_error);
-    ATRACE_INT(mAppDescriptorTrace->trace_pid_derivative.c_str(),
-               derivative_sum / dt / (length - d_start));
-    ATRACE_INT(mAppDescriptorTrace->trace_pid_pOut.c_str(), pOut);
-    ATRACE_INT(mAppDescriptorTrace->trace_pid_iOut.c_str(), iOut);
-    ATRACE_INT(mAppDescriptorTrace->trace_pid_dOut.c_str(), dOut);
-    ATRACE_INT(mAppDescriptorTrace->trace_pid_output.c_str(), output);
-    return output;
+        if (ATRACE_ENABLED()) {
+            ATRACE_INT(mAppDescriptorTrace->trace_hboost_pid_pu.c_str(), pid_pu_active * 100);
+        }
+    }
+
+    PidOutput pid = mPidEngine.update(actualDurations.data(), actualDurations.size(),
+                                      pid_pu_active, &mDescriptor->integral_error,
+                                      &mDescriptor->previous_error);
+    if (pid.outlierNs != 0) {
+        ALOGW("The actual duration is way far from the target (%" PRId64 " >> %" PRId64 ")",
+              pid.outlierNs, static_cast<int64_t>(mDescriptor->targetNs.count()));
+    }
+
+    mAppDescriptorTrace->events.record(SessionEventType::PID, static_cast<int32_t>(pid.output),
+                                       pid.pOut, pid.iOut, pid.dOut);
+    if (ATRACE_ENABLED()) {
+        ATRACE_INT(mAppDescriptorTrace->trace_pid_err.c_str(), pid.err);
+        ATRACE_INT(mAppDescriptorTrace->trace_pid_integral.c_str(), pid.integral);
+        ATRACE_INT(mAppDescriptorTrace->trace_pid_derivative.c_str(), pid.derivative);
+        ATRACE_INT(mAppDescriptorTrace->trace_pid_pOut.c_str(), pid.pOut);
+        ATRACE_INT(mAppDescriptorTrace->trace_pid_iOut.c_str(), pid.iOut);
+        ATRACE_INT(mAppDescriptorTrace->trace_pid_dOut.c_str(), pid.dOut);
+        ATRACE_INT(mAppDescriptorTrace->trace_pid_output.c_str(), pid.output);
+    }
+    return pid.output;
 }
 
 template <class HintManagerT, class PowerSessionManagerT>
@@ -175,8 +144,10 @@ PowerHintSession<HintManagerT, PowerSessionManagerT>::PowerHintSession(
                                         getAdpfProfile()->mJankCheckTimeFactor.value())
                               : nullptr) {
     ATRACE_CALL();
-    ATRACE_INT(mAppDescriptorTrace->trace_target.c_str(), mDescriptor->targetNs.count());
-    ATRACE_INT(mAppDescriptorTrace->trace_active.c_str(), mDescriptor->is_active.load());
+    if (ATRACE_ENABLED()) {
+        ATRACE_INT(mAppDescriptorTrace->trace_target.c_str(), mDescriptor->targetNs.count());
+        ATRACE_INT(mAppDescriptorTrace->trace_active.c_str(), mDescriptor->is_active.load());
+    }
 
     if (mProcTag != ProcessTag::DEFAULT) {
         HintManager::GetInstance()->RegisterAdpfUpdateEvent(toString(mProcTag), &mOnAdpfUpdate);
@@ -204,9 +175,11 @@ PowerHintSession<HintManagerT, PowerSessionManagerT>::~PowerHintSession() {
     ATRACE_CALL();
     close();
     ALOGV("PowerHintSession deleted: %s", mDescriptor->toString().c_str());
-    ATRACE_INT(mAppDescriptorTrace->trace_target.c_str(), 0);
-    ATRACE_INT(mAppDescriptorTrace->trace_actl_last.c_str(), 0);
-    ATRACE_INT(mAppDescriptorTrace->trace_active.c_str(), 0);
+    if (ATRACE_ENABLED()) {
+        ATRACE_INT(mAppDescriptorTrace->trace_target.c_str(), 0);
+        ATRACE_INT(mAppDescriptorTrace->trace_actl_last.c_str(), 0);
+        ATRACE_INT(mAppDescriptorTrace->trace_active.c_str(), 0);
+    }
 }
 
 template <class HintManagerT, class PowerSessionManagerT>
@@ -227,7 +200,10 @@ void PowerHintSession<HintManagerT, PowerSessionManagerT>::updatePidControlVaria
                                                                 adpfConfig->mStaleTimeFactor),
                                      nanoseconds(adpfConfig->mReportingRateLimitNs) * 2));
     }
-    ATRACE_INT(mAppDescriptorTrace->trace_min.c_str(), pidControlVariable);
+    mAppDescriptorTrace->events.record(SessionEventType::UCLAMP_MIN_VOTE, pidControlVariable);
+    if (ATRACE_ENABLED()) {
+        ATRACE_INT(mAppDescriptorTrace->trace_min.c_str(), pidControlVariable);
+    }
 }
 
 template <class HintManagerT, class PowerSessionManagerT>
@@ -258,6 +234,10 @@ void PowerHintSession<HintManagerT, PowerSessionManagerT>::dumpToStream(std::ost
     stream << ", " << mDescriptor->pidControlVariable;
     stream << ", " << mDescriptor->is_active;
     stream << ", " << isTimeout() << ")";
+    if (getAdpfProfile()->mPredictiveBoostOn.value_or(false)) {
+        stream << " ";
+        mSpikePredictor.dump(stream);
+    }
 }
 
 template <class HintManagerT, class PowerSessionManagerT>
@@ -273,8 +253,10 @@ ndk::ScopedAStatus PowerHintSession<HintManagerT, PowerSessionManagerT>::pause()
     mDescriptor->is_active.store(false);
     mPSManager->pause(mSessionId);
     mPSManager->setThreadsFromPowerSession(mSessionId, {});
-    ATRACE_INT(mAppDescriptorTrace->trace_active.c_str(), false);
-    ATRACE_INT(mAppDescriptorTrace->trace_min.c_str(), 0);
+    if (ATRACE_ENABLED()) {
+        ATRACE_INT(mAppDescriptorTrace->trace_active.c_str(), false);
+        ATRACE_INT(mAppDescriptorTrace->trace_min.c_str(), 0);
+    }
     return ndk::ScopedAStatus::ok();
 }
 
@@ -292,8 +274,10 @@ ndk::ScopedAStatus PowerHintSession<HintManagerT, PowerSessionManagerT>::resume(
     mDescriptor->is_active.store(true);
     // resume boost
     mPSManager->resume(mSessionId);
-    ATRACE_INT(mAppDescriptorTrace->trace_active.c_str(), true);
-    ATRACE_INT(mAppDescriptorTrace->trace_min.c_str(), mDescriptor->pidControlVariable);
+    if (ATRACE_ENABLED()) {
+        ATRACE_INT(mAppDescriptorTrace->trace_active.c_str(), true);
+        ATRACE_INT(mAppDescriptorTrace->trace_min.c_str(), mDescriptor->pidControlVariable);
+    }
     return ndk::ScopedAStatus::ok();
 }
 
@@ -313,7 +297,9 @@ ndk::ScopedAStatus PowerHintSession<HintManagerT, PowerSessionManagerT>::close()
     } else {
         HintManager::GetInstance()->UnregisterAdpfUpdateEvent(toString(mSessTag), &mOnAdpfUpdate);
     }
-    ATRACE_INT(mAppDescriptorTrace->trace_min.c_str(), 0);
+    if (ATRACE_ENABLED()) {
+        ATRACE_INT(mAppDescriptorTrace->trace_min.c_str(), 0);
+    }
     return ndk::ScopedAStatus::ok();
 }
 
@@ -329,24 +315,27 @@ ndk::ScopedAStatus PowerHintSession<HintManagerT, PowerSessionManagerT>::updateT
         ALOGE("Error: targetDurationNanos(%" PRId64 ") should bigger than 0", targetDurationNanos);
         return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_ARGUMENT);
     }
-    targetDurationNanos = targetDurationNanos * getAdpfProfile()->mTargetTimeFactor;
-
-    // Reset session records and heuristic boost states when the percentage change of target
-    // duration is over the threshold.
-    if (targetDurationNanos != mDescriptor->targetNs.count() &&
-        getAdpfProfile()->mHeuristicBoostOn.has_value() &&
-        getAdpfProfile()->mHeuristicBoostOn.value()) {
-        auto lastTargetNs = mDescriptor->targetNs.count();
-        if (abs(targetDurationNanos - lastTargetNs) >
-            lastTargetNs / 100 * kTargetDurationChangeThreshold) {
+    auto adpfConfig = getAdpfProfile();
+    targetDurationNanos = targetDurationNanos * adpfConfig->mTargetTimeFactor;
+
+    // Reset session records, heuristic boost and spike prediction states when the percentage
+    // change of target duration is over the threshold.
+    auto lastTargetNs = mDescriptor->targetNs.count();
+    if (targetDurationNanos != lastTargetNs &&
+        abs(targetDurationNanos - lastTargetNs) >
+                lastTargetNs / 100 * kTargetDurationChangeThreshold) {
+        if (adpfConfig->mHeuristicBoostOn.has_value() && adpfConfig->mHeuristicBoostOn.value()) {
             resetSessionHeuristicStates();
         }
+        mSpikePredictor.reset();
     }
 
     mDescriptor->targetNs = std::chrono::nanoseconds(targetDurationNanos);
     mPSManager->updateTargetWorkDuration(mSessionId, AdpfVoteType::CPU_VOTE_DEFAULT,
                                          mDescriptor->targetNs);
-    ATRACE_INT(mAppDescriptorTrace->trace_target.c_str(), targetDurationNanos);
+    if (ATRACE_ENABLED()) {
+        ATRACE_INT(mAppDescriptorTrace->trace_target.c_str(), targetDurationNanos);
+    }
 
     return ndk::ScopedAStatus::ok();
 }
@@ -356,12 +345,16 @@ void PowerHintSession<HintManagerT, PowerSessionManagerT>::resetSessionHeuristic
     mSessionRecords->resetRecords();
     mJankyLevel = SessionJankyLevel::LIGHT;
     mJankyFrameNum = 0;
-    ATRACE_INT(mAppDescriptorTrace->trace_hboost_janky_level.c_str(),
-               static_cast<int32_t>(mJankyLevel));
-    ATRACE_INT(mAppDescriptorTrace->trace_missed_cycles.c_str(), mJankyFrameNum);
-    ATRACE_INT(mAppDescriptorTrace->trace_avg_duration.c_str(), 0);
-    ATRACE_INT(mAppDescriptorTrace->trace_max_duration.c_str(), 0);
-    ATRACE_INT(mAppDescriptorTrace->trace_low_frame_rate.c_str(), false);
+    mAppDescriptorTrace->events.record(SessionEventType::JANK_LEVEL,
+                                       static_cast<int32_t>(mJankyLevel));
+    if (ATRACE_ENABLED()) {
+        ATRACE_INT(mAppDescriptorTrace->trace_hboost_janky_level.c_str(),
+                   static_cast<int32_t>(mJankyLevel));
+        ATRACE_INT(mAppDescriptorTrace->trace_missed_cycles.c_str(), mJankyFrameNum);
+        ATRACE_INT(mAppDescriptorTrace->trace_avg_duration.c_str(), 0);
+        ATRACE_INT(mAppDescriptorTrace->trace_max_duration.c_str(), 0);
+        ATRACE_INT(mAppDescriptorTrace->trace_low_frame_rate.c_str(), false);
+    }
 }
 
 template <class HintManagerT, class PowerSessionManagerT>
@@ -375,8 +368,9 @@ SessionJankyLevel PowerHintSession<HintManagerT, PowerSessionManagerT>::updateSe
 
     auto adpfConfig = getAdpfProfile();
     if (numOfJankFrames < adpfConfig->mHBoostModerateJankThreshold.value()) {
-        if (oldState == SessionJankyLevel::LIGHT ||
-            durationVariance < adpfConfig->mHBoostOffMaxAvgDurRatio.value()) {
+        const double offRatio = adpfConfig->mHBoostOffP90AvgDurRatio.value_or(
+                adpfConfig->mHBoostOffMaxAvgDurRatio.value());
+        if (oldState == SessionJankyLevel::LIGHT || durationVariance < offRatio) {
             newState = SessionJankyLevel::LIGHT;
         } else {
             newState = SessionJankyLevel::MODERATE;
@@ -401,13 +395,24 @@ void PowerHintSession<HintManagerT, PowerSessionManagerT>::updateHeuristicBoost(
         return;
     }
 
-    auto maxToAvgRatio = maxDurationUs.value() * 1.0 / avgDurationUs.value();
-    auto isLowFPS =
-            mSessionRecords->isLowFrameRate(getAdpfProfile()->mLowFrameRateThreshold.value());
+    // A single long frame dominates the max, the p90 only moves once
+    // slow frames are a pattern
+    auto adpfConfig = getAdpfProfile();
+    auto spreadDurationUs = adpfConfig->mHBoostOffP90AvgDurRatio.has_value()
+                                    ? mSessionRecords->getPercentileDuration(90).value()
+                                    : maxDurationUs.value();
+    auto durationRatio = spreadDurationUs * 1.0 / avgDurationUs.value();
+    auto isLowFPS = mSessionRecords->isLowFrameRate(adpfConfig->mLowFrameRateThreshold.value());
 
-    mJankyLevel = updateSessionJankState(mJankyLevel, numOfJankFrames, maxToAvgRatio, isLowFPS);
+    mJankyLevel = updateSessionJankState(mJankyLevel, numOfJankFrames, durationRatio, isLowFPS);
     mJankyFrameNum = numOfJankFrames;
 
+    mAppDescriptorTrace->events.record(SessionEventType::JANK_LEVEL,
+                                       static_cast<int32_t>(mJankyLevel), mJankyFrameNum,
+                                       avgDurationUs.value(), maxDurationUs.value());
+    if (!ATRACE_ENABLED()) {
+        return;
+    }
     ATRACE_INT(mAppDescriptorTrace->trace_hboost_janky_level.c_str(),
                static_cast<int32_t>(mJankyLevel));
     ATRACE_INT(mAppDescriptorTrace->trace_missed_cycles.c_str(), mJankyFrameNum);
@@ -445,17 +450,22 @@ ndk::ScopedAStatus PowerHintSession<HintManagerT, PowerSessionManagerT>::reportA
     auto adpfConfig = getAdpfProfile();
     mDescriptor->update_count++;
     bool isFirstFrame = isTimeout();
-    ATRACE_INT(mAppDescriptorTrace->trace_batch_size.c_str(), actualDurations.size());
-    ATRACE_INT(mAppDescriptorTrace->trace_actl_last.c_str(), actualDurations.back().durationNanos);
-    ATRACE_INT(mAppDescriptorTrace->trace_target.c_str(), mDescriptor->targetNs.count());
-    ATRACE_INT(mAppDescriptorTrace->trace_hint_count.c_str(), mDescriptor->update_count);
-    ATRACE_INT(mAppDescriptorTrace->trace_hint_overtime.c_str(),
-               actualDurations.back().durationNanos - mDescriptor->targetNs.count() > 0);
-    ATRACE_INT(mAppDescriptorTrace->trace_is_first_frame.c_str(), (isFirstFrame) ? (1) : (0));
-    ATRACE_INT(mAppDescriptorTrace->trace_cpu_duration.c_str(),
-               actualDurations.back().cpuDurationNanos);
-    ATRACE_INT(mAppDescriptorTrace->trace_gpu_duration.c_str(),
-               actualDurations.back().gpuDurationNanos);
+    mAppDescriptorTrace->events.record(
+            SessionEventType::REPORT, static_cast<int32_t>(actualDurations.size()),
+            actualDurations.back().durationNanos, mDescriptor->targetNs.count(),
+            actualDurations.back().gpuDurationNanos);
+    if (ATRACE_ENABLED()) {
+        const WorkDuration &last = actualDurations.back();
+        ATRACE_INT(mAppDescriptorTrace->trace_batch_size.c_str(), actualDurations.size());
+        ATRACE_INT(mAppDescriptorTrace->trace_actl_last.c_str(), last.durationNanos);
+        ATRACE_INT(mAppDescriptorTrace->trace_target.c_str(), mDescriptor->targetNs.count());
+        ATRACE_INT(mAppDescriptorTrace->trace_hint_count.c_str(), mDescriptor->update_count);
+        ATRACE_INT(mAppDescriptorTrace->trace_hint_overtime.c_str(),
+                   last.durationNanos - mDescriptor->targetNs.count() > 0);
+        ATRACE_INT(mAppDescriptorTrace->trace_is_first_frame.c_str(), (isFirstFrame) ? (1) : (0));
+        ATRACE_INT(mAppDescriptorTrace->trace_cpu_duration.c_str(), last.cpuDurationNanos);
+        ATRACE_INT(mAppDescriptorTrace->trace_gpu_duration.c_str(), last.gpuDurationNanos);
+    }
 
     mLastUpdatedTime = std::chrono::steady_clock::now();
 
@@ -519,8 +529,10 @@ ndk::ScopedAStatus PowerHintSession<HintManagerT, PowerSessionManagerT>::reportA
             uclampMinFloor = hboostMaxUclampMinFloor;
             uclampMinCeiling = hboostMaxUclampMinCeiling;
         }
-        ATRACE_INT(mAppDescriptorTrace->trace_uclamp_min_ceiling.c_str(), uclampMinCeiling);
-        ATRACE_INT(mAppDescriptorTrace->trace_uclamp_min_floor.c_str(), uclampMinFloor);
+        if (ATRACE_ENABLED()) {
+            ATRACE_INT(mAppDescriptorTrace->trace_uclamp_min_ceiling.c_str(), uclampMinCeiling);
+            ATRACE_INT(mAppDescriptorTrace->trace_uclamp_min_floor.c_str(), uclampMinFloor);
+        }
     }
 
     int next_min = std::min(static_cast<int>(uclampMinCeiling),
@@ -529,8 +541,23 @@ ndk::ScopedAStatus PowerHintSession<HintManagerT, PowerSessionManagerT>::reportA
 
     updatePidControlVariable(next_min);
 
+    // Boost ahead of a heavy frame predicted from the period of the earlier ones, on top of
+    // the PID output. The vote is dropped by disableBoosts() on the next report.
+    bool spikePredicted = false;
+    if (adpfConfig->mPredictiveBoostOn.value_or(false)) {
+        spikePredicted = mSpikePredictor.update(
+                actualDurations.data(), actualDurations.size(),
+                static_cast<int64_t>(mDescriptor->targetNs.count() *
+                                     adpfConfig->mPredictiveBoostHeavyFactor.value()));
+        if (spikePredicted) {
+            mPSManager->voteSet(mSessionId, AdpfVoteType::CPU_PREDICTED,
+                                adpfConfig->mPredictiveBoostUclampMin.value(), kUclampMax,
+                                std::chrono::steady_clock::now(), mDescriptor->targetNs * 2);
+        }
+    }
+
     if (!adpfConfig->mGpuBoostOn.value_or(false) || !adpfConfig->mGpuBoostCapacityMax ||
-        !actualDurations.back().gpuDurationNanos) {
+        (!actualDurations.back().gpuDurationNanos && !spikePredicted)) {
         return ndk::ScopedAStatus::ok();
     }
 
@@ -538,13 +565,26 @@ ndk::ScopedAStatus PowerHintSession<HintManagerT, PowerSessionManagerT>::reportA
     if (!gpu_freq) {
         return ndk::ScopedAStatus::ok();
     }
-    auto const additional_gpu_capacity =
+    auto additional_gpu_capacity =
             calculate_capacity(actualDurations.back(), mDescriptor->targetNs, *gpu_freq);
-    ATRACE_INT(mAppDescriptorTrace->trace_gpu_capacity.c_str(),
-               static_cast<int>(additional_gpu_capacity));
+    if (spikePredicted) {
+        WorkDuration heavyFrame;
+        heavyFrame.durationNanos = mSpikePredictor.heavyDurationNs();
+        heavyFrame.cpuDurationNanos = mSpikePredictor.heavyCpuDurationNs();
+        heavyFrame.gpuDurationNanos = mSpikePredictor.heavyGpuDurationNs();
+        additional_gpu_capacity = std::max(
+                additional_gpu_capacity,
+                calculate_capacity(heavyFrame, mDescriptor->targetNs, *gpu_freq));
+    }
+    if (ATRACE_ENABLED()) {
+        ATRACE_INT(mAppDescriptorTrace->trace_gpu_capacity.c_str(),
+                   static_cast<int>(additional_gpu_capacity));
+    }
 
     auto const additional_gpu_capacity_clamped = std::clamp(
             additional_gpu_capacity, Cycles(0), Cycles(*adpfConfig->mGpuBoostCapacityMax));
+    mAppDescriptorTrace->events.record(SessionEventType::GPU_CAPACITY,
+                                       static_cast<int>(additional_gpu_capacity_clamped));
 
     mPSManager->voteSet(
             mSessionId, AdpfVoteType::GPU_CAPACITY, additional_gpu_capacity_clamped,
@@ -671,7 +711,9 @@ ndk::ScopedAStatus PowerHintSession<HintManagerT, PowerSessionManagerT>::setMode
     }
 
     mModes[static_cast<size_t>(mode)] = enabled;
-    ATRACE_INT(mAppDescriptorTrace->trace_modes[static_cast<size_t>(mode)].c_str(), enabled);
+    if (ATRACE_ENABLED()) {
+        ATRACE_INT(mAppDescriptorTrace->trace_modes[static_cast<size_t>(mode)].c_str(), enabled);
+    }
     mLastUpdatedTime = std::chrono::steady_clock::now();
     return ndk::ScopedAStatus::ok();
 }
@@ -710,20 +752,23 @@ SessionTag PowerHintSession<HintManagerT, PowerSessionManagerT>::getSessionTag()
 template <class HintManagerT, class PowerSessionManagerT>
 const std::shared_ptr<AdpfConfig>
 PowerHintSession<HintManagerT, PowerSessionManagerT>::getAdpfProfile() const {
-    if (!mAdpfProfile) {
+    auto profile = mAdpfProfile.Load();
+    if (!profile) {
         return mProcTag == ProcessTag::DEFAULT
                        ? HintManager::GetInstance()->GetAdpfProfile(toString(mSessTag))
                        : HintManager::GetInstance()->GetAdpfProfile(toString(mProcTag));
     }
-    return mAdpfProfile;
+    return profile;
 }
 
 template <class HintManagerT, class PowerSessionManagerT>
 void PowerHintSession<HintManagerT, PowerSessionManagerT>::setAdpfProfile(
         const std::shared_ptr<AdpfConfig> profile) {
-    // Must prevent profile from being changed in a binder call duration.
-    std::scoped_lock lock{mPowerHintSessionLock};
-    mAdpfProfile = profile;
+    // Not taking mPowerHintSessionLock: HintManager calls this with its ADPF
+    // lock held, and close() unregisters under mPowerHintSessionLock. A new
+    // profile may land between two getAdpfProfile() calls of one binder call,
+    // so read related fields from a single snapshot.
+    mAdpfProfile.Store(profile);
 }
 
 std::string AppHintDesc::toString() const {
@@ -745,12 +790,17 @@ bool PowerHintSession<HintManagerT, PowerSessionManagerT>::isTimeout() {
     return now >= staleTime;
 }
 
+#if defined(ADPF_REPLAY_SIM)
+// adpf_replay_sim runs the session logic alone, without the rest of the HAL
+template class PowerHintSession<SimHintManager, SimPowerSessionManager>;
+#else
 template class PowerHintSession<>;
 template class PowerHintSession<testing::NiceMock<mock::pixel::MockHintManager>,
                                 testing::NiceMock<mock::pixel::MockPowerSessionManager>>;
 template class PowerHintSession<
         testing::NiceMock<mock::pixel::MockHintManager>,
         PowerSessionManager<testing::NiceMock<mock::pixel::MockHintManager>>>;
+#endif
 }  // namespace pixel
 }  // namespace impl
 }  // namespace power
@@ -18,6 +18,7 @@
 
 #include <aidl/android/hardware/power/BnPowerHintSession.h>
 #include <perfmgr/HintManager.h>
+#include <perfmgr/RcuPtr.h>
 #include <utils/Looper.h>
 #include <utils/Thread.h>
 
@@ -26,8 +27,10 @@
 
 #include "AdpfTypes.h"
 #include "AppDescriptorTrace.h"
+#include "PidEngine.h"
 #include "PowerSessionManager.h"
 #include "SessionRecords.h"
+#include "SpikePredictor.h"
 
 namespace aidl {
 namespace google {
@@ -113,13 +116,17 @@ class PowerHintSession : public BnPowerHintSession, public Immobile {
     std::unordered_map<std::string, std::optional<bool>> mutable mSupportedHints;
     // Use the value of the last enum in enum_range +1 as array size
     std::array<bool, enum_size<SessionMode>()> mModes GUARDED_BY(mPowerHintSessionLock){};
-    std::shared_ptr<AdpfConfig> mAdpfProfile;
+    // Read on every report without mPowerHintSessionLock; written only by
+    // mOnAdpfUpdate, which HintManager serializes.
+    ::android::perfmgr::RcuPtr<AdpfConfig> mAdpfProfile;
     const bool mEnableMetricCollection;
     std::function<void(const std::shared_ptr<AdpfConfig>)> mOnAdpfUpdate;
     std::unique_ptr<SessionRecords> mSessionRecords GUARDED_BY(mPowerHintSessionLock) = nullptr;
+    SpikePredictor mSpikePredictor GUARDED_BY(mPowerHintSessionLock);
     bool mHeuristicBoostActive GUARDED_BY(mPowerHintSessionLock){false};
     SessionJankyLevel mJankyLevel GUARDED_BY(mPowerHintSessionLock){SessionJankyLevel::LIGHT};
     uint32_t mJankyFrameNum GUARDED_BY(mPowerHintSessionLock){0};
+    PidEngine mPidEngine GUARDED_BY(mPowerHintSessionLock);
 };
 
 }  // namespace pixel
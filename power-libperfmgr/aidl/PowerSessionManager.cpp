@@ -24,9 +24,12 @@
 #include <powerhal_flags.h>
 #include <private/android_filesystem_config.h>
 #include <processgroup/processgroup.h>
+#include <signal.h>
 #include <sys/syscall.h>
 #include <utils/Trace.h>
 
+#include <tuple>
+
 #include "AdpfTypes.h"
 #include "AppDescriptorTrace.h"
 #include "AppHintDesc.h"
@@ -61,10 +64,15 @@ struct sched_attr {
     __u32 sched_util_max;
 };
 
-static int set_uclamp(int tid, UclampRange range) {
-    // Ensure min and max are bounded by the range limits and each other
+// Ensure min and max are bounded by the range limits and each other
+static UclampRange bound_uclamp(UclampRange range) {
     range.uclampMin = std::min(std::max(kUclampMin, range.uclampMin), kUclampMax);
     range.uclampMax = std::min(std::max(range.uclampMax, range.uclampMin), kUclampMax);
+    return range;
+}
+
+static int set_uclamp(int tid, UclampRange range) {
+    range = bound_uclamp(range);
     sched_attr attr = {};
     attr.size = sizeof(attr);
 
@@ -138,12 +146,7 @@ void PowerSessionManager<HintManagerT>::addPowerSession(
         sve.sessFrameMetrics = sessMetr;
     }
 
-    bool addedRes = false;
-    {
-        std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-        addedRes = mSessionTaskMap.add(sessionDescriptor->sessionId, sve, {});
-    }
-    if (!addedRes) {
+    if (!mSessionTaskMap.add(sessionDescriptor->sessionId, sve, {})) {
         ALOGE("sessionTaskMap failed to add power session: %" PRId64, sessionDescriptor->sessionId);
     }
 
@@ -161,24 +164,38 @@ void PowerSessionManager<HintManagerT>::removePowerSession(int64_t sessionId) {
     std::vector<pid_t> removedThreads;
     std::vector<std::string> profiles = getSessionTaskProfiles(sessionId, false);
 
-    {
-        // Wait till end to remove session because it needs to be around for apply U clamp
-        // to work above since applying the uclamp needs a valid session id
-        std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-
-        // collect the session metric before close the session
-        auto sessValPtr = mSessionTaskMap.findSession(sessionId);
-        if (sessValPtr->sessFrameMetrics) {
-            sessValPtr->sessFrameMetrics.value().metricEndTime = std::chrono::system_clock::now();
-            sessValPtr->sessFrameMetrics.value().metricSessionCompleted = true;
-            if (sessValPtr->sessFrameMetrics.value().totalFrameNumber >= kNumOfFramesThreshold &&
-                mCollectedSessionMetrics.size() < kMaxNumOfCachedSessionMetrics) {
-                mCollectedSessionMetrics.push_back(sessValPtr->sessFrameMetrics.value());
-            }
-        }
+    // Wait till end to remove session because it needs to be around for apply U clamp
+    // to work above since applying the uclamp needs a valid session id
 
-        mSessionTaskMap.replace(sessionId, {}, &addedThreads, &removedThreads);
-        mSessionTaskMap.remove(sessionId);
+    // collect the session metric before close the session
+    decltype(SessionValueEntry::voteTimers) voteTimers{};
+    mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &sessVal) {
+        if (sessVal.sessFrameMetrics) {
+            sessVal.sessFrameMetrics.value().metricEndTime = std::chrono::system_clock::now();
+            sessVal.sessFrameMetrics.value().metricSessionCompleted = true;
+            cacheSessionMetrics(sessVal.sessFrameMetrics.value());
+        }
+        voteTimers = sessVal.voteTimers;
+    });
+
+    mSessionTaskMap.replace(sessionId, {}, &addedThreads, &removedThreads);
+    mSessionTaskMap.remove(sessionId);
+    forgetAppliedUclamp(removedThreads);
+    auto const adpfConfig = HintManagerT::GetInstance()->GetAdpfProfile();
+    if (mGpuCapacityNode && adpfConfig->mGpuBoostOn) {
+        const Cycles hysteresis(static_cast<int>(adpfConfig->mGpuCapacityWriteHysteresis));
+        std::lock_guard<std::mutex> lock(mGpuVoteMutex);
+        auto const capacity =
+                mGpuVotes.remove(sessionId, std::chrono::steady_clock::now(), hysteresis);
+        if (capacity) {
+            (*mGpuCapacityNode)->set_gpu_capacity(*capacity);
+        }
+    }
+    // Pending timeouts have nothing left to time out
+    for (auto timer : voteTimers) {
+        if (timer != kInvalidTimerHandle) {
+            mEventSessionTimeoutWorker.cancel(timer);
+        }
     }
 
     for (auto tid : removedThreads) {
@@ -196,10 +213,11 @@ void PowerSessionManager<HintManagerT>::setThreadsFromPowerSession(
     std::vector<pid_t> addedThreads;
     std::vector<pid_t> removedThreads;
     forceSessionActive(sessionId, false);
-    {
-        std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-        mSessionTaskMap.replace(sessionId, threadIds, &addedThreads, &removedThreads);
-    }
+    mSessionTaskMap.replace(sessionId, threadIds, &addedThreads, &removedThreads);
+    // New threads have not been written yet and removed ones may go away, so
+    // neither should be matched against a previously applied range
+    forgetAppliedUclamp(addedThreads);
+    forgetAppliedUclamp(removedThreads);
 
     auto profiles = getSessionTaskProfiles(sessionId, true);
     for (auto tid : addedThreads) {
@@ -218,30 +236,40 @@ void PowerSessionManager<HintManagerT>::setThreadsFromPowerSession(
 
 template <class HintManagerT>
 bool PowerSessionManager<HintManagerT>::isAnyAppSessionActive() {
-    bool isAnyAppSessionActive = false;
-    {
-        std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-        isAnyAppSessionActive =
-                mSessionTaskMap.isAnyAppSessionActive(std::chrono::steady_clock::now());
-    }
-    return isAnyAppSessionActive;
+    return mSessionTaskMap.isAnyAppSessionActive(std::chrono::steady_clock::now());
 }
 
 template <class HintManagerT>
 bool PowerSessionManager<HintManagerT>::areAllSessionsTimeout() {
-    bool areAllTimeout = false;
-    {
-        std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-        areAllTimeout = mSessionTaskMap.areAllSessionsTimeout(std::chrono::steady_clock::now());
+    return mSessionTaskMap.areAllSessionsTimeout(std::chrono::steady_clock::now());
+}
+
+template <class HintManagerT>
+void PowerSessionManager<HintManagerT>::dumpEventsToFd(int fd) {
+    // Copy the session list out first, so no shard is locked while writing
+    std::vector<std::tuple<int64_t, std::string, std::shared_ptr<AppDescriptorTrace>>> sessions;
+    mSessionTaskMap.forEachSessionValTasks(
+            [&](auto sessionId, const auto &sessionVal, const auto & /* tasks */) {
+                if (sessionVal.sessionTrace) {
+                    sessions.emplace_back(sessionId, sessionVal.idString, sessionVal.sessionTrace);
+                }
+            });
+    if (!SessionEventRecorder::writeDumpHeader(fd)) {
+        ALOGE("Failed to dump session events to fd:%d", fd);
+        return;
+    }
+    for (const auto &[sessionId, idString, trace] : sessions) {
+        if (!trace->events.writeDump(fd, sessionId, idString)) {
+            ALOGE("Failed to dump session events to fd:%d", fd);
+            return;
+        }
     }
-    return areAllTimeout;
 }
 
 template <class HintManagerT>
 void PowerSessionManager<HintManagerT>::dumpToFd(int fd) {
     std::ostringstream dump_buf;
     dump_buf << "========== Begin PowerSessionManager ADPF list ==========\n";
-    std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
     mSessionTaskMap.forEachSessionValTasks(
             [&](auto /* sessionId */, const auto &sessionVal, const auto &tasks) {
                 sessionVal.dump(dump_buf);
@@ -261,6 +289,13 @@ void PowerSessionManager<HintManagerT>::dumpToFd(int fd) {
                 }
                 dump_buf << "]\n";
             });
+    dump_buf << "Uclamp syscalls issued: " << mUclampSyscalls.load()
+             << ", skipped unchanged: " << mUclampSkipped.load()
+             << ", coalesced tasks: " << mUclampCoalesced.load() << "\n";
+    {
+        std::lock_guard<std::mutex> lock(mGpuVoteMutex);
+        mGpuVotes.dump(dump_buf, std::chrono::steady_clock::now());
+    }
     dump_buf << "========== End PowerSessionManager ADPF list ==========\n";
 
     dump_buf << "========== Begin power session metrics list ==========\n";
@@ -272,8 +307,11 @@ void PowerSessionManager<HintManagerT>::dumpToFd(int fd) {
                 }
             });
     dump_buf << "\n--- Cached sessions' metrics ---\n";
-    for (const auto &met : mCollectedSessionMetrics) {
-        met.dump(dump_buf);
+    {
+        std::lock_guard<std::mutex> lock(mSessionMetricsMutex);
+        for (const auto &met : mCollectedSessionMetrics) {
+            met.dump(dump_buf);
+        }
     }
     dump_buf << "========== End power session metrics list ==========\n";
     if (!::android::base::WriteStringToFd(dump_buf.str(), fd)) {
@@ -283,62 +321,67 @@ void PowerSessionManager<HintManagerT>::dumpToFd(int fd) {
 
 template <class HintManagerT>
 void PowerSessionManager<HintManagerT>::pause(int64_t sessionId) {
-    {
-        std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-        auto sessValPtr = mSessionTaskMap.findSession(sessionId);
-        if (nullptr == sessValPtr) {
-            ALOGW("Pause failed, session is null %" PRId64, sessionId);
+    bool wasActive = false;
+    bool cancelRampupBoost = false;
+    const bool found = mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &sessVal) {
+        wasActive = sessVal.isActive;
+        if (!wasActive) {
             return;
         }
-
-        if (!sessValPtr->isActive) {
-            ALOGW("Sess(%" PRId64 "), cannot pause, already inActive", sessionId);
-            return;
-        }
-        sessValPtr->isActive = false;
-        if (sessValPtr->rampupBoostActive) {
-            sessValPtr->rampupBoostActive = false;
-            // TODO(guibing): cancel the per task rampup qos vote instead of voting the
-            // default low value when session gets paused.
-            voteRampupBoostLocked(sessionId, false, kBGRampupVal, kBGRampupVal);
+        sessVal.isActive = false;
+        if (sessVal.rampupBoostActive) {
+            sessVal.rampupBoostActive = false;
+            cancelRampupBoost = true;
         }
 
         // collect the session metric
-        if (sessValPtr->sessFrameMetrics) {
-            sessValPtr->sessFrameMetrics.value().metricEndTime = std::chrono::system_clock::now();
-            sessValPtr->sessFrameMetrics.value().metricSessionCompleted = true;
-            if (sessValPtr->sessFrameMetrics.value().totalFrameNumber >= kNumOfFramesThreshold &&
-                mCollectedSessionMetrics.size() < kMaxNumOfCachedSessionMetrics) {
-                mCollectedSessionMetrics.push_back(sessValPtr->sessFrameMetrics.value());
-            }
-            sessValPtr->sessFrameMetrics.value().resetMetric(
+        if (sessVal.sessFrameMetrics) {
+            sessVal.sessFrameMetrics.value().metricEndTime = std::chrono::system_clock::now();
+            sessVal.sessFrameMetrics.value().metricSessionCompleted = true;
+            cacheSessionMetrics(sessVal.sessFrameMetrics.value());
+            sessVal.sessFrameMetrics.value().resetMetric(
                     ThermalStateListener::getInstance()->getThermalThrotSev(),
                     mGameModeEnabled ? ScenarioType::GAME : ScenarioType::DEFAULT);
         }
+    });
+    if (!found) {
+        ALOGW("Pause failed, session is null %" PRId64, sessionId);
+        return;
+    }
+    if (!wasActive) {
+        ALOGW("Sess(%" PRId64 "), cannot pause, already inActive", sessionId);
+        return;
+    }
+    if (cancelRampupBoost) {
+        // TODO(guibing): cancel the per task rampup qos vote instead of voting the
+        // default low value when session gets paused.
+        voteRampupBoost(sessionId, false, kBGRampupVal, kBGRampupVal);
     }
     applyCpuAndGpuVotes(sessionId, std::chrono::steady_clock::now());
 }
 
 template <class HintManagerT>
 void PowerSessionManager<HintManagerT>::resume(int64_t sessionId) {
-    {
-        std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-        auto sessValPtr = mSessionTaskMap.findSession(sessionId);
-        if (nullptr == sessValPtr) {
-            ALOGW("Resume failed, session is null %" PRId64, sessionId);
+    bool wasActive = false;
+    const bool found = mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &sessVal) {
+        wasActive = sessVal.isActive;
+        if (wasActive) {
             return;
         }
-
-        if (sessValPtr->isActive) {
-            ALOGW("Sess(%" PRId64 "), cannot resume, already active", sessionId);
-            return;
-        }
-        sessValPtr->isActive = true;
-        if (sessValPtr->sessFrameMetrics) {
-            sessValPtr->sessFrameMetrics.value().resetMetric(
+        sessVal.isActive = true;
+        if (sessVal.sessFrameMetrics) {
+            sessVal.sessFrameMetrics.value().resetMetric(
                     ThermalStateListener::getInstance()->getThermalThrotSev(),
                     mGameModeEnabled ? ScenarioType::GAME : ScenarioType::DEFAULT);
         }
+    });
+    if (!found) {
+        ALOGW("Resume failed, session is null %" PRId64, sessionId);
+        return;
+    }
+    if (wasActive) {
+        ALOGW("Sess(%" PRId64 "), cannot resume, already active", sessionId);
+        return;
     }
     applyCpuAndGpuVotes(sessionId, std::chrono::steady_clock::now());
 }
@@ -347,23 +390,36 @@ template <class HintManagerT>
 void PowerSessionManager<HintManagerT>::updateTargetWorkDuration(
         int64_t sessionId, AdpfVoteType voteId, std::chrono::nanoseconds durationNs) {
     int voteIdInt = static_cast<std::underlying_type_t<AdpfVoteType>>(voteId);
-    std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-    auto sessValPtr = mSessionTaskMap.findSession(sessionId);
-    if (nullptr == sessValPtr) {
+    const bool found = mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &sessVal) {
+        sessVal.votes->updateDuration(voteIdInt, durationNs);
+    });
+    if (!found) {
         ALOGE("Failed to updateTargetWorkDuration, session val is null id: %" PRId64, sessionId);
         return;
     }
 
-    sessValPtr->votes->updateDuration(voteIdInt, durationNs);
     // Note, for now we are not recalculating and applying uclamp because
     // that maintains behavior from before.  In the future we may want to
     // revisit that decision.
 }
 
-template <typename T>
-auto shouldScheduleTimeout(Votes const &votes, int vote_id, std::chrono::time_point<T> deadline)
-        -> bool {
-    return !votes.voteIsActive(vote_id) || deadline < votes.voteTimeout(vote_id);
+template <class HintManagerT>
+void PowerSessionManager<HintManagerT>::armVoteTimeout(
+        int64_t sessionId, int voteId, TimerHandle timer,
+        std::chrono::steady_clock::time_point startTime,
+        std::chrono::steady_clock::time_point deadline) {
+    const EventSessionTimeout event{.timeStamp = startTime, .sessionId = sessionId,
+                                    .voteId = voteId};
+    // Move the pending timeout of this vote if it has one, so no stale
+    // timeout is left behind for the worker to drop
+    if (timer != kInvalidTimerHandle &&
+        mEventSessionTimeoutWorker.reschedule(timer, event, deadline)) {
+        return;
+    }
+    timer = mEventSessionTimeoutWorker.schedule(event, deadline);
+    mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &sessVal) {
+        sessVal.voteTimers[voteId] = timer;
+    });
 }
 
 template <class HintManagerT>
@@ -373,30 +429,24 @@ void PowerSessionManager<HintManagerT>::voteSet(int64_t sessionId, AdpfVoteType
                                                 std::chrono::nanoseconds durationNs) {
     const int voteIdInt = static_cast<std::underlying_type_t<AdpfVoteType>>(voteId);
     const auto timeoutDeadline = startTime + durationNs;
-    bool scheduleTimeout = false;
+    TimerHandle timer = kInvalidTimerHandle;
 
-    {
-        std::lock_guard lock(mSessionTaskMapMutex);
-        auto session = mSessionTaskMap.findSession(sessionId);
-        if (!session) {
-            // Because of the async nature of some events an event for a session
-            // that has been removed is a possibility
-            return;
-        }
-        scheduleTimeout = shouldScheduleTimeout(*session->votes, voteIdInt, timeoutDeadline),
-        mSessionTaskMap.addVote(sessionId, voteIdInt, uclampMin, uclampMax, startTime, durationNs);
+    const bool found = mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &session) {
+        timer = session.voteTimers[voteIdInt];
+        session.votes->add(voteIdInt, CpuVote(true, startTime, durationNs, uclampMin, uclampMax));
         if (ATRACE_ENABLED()) {
-            ATRACE_INT(session->sessionTrace->trace_votes[voteIdInt].c_str(), uclampMin);
+            ATRACE_INT(session.sessionTrace->trace_votes[voteIdInt].c_str(), uclampMin);
         }
-        session->lastUpdatedTime = startTime;
-        applyUclampLocked(sessionId, startTime);
+        session.lastUpdatedTime = startTime;
+    });
+    if (!found) {
+        // Because of the async nature of some events an event for a session
+        // that has been removed is a possibility
+        return;
     }
+    applyUclamp(sessionId, startTime);
 
-    if (scheduleTimeout) {
-        mEventSessionTimeoutWorker.schedule(
-                {.timeStamp = startTime, .sessionId = sessionId, .voteId = voteIdInt},
-                timeoutDeadline);
-    }
+    armVoteTimeout(sessionId, voteIdInt, timer, startTime, timeoutDeadline);
 }
 
 template <class HintManagerT>
@@ -406,68 +456,51 @@ void PowerSessionManager<HintManagerT>::voteSet(int64_t sessionId, AdpfVoteType
                                                 std::chrono::nanoseconds durationNs) {
     const int voteIdInt = static_cast<std::underlying_type_t<AdpfVoteType>>(voteId);
     const auto timeoutDeadline = startTime + durationNs;
-    bool scheduleTimeout = false;
+    TimerHandle timer = kInvalidTimerHandle;
 
-    {
-        std::lock_guard lock(mSessionTaskMapMutex);
-        auto session = mSessionTaskMap.findSession(sessionId);
-        if (!session) {
-            return;
-        }
-        scheduleTimeout = shouldScheduleTimeout(*session->votes, voteIdInt, timeoutDeadline),
-        mSessionTaskMap.addGpuVote(sessionId, voteIdInt, capacity, startTime, durationNs);
+    const bool found = mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &session) {
+        timer = session.voteTimers[voteIdInt];
+        session.votes->add(voteIdInt, GpuVote(true, startTime, durationNs, capacity));
         if (ATRACE_ENABLED()) {
-            ATRACE_INT(session->sessionTrace->trace_votes[voteIdInt].c_str(),
+            ATRACE_INT(session.sessionTrace->trace_votes[voteIdInt].c_str(),
                        static_cast<int>(capacity));
         }
-        session->lastUpdatedTime = startTime;
-        applyGpuVotesLocked(sessionId, startTime);
+        session.lastUpdatedTime = startTime;
+    });
+    if (!found) {
+        return;
     }
+    applyGpuVotes(sessionId, startTime);
 
-    if (scheduleTimeout) {
-        mEventSessionTimeoutWorker.schedule(
-                {.timeStamp = startTime, .sessionId = sessionId, .voteId = voteIdInt},
-                timeoutDeadline);
-    }
+    armVoteTimeout(sessionId, voteIdInt, timer, startTime, timeoutDeadline);
 }
 
 template <class HintManagerT>
 void PowerSessionManager<HintManagerT>::disableBoosts(int64_t sessionId) {
-    {
-        std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-        auto sessValPtr = mSessionTaskMap.findSession(sessionId);
-        if (nullptr == sessValPtr) {
-            // Because of the async nature of some events an event for a session
-            // that has been removed is a possibility
-            return;
-        }
-
-        // sessValPtr->disableBoosts();
+    // Because of the async nature of some events an event for a session
+    // that has been removed is a possibility
+    mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &sessVal) {
         for (auto vid : {AdpfVoteType::CPU_LOAD_UP, AdpfVoteType::CPU_LOAD_RESET,
                          AdpfVoteType::CPU_LOAD_RESUME, AdpfVoteType::VOTE_POWER_EFFICIENCY,
-                         AdpfVoteType::GPU_LOAD_UP, AdpfVoteType::GPU_LOAD_RESET}) {
+                         AdpfVoteType::GPU_LOAD_UP, AdpfVoteType::GPU_LOAD_RESET,
+                         AdpfVoteType::CPU_PREDICTED}) {
             auto vint = static_cast<std::underlying_type_t<AdpfVoteType>>(vid);
-            sessValPtr->votes->setUseVote(vint, false);
+            sessVal.votes->setUseVote(vint, false);
             if (ATRACE_ENABLED()) {
-                ATRACE_INT(sessValPtr->sessionTrace->trace_votes[vint].c_str(), 0);
+                ATRACE_INT(sessVal.sessionTrace->trace_votes[vint].c_str(), 0);
             }
         }
-    }
+    });
 }
 
 template <class HintManagerT>
 void PowerSessionManager<HintManagerT>::handleEvent(const EventSessionTimeout &eventTimeout) {
     bool recalcUclamp = false;
+    std::optional<std::chrono::steady_clock::time_point> requeueDeadline;
     const auto tNow = std::chrono::steady_clock::now();
-    {
-        std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-        auto sessValPtr = mSessionTaskMap.findSession(eventTimeout.sessionId);
-        if (nullptr == sessValPtr) {
-            // It is ok for session timeouts to fire after a session has been
-            // removed
-            return;
-        }
-
+    // It is ok for session timeouts to fire after a session has been
+    // removed
+    mSessionTaskMap.withSession(eventTimeout.sessionId, [&](SessionValueEntry &sessVal) {
         // To minimize the number of events pushed into the queue, we are using
         // the following logic to make use of a single timeout event which will
         // requeue itself if the timeout has been changed since it was added to
@@ -476,23 +509,26 @@ void PowerSessionManager<HintManagerT>::handleEvent(const EventSessionTimeout &e
         //    then deactivate vote and recalc uclamp (near end of function)
         // if vote active and vote timeout > sched time
         //    then requeue timeout event for new deadline (which is vote timeout)
-        const bool voteIsActive = sessValPtr->votes->voteIsActive(eventTimeout.voteId);
-        const auto voteTimeout = sessValPtr->votes->voteTimeout(eventTimeout.voteId);
+        const bool voteIsActive = sessVal.votes->voteIsActive(eventTimeout.voteId);
+        const auto voteTimeout = sessVal.votes->voteTimeout(eventTimeout.voteId);
 
         if (voteIsActive) {
             if (voteTimeout <= tNow) {
-                sessValPtr->votes->setUseVote(eventTimeout.voteId, false);
+                sessVal.votes->setUseVote(eventTimeout.voteId, false);
                 recalcUclamp = true;
                 if (ATRACE_ENABLED()) {
-                    ATRACE_INT(sessValPtr->sessionTrace->trace_votes[eventTimeout.voteId].c_str(),
-                               0);
+                    ATRACE_INT(sessVal.sessionTrace->trace_votes[eventTimeout.voteId].c_str(), 0);
                 }
             } else {
-                // Can unlock sooner than we do
-                auto eventTimeout2 = eventTimeout;
-                mEventSessionTimeoutWorker.schedule(eventTimeout2, voteTimeout);
+                requeueDeadline = voteTimeout;
             }
         }
+    });
+
+    if (requeueDeadline) {
+        // The timer that fired is spent, arm a new one for the vote
+        armVoteTimeout(eventTimeout.sessionId, eventTimeout.voteId, kInvalidTimerHandle,
+                       eventTimeout.timeStamp, *requeueDeadline);
     }
 
     if (!recalcUclamp) {
@@ -506,67 +542,179 @@ void PowerSessionManager<HintManagerT>::handleEvent(const EventSessionTimeout &e
 }
 
 template <class HintManagerT>
-void PowerSessionManager<HintManagerT>::applyUclampLocked(
+void PowerSessionManager<HintManagerT>::applyUclamp(
         int64_t sessionId, std::chrono::steady_clock::time_point timePoint) {
     auto config = HintManagerT::GetInstance()->GetAdpfProfile();
-    {
-        // TODO(kevindubois) un-indent this in followup patch to reduce churn.
-        auto sessValPtr = mSessionTaskMap.findSession(sessionId);
-        if (nullptr == sessValPtr) {
-            return;
+    if (!config->mUclampMinOn) {
+        ALOGV("PowerSessionManager::set_uclamp: skip");
+    } else {
+        queueUclamp(sessionId, mSessionTaskMap.getTaskIds(sessionId), timePoint);
+    }
+
+    mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &sessVal) {
+        sessVal.lastUpdatedTime = timePoint;
+    });
+}
+
+template <class HintManagerT>
+void PowerSessionManager<HintManagerT>::queueUclamp(
+        int64_t sessionId, const std::vector<pid_t> &taskIds,
+        std::chrono::steady_clock::time_point timePoint) {
+    std::unordered_map<pid_t, PendingUclamp> batch;
+    std::unique_lock<std::mutex> lock(mUclampMutex);
+    for (auto tid : taskIds) {
+        auto [it, inserted] = mPendingUclamp.try_emplace(tid, PendingUclamp{timePoint, sessionId});
+        if (!inserted) {
+            it->second.timePoint = std::max(it->second.timePoint, timePoint);
+            if (it->second.sessionId != sessionId) {
+                it->second.sessionId = kAnySession;
+            }
+            ++mUclampCoalesced;
+        }
+    }
+    const uint64_t queued = ++mUclampQueued;
+    // Wait for the batch holding these tasks, draining it here if no other
+    // caller is draining. A caller drains at most the batch its own tasks
+    // are in, tasks queued meanwhile are left to their callers.
+    while (mUclampDrained < queued) {
+        if (mUclampFlushing) {
+            mUclampDrainedCv.wait(lock);
+            continue;
+        }
+        mUclampFlushing = true;
+        batch.swap(mPendingUclamp);
+        const uint64_t batchQueued = mUclampQueued;
+        lock.unlock();
+        flushUclamp(batch);
+        batch.clear();
+        lock.lock();
+        mUclampDrained = batchQueued;
+        mUclampFlushing = false;
+        mUclampDrainedCv.notify_all();
+    }
+}
+
+template <class HintManagerT>
+void PowerSessionManager<HintManagerT>::flushUclamp(
+        const std::unordered_map<pid_t, PendingUclamp> &batch) {
+    auto config = HintManagerT::GetInstance()->GetAdpfProfile();
+    for (const auto &[tid, pending] : batch) {
+        UclampRange uclampRange;
+        mSessionTaskMap.getTaskVoteRange(tid, pending.timePoint, uclampRange,
+                                         config->mUclampMaxEfficientBase,
+                                         config->mUclampMaxEfficientOffset);
+        uclampRange = bound_uclamp(uclampRange);
+        uint64_t appliedGen;
+        bool cached;
+        {
+            std::lock_guard<std::mutex> lock(mUclampMutex);
+            appliedGen = mAppliedUclampGen;
+            auto applied = mAppliedUclamp.find(tid);
+            cached = applied != mAppliedUclamp.end() &&
+                     applied->second.uclampMin == uclampRange.uclampMin &&
+                     applied->second.uclampMax == uclampRange.uclampMax;
         }
 
-        if (!config->mUclampMinOn) {
-            ALOGV("PowerSessionManager::set_uclamp: skip");
+        int stat;
+        if (cached) {
+            // Nothing to write, but a dead task is still found and unlinked
+            // as if the write had failed
+            if (kill(tid, 0) == 0 || errno != ESRCH) {
+                ++mUclampSkipped;
+                continue;
+            }
+            stat = ESRCH;
         } else {
-            auto &threadList = mSessionTaskMap.getTaskIds(sessionId);
-            auto tidIter = threadList.begin();
-            while (tidIter != threadList.end()) {
-                UclampRange uclampRange;
-                mSessionTaskMap.getTaskVoteRange(*tidIter, timePoint, uclampRange,
-                                                 config->mUclampMaxEfficientBase,
-                                                 config->mUclampMaxEfficientOffset);
-                int stat = set_uclamp(*tidIter, uclampRange);
-                if (stat == ESRCH) {
-                    ALOGV("Removing dead thread %d from hint session %s.", *tidIter,
-                          sessValPtr->idString.c_str());
-                    if (mSessionTaskMap.removeDeadTaskSessionMap(sessionId, *tidIter)) {
-                        ALOGV("Removed dead thread-session map.");
-                    }
-                    tidIter = threadList.erase(tidIter);
-                } else {
-                    tidIter++;
-                }
+            ++mUclampSyscalls;
+            stat = set_uclamp(tid, uclampRange);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mUclampMutex);
+            // A task forgotten while it was written must not get its range
+            // cached back
+            if (stat == 0 && appliedGen == mAppliedUclampGen) {
+                mAppliedUclamp[tid] = uclampRange;
+            } else {
+                mAppliedUclamp.erase(tid);
+            }
+        }
+        if (stat != ESRCH) {
+            continue;
+        }
+        // Unlink the dead task from the session that queued it, or from all
+        // of them if it was queued by several
+        std::vector<int64_t> sessionIds;
+        if (pending.sessionId == kAnySession) {
+            sessionIds = mSessionTaskMap.getSessionIds(tid);
+        } else {
+            sessionIds.push_back(pending.sessionId);
+        }
+        for (auto sessionId : sessionIds) {
+            ALOGV("Removing dead thread %d from hint session %" PRId64 ".", tid, sessionId);
+            if (mSessionTaskMap.removeDeadTaskSessionMap(sessionId, tid)) {
+                ALOGV("Removed dead thread-session map.");
             }
         }
+    }
+}
 
-        sessValPtr->lastUpdatedTime = timePoint;
+template <class HintManagerT>
+void PowerSessionManager<HintManagerT>::forgetAppliedUclamp(const std::vector<pid_t> &taskIds) {
+    std::lock_guard<std::mutex> lock(mUclampMutex);
+    ++mAppliedUclampGen;
+    for (auto tid : taskIds) {
+        mAppliedUclamp.erase(tid);
     }
 }
 
 template <class HintManagerT>
-void PowerSessionManager<HintManagerT>::applyGpuVotesLocked(
+void PowerSessionManager<HintManagerT>::applyGpuVotes(
         int64_t sessionId, std::chrono::steady_clock::time_point timePoint) {
-    auto const sessValPtr = mSessionTaskMap.findSession(sessionId);
-    if (!sessValPtr) {
+    auto const adpfConfig = HintManagerT::GetInstance()->GetAdpfProfile();
+    if (!mGpuCapacityNode || !adpfConfig->mGpuBoostOn) {
+        mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &sessVal) {
+            sessVal.lastUpdatedTime = timePoint;
+        });
         return;
     }
 
-    auto const gpuVotingOn = HintManagerT::GetInstance()->GetAdpfProfile()->mGpuBoostOn;
-    if (mGpuCapacityNode && gpuVotingOn) {
-        auto const capacity = mSessionTaskMap.getSessionsGpuCapacity(timePoint);
-        (*mGpuCapacityNode)->set_gpu_capacity(capacity);
+    const Cycles hysteresis(static_cast<int>(adpfConfig->mGpuCapacityWriteHysteresis));
+    // Read the request under mGpuVoteMutex too, so requests of a session are
+    // aggregated in the order they were read and none is aggregated after
+    // removePowerSession withdrew the session
+    std::lock_guard<std::mutex> lock(mGpuVoteMutex);
+    Cycles request(0);
+    std::chrono::steady_clock::time_point deadline;
+    const bool found = mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &sessVal) {
+        sessVal.lastUpdatedTime = timePoint;
+        request = sessVal.votes->getGpuCapacityRequest(timePoint).value_or(Cycles(0));
+        deadline = sessVal.votes->getGpuCapacityDeadline(timePoint).value_or(timePoint);
+    });
+    if (!found) {
+        return;
+    }
+    auto const capacity = mGpuVotes.update(sessionId, request, deadline, timePoint, hysteresis);
+    if (capacity) {
+        (*mGpuCapacityNode)->set_gpu_capacity(*capacity);
     }
-
-    sessValPtr->lastUpdatedTime = timePoint;
 }
 
 template <class HintManagerT>
 void PowerSessionManager<HintManagerT>::applyCpuAndGpuVotes(
         int64_t sessionId, std::chrono::steady_clock::time_point timePoint) {
-    std::lock_guard lock(mSessionTaskMapMutex);
-    applyUclampLocked(sessionId, timePoint);
-    applyGpuVotesLocked(sessionId, timePoint);
+    applyUclamp(sessionId, timePoint);
+    applyGpuVotes(sessionId, timePoint);
+}
+
+template <class HintManagerT>
+void PowerSessionManager<HintManagerT>::cacheSessionMetrics(const SessionMetrics &metrics) {
+    if (metrics.totalFrameNumber < kNumOfFramesThreshold) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mSessionMetricsMutex);
+    if (mCollectedSessionMetrics.size() < kMaxNumOfCachedSessionMetrics) {
+        mCollectedSessionMetrics.push_back(metrics);
+    }
 }
 
 template <class HintManagerT>
@@ -579,13 +727,10 @@ std::optional<Frequency> PowerSessionManager<HintManagerT>::gpuFrequency() const
 
 template <class HintManagerT>
 void PowerSessionManager<HintManagerT>::forceSessionActive(int64_t sessionId, bool isActive) {
-    {
-        std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-        auto sessValPtr = mSessionTaskMap.findSession(sessionId);
-        if (nullptr == sessValPtr) {
-            return;
-        }
-        sessValPtr->isActive = isActive;
+    const bool found = mSessionTaskMap.withSession(
+            sessionId, [&](SessionValueEntry &sessVal) { sessVal.isActive = isActive; });
+    if (!found) {
+        return;
     }
 
     // As currently written, call needs to occur synchronously so as to ensure
@@ -596,14 +741,15 @@ void PowerSessionManager<HintManagerT>::forceSessionActive(int64_t sessionId, bo
 
 template <class HintManagerT>
 void PowerSessionManager<HintManagerT>::setPreferPowerEfficiency(int64_t sessionId, bool enabled) {
-    std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-    auto sessValPtr = mSessionTaskMap.findSession(sessionId);
-    if (nullptr == sessValPtr) {
-        return;
-    }
-    if (enabled != sessValPtr->isPowerEfficient) {
-        sessValPtr->isPowerEfficient = enabled;
-        applyUclampLocked(sessionId, std::chrono::steady_clock::now());
+    bool changed = false;
+    mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &sessVal) {
+        if (enabled != sessVal.isPowerEfficient) {
+            sessVal.isPowerEfficient = enabled;
+            changed = true;
+        }
+    });
+    if (changed) {
+        applyUclamp(sessionId, std::chrono::steady_clock::now());
     }
 }
 
@@ -644,51 +790,44 @@ void PowerSessionManager<HintManagerT>::clear() {
 template <class HintManagerT>
 void PowerSessionManager<HintManagerT>::updateFrameMetrics(
         int64_t sessionId, const FrameTimingMetrics &lastReportedFrames) {
-    std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-    auto sessValPtr = mSessionTaskMap.findSession(sessionId);
-    if (nullptr == sessValPtr) {
-        return;
-    }
-
-    sessValPtr->sessFrameBuckets.addUpNewFrames(lastReportedFrames.framesInBuckets);
-    if (sessValPtr->sessFrameMetrics) {
-        switch (sessValPtr->sessFrameMetrics.value().scenarioType) {
-            case ScenarioType::GAME:
-                sessValPtr->sessFrameMetrics.value().addNewFrames(
-                        lastReportedFrames.gameFrameMetrics);
-                break;
-            case ScenarioType::DEFAULT:
-                sessValPtr->sessFrameMetrics.value().addNewFrames(
-                        lastReportedFrames.framesInBuckets);
-                break;
-            default:
-                ALOGW("Unknown scenarioType during updateFrameMetrics.");
+    mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &sessVal) {
+        sessVal.sessFrameBuckets.addUpNewFrames(lastReportedFrames.framesInBuckets);
+        if (sessVal.sessFrameMetrics) {
+            switch (sessVal.sessFrameMetrics.value().scenarioType) {
+                case ScenarioType::GAME:
+                    sessVal.sessFrameMetrics.value().addNewFrames(
+                            lastReportedFrames.gameFrameMetrics);
+                    break;
+                case ScenarioType::DEFAULT:
+                    sessVal.sessFrameMetrics.value().addNewFrames(
+                            lastReportedFrames.framesInBuckets);
+                    break;
+                default:
+                    ALOGW("Unknown scenarioType during updateFrameMetrics.");
+            }
         }
-    }
+    });
 }
 
 template <class HintManagerT>
 void PowerSessionManager<HintManagerT>::updateHboostStatistics(int64_t sessionId,
                                                                SessionJankyLevel jankyLevel,
                                                                int32_t numOfFrames) {
-    std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-    auto sessValPtr = mSessionTaskMap.findSession(sessionId);
-    if (nullptr == sessValPtr) {
-        return;
-    }
-    switch (jankyLevel) {
-        case SessionJankyLevel::LIGHT:
-            sessValPtr->hBoostModeDist.lightModeFrames += numOfFrames;
-            break;
-        case SessionJankyLevel::MODERATE:
-            sessValPtr->hBoostModeDist.moderateModeFrames += numOfFrames;
-            break;
-        case SessionJankyLevel::SEVERE:
-            sessValPtr->hBoostModeDist.severeModeFrames += numOfFrames;
-            break;
-        default:
-            ALOGW("Unknown janky level during updateHboostStatistics");
-    }
+    mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &sessVal) {
+        switch (jankyLevel) {
+            case SessionJankyLevel::LIGHT:
+                sessVal.hBoostModeDist.lightModeFrames += numOfFrames;
+                break;
+            case SessionJankyLevel::MODERATE:
+                sessVal.hBoostModeDist.moderateModeFrames += numOfFrames;
+                break;
+            case SessionJankyLevel::SEVERE:
+                sessVal.hBoostModeDist.severeModeFrames += numOfFrames;
+                break;
+            default:
+                ALOGW("Unknown janky level during updateHboostStatistics");
+        }
+    });
 }
 
 template <class HintManagerT>
@@ -725,18 +864,22 @@ bool PowerSessionManager<HintManagerT>::hasValidTaskRampupMultNode() {
 }
 
 template <class HintManagerT>
-void PowerSessionManager<HintManagerT>::voteRampupBoostLocked(int64_t sessionId,
-                                                              bool rampupBoostVote,
-                                                              int32_t defaultRampupVal,
-                                                              int32_t highRampupVal) {
+void PowerSessionManager<HintManagerT>::voteRampupBoost(int64_t sessionId, bool rampupBoostVote,
+                                                        int32_t defaultRampupVal,
+                                                        int32_t highRampupVal) {
     auto threadIds = mSessionTaskMap.getTaskIds(sessionId);
     for (auto tid : threadIds) {
         auto sessionIds = mSessionTaskMap.getSessionIds(tid);
         // Check the aggregated rampup boost status for all the other sessions.
         bool otherSessionsRampupBoost = false;
         for (auto sess : sessionIds) {
-            if (sess != sessionId && mSessionTaskMap.findSession(sess)->rampupBoostActive) {
-                otherSessionsRampupBoost = true;
+            if (sess == sessionId) {
+                continue;
+            }
+            mSessionTaskMap.withSession(sess, [&](const SessionValueEntry &sessVal) {
+                otherSessionsRampupBoost = sessVal.rampupBoostActive;
+            });
+            if (otherSessionsRampupBoost) {
                 break;
             }
         }
@@ -760,74 +903,71 @@ void PowerSessionManager<HintManagerT>::updateRampupBoostMode(int64_t sessionId,
                                                               SessionJankyLevel jankyLevel,
                                                               int32_t defaultRampupVal,
                                                               int32_t highRampupVal) {
-    std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-    auto sessValPtr = mSessionTaskMap.findSession(sessionId);
-    if (nullptr == sessValPtr) {
-        return;
-    }
-    auto lastRampupBoostActive = sessValPtr->rampupBoostActive;
-    if (!sessValPtr->isActive) {
-        sessValPtr->rampupBoostActive = false;
-    } else {
-        switch (jankyLevel) {
-            case SessionJankyLevel::LIGHT:
-                sessValPtr->rampupBoostActive = false;
-                break;
-            case SessionJankyLevel::MODERATE:
-                sessValPtr->rampupBoostActive = true;
-                break;
-            case SessionJankyLevel::SEVERE:
-                sessValPtr->rampupBoostActive = true;
-                break;
-            default:
-                ALOGW("Unknown janky level during updateHboostStatistics");
+    bool lastRampupBoostActive = false;
+    bool rampupBoostActive = false;
+    const bool found = mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &sessVal) {
+        lastRampupBoostActive = sessVal.rampupBoostActive;
+        if (!sessVal.isActive) {
+            sessVal.rampupBoostActive = false;
+        } else {
+            switch (jankyLevel) {
+                case SessionJankyLevel::LIGHT:
+                    sessVal.rampupBoostActive = false;
+                    break;
+                case SessionJankyLevel::MODERATE:
+                    sessVal.rampupBoostActive = true;
+                    break;
+                case SessionJankyLevel::SEVERE:
+                    sessVal.rampupBoostActive = true;
+                    break;
+                default:
+                    ALOGW("Unknown janky level during updateHboostStatistics");
+            }
         }
-    }
+        rampupBoostActive = sessVal.rampupBoostActive;
 
-    if (ATRACE_ENABLED()) {
-        ATRACE_INT(sessValPtr->sessionTrace->trace_rampup_boost_active.c_str(),
-                   sessValPtr->rampupBoostActive);
+        if (ATRACE_ENABLED()) {
+            ATRACE_INT(sessVal.sessionTrace->trace_rampup_boost_active.c_str(),
+                       sessVal.rampupBoostActive);
+        }
+    });
+    if (!found) {
+        return;
     }
 
-    if (sessValPtr->rampupBoostActive != lastRampupBoostActive) {
-        voteRampupBoostLocked(sessionId, sessValPtr->rampupBoostActive, defaultRampupVal,
-                              highRampupVal);
+    if (rampupBoostActive != lastRampupBoostActive) {
+        voteRampupBoost(sessionId, rampupBoostActive, defaultRampupVal, highRampupVal);
     }
 }
 
 template <class HintManagerT>
 bool PowerSessionManager<HintManagerT>::updateCollectedSessionMetrics(int64_t sessionId) {
-    std::lock_guard<std::mutex> lock(mSessionTaskMapMutex);
-    auto sessValPtr = mSessionTaskMap.findSession(sessionId);
-    if (nullptr == sessValPtr || !sessValPtr->sessFrameMetrics) {
-        return false;
-    }
-
     bool needNewMetricSession = false;
-    auto newScenarioType = mGameModeEnabled ? ScenarioType::GAME : ScenarioType::DEFAULT;
-    if (sessValPtr->tag == SessionTag::SURFACEFLINGER) {
-        if (sessValPtr->sessFrameMetrics.value().scenarioType != newScenarioType) {
-            needNewMetricSession = true;
+    mSessionTaskMap.withSession(sessionId, [&](SessionValueEntry &sessVal) {
+        if (!sessVal.sessFrameMetrics) {
+            return;
         }
-    }
 
-    auto newThermalThrotSev = ThermalStateListener::getInstance()->getThermalThrotSev();
-    if (sessValPtr->sessFrameMetrics.value().thermalThrotStat != newThermalThrotSev) {
-        needNewMetricSession = true;
-    }
+        auto newScenarioType = mGameModeEnabled ? ScenarioType::GAME : ScenarioType::DEFAULT;
+        if (sessVal.tag == SessionTag::SURFACEFLINGER) {
+            if (sessVal.sessFrameMetrics.value().scenarioType != newScenarioType) {
+                needNewMetricSession = true;
+            }
+        }
 
-    if (needNewMetricSession) {
-        sessValPtr->sessFrameMetrics.value().metricEndTime = std::chrono::system_clock::now();
-        sessValPtr->sessFrameMetrics.value().metricSessionCompleted = true;
-        if (sessValPtr->sessFrameMetrics.value().totalFrameNumber >= kNumOfFramesThreshold &&
-            mCollectedSessionMetrics.size() < kMaxNumOfCachedSessionMetrics) {
-            mCollectedSessionMetrics.push_back(sessValPtr->sessFrameMetrics.value());
+        auto newThermalThrotSev = ThermalStateListener::getInstance()->getThermalThrotSev();
+        if (sessVal.sessFrameMetrics.value().thermalThrotStat != newThermalThrotSev) {
+            needNewMetricSession = true;
         }
-        sessValPtr->sessFrameMetrics.value().resetMetric(newThermalThrotSev, newScenarioType);
-        return true;
-    }
 
-    return false;
+        if (needNewMetricSession) {
+            sessVal.sessFrameMetrics.value().metricEndTime = std::chrono::system_clock::now();
+            sessVal.sessFrameMetrics.value().metricSessionCompleted = true;
+            cacheSessionMetrics(sessVal.sessFrameMetrics.value());
+            sessVal.sessFrameMetrics.value().resetMetric(newThermalThrotSev, newScenarioType);
+        }
+    });
+    return needNewMetricSession;
 }
 
 template class PowerSessionManager<>;
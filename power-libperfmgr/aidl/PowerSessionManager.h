@@ -20,12 +20,16 @@
 #include <perfmgr/HintManager.h>
 #include <utils/Mutex.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <optional>
+#include <unordered_map>
 
 #include "AppHintDesc.h"
 #include "BackgroundWorker.h"
 #include "GpuCapacityNode.h"
+#include "GpuVoteAggregator.h"
 #include "SessionMetrics.h"
 #include "SessionTaskMap.h"
 #include "TaskRampupMultNode.h"
@@ -59,6 +63,8 @@ class PowerSessionManager : public Immobile {
     void resume(int64_t sessionId);
 
     void dumpToFd(int fd);
+    // Write the binary event record of every session, see SessionEventRecorder
+    void dumpEventsToFd(int fd);
 
     void updateTargetWorkDuration(int64_t sessionId, AdpfVoteType voteId,
                                   std::chrono::nanoseconds durationNs);
@@ -103,8 +109,7 @@ class PowerSessionManager : public Immobile {
     bool isAnyAppSessionActive();
     const std::string kDisableBoostHintName;
 
-    // Rewrite specific
-    mutable std::mutex mSessionTaskMapMutex;
+    // Rewrite specific, SessionTaskMap does its own per-session locking
     SessionTaskMap mSessionTaskMap;
     std::shared_ptr<PriorityQueueWorkerPool> mPriorityQueueWorkerPool;
 
@@ -115,21 +120,45 @@ class PowerSessionManager : public Immobile {
         int voteId{0};
     };
     void handleEvent(const EventSessionTimeout &e);
+    // Arm or move the timeout of a vote. timer is the vote's current timer.
+    void armVoteTimeout(int64_t sessionId, int voteId, TimerHandle timer,
+                        std::chrono::steady_clock::time_point startTime,
+                        std::chrono::steady_clock::time_point deadline);
     TemplatePriorityQueueWorker<EventSessionTimeout> mEventSessionTimeoutWorker;
 
-    // Calculate uclamp range
-    void applyUclampLocked(int64_t sessionId, std::chrono::steady_clock::time_point timePoint)
-            REQUIRES(mSessionTaskMapMutex);
-
-    void applyGpuVotesLocked(int64_t sessionId, std::chrono::steady_clock::time_point timePoint)
-            REQUIRES(mSessionTaskMapMutex);
+    // Calculate uclamp range. Must not be called from a SessionTaskMap callback.
+    void applyUclamp(int64_t sessionId, std::chrono::steady_clock::time_point timePoint);
+    // Tasks waiting for uclamp evaluation
+    struct PendingUclamp {
+        // Latest time the task was queued at
+        std::chrono::steady_clock::time_point timePoint;
+        // Session that queued the task, kAnySession if several did
+        int64_t sessionId;
+    };
+    static constexpr int64_t kAnySession = -1;
+    // Queue tasks of sessionId for uclamp evaluation. If no other caller is
+    // draining the queue this one drains the batch holding its tasks, so a
+    // task shared by sessions updated at the same time is evaluated and
+    // written once. Otherwise it waits for the caller draining it, either way
+    // the tasks are written on return.
+    void queueUclamp(int64_t sessionId, const std::vector<pid_t> &taskIds,
+                     std::chrono::steady_clock::time_point timePoint);
+    void flushUclamp(const std::unordered_map<pid_t, PendingUclamp> &batch);
+    // Drop cached ranges so the next evaluation always writes them
+    void forgetAppliedUclamp(const std::vector<pid_t> &taskIds);
+
+    // Fold the session's GPU capacity request into the aggregate and write
+    // the node if the aggregate moved enough
+    void applyGpuVotes(int64_t sessionId, std::chrono::steady_clock::time_point timePoint);
 
     void applyCpuAndGpuVotes(int64_t sessionId, std::chrono::steady_clock::time_point timePoint);
     // Force a session active or in-active, helper for other methods
     void forceSessionActive(int64_t sessionId, bool isActive);
     std::vector<std::string> getSessionTaskProfiles(int64_t sessionId, bool isSetProfile) const;
-    void voteRampupBoostLocked(int64_t sessionId, bool rampupBoostVote, int32_t defaultRampupVal,
-                               int32_t highRampupVal);
+    void voteRampupBoost(int64_t sessionId, bool rampupBoostVote, int32_t defaultRampupVal,
+                         int32_t highRampupVal);
+    // Keep a completed session metric for upload if it is worth it
+    void cacheSessionMetrics(const SessionMetrics &metrics);
 
     // Singleton
     PowerSessionManager()
@@ -144,6 +173,10 @@ class PowerSessionManager : public Immobile {
     PowerSessionManager &operator=(PowerSessionManager const &) = delete;
 
     std::optional<std::unique_ptr<GpuCapacityNode>> const mGpuCapacityNode;
+    // Held from reading a session's request through the node write, so writes
+    // land in request order. Taken before the SessionTaskMap lock.
+    std::mutex mGpuVoteMutex;
+    GpuVoteAggregator mGpuVotes GUARDED_BY(mGpuVoteMutex);
 
     std::mutex mSessionMapMutex;
     std::unordered_map<int, std::weak_ptr<void>> mSessionMap GUARDED_BY(mSessionMapMutex);
@@ -151,7 +184,25 @@ class PowerSessionManager : public Immobile {
     std::atomic<bool> mGameModeEnabled{false};
     std::shared_ptr<TaskRampupMultNode> mTaskRampupMultNode;
 
-    std::vector<SessionMetrics> mCollectedSessionMetrics GUARDED_BY(mSessionTaskMapMutex);
+    std::mutex mUclampMutex;
+    std::unordered_map<pid_t, PendingUclamp> mPendingUclamp GUARDED_BY(mUclampMutex);
+    bool mUclampFlushing GUARDED_BY(mUclampMutex){false};
+    // Every queueing bumps mUclampQueued, a drained batch publishes the value
+    // it was taken at in mUclampDrained
+    uint64_t mUclampQueued GUARDED_BY(mUclampMutex){0};
+    uint64_t mUclampDrained GUARDED_BY(mUclampMutex){0};
+    std::condition_variable mUclampDrainedCv;
+    // Last range written to each task, unchanged ranges skip sched_setattr
+    // and only check the task is still alive
+    std::unordered_map<pid_t, UclampRange> mAppliedUclamp GUARDED_BY(mUclampMutex);
+    // Bumped by forgetAppliedUclamp, a range written across a bump is not cached
+    uint64_t mAppliedUclampGen GUARDED_BY(mUclampMutex){0};
+    std::atomic<uint64_t> mUclampSyscalls{0};
+    std::atomic<uint64_t> mUclampSkipped{0};
+    std::atomic<uint64_t> mUclampCoalesced{0};
+
+    std::mutex mSessionMetricsMutex;
+    std::vector<SessionMetrics> mCollectedSessionMetrics GUARDED_BY(mSessionMetricsMutex);
     const int32_t kMaxNumOfCachedSessionMetrics;
 };
 
@@ -38,13 +38,10 @@ class SessionChannel {
   private:
     int32_t mTgid = -1;
     int32_t mUid = -1;
-    // An ID starting from 0 increasing sequentially, representing
-    // location in the session array. If a channel dies, it isn't removed
-    // but killed, so that the order remains the same for everyone. It will
-    // be replaced when new sessions come along. The first 15 sessions
-    // all get unique sets of bits to communicate with their client,
-    // and 16+ have to share the last slot. It's worth considering making
-    // another thread if we go beyond 16.
+    // Group and slot of the channel. If a channel dies its slot is freed and
+    // reused by the next channel placed in the group. Every slot has its own
+    // read and write bits, a group never holds more than kMaxChannels, and
+    // ChannelManager opens another group and thread beyond that.
     const int64_t mId = -1;
     const uint32_t mReadMask = 0;
     const uint32_t mWriteMask = 0;
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "powerhal-libperfmgr"
+
+#include "SessionEventRecorder.h"
+
+#include <android-base/file.h>
+#include <log/log.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+static_assert((SessionEventRecorder::kCapacity & (SessionEventRecorder::kCapacity - 1)) == 0);
+
+static constexpr char kDumpMagic[8] = {'A', 'D', 'P', 'F', 'E', 'V', 'T', '1'};
+
+SessionEventRecorder::SessionEventRecorder(const std::string &name) {
+    mFd.reset(memfd_create(("adpf-events-" + name).c_str(), MFD_CLOEXEC));
+    if (mFd.ok() && ftruncate(mFd.get(), sizeof(Ring)) == 0) {
+        void *addr = mmap(nullptr, sizeof(Ring), PROT_READ | PROT_WRITE, MAP_SHARED, mFd.get(), 0);
+        if (addr != MAP_FAILED) {
+            mRing = new (addr) Ring();
+            return;
+        }
+    }
+    ALOGW("Failed to map shared event ring for %s, using private memory", name.c_str());
+    mFd.reset();
+    void *addr = mmap(nullptr, sizeof(Ring), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                      -1, 0);
+    if (addr != MAP_FAILED) {
+        mRing = new (addr) Ring();
+    }
+}
+
+SessionEventRecorder::~SessionEventRecorder() {
+    if (mRing) {
+        mRing->~Ring();
+        munmap(mRing, sizeof(Ring));
+    }
+}
+
+void SessionEventRecorder::record(SessionEventType type, int32_t arg, int64_t v0, int64_t v1,
+                                  int64_t v2) {
+    if (!mRing) {
+        return;
+    }
+    const uint64_t head = mRing->head.load(std::memory_order_relaxed);
+    SessionEvent &event = mRing->events[head & (kCapacity - 1)];
+    event.timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now().time_since_epoch())
+                                .count();
+    event.type = static_cast<uint16_t>(type);
+    event.reserved = 0;
+    event.arg = arg;
+    event.values[0] = v0;
+    event.values[1] = v1;
+    event.values[2] = v2;
+    mRing->head.store(head + 1, std::memory_order_release);
+}
+
+void SessionEventRecorder::snapshot(std::vector<SessionEvent> *events) const {
+    events->clear();
+    if (!mRing) {
+        return;
+    }
+    const uint64_t head = mRing->head.load(std::memory_order_acquire);
+    // The oldest slot is the next one the writer reuses, leave it out
+    const uint64_t first = head > kCapacity - 1 ? head - (kCapacity - 1) : 0;
+    events->reserve(head - first);
+    for (uint64_t i = first; i < head; i++) {
+        events->push_back(mRing->events[i & (kCapacity - 1)]);
+    }
+    // The writer may have lapped the copy: the event it is writing now and
+    // everything it published meanwhile overwrote the oldest slots
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t newHead = mRing->head.load(std::memory_order_relaxed);
+    if (newHead + 1 > first + kCapacity) {
+        const uint64_t torn = std::min<uint64_t>(newHead + 1 - kCapacity - first, events->size());
+        events->erase(events->begin(), events->begin() + torn);
+    }
+}
+
+uint64_t SessionEventRecorder::recorded() const {
+    return mRing ? mRing->head.load(std::memory_order_relaxed) : 0;
+}
+
+bool SessionEventRecorder::writeDumpHeader(int fd) {
+    char header[16];
+    const uint32_t version = kDumpVersion;
+    const uint32_t eventSize = sizeof(SessionEvent);
+    memcpy(header, kDumpMagic, sizeof(kDumpMagic));
+    memcpy(header + 8, &version, sizeof(version));
+    memcpy(header + 12, &eventSize, sizeof(eventSize));
+    return ::android::base::WriteFully(fd, header, sizeof(header));
+}
+
+bool SessionEventRecorder::writeDump(int fd, int64_t sessionId, const std::string &name) const {
+    std::vector<SessionEvent> events;
+    snapshot(&events);
+    const uint32_t nameLen = name.size();
+    const uint32_t count = events.size();
+    char header[16];
+    memcpy(header, &sessionId, sizeof(sessionId));
+    memcpy(header + 8, &nameLen, sizeof(nameLen));
+    memcpy(header + 12, &count, sizeof(count));
+    return ::android::base::WriteFully(fd, header, sizeof(header)) &&
+           ::android::base::WriteFully(fd, name.data(), name.size()) &&
+           ::android::base::WriteFully(fd, events.data(), events.size() * sizeof(SessionEvent));
+}
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
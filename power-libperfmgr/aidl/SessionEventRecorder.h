@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+enum class SessionEventType : uint16_t {
+    // arg: batch size, values: last duration, target, last GPU duration
+    REPORT = 1,
+    // arg: PID output, values: P, I and D terms
+    PID,
+    // arg: uclamp.min voted by the PID controller. The applied uclamp.min also
+    // depends on the other votes of the session and of other sessions.
+    UCLAMP_MIN_VOTE,
+    // arg: GPU capacity voted
+    GPU_CAPACITY,
+    // arg: SessionJankyLevel, values: janky frames, average and max duration in us
+    JANK_LEVEL,
+};
+
+// Fixed size, so that a dump is a plain array of events
+struct SessionEvent {
+    int64_t timestampNs;
+    uint16_t type;
+    uint16_t reserved;
+    int32_t arg;
+    int64_t values[3];
+};
+static_assert(sizeof(SessionEvent) == 40);
+
+// Always-on ring of the latest binary events of a session, kept in a memfd
+// mapping so it can be handed to another process as is. Recording is a copy
+// and a release store; there is a single writer, which the session lock
+// serializes, and any number of readers.
+//
+// Binary dump layout, native endian:
+//   header:  char magic[8] "ADPFEVT1", uint32 version, uint32 sizeof(SessionEvent)
+//   session: int64 session id, uint32 name length, uint32 event count,
+//            name bytes, events oldest first
+class SessionEventRecorder {
+  public:
+    // Events kept per session, a power of two
+    static constexpr uint32_t kCapacity = 256;
+    static constexpr uint32_t kDumpVersion = 1;
+
+    explicit SessionEventRecorder(const std::string &name);
+    ~SessionEventRecorder();
+    SessionEventRecorder(const SessionEventRecorder &) = delete;
+    SessionEventRecorder &operator=(const SessionEventRecorder &) = delete;
+
+    void record(SessionEventType type, int32_t arg, int64_t v0 = 0, int64_t v1 = 0,
+                int64_t v2 = 0);
+    // Copies up to the latest kCapacity - 1 events, oldest first. Events
+    // overwritten while copying are left out.
+    void snapshot(std::vector<SessionEvent> *events) const;
+    // Events recorded since creation
+    uint64_t recorded() const;
+    // The shared memory of the ring, -1 if it fell back to private memory
+    int fd() const { return mFd.get(); }
+
+    static bool writeDumpHeader(int fd);
+    bool writeDump(int fd, int64_t sessionId, const std::string &name) const;
+
+  private:
+    struct Ring {
+        std::atomic<uint64_t> head;
+        SessionEvent events[kCapacity];
+    };
+
+    ::android::base::unique_fd mFd;
+    Ring *mRing{nullptr};
+};
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
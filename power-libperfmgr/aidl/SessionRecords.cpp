@@ -30,54 +30,42 @@ namespace pixel {
 static constexpr int32_t kTotalFramesForFPSCheck = 3;
 
 SessionRecords::SessionRecords(const int32_t maxNumOfRecords, const double jankCheckTimeFactor)
-    : kMaxNumOfRecords(maxNumOfRecords), kJankCheckTimeFactor(jankCheckTimeFactor) {
-    mRecords.resize(maxNumOfRecords);
-}
+    : kMaxNumOfRecords(maxNumOfRecords),
+      kJankCheckTimeFactor(jankCheckTimeFactor),
+      mDurations(maxNumOfRecords),
+      mStartIntervalsUs(mDurations.capacity()),
+      mFPSJitters(mDurations.capacity()) {}
 
-void SessionRecords::addReportedDurations(const std::vector<WorkDuration> &actualDurationsNs,
+void SessionRecords::addReportedDurations(std::span<const WorkDuration> actualDurationsNs,
                                           int64_t targetDurationNs,
                                           FrameTimingMetrics &newFrameMetrics,
                                           bool computeGameMetrics) {
     for (auto &duration : actualDurationsNs) {
         int32_t totalDurationUs = duration.durationNanos / 1000;
 
-        if (mNumOfFrames >= kMaxNumOfRecords) {
-            // Remove the oldest record when the number of records is greater
-            // than allowed.
-            int32_t indexOfRecordToRemove = (mLatestRecordIndex + 1) % kMaxNumOfRecords;
-            mSumOfDurationsUs -= mRecords[indexOfRecordToRemove].totalDurationUs;
-            if (mRecords[indexOfRecordToRemove].isMissedCycle) {
-                mNumOfMissedCycles--;
-                if (mNumOfMissedCycles < 0) {
-                    LOG(ERROR) << "Invalid number of missed cycles: " << mNumOfMissedCycles;
-                }
-            }
-            if (mRecords[indexOfRecordToRemove].isFPSJitter) {
+        if (mDurations.full()) {
+            // The oldest record is replaced by this one
+            if (mFPSJitters[mDurations.nextSlot()]) {
                 mNumOfFrameFPSJitters--;
                 if (mNumOfFrameFPSJitters < 0) {
                     LOG(ERROR) << "Invalid number of FPS jitter frames: " << mNumOfFrameFPSJitters;
                 }
             }
-            mNumOfFrames--;
-
-            // If the record to be removed is the max duration, pop it out of the
-            // descending dequeue of record indexes.
-            if (mRecordsIndQueue.front() == indexOfRecordToRemove) {
-                mRecordsIndQueue.pop_front();
-            }
         }
 
-        mPreLastRecordIndex = mLatestRecordIndex;
-        mLatestRecordIndex = (mLatestRecordIndex + 1) % kMaxNumOfRecords;
-
         // Track start delay
         auto startTimeNs = duration.timeStampNanos - duration.durationNanos;
         int32_t startIntervalUs = 0;
-        if (mNumOfFrames > 0) {
+        if (mDurations.size() > 0) {
             startIntervalUs = (startTimeNs - mLastStartTimeNs) / 1000;
         }
         mLastStartTimeNs = startTimeNs;
 
+        bool cycleMissed = totalDurationUs > (targetDurationNs / 1000) * kJankCheckTimeFactor;
+        mDurations.push(totalDurationUs, cycleMissed);
+        mPreLastRecordIndex = mLatestRecordIndex;
+        mLatestRecordIndex = mDurations.slotOf(0);
+
         // Track the number of frame FPS jitters.
         // A frame is evaluated as FPS jitter if its startInterval is not less
         // than previous three frames' average startIntervals.
@@ -93,25 +81,17 @@ void SessionRecords::addReportedDurations(const std::vector<WorkDuration> &actua
                     FPSJitter = true;
                     mNumOfFrameFPSJitters++;
                 }
-                int32_t oldRecordIndex = mLatestRecordIndex - kTotalFramesForFPSCheck;
-                if (oldRecordIndex < 0) {
-                    oldRecordIndex += kMaxNumOfRecords;
-                }
                 mLatestStartIntervalSumUs +=
-                        startIntervalUs - mRecords[oldRecordIndex].startIntervalUs;
+                        startIntervalUs -
+                        mStartIntervalsUs[mDurations.slotOf(kTotalFramesForFPSCheck)];
             }
         } else {
             mLatestStartIntervalSumUs = 0;
             mAddedFramesForFPSCheck = 0;
         }
 
-        bool cycleMissed = totalDurationUs > (targetDurationNs / 1000) * kJankCheckTimeFactor;
-        mRecords[mLatestRecordIndex] =
-                CycleRecord{startIntervalUs, totalDurationUs, cycleMissed, FPSJitter};
-        mNumOfFrames++;
-        if (cycleMissed) {
-            mNumOfMissedCycles++;
-        }
+        mStartIntervalsUs[mLatestRecordIndex] = startIntervalUs;
+        mFPSJitters[mLatestRecordIndex] = FPSJitter;
         updateFrameBuckets(totalDurationUs, cycleMissed, newFrameMetrics.framesInBuckets);
         if (computeGameMetrics) {
             /**
@@ -121,65 +101,46 @@ void SessionRecords::addReportedDurations(const std::vector<WorkDuration> &actua
              */
             updateGameMetrics(startIntervalUs, newFrameMetrics.gameFrameMetrics);
         }
-
-        // Pop out the indexes that their related values are not greater than the latest one.
-        while (!mRecordsIndQueue.empty() &&
-               (mRecords[mRecordsIndQueue.back()].totalDurationUs <= totalDurationUs)) {
-            mRecordsIndQueue.pop_back();
-        }
-        mRecordsIndQueue.push_back(mLatestRecordIndex);
-
-        mSumOfDurationsUs += totalDurationUs;
-        mAvgDurationUs = mSumOfDurationsUs / mNumOfFrames;
     }
 }
 
 std::optional<int32_t> SessionRecords::getMaxDuration() {
-    if (mRecordsIndQueue.empty()) {
-        return std::nullopt;
-    }
-    return mRecords[mRecordsIndQueue.front()].totalDurationUs;
+    return mDurations.max();
 }
 
 std::optional<int32_t> SessionRecords::getAvgDuration() {
-    if (mNumOfFrames <= 0) {
-        return std::nullopt;
-    }
-    return mAvgDurationUs;
+    return mDurations.mean();
+}
+
+std::optional<int32_t> SessionRecords::getPercentileDuration(int32_t percent) {
+    return mDurations.percentile(percent);
 }
 
 int32_t SessionRecords::getNumOfRecords() {
-    return mNumOfFrames;
+    return mDurations.size();
 }
 
 int32_t SessionRecords::getNumOfMissedCycles() {
-    return mNumOfMissedCycles;
+    return mDurations.missedCount();
 }
 
 bool SessionRecords::isLowFrameRate(int32_t fpsLowRateThreshold) {
     // Check the last three records. If all of their start delays are larger
     // than the cycle duration threshold, return "true".
     auto cycleDurationThresholdUs = 1000000.0 / fpsLowRateThreshold;
-    if (mNumOfFrames >= 3) {  // Todo: make this number as a tunable config
-        int32_t ind1 = mLatestRecordIndex;
-        int32_t ind2 = ind1 == 0 ? (kMaxNumOfRecords - 1) : (ind1 - 1);
-        int32_t ind3 = ind2 == 0 ? (kMaxNumOfRecords - 1) : (ind2 - 1);
-        return (mRecords[ind1].startIntervalUs >= cycleDurationThresholdUs) &&
-               (mRecords[ind2].startIntervalUs >= cycleDurationThresholdUs) &&
-               (mRecords[ind3].startIntervalUs >= cycleDurationThresholdUs);
+    if (mDurations.size() >= 3) {  // Todo: make this number as a tunable config
+        return (mStartIntervalsUs[mDurations.slotOf(0)] >= cycleDurationThresholdUs) &&
+               (mStartIntervalsUs[mDurations.slotOf(1)] >= cycleDurationThresholdUs) &&
+               (mStartIntervalsUs[mDurations.slotOf(2)] >= cycleDurationThresholdUs);
     }
 
     return false;
 }
 
 void SessionRecords::resetRecords() {
-    mAvgDurationUs = 0;
     mLastStartTimeNs = 0;
     mLatestRecordIndex = -1;
-    mNumOfMissedCycles = 0;
-    mNumOfFrames = 0;
-    mSumOfDurationsUs = 0;
-    mRecordsIndQueue.clear();
+    mDurations.reset();
 }
 
 int32_t SessionRecords::getLatestFPS() const {
@@ -217,16 +178,16 @@ void SessionRecords::updateGameMetrics(int32_t frameIntervalUs, GameFrameMetrics
     auto frameIntervalMs = frameIntervalUs / 1000;
     gameMetrics.frameTimingMs.push_back(frameIntervalMs);
 
-    if (mNumOfFrames > 2) {
+    if (mDurations.size() > 2) {
         gameMetrics.frameTimingDeltaMs.push_back(
-                std::abs(frameIntervalUs - mRecords[mPreLastRecordIndex].startIntervalUs) / 1000);
+                std::abs(frameIntervalUs - mStartIntervalsUs[mPreLastRecordIndex]) / 1000);
     }
     gameMetrics.totalFrameTimeMs += frameIntervalMs;
     gameMetrics.numOfFrames++;
 }
 
 bool SessionRecords::areAllRecordsInitialized() const {
-    return mNumOfFrames >= kMaxNumOfRecords;
+    return mDurations.full();
 }
 
 }  // namespace pixel
@@ -18,11 +18,12 @@
 
 #include <aidl/android/hardware/power/WorkDuration.h>
 
-#include <deque>
 #include <optional>
+#include <span>
 #include <vector>
 
 #include "SessionMetrics.h"
+#include "SlidingWindowStats.h"
 
 namespace aidl {
 namespace google {
@@ -33,23 +34,17 @@ namespace pixel {
 
 using aidl::android::hardware::power::WorkDuration;
 class SessionRecords {
-  public:
-    struct CycleRecord {
-        int32_t startIntervalUs{0};
-        int32_t totalDurationUs{0};
-        bool isMissedCycle{false};
-        bool isFPSJitter{false};
-    };
-
   public:
     SessionRecords(const int32_t maxNumOfRecords, const double jankCheckTimeFactor);
     ~SessionRecords() = default;
 
-    void addReportedDurations(const std::vector<WorkDuration> &actualDurationsNs,
+    void addReportedDurations(std::span<const WorkDuration> actualDurationsNs,
                               int64_t targetDurationNs, FrameTimingMetrics &newFrameMetrics,
                               bool computeGameMetrics = false);
     std::optional<int32_t> getMaxDuration();
     std::optional<int32_t> getAvgDuration();
+    // Approximate percentile of the recorded durations, e.g. 90 for p90
+    std::optional<int32_t> getPercentileDuration(int32_t percent);
     int32_t getNumOfRecords();
     int32_t getNumOfMissedCycles();
     bool isLowFrameRate(int32_t fpsLowRateThreshold);
@@ -67,17 +62,14 @@ class SessionRecords {
 
     const int32_t kMaxNumOfRecords;
     const double kJankCheckTimeFactor;
-    std::vector<CycleRecord> mRecords;
-    // A descending order queue to store the records' indexes.
-    // It is for detecting the maximum duration.
-    std::deque<int32_t> mRecordsIndQueue;
-    int32_t mAvgDurationUs{0};
+    // Total durations and missed cycles of the records
+    SlidingWindowStats mDurations;
+    // Per record data, indexed by the record's slot in mDurations
+    std::vector<int32_t> mStartIntervalsUs;
+    std::vector<uint8_t> mFPSJitters;
     int64_t mLastStartTimeNs{0};
     int32_t mLatestRecordIndex{-1};
     int32_t mPreLastRecordIndex{-1};
-    int32_t mNumOfMissedCycles{0};
-    int32_t mNumOfFrames{0};
-    int64_t mSumOfDurationsUs{0};
 
     // Compute the sum of start interval for the last few frames.
     // It can be beneficial for computing the FPS jitters.
@@ -28,20 +28,27 @@ namespace pixel {
 
 bool SessionTaskMap::add(int64_t sessionId, const SessionValueEntry &sv,
                          const std::vector<pid_t> &taskIds) {
-    if (mSessions.find(sessionId) != mSessions.end()) {
-        return false;
-    }
-
+    std::lock_guard<std::mutex> indexLock(mTaskIndexMutex);
     auto sessValPtr = std::make_shared<SessionValueEntry>();
     (*sessValPtr) = sv;
     sessValPtr->sessionId = sessionId;
+    {
+        Shard &shard = shardOf(sessionId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.sessions.find(sessionId) != shard.sessions.end()) {
+            return false;
+        }
+        auto &sessEntry = shard.sessions[sessionId];
+        sessEntry.val = sessValPtr;
+        sessEntry.linkedTasks = taskIds;
+    }
 
-    auto &sessEntry = mSessions[sessionId];
-    sessEntry.val = sessValPtr;
-    sessEntry.linkedTasks = taskIds;
-
-    for (auto taskId : taskIds) {
-        mTasks[taskId].push_back(sessValPtr);
+    if (!taskIds.empty()) {
+        auto tasks = std::make_shared<TaskIndex>(*mTasks.Load());
+        for (auto taskId : taskIds) {
+            (*tasks)[taskId].push_back(sessValPtr);
+        }
+        mTasks.Store(std::move(tasks));
     }
     return true;
 }
@@ -49,29 +56,24 @@ bool SessionTaskMap::add(int64_t sessionId, const SessionValueEntry &sv,
 void SessionTaskMap::addVote(int64_t sessionId, int voteId, int uclampMin, int uclampMax,
                              std::chrono::steady_clock::time_point startTime,
                              std::chrono::nanoseconds durationNs) {
-    auto sessItr = mSessions.find(sessionId);
-    if (sessItr == mSessions.end()) {
-        return;
-    }
-
-    sessItr->second.val->votes->add(voteId,
-                                    CpuVote(true, startTime, durationNs, uclampMin, uclampMax));
+    withSession(sessionId, [&](SessionValueEntry &sv) {
+        sv.votes->add(voteId, CpuVote(true, startTime, durationNs, uclampMin, uclampMax));
+    });
 }
 
 void SessionTaskMap::addGpuVote(int64_t sessionId, int voteId, Cycles capacity,
                                 std::chrono::steady_clock::time_point startTime,
                                 std::chrono::nanoseconds durationNs) {
-    auto sessItr = mSessions.find(sessionId);
-    if (sessItr == mSessions.end()) {
-        return;
-    }
-
-    sessItr->second.val->votes->add(voteId, GpuVote(true, startTime, durationNs, capacity));
+    withSession(sessionId, [&](SessionValueEntry &sv) {
+        sv.votes->add(voteId, GpuVote(true, startTime, durationNs, capacity));
+    });
 }
 
 std::shared_ptr<SessionValueEntry> SessionTaskMap::findSession(int64_t sessionId) const {
-    auto sessItr = mSessions.find(sessionId);
-    if (sessItr == mSessions.end()) {
+    const Shard &shard = shardOf(sessionId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto sessItr = shard.sessions.find(sessionId);
+    if (sessItr == shard.sessions.end()) {
         return nullptr;
     }
     return sessItr->second.val;
@@ -81,14 +83,17 @@ void SessionTaskMap::getTaskVoteRange(pid_t taskId, std::chrono::steady_clock::t
                                       UclampRange &range,
                                       std::optional<int32_t> &uclampMaxEfficientBase,
                                       std::optional<int32_t> &uclampMaxEfficientOffset) const {
-    auto taskItr = mTasks.find(taskId);
-    if (taskItr == mTasks.end()) {
+    std::shared_ptr<const TaskIndex> tasks = mTasks.Load();
+    auto taskItr = tasks->find(taskId);
+    if (taskItr == tasks->end()) {
         // Assign to default range
         range = {};
         return;
     }
 
     for (const auto &sessInTask : taskItr->second) {
+        // Only the votes need the lock, the index entry itself is immutable
+        std::lock_guard<std::mutex> lock(shardOf(sessInTask->sessionId).mutex);
         if (!sessInTask->isActive) {
             continue;
         }
@@ -105,18 +110,21 @@ void SessionTaskMap::getTaskVoteRange(pid_t taskId, std::chrono::steady_clock::t
 Cycles SessionTaskMap::getSessionsGpuCapacity(
         std::chrono::steady_clock::time_point time_point) const {
     Cycles max(0);
-    for (auto const &[_, session] : mSessions) {
-        max = std::max(max,
-                       session.val->votes->getGpuCapacityRequest(time_point).value_or(Cycles(0)));
+    for (const auto &shard : mShards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto const &[_, session] : shard.sessions) {
+            max = std::max(max, session.val->votes->getGpuCapacityRequest(time_point)
+                                        .value_or(Cycles(0)));
+        }
     }
     return max;
 }
 
 std::vector<int64_t> SessionTaskMap::getSessionIds(pid_t taskId) const {
-    auto itr = mTasks.find(taskId);
-    if (itr == mTasks.end()) {
-        static const std::vector<int64_t> emptySessionIdVec;
-        return emptySessionIdVec;
+    std::shared_ptr<const TaskIndex> tasks = mTasks.Load();
+    auto itr = tasks->find(taskId);
+    if (itr == tasks->end()) {
+        return {};
     }
     std::vector<int64_t> res;
     res.reserve(itr->second.size());
@@ -126,164 +134,203 @@ std::vector<int64_t> SessionTaskMap::getSessionIds(pid_t taskId) const {
     return res;
 }
 
-std::vector<pid_t> &SessionTaskMap::getTaskIds(int64_t sessionId) {
-    auto taskItr = mSessions.find(sessionId);
-    if (taskItr == mSessions.end()) {
-        static std::vector<pid_t> emptyTaskIdVec;
-        return emptyTaskIdVec;
+std::vector<pid_t> SessionTaskMap::getTaskIds(int64_t sessionId) const {
+    const Shard &shard = shardOf(sessionId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto taskItr = shard.sessions.find(sessionId);
+    if (taskItr == shard.sessions.end()) {
+        return {};
     }
     return taskItr->second.linkedTasks;
 }
 
 bool SessionTaskMap::isAnyAppSessionActive(std::chrono::steady_clock::time_point timePoint) const {
-    for (auto &sessionVal : mSessions) {
-        if (!sessionVal.second.val->isAppSession) {
-            continue;
-        }
-        if (!sessionVal.second.val->isActive) {
-            continue;
-        }
-        if (!sessionVal.second.val->votes->allTimedOut(timePoint)) {
-            return true;
+    for (const auto &shard : mShards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto &sessionVal : shard.sessions) {
+            if (!sessionVal.second.val->isAppSession) {
+                continue;
+            }
+            if (!sessionVal.second.val->isActive) {
+                continue;
+            }
+            if (!sessionVal.second.val->votes->allTimedOut(timePoint)) {
+                return true;
+            }
         }
     }
     return false;
 }
 
 bool SessionTaskMap::areAllSessionsTimeout(std::chrono::steady_clock::time_point timePoint) const {
-    for (auto &sessionVal : mSessions) {
-        if (!sessionVal.second.val->votes->allTimedOut(timePoint)) {
-            return false;
+    for (const auto &shard : mShards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto &sessionVal : shard.sessions) {
+            if (!sessionVal.second.val->votes->allTimedOut(timePoint)) {
+                return false;
+            }
         }
     }
     return true;
 }
 
-bool SessionTaskMap::remove(int64_t sessionId) {
-    auto sessItr = mSessions.find(sessionId);
-    if (sessItr == mSessions.end()) {
-        return false;
-    }
-
+void SessionTaskMap::unlinkTasks(TaskIndex *tasks, const std::shared_ptr<SessionValueEntry> &val,
+                                 const std::vector<pid_t> &taskIds) {
     // For each task id in linked tasks need to remove the corresponding
     // task to session mapping in the task map
-    for (const auto taskId : sessItr->second.linkedTasks) {
-        // Used linked task ids to cleanup
-        auto taskItr = mTasks.find(taskId);
-        if (taskItr == mTasks.end()) {
+    for (const auto taskId : taskIds) {
+        auto taskItr = tasks->find(taskId);
+        if (taskItr == tasks->end()) {
             // Inconsisent state
             continue;
         }
 
-        // Now lookup session id in task's set
-        auto taskSessItr =
-                std::find(taskItr->second.begin(), taskItr->second.end(), sessItr->second.val);
+        // Now lookup session in task's set
+        auto taskSessItr = std::find(taskItr->second.begin(), taskItr->second.end(), val);
         if (taskSessItr == taskItr->second.end()) {
             // Should not happen
             continue;
         }
 
-        // Remove session id from task map
+        // Remove session from task map
         taskItr->second.erase(taskSessItr);
         if (taskItr->second.empty()) {
-            mTasks.erase(taskItr);
+            tasks->erase(taskItr);
+        }
+    }
+}
+
+bool SessionTaskMap::remove(int64_t sessionId) {
+    std::lock_guard<std::mutex> indexLock(mTaskIndexMutex);
+    ValEntry entry;
+    {
+        Shard &shard = shardOf(sessionId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto sessItr = shard.sessions.find(sessionId);
+        if (sessItr == shard.sessions.end()) {
+            return false;
         }
+        entry = std::move(sessItr->second);
+        shard.sessions.erase(sessItr);
     }
 
-    // Now we can safely remove session entirely since there are no more
-    // mappings in task to session id
-    mSessions.erase(sessItr);
+    if (!entry.linkedTasks.empty()) {
+        auto tasks = std::make_shared<TaskIndex>(*mTasks.Load());
+        unlinkTasks(tasks.get(), entry.val, entry.linkedTasks);
+        mTasks.Store(std::move(tasks));
+    }
     return true;
 }
 
 bool SessionTaskMap::removeDeadTaskSessionMap(int64_t sessionId, pid_t taskId) {
-    auto sessItr = mSessions.find(sessionId);
-    if (sessItr == mSessions.end()) {
-        return false;
+    std::lock_guard<std::mutex> indexLock(mTaskIndexMutex);
+    std::shared_ptr<SessionValueEntry> sessValPtr;
+    {
+        Shard &shard = shardOf(sessionId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto sessItr = shard.sessions.find(sessionId);
+        if (sessItr == shard.sessions.end()) {
+            return false;
+        }
+        auto &linkedTasks = sessItr->second.linkedTasks;
+        linkedTasks.erase(std::remove(linkedTasks.begin(), linkedTasks.end(), taskId),
+                          linkedTasks.end());
+        sessValPtr = sessItr->second.val;
     }
 
-    auto taskItr = mTasks.find(taskId);
-    if (taskItr == mTasks.end()) {
+    std::shared_ptr<const TaskIndex> current = mTasks.Load();
+    auto taskItr = current->find(taskId);
+    if (taskItr == current->end()) {
         // Inconsisent state
         return false;
     }
-
-    // Now lookup session id in task's set
-    auto taskSessItr =
-            std::find(taskItr->second.begin(), taskItr->second.end(), sessItr->second.val);
-    if (taskSessItr == taskItr->second.end()) {
+    if (std::find(taskItr->second.begin(), taskItr->second.end(), sessValPtr) ==
+        taskItr->second.end()) {
         // Should not happen
         return false;
     }
 
-    // Remove session id from task map
-    taskItr->second.erase(taskSessItr);
-    if (taskItr->second.empty()) {
-        mTasks.erase(taskItr);
-    }
-
+    auto tasks = std::make_shared<TaskIndex>(*current);
+    unlinkTasks(tasks.get(), sessValPtr, {taskId});
+    mTasks.Store(std::move(tasks));
     return true;
 }
 
 bool SessionTaskMap::replace(int64_t sessionId, const std::vector<pid_t> &taskIds,
                              std::vector<pid_t> *addedThreads, std::vector<pid_t> *removedThreads) {
-    auto itr = mSessions.find(sessionId);
-    if (itr == mSessions.end()) {
-        return false;
+    std::lock_guard<std::mutex> indexLock(mTaskIndexMutex);
+    std::shared_ptr<SessionValueEntry> sessValPtr;
+    std::vector<pid_t> previousTaskIds;
+    {
+        Shard &shard = shardOf(sessionId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto itr = shard.sessions.find(sessionId);
+        if (itr == shard.sessions.end()) {
+            return false;
+        }
+        sessValPtr = itr->second.val;
+        previousTaskIds = std::move(itr->second.linkedTasks);
+        itr->second.linkedTasks = taskIds;
     }
 
-    // Make copies of val and threads
-    auto svTmp = itr->second.val;
-    const auto previousTaskIds = itr->second.linkedTasks;
-
+    std::shared_ptr<const TaskIndex> current = mTasks.Load();
     // Determine newly added threads
     if (addedThreads) {
         for (auto tid : taskIds) {
-            auto taskSessItr = mTasks.find(tid);
-            if (taskSessItr == mTasks.end()) {
+            if (current->find(tid) == current->end()) {
                 addedThreads->push_back(tid);
             }
         }
     }
 
-    // Remove session from mappings
-    remove(sessionId);
-    // Add session value and task mappings
-    add(sessionId, *svTmp, taskIds);
+    // Relink session in a copy of the index
+    auto tasks = std::make_shared<TaskIndex>(*current);
+    unlinkTasks(tasks.get(), sessValPtr, previousTaskIds);
+    for (auto tid : taskIds) {
+        (*tasks)[tid].push_back(sessValPtr);
+    }
 
     // Determine completely removed threads
     if (removedThreads) {
         for (auto tid : previousTaskIds) {
-            auto taskSessItr = mTasks.find(tid);
-            if (taskSessItr == mTasks.end()) {
+            if (tasks->find(tid) == tasks->end()) {
                 removedThreads->push_back(tid);
             }
         }
     }
 
+    mTasks.Store(std::move(tasks));
     return true;
 }
 
 size_t SessionTaskMap::sizeSessions() const {
-    return mSessions.size();
+    size_t size = 0;
+    for (const auto &shard : mShards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size += shard.sessions.size();
+    }
+    return size;
 }
 
 size_t SessionTaskMap::sizeTasks() const {
-    return mTasks.size();
+    return mTasks.Load()->size();
 }
 
-const std::string &SessionTaskMap::idString(int64_t sessionId) const {
-    auto sessItr = mSessions.find(sessionId);
-    if (sessItr == mSessions.end()) {
-        static const std::string emptyString;
-        return emptyString;
+std::string SessionTaskMap::idString(int64_t sessionId) const {
+    const Shard &shard = shardOf(sessionId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto sessItr = shard.sessions.find(sessionId);
+    if (sessItr == shard.sessions.end()) {
+        return {};
     }
     return sessItr->second.val->idString;
 }
 
 bool SessionTaskMap::isAppSession(int64_t sessionId) const {
-    auto sessItr = mSessions.find(sessionId);
-    if (sessItr == mSessions.end()) {
+    const Shard &shard = shardOf(sessionId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto sessItr = shard.sessions.find(sessionId);
+    if (sessItr == shard.sessions.end()) {
         return false;
     }
 
@@ -16,6 +16,11 @@
 
 #pragma once
 
+#include <android-base/thread_annotations.h>
+#include <perfmgr/RcuPtr.h>
+
+#include <array>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
@@ -40,9 +45,19 @@ namespace pixel {
  *  Tasks[tid1] -> [sid1]
  *  Tasks[tid2] -> [sid1, sid2]
  *  Tasks[tid3] -> [sid2]
+ *
+ * The map is thread safe. Sessions are spread over kShardCount shards by id and
+ * a session's value and linked tasks are guarded by its shard's lock, so
+ * unrelated sessions rarely contend. The task to session index only changes
+ * when threads are added or removed; it is copied on write and read without
+ * locking. No method holds more than one shard lock at a time, and callbacks
+ * run under the lock of the shard of the session they are given, so they must
+ * not call back into methods that lock a session.
  */
 class SessionTaskMap {
   public:
+    static constexpr size_t kShardCount = 16;
+
     // Add a session with associated tasks to mapping
     bool add(int64_t sessionId, const SessionValueEntry &sv, const std::vector<pid_t> &taskIds);
 
@@ -54,9 +69,24 @@ class SessionTaskMap {
                     std::chrono::steady_clock::time_point startTime,
                     std::chrono::nanoseconds durationNs);
 
-    // Find session id and run callback on session value, linked tasks
+    // Find session id and return its value. The value is shared with the map,
+    // use withSession() to access it while other threads may update it.
     std::shared_ptr<SessionValueEntry> findSession(int64_t sessionId) const;
 
+    // Run fn on the session value under its shard lock. Return false if the
+    // session does not exist.
+    template <typename FN>
+    bool withSession(int64_t sessionId, FN fn) {
+        Shard &shard = shardOf(sessionId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto sessItr = shard.sessions.find(sessionId);
+        if (sessItr == shard.sessions.end()) {
+            return false;
+        }
+        fn(*(sessItr->second.val));
+        return true;
+    }
+
     void getTaskVoteRange(pid_t taskId, std::chrono::steady_clock::time_point timeNow,
                           UclampRange &range, std::optional<int32_t> &uclampMaxEfficientBase,
                           std::optional<int32_t> &uclampMaxEfficientOffset) const;
@@ -65,8 +95,8 @@ class SessionTaskMap {
     // Find session ids given a task id if it exists
     std::vector<int64_t> getSessionIds(pid_t taskId) const;
 
-    // Get a vec of tasks associated with a session
-    std::vector<pid_t> &getTaskIds(int64_t sessionId);
+    // Get a copy of the tasks associated with a session
+    std::vector<pid_t> getTaskIds(int64_t sessionId) const;
 
     // Return true if any app session is active, false otherwise
     bool isAnyAppSessionActive(std::chrono::steady_clock::time_point timePoint) const;
@@ -88,13 +118,16 @@ class SessionTaskMap {
     // Given task id, for each linked-to session id call fn
     template <typename FN>
     void forEachSessionInTask(pid_t taskId, FN fn) const {
-        auto taskSessItr = mTasks.find(taskId);
-        if (taskSessItr == mTasks.end()) {
+        std::shared_ptr<const TaskIndex> tasks = mTasks.Load();
+        auto taskSessItr = tasks->find(taskId);
+        if (taskSessItr == tasks->end()) {
             return;
         }
         for (const auto &session : taskSessItr->second) {
-            auto sessionItr = mSessions.find(session->sessionId);
-            if (sessionItr == mSessions.end()) {
+            const Shard &shard = shardOf(session->sessionId);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto sessionItr = shard.sessions.find(session->sessionId);
+            if (sessionItr == shard.sessions.end()) {
                 continue;
             }
             fn(sessionItr->first, *(sessionItr->second.val));
@@ -105,18 +138,21 @@ class SessionTaskMap {
     // fn takes int64_t session id, session entry val, linked task ids
     template <typename FN>
     void forEachSessionValTasks(FN fn) const {
-        for (const auto &e : mSessions) {
-            fn(e.first, *(e.second.val), e.second.linkedTasks);
+        for (const auto &shard : mShards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (const auto &e : shard.sessions) {
+                fn(e.first, *(e.second.val), e.second.linkedTasks);
+            }
         }
     }
 
     // Returns string id of session
-    const std::string &idString(int64_t sessionId) const;
+    std::string idString(int64_t sessionId) const;
 
     // Returns true if session id is an app session id
     bool isAppSession(int64_t sessionId) const;
 
-    // Remove dead task-session map entry
+    // Remove dead task from the session and the task-session map
     bool removeDeadTaskSessionMap(int64_t sessionId, pid_t taskId);
 
   private:
@@ -125,10 +161,29 @@ class SessionTaskMap {
         std::shared_ptr<SessionValueEntry> val;
         std::vector<pid_t> linkedTasks;
     };
-    // Map session id to value
-    std::unordered_map<int64_t, ValEntry> mSessions;
-    // Map task id to set of session ids
-    std::unordered_map<pid_t, std::vector<std::shared_ptr<SessionValueEntry>>> mTasks;
+    struct Shard {
+        mutable std::mutex mutex;
+        // Map session id to value
+        std::unordered_map<int64_t, ValEntry> sessions GUARDED_BY(mutex);
+    };
+    // Map task id to set of sessions
+    using TaskIndex = std::unordered_map<pid_t, std::vector<std::shared_ptr<SessionValueEntry>>>;
+
+    Shard &shardOf(int64_t sessionId) {
+        return mShards[static_cast<uint64_t>(sessionId) % kShardCount];
+    }
+    const Shard &shardOf(int64_t sessionId) const {
+        return mShards[static_cast<uint64_t>(sessionId) % kShardCount];
+    }
+    // Unlink session value from tasks in the index
+    static void unlinkTasks(TaskIndex *tasks, const std::shared_ptr<SessionValueEntry> &val,
+                            const std::vector<pid_t> &taskIds);
+
+    std::array<Shard, kShardCount> mShards;
+    // Serializes updates of the task index and the linked tasks of sessions.
+    // Taken before any shard lock.
+    std::mutex mTaskIndexMutex;
+    ::android::perfmgr::RcuPtr<const TaskIndex> mTasks{std::make_shared<const TaskIndex>()};
 };
 
 }  // namespace pixel
@@ -49,6 +49,9 @@ std::ostream &SessionValueEntry::dump(std::ostream &os) const {
        << "%-" << totalFrames << ", ";
     os << sessFrameBuckets.toString() << ", ";
     os << "Ramup boost active: " << rampupBoostActive << ", ";
+    if (sessionTrace) {
+        os << "Events recorded: " << sessionTrace->events.recorded() << ", ";
+    }
 
     return os;
 }
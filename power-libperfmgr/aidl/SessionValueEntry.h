@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <array>
 #include <ostream>
 
 #include "AdpfTypes.h"
@@ -59,6 +60,8 @@ struct SessionValueEntry {
     HeurBoostStatistics hBoostModeDist;
     bool rampupBoostActive{false};
     std::optional<SessionMetrics> sessFrameMetrics;
+    // Pending timeout per vote type on the session timeout worker
+    std::array<TimerHandle, static_cast<int32_t>(AdpfVoteType::VOTE_TYPE_SIZE)> voteTimers{};
 
     // Write info about power session to ostream for logging and debugging
     std::ostream &dump(std::ostream &os) const;
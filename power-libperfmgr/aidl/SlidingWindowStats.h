@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+// Statistics over the last `capacity` samples of a stream of non-negative
+// values. Max, mean and the missed count are exact. Percentiles come from a
+// log-linear histogram of the window, so they are within one bucket (at most
+// 25% above the true value) and cost a fixed number of steps. Pushing a sample
+// is O(1) amortized and never allocates.
+//
+// Samples are stored as parallel arrays indexed by slot, so callers can keep
+// their own per-sample data in arrays indexed by the same slots.
+class SlidingWindowStats {
+  public:
+    explicit SlidingWindowStats(int32_t capacity)
+        : mCapacity(std::max(capacity, 1)),
+          mValues(mCapacity),
+          mMissed(mCapacity),
+          mMaxQueue(mCapacity) {}
+
+    // Slot the next push() writes to, and evicts from when full()
+    int32_t nextSlot() const { return (mLatestSlot + 1) % mCapacity; }
+    // Slot of the sample pushed `age` pushes ago, -1 if there is no such slot
+    // yet. Slots keep their old contents after reset().
+    int32_t slotOf(int32_t age) const {
+        if (mLatestSlot < 0) {
+            return -1;
+        }
+        return ((mLatestSlot - age) % mCapacity + mCapacity) % mCapacity;
+    }
+
+    void push(int32_t value, bool missed) {
+        const int32_t slot = nextSlot();
+        if (full()) {
+            evict(slot);
+        }
+        mLatestSlot = slot;
+        mValues[slot] = value;
+        mMissed[slot] = missed;
+        mSize++;
+        mSum += value;
+        mMissedCount += missed;
+        mBuckets[bucketOf(value)]++;
+
+        // Keep the queue descending, so its front is the max of the window
+        while (mMaxCount > 0 && mValues[mMaxQueue[queueSlot(mMaxCount - 1)]] <= value) {
+            mMaxCount--;
+        }
+        mMaxQueue[queueSlot(mMaxCount)] = slot;
+        mMaxCount++;
+    }
+
+    void reset() {
+        mLatestSlot = -1;
+        mSize = 0;
+        mSum = 0;
+        mMissedCount = 0;
+        mMaxHead = 0;
+        mMaxCount = 0;
+        mBuckets.fill(0);
+    }
+
+    int32_t capacity() const { return mCapacity; }
+    int32_t size() const { return mSize; }
+    bool full() const { return mSize >= mCapacity; }
+    int32_t missedCount() const { return mMissedCount; }
+    int32_t value(int32_t slot) const { return mValues[slot]; }
+
+    std::optional<int32_t> max() const {
+        if (mMaxCount == 0) {
+            return std::nullopt;
+        }
+        return mValues[mMaxQueue[mMaxHead]];
+    }
+
+    std::optional<int32_t> mean() const {
+        if (mSize == 0) {
+            return std::nullopt;
+        }
+        return static_cast<int32_t>(mSum / mSize);
+    }
+
+    // Smallest bucket bound that at least `percent` of the window is at or
+    // below, capped by the window max
+    std::optional<int32_t> percentile(int32_t percent) const {
+        if (mSize == 0) {
+            return std::nullopt;
+        }
+        const int64_t rank = std::max<int64_t>(
+                1, (static_cast<int64_t>(std::clamp(percent, 0, 100)) * mSize + 99) / 100);
+        int64_t seen = 0;
+        for (size_t bucket = 0; bucket < kNumBuckets; bucket++) {
+            seen += mBuckets[bucket];
+            if (seen >= rank) {
+                return std::min(bucketMax(bucket), *max());
+            }
+        }
+        return max();
+    }
+
+  private:
+    // Every power of two is split into kSubBuckets linear buckets
+    static constexpr uint32_t kSubBucketBits = 2;
+    static constexpr uint32_t kSubBuckets = 1 << kSubBucketBits;
+    static constexpr size_t kNumBuckets = (32 - kSubBucketBits) * kSubBuckets;
+
+    static size_t bucketOf(int32_t value) {
+        const uint32_t v = static_cast<uint32_t>(std::max(value, 0));
+        if (v < kSubBuckets) {
+            return v;
+        }
+        const uint32_t msb = std::bit_width(v) - 1;
+        const uint32_t sub = (v >> (msb - kSubBucketBits)) & (kSubBuckets - 1);
+        return (msb - kSubBucketBits + 1) * kSubBuckets + sub;
+    }
+
+    static int32_t bucketMax(size_t bucket) {
+        if (bucket < kSubBuckets) {
+            return static_cast<int32_t>(bucket);
+        }
+        const uint32_t shift = bucket / kSubBuckets - 1;
+        const uint64_t low = (kSubBuckets + bucket % kSubBuckets) << shift;
+        return static_cast<int32_t>(std::min<uint64_t>(low + (uint64_t{1} << shift) - 1,
+                                                       INT32_MAX));
+    }
+
+    int32_t queueSlot(int32_t i) const { return (mMaxHead + i) % mCapacity; }
+
+    void evict(int32_t slot) {
+        mSize--;
+        mSum -= mValues[slot];
+        mMissedCount -= mMissed[slot];
+        mBuckets[bucketOf(mValues[slot])]--;
+        if (mMaxCount > 0 && mMaxQueue[mMaxHead] == slot) {
+            mMaxHead = (mMaxHead + 1) % mCapacity;
+            mMaxCount--;
+        }
+    }
+
+    const int32_t mCapacity;
+    std::vector<int32_t> mValues;
+    std::vector<uint8_t> mMissed;
+    // Ring of slots whose values are descending, for the window max
+    std::vector<int32_t> mMaxQueue;
+    int32_t mMaxHead{0};
+    int32_t mMaxCount{0};
+    std::array<int32_t, kNumBuckets> mBuckets{};
+    int32_t mLatestSlot{-1};
+    int32_t mSize{0};
+    int64_t mSum{0};
+    int32_t mMissedCount{0};
+};
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+// SpikePredictor watches the reported durations of a session for heavy frames
+// that repeat with a stable period, e.g. a game doing physics every 4th frame,
+// and predicts when the next one is due so it can be boosted ahead of time.
+// The period and its jitter are exponentially weighted averages of the
+// distance between heavy frames. Like PidEngine it does not allocate, log or
+// trace, so recorded traces can be replayed through it.
+class SpikePredictor {
+  public:
+    // Weight of the newest interval in the period and jitter averages
+    static constexpr double kAlpha = 0.25;
+    // Heavy frames needed before the period is trusted
+    static constexpr int32_t kMinSpikes = 3;
+    // Periods of a single frame are just a heavy workload, not spikes
+    static constexpr double kMinPeriod = 2.0;
+    // The jitter must stay within this fraction of the period, and at most
+    // half a frame off for short periods
+    static constexpr double kMaxJitterRatio = 0.15;
+
+    // samples are WorkDuration like structs with durationNanos,
+    // cpuDurationNanos and gpuDurationNanos. Frames longer than heavyNs are
+    // heavy. Returns true if a heavy frame is predicted within the next batch,
+    // assuming it has as many frames as this one.
+    template <typename Sample>
+    bool update(const Sample *samples, size_t count, int64_t heavyNs) {
+        for (size_t i = 0; i < count; i++) {
+            const bool heavy = samples[i].durationNanos > heavyNs;
+            addFrame(heavy);
+            if (heavy) {
+                addHeavyTimings(samples[i].durationNanos, samples[i].cpuDurationNanos,
+                                samples[i].gpuDurationNanos);
+            }
+        }
+        mPredictedHit = false;
+        if (isHeavyFrameDue(static_cast<int64_t>(count))) {
+            mPredictedStart = mFrame;
+            mPredictedEnd = mFrame + static_cast<int64_t>(count);
+            return true;
+        }
+        mPredictedStart = mPredictedEnd = -1;
+        return false;
+    }
+
+    void reset() {
+        mFrame = 0;
+        mLastHeavy = -1;
+        mSpikes = 0;
+        mPeriod = 0;
+        mJitter = 0;
+        mPredictedStart = mPredictedEnd = -1;
+        mPredictedHit = false;
+    }
+
+    // Average timings of recent heavy frames, to size a boost for the next one
+    int64_t heavyDurationNs() const { return mHeavyNs; }
+    int64_t heavyCpuDurationNs() const { return mHeavyCpuNs; }
+    int64_t heavyGpuDurationNs() const { return mHeavyGpuNs; }
+    double period() const { return mPeriod; }
+    // Predicted batches that had a heavy frame
+    uint64_t hits() const { return mHits; }
+    // Predicted batches that had no heavy frame
+    uint64_t misses() const { return mMisses; }
+    // Heavy frames that were not predicted
+    uint64_t unpredicted() const { return mUnpredicted; }
+
+    void dump(std::ostream &os) const {
+        os << "Predict.Period.Hit.Miss.Unpredicted(" << mPeriod << ", " << mHits << ", "
+           << mMisses << ", " << mUnpredicted << ")";
+    }
+
+  private:
+    static int64_t average(int64_t avg, int64_t sample) {
+        return avg + static_cast<int64_t>(kAlpha * (sample - avg));
+    }
+
+    void addFrame(bool heavy) {
+        const int64_t frame = mFrame++;
+        if (frame >= mPredictedStart && frame < mPredictedEnd) {
+            if (heavy && !mPredictedHit) {
+                mHits++;
+                mPredictedHit = true;
+            } else if (frame == mPredictedEnd - 1 && !mPredictedHit) {
+                mMisses++;
+            }
+        } else if (heavy) {
+            mUnpredicted++;
+        }
+
+        if (!heavy) {
+            // The pattern is gone once a spike is well overdue
+            if (mSpikes > 1 && frame - mLastHeavy > 2 * mPeriod + 1) {
+                mSpikes = 1;
+            }
+            return;
+        }
+        if (mSpikes == 1) {
+            mPeriod = frame - mLastHeavy;
+            mJitter = 0;
+        } else if (mSpikes > 1) {
+            const double interval = frame - mLastHeavy;
+            mJitter += kAlpha * (std::abs(interval - mPeriod) - mJitter);
+            mPeriod += kAlpha * (interval - mPeriod);
+        }
+        mSpikes++;
+        mLastHeavy = frame;
+    }
+
+    void addHeavyTimings(int64_t durationNs, int64_t cpuDurationNs, int64_t gpuDurationNs) {
+        if (mSpikes == 1) {
+            mHeavyNs = durationNs;
+            mHeavyCpuNs = cpuDurationNs;
+            mHeavyGpuNs = gpuDurationNs;
+            return;
+        }
+        mHeavyNs = average(mHeavyNs, durationNs);
+        mHeavyCpuNs = average(mHeavyCpuNs, cpuDurationNs);
+        mHeavyGpuNs = average(mHeavyGpuNs, gpuDurationNs);
+    }
+
+    bool isHeavyFrameDue(int64_t batchSize) const {
+        if (mSpikes < kMinSpikes || mPeriod < kMinPeriod ||
+            mJitter > std::max(0.5, mPeriod * kMaxJitterRatio)) {
+            return false;
+        }
+        const int64_t due = std::llround(mLastHeavy + mPeriod);
+        return due >= mFrame && due < mFrame + batchSize;
+    }
+
+    // Index of the next frame to be reported
+    int64_t mFrame{0};
+    int64_t mLastHeavy{-1};
+    int32_t mSpikes{0};
+    // Average and mean deviation of the frames between heavy frames
+    double mPeriod{0};
+    double mJitter{0};
+    int64_t mHeavyNs{0};
+    int64_t mHeavyCpuNs{0};
+    int64_t mHeavyGpuNs{0};
+    // Frames of the batch predicted to have a heavy frame
+    int64_t mPredictedStart{-1};
+    int64_t mPredictedEnd{-1};
+    bool mPredictedHit{false};
+    uint64_t mHits{0};
+    uint64_t mMisses{0};
+    uint64_t mUnpredicted{0};
+};
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
@@ -70,6 +70,19 @@ std::optional<Cycles> Votes::getGpuCapacityRequest(std::chrono::steady_clock::ti
     return res;
 }
 
+std::optional<std::chrono::steady_clock::time_point> Votes::getGpuCapacityDeadline(
+        std::chrono::steady_clock::time_point t) const {
+    std::optional<std::chrono::steady_clock::time_point> res = std::nullopt;
+    for (auto const hint : {AdpfVoteType::GPU_CAPACITY, AdpfVoteType::GPU_LOAD_UP}) {
+        auto it = mGpuVotes.find(static_cast<int>(hint));
+        if (it != mGpuVotes.end() && it->second.isTimeInRange(t)) {
+            auto const end = it->second.startTime() + it->second.durationNs();
+            res = res ? std::min(*res, end) : end;
+        }
+    }
+    return res;
+}
+
 void Votes::add(int id, GpuVote const &vote) {
     if (isGpuVote(id)) {
         mGpuVotes[id] = vote;
@@ -122,6 +122,9 @@ class Votes {
     void getUclampRange(UclampRange &uclampRange, std::chrono::steady_clock::time_point t) const;
 
     std::optional<Cycles> getGpuCapacityRequest(std::chrono::steady_clock::time_point t) const;
+    // The earliest end of the votes making up the GPU capacity request at t
+    std::optional<std::chrono::steady_clock::time_point> getGpuCapacityDeadline(
+            std::chrono::steady_clock::time_point t) const;
     // Return true if any vote has timed out, otherwise return false
     bool anyTimedOut(std::chrono::steady_clock::time_point t) const;
 
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "aidl/BackgroundWorker.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+using std::literals::chrono_literals::operator""ms;
+
+constexpr int kNumSessions = 100;
+constexpr std::chrono::nanoseconds kFramePeriod120Hz(8333333);
+// Vote timeouts are a couple of frames past the report that armed them
+constexpr std::chrono::nanoseconds kVoteTimeout = 2 * kFramePeriod120Hz;
+
+// 100 sessions re-arming their vote timeout every 120 Hz frame, on simulated
+// time so only the wheel itself is measured. One iteration is one frame.
+static void BM_TimerWheelRearm120Hz(benchmark::State &state) {
+    auto now = std::chrono::steady_clock::now();
+    TimerWheel wheel(now);
+    std::vector<TimerHandle> timers(kNumSessions, kInvalidTimerHandle);
+    std::vector<TimerWheel::Expired> expired;
+    for (auto _ : state) {
+        now += kFramePeriod120Hz;
+        for (int i = 0; i < kNumSessions; i++) {
+            if (!wheel.rearm(timers[i], now + kVoteTimeout)) {
+                timers[i] = wheel.arm(now + kVoteTimeout, 1, i);
+            }
+        }
+        expired.clear();
+        wheel.advance(now, &expired);
+        benchmark::DoNotOptimize(expired.data());
+    }
+    state.SetItemsProcessed(state.iterations() * kNumSessions);
+}
+BENCHMARK(BM_TimerWheelRearm120Hz);
+
+// Same load through the worker pool, so the cost includes the lock and the
+// wakeups a re-arm can cause on the worker thread.
+static void BM_PriorityQueueWorkerReschedule120Hz(benchmark::State &state) {
+    auto pool = std::make_shared<PriorityQueueWorkerPool>(1, "adpf_bench");
+    TemplatePriorityQueueWorker<int> worker([](int session) { benchmark::DoNotOptimize(session); },
+                                            pool);
+    std::vector<TimerHandle> timers(kNumSessions, kInvalidTimerHandle);
+    for (auto _ : state) {
+        const auto deadline = std::chrono::steady_clock::now() + kVoteTimeout;
+        for (int i = 0; i < kNumSessions; i++) {
+            if (!worker.reschedule(timers[i], i, deadline)) {
+                timers[i] = worker.schedule(i, deadline);
+            }
+        }
+    }
+    for (auto timer : timers) {
+        worker.cancel(timer);
+    }
+    state.SetItemsProcessed(state.iterations() * kNumSessions);
+}
+BENCHMARK(BM_PriorityQueueWorkerReschedule120Hz);
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "aidl/PidEngine.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+static PidParams benchParams(uint64_t samplingWindow) {
+    PidParams params;
+    params.targetNs = 16666666;
+    params.dt = params.targetNs / PidParams::kErrorUnitNs;
+    params.outlierNs = params.targetNs * PidParams::kOutlierTargetFactor;
+    params.integralHigh = 512;
+    params.integralLow = -30;
+    params.samplingWindowP = samplingWindow;
+    params.samplingWindowI = samplingWindow;
+    params.samplingWindowD = samplingWindow;
+    params.pidPo = 2.0;
+    params.pidI = 0.001;
+    params.pidDo = 500.0;
+    params.pidDu = 0.0;
+    return params;
+}
+
+// Args: batch size, sampling window (0 covers the whole batch).
+static void BM_PidEngineUpdate(benchmark::State &state) {
+    const PidParams params = benchParams(state.range(1));
+    std::mt19937_64 rng(0);
+    std::uniform_int_distribution<int64_t> duration(params.targetNs / 2, params.targetNs * 2);
+    std::vector<int64_t> durations(state.range(0));
+    for (auto &d : durations) {
+        d = duration(rng);
+    }
+    int64_t integral = 0, previous = 0;
+    for (auto _ : state) {
+        PidOutput out = PidEngine::update(params, durations.data(), durations.size(), 1.0,
+                                          &integral, &previous);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations() * durations.size());
+}
+BENCHMARK(BM_PidEngineUpdate)->ArgsProduct({benchmark::CreateRange(1, 64, 2), {0, 1}});
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
+
+BENCHMARK_MAIN();
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "aidl/SessionTaskMap.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+using std::literals::chrono_literals::operator""ms;
+
+constexpr int kNumSessions = 64;
+constexpr int kTasksPerSession = 4;
+// Tasks shared by every session, e.g. a RenderThread hinted by several apps
+constexpr pid_t kSharedTask = 1;
+constexpr std::chrono::nanoseconds kReportPeriod120Hz(8333333);
+
+static std::unique_ptr<SessionTaskMap> gMap;
+// Stands in for the global mSessionTaskMapMutex the map used to need
+static std::mutex gGlobalMutex;
+
+static void setUpSessions() {
+    gMap = std::make_unique<SessionTaskMap>();
+    for (int i = 0; i < kNumSessions; i++) {
+        SessionValueEntry sv;
+        sv.isActive = true;
+        sv.isAppSession = true;
+        sv.lastUpdatedTime = std::chrono::steady_clock::now();
+        sv.votes = std::make_shared<Votes>();
+        std::vector<pid_t> tasks{kSharedTask};
+        for (int t = 0; t < kTasksPerSession; t++) {
+            tasks.push_back(1000 + i * kTasksPerSession + t);
+        }
+        gMap->add(i, sv, tasks);
+    }
+}
+
+// The map side of PowerSessionManager::voteSet(): record the vote, then
+// resolve the uclamp range of every task linked to the session.
+static void reportOnce(int64_t sessionId, int uclampMin) {
+    const auto tNow = std::chrono::steady_clock::now();
+    std::optional<int32_t> efficiencyParam;
+    gMap->withSession(sessionId, [&](SessionValueEntry &sv) {
+        sv.votes->add(1, CpuVote(true, tNow, 16ms, uclampMin, kUclampMax));
+        sv.lastUpdatedTime = tNow;
+    });
+    for (auto tid : gMap->getTaskIds(sessionId)) {
+        UclampRange range;
+        gMap->getTaskVoteRange(tid, tNow, range, efficiencyParam, efficiencyParam);
+        benchmark::DoNotOptimize(range);
+    }
+}
+
+static void report(int64_t sessionId, int uclampMin, bool globalLock) {
+    if (globalLock) {
+        std::lock_guard<std::mutex> lock(gGlobalMutex);
+        reportOnce(sessionId, uclampMin);
+    } else {
+        reportOnce(sessionId, uclampMin);
+    }
+}
+
+// Back-to-back reports, one session per thread. Arg: 1 serializes every
+// report on a single global lock as a baseline.
+static void BM_SessionTaskMapReport(benchmark::State &state) {
+    if (state.thread_index() == 0) {
+        setUpSessions();
+    }
+    const int64_t sessionId = state.thread_index() % kNumSessions;
+    int uclampMin = 0;
+    for (auto _ : state) {
+        report(sessionId, ++uclampMin % kUclampMax, state.range(0));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SessionTaskMapReport)->Arg(0)->Arg(1)->ThreadRange(1, kNumSessions)->UseRealTime();
+
+// 64 sessions each reporting at 120 Hz; only the report itself is timed, so
+// the result is the per-frame latency a session sees under that load.
+static void BM_SessionTaskMapReport120Hz(benchmark::State &state) {
+    if (state.thread_index() == 0) {
+        setUpSessions();
+    }
+    const int64_t sessionId = state.thread_index();
+    int uclampMin = 0;
+    auto deadline = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        deadline += kReportPeriod120Hz;
+        std::this_thread::sleep_until(deadline);
+        const auto start = std::chrono::steady_clock::now();
+        report(sessionId, ++uclampMin % kUclampMax, state.range(0));
+        state.SetIterationTime(
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SessionTaskMapReport120Hz)
+        ->Arg(0)
+        ->Arg(1)
+        ->Threads(kNumSessions)
+        ->Iterations(120)
+        ->UseManualTime();
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
@@ -29,9 +29,11 @@
 #include "MetricUploader.h"
 #include "Power.h"
 #include "PowerExt.h"
+#include "disp-power/DisplayEventLoop.h"
 #include "disp-power/DisplayLowPower.h"
 #include "utils/ThermalStateListener.h"
 
+using aidl::google::hardware::power::impl::pixel::DisplayEventLoop;
 using aidl::google::hardware::power::impl::pixel::DisplayLowPower;
 using aidl::google::hardware::power::impl::pixel::MetricUploader;
 using aidl::google::hardware::power::impl::pixel::Power;
@@ -50,18 +52,24 @@ int main() {
         LOG(FATAL) << "HintManager Init failed";
     }
 
-    std::shared_ptr<DisplayLowPower> dlpw = std::make_shared<DisplayLowPower>();
-
     // set task profile "PreferIdle" to lower scheduling latency.
     if (!SetTaskProfiles(0, {"PreferIdleSet"})) {
         LOG(WARNING) << "Device does not support 'PreferIdleSet' task profile.";
     }
 
+    // Display idle events, started after the task profile so its thread
+    // inherits it
+    std::shared_ptr<DisplayEventLoop> displayLoop = std::make_shared<DisplayEventLoop>();
+    if (!displayLoop->Start()) {
+        LOG(ERROR) << "Display event loop failed to start";
+    }
+    std::shared_ptr<DisplayLowPower> dlpw = std::make_shared<DisplayLowPower>();
+
     // single thread
     ABinderProcess_setThreadPoolMaxThreadCount(0);
 
     // core service
-    std::shared_ptr<Power> pw = ndk::SharedRefBase::make<Power>(dlpw);
+    std::shared_ptr<Power> pw = ndk::SharedRefBase::make<Power>(dlpw, displayLoop);
     ndk::SpAIBinder pwBinder = pw->asBinder();
     AIBinder_setMinSchedulerPolicy(pwBinder.get(), SCHED_NORMAL, -20);
 
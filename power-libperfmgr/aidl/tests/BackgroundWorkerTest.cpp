@@ -16,6 +16,8 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
 #include "aidl/BackgroundWorker.h"
 
 namespace aidl {
@@ -160,6 +162,107 @@ TEST(TemplatePriorityQueueWorker, testDouble) {
     EXPECT_NEAR(350, getDurationMs(vec[5].t, tNow).count(), kTIMING_TOLERANCE_MS);
 }
 
+TEST(TimerWheel, expiresInDeadlineOrder) {
+    const auto t0 = std::chrono::steady_clock::now();
+    TimerWheel wheel(t0);
+    // Spread over every level, including beyond the top level's range
+    const std::vector<std::chrono::milliseconds> delays = {
+            5s * 3600, 30ms, 1ms, 63ms, 64ms, 4095ms, 4096ms, 300s, 0ms, 70ms};
+    for (size_t i = 0; i < delays.size(); ++i) {
+        EXPECT_NE(kInvalidTimerHandle, wheel.arm(t0 + delays[i], 1, i));
+    }
+    EXPECT_EQ(delays.size(), wheel.size());
+
+    std::vector<TimerWheel::Expired> expired;
+    std::vector<std::chrono::milliseconds> fired;
+    auto t = t0;
+    while (wheel.size() > 0) {
+        // Never wake up after the earliest deadline
+        const auto wakeup = wheel.nextWakeup();
+        ASSERT_GE(wakeup, t);
+        t = wakeup;
+        wheel.advance(t, &expired);
+        for (const auto &e : expired) {
+            EXPECT_LE(e.deadline, t);
+            EXPECT_GT(e.deadline + TimerWheel::kTick, t);
+            fired.push_back(delays[e.packageId]);
+        }
+        expired.clear();
+    }
+    auto sorted = delays;
+    std::sort(sorted.begin(), sorted.end());
+    EXPECT_EQ(sorted, fired);
+    EXPECT_EQ(std::chrono::steady_clock::time_point::max(), wheel.nextWakeup());
+}
+
+TEST(TimerWheel, rearmAndCancel) {
+    const auto t0 = std::chrono::steady_clock::now();
+    TimerWheel wheel(t0);
+    const TimerHandle a = wheel.arm(t0 + 10ms, 1, 100);
+    const TimerHandle b = wheel.arm(t0 + 20ms, 1, 200);
+    const TimerHandle c = wheel.arm(t0 + 30ms, 1, 300);
+
+    int64_t packageId = 0;
+    EXPECT_TRUE(wheel.rearm(a, t0 + 5s, &packageId));
+    EXPECT_EQ(100, packageId);
+    EXPECT_TRUE(wheel.cancel(b, &packageId));
+    EXPECT_EQ(200, packageId);
+    EXPECT_FALSE(wheel.cancel(b));
+    EXPECT_FALSE(wheel.rearm(b, t0 + 1ms));
+    EXPECT_EQ(2, wheel.size());
+
+    std::vector<TimerWheel::Expired> expired;
+    wheel.advance(t0 + 1s, &expired);
+    ASSERT_EQ(1, expired.size());
+    EXPECT_EQ(300, expired[0].packageId);
+    // Expired handles are stale, even once their slab entry is reused
+    EXPECT_FALSE(wheel.rearm(c, t0 + 2s));
+    const TimerHandle d = wheel.arm(t0 + 2s, 1, 400);
+    EXPECT_NE(c, d);
+    EXPECT_FALSE(wheel.cancel(c));
+
+    expired.clear();
+    wheel.advance(t0 + 10s, &expired);
+    ASSERT_EQ(2, expired.size());
+    EXPECT_EQ(400, expired[0].packageId);
+    EXPECT_EQ(100, expired[1].packageId);
+}
+
+TEST(TemplatePriorityQueueWorker, rescheduleAndCancel) {
+    std::condition_variable cv;
+    std::mutex m;
+    std::vector<work> vec;
+
+    auto p = std::make_shared<PriorityQueueWorkerPool>(1, "adpf_");
+    TemplatePriorityQueueWorker<int> worker{
+            [&](int i) {
+                std::lock_guard<std::mutex> lock(m);
+                vec.push_back({i, std::chrono::steady_clock::now()});
+                cv.notify_all();
+            },
+            p};
+
+    const auto tNow = std::chrono::steady_clock::now();
+    const TimerHandle late = worker.schedule(1, tNow + 1s);
+    const TimerHandle cancelled = worker.schedule(2, tNow + 100ms);
+    worker.schedule(3, tNow + 200ms);
+    // Move the late one earlier with a new package and drop another
+    EXPECT_TRUE(worker.reschedule(late, 4, tNow + 100ms));
+    EXPECT_TRUE(worker.cancel(cancelled));
+    EXPECT_FALSE(worker.cancel(cancelled));
+
+    std::unique_lock<std::mutex> lock(m);
+    cv.wait_for(lock, 1500ms, [&]() { return vec.size() == 2; });
+
+    ASSERT_EQ(2, vec.size());
+    EXPECT_EQ(4, vec[0].val);
+    EXPECT_NEAR(100, getDurationMs(vec[0].t, tNow).count(), kTIMING_TOLERANCE_MS);
+    EXPECT_EQ(3, vec[1].val);
+    EXPECT_NEAR(200, getDurationMs(vec[1].t, tNow).count(), kTIMING_TOLERANCE_MS);
+    // Work that already ran cannot be moved
+    EXPECT_FALSE(worker.reschedule(late, 5, tNow + 300ms));
+}
+
 }  // namespace pixel
 }  // namespace impl
 }  // namespace power
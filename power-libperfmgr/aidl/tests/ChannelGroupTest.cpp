@@ -15,12 +15,14 @@
  */
 
 #include <aidl/android/hardware/power/BnPower.h>
+#include <android-base/file.h>
 #include <fmq/AidlMessageQueue.h>
 #include <fmq/EventFlag.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include <future>
+#include <thread>
 
 #include "aidl/AdpfTypes.h"
 #include "aidl/ChannelGroup.h"
@@ -185,6 +187,97 @@ TEST_F(FMQTest, testSendingHint) {
     EXPECT_EQ(out, SessionHint::GPU_LOAD_RESET);
 }
 
+TEST_F(FMQTest, testDispatchLatencyDumped) {
+    std::promise<void> hintSent;
+    EXPECT_CALL(*mMockPowerHintSession, sendHint).Times(1).WillOnce([&](SessionHint) {
+        hintSent.set_value();
+        return ndk::ScopedAStatus::ok();
+    });
+
+    ChannelMessage in{.timeStampNanos = 1L,
+                      .sessionID = mSessionId,
+                      .data = ChannelMessage::ChannelMessageContents::make<
+                              ChannelMessage::ChannelMessageContents::Tag::hint>(
+                              SessionHint::CPU_LOAD_UP)};
+    mChannel->writeBlocking(&in, 1, mReadFlag, mWriteFlag, 0, mEventFlag);
+    ASSERT_EQ(hintSent.get_future().wait_for(1s), std::future_status::ready);
+
+    // The sample is recorded once the whole wake-up has been dispatched
+    std::string dump;
+    for (int i = 0; i < 100 && dump.find("count:1") == std::string::npos; i++) {
+        TemporaryFile file;
+        mChannelGroup.dumpToFd(file.fd);
+        ASSERT_TRUE(::android::base::ReadFileToString(file.path, &dump));
+        std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_THAT(dump, HasSubstr("ChannelGroup 1 channels: 1"));
+    EXPECT_THAT(dump, HasSubstr("count:1"));
+}
+
+TEST_F(FMQTest, testWakeWithoutMessagesCountsFalseWakeup) {
+    EXPECT_CALL(*mMockPowerHintSession, sendHint).Times(0);
+    ASSERT_EQ(mEventFlag->wake(mWriteFlag), ::android::OK);
+
+    for (int i = 0; i < 100 && mChannelGroup.getFalseWakeups() == 0; i++) {
+        std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_EQ(mChannelGroup.getFalseWakeups(), 1);
+    EXPECT_FALSE(mChannelGroup.isCongested());
+}
+
+TEST_F(FMQTest, testContendedWakeupsMarkGroupCongested) {
+    EXPECT_CALL(*mMockPowerHintSession, sendHint).WillRepeatedly([](SessionHint) {
+        return ndk::ScopedAStatus::ok();
+    });
+    auto secondBackendChannel = mChannelGroup.createChannel(mTestTgid + 1, mTestUid + 1);
+    ChannelQueueDesc channelDesc;
+    secondBackendChannel->getDesc(&channelDesc);
+    auto secondChannel = std::make_shared<SessionMessageQueue>(channelDesc, true);
+    ASSERT_TRUE(secondChannel->isValid());
+
+    ChannelMessage in{.timeStampNanos = 1L,
+                      .sessionID = mSessionId,
+                      .data = ChannelMessage::ChannelMessageContents::make<
+                              ChannelMessage::ChannelMessageContents::Tag::hint>(
+                              SessionHint::CPU_LOAD_UP)};
+    int wakeups = 0;
+    // Queue a message on each channel, then wake the group once for all of them
+    auto wakeWith = [&](const std::vector<std::pair<SessionMessageQueue *, uint32_t>> &channels) {
+        uint32_t writeBits = 0;
+        for (auto &[channel, writeFlag] : channels) {
+            ASSERT_TRUE(channel->write(&in, 1));
+            writeBits |= writeFlag;
+        }
+        ASSERT_EQ(mEventFlag->wake(writeBits), ::android::OK);
+        std::string dump;
+        const std::string expected = "wakeups: " + std::to_string(++wakeups) + " false";
+        for (int i = 0; i < 100 && dump.find(expected) == std::string::npos; i++) {
+            TemporaryFile file;
+            mChannelGroup.dumpToFd(file.fd);
+            ASSERT_TRUE(::android::base::ReadFileToString(file.path, &dump));
+            std::this_thread::sleep_for(10ms);
+        }
+        ASSERT_THAT(dump, HasSubstr(expected));
+    };
+    const std::vector<std::pair<SessionMessageQueue *, uint32_t>> both = {
+            {mChannel.get(), mWriteFlag},
+            {secondChannel.get(), secondBackendChannel->getWriteBitmask()}};
+
+    // The average needs a run of contended wake-ups, not a single one
+    for (int i = 0; i < 4; i++) {
+        wakeWith(both);
+        EXPECT_FALSE(mChannelGroup.isCongested()) << "after " << wakeups << " wake-ups";
+    }
+    wakeWith(both);
+    EXPECT_TRUE(mChannelGroup.isCongested());
+
+    // Wake-ups with one channel to drain bring it back down
+    wakeWith({{mChannel.get(), mWriteFlag}});
+    EXPECT_TRUE(mChannelGroup.isCongested());
+    wakeWith({{mChannel.get(), mWriteFlag}});
+    EXPECT_FALSE(mChannelGroup.isCongested());
+}
+
 ChannelMessage fromWorkDuration(WorkDuration in, int32_t sessionId) {
     return ChannelMessage{
             .timeStampNanos = in.timeStampNanos,
@@ -261,4 +354,45 @@ TEST_F(FMQTest, testSendingManyReportActualMessages) {
     }
 }
 
+TEST_F(FMQTest, testDurationBatchEndsAtOtherMessage) {
+    std::vector<size_t> batchSizes;
+    std::promise<void> done;
+    {
+        InSequence seq;
+        EXPECT_CALL(*mMockPowerHintSession, reportActualWorkDuration)
+                .WillOnce([&](const std::vector<WorkDuration> &actualDurations) {
+                    batchSizes.push_back(actualDurations.size());
+                    return ndk::ScopedAStatus::ok();
+                });
+        EXPECT_CALL(*mMockPowerHintSession, sendHint(SessionHint::CPU_LOAD_UP))
+                .WillOnce(Return(ByMove(ndk::ScopedAStatus::ok())));
+        EXPECT_CALL(*mMockPowerHintSession, reportActualWorkDuration)
+                .WillOnce([&](const std::vector<WorkDuration> &actualDurations) {
+                    batchSizes.push_back(actualDurations.size());
+                    done.set_value();
+                    return ndk::ScopedAStatus::ok();
+                });
+    }
+
+    WorkDuration duration{.timeStampNanos = 1L,
+                          .durationNanos = 5L,
+                          .workPeriodStartTimestampNanos = 3L,
+                          .cpuDurationNanos = 4L,
+                          .gpuDurationNanos = 5L};
+    std::vector<ChannelMessage> messagesIn;
+    messagesIn.emplace_back(fromWorkDuration(duration, mSessionId));
+    messagesIn.emplace_back(fromWorkDuration(duration, mSessionId));
+    messagesIn.emplace_back(ChannelMessage{
+            .timeStampNanos = 2L,
+            .sessionID = mSessionId,
+            .data = ChannelMessage::ChannelMessageContents::make<
+                    ChannelMessage::ChannelMessageContents::Tag::hint>(SessionHint::CPU_LOAD_UP)});
+    messagesIn.emplace_back(fromWorkDuration(duration, mSessionId));
+    mChannel->writeBlocking(messagesIn.data(), messagesIn.size(), mReadFlag, mWriteFlag, 0,
+                            mEventFlag);
+
+    ASSERT_EQ(done.get_future().wait_for(1s), std::future_status::ready);
+    EXPECT_THAT(batchSizes, ElementsAre(2, 1));
+}
+
 }  // namespace aidl::google::hardware::power::impl::pixel
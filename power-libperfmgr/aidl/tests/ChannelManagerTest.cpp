@@ -20,10 +20,14 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
-#include "aidl/ChannelManager.h"
+#include "mocks/MockChannelGroup.h"
 #include "mocks/MockPowerHintSession.h"
 #include "mocks/MockPowerSessionManager.h"
 
+// define private as public to expose the private members for test.
+#define private public
+#include "aidl/ChannelManager.h"
+
 namespace aidl::google::hardware::power::impl::pixel {
 
 using namespace std::chrono_literals;
@@ -114,4 +118,41 @@ TEST_F(ChannelManagerTest, testGroupsCloseOnLastChannelDies) {
     ASSERT_EQ(mChannelManager->getChannelCount(), 0);
 }
 
+using MockGroupChannelManager = ChannelManager<NiceMock<mock::pixel::MockChannelGroup>>;
+
+TEST(ChannelManagerPlacementTest, testNewChannelSkipsCongestedAndFullGroups) {
+    MockGroupChannelManager manager;
+    std::scoped_lock lock{manager.mChannelManagerMutex};
+    // Group 0 holds one channel and group 1 holds three
+    for (int32_t groupId : {0, 1}) {
+        auto &group = manager.mChannelGroups
+                              .emplace(std::piecewise_construct, std::forward_as_tuple(groupId),
+                                       std::forward_as_tuple(groupId))
+                              .first->second;
+        ON_CALL(group, getChannelCount()).WillByDefault(Return(groupId == 0 ? 1 : 3));
+        ON_CALL(group, createChannel(_, _)).WillByDefault([groupId](int32_t tgid, int32_t uid) {
+            MockGroupChannelManager::ChannelMapValue id{{.groupId = groupId, .offset = 0}};
+            return std::make_shared<SessionChannel>(tgid, uid, id, 0);
+        });
+    }
+    auto &leastLoaded = manager.mChannelGroups.at(0);
+    auto groupOf = [](const std::shared_ptr<SessionChannel> &channel) {
+        return MockGroupChannelManager::ChannelMapValue{.value = channel->getId()}.groupId;
+    };
+
+    // The least loaded group takes new channels while it keeps up
+    EXPECT_EQ(0, groupOf(manager.getOrCreateChannel(4000, 3000)));
+
+    // Once congested, new channels go to the busier group rather than queue
+    // behind its channels
+    ON_CALL(leastLoaded, isCongested()).WillByDefault(Return(true));
+    EXPECT_EQ(1, groupOf(manager.getOrCreateChannel(4001, 3001)));
+
+    // A full group is skipped as well
+    ON_CALL(leastLoaded, isCongested()).WillByDefault(Return(false));
+    ON_CALL(leastLoaded, getChannelCount()).WillByDefault(Return(kMaxChannels));
+    EXPECT_EQ(1, groupOf(manager.getOrCreateChannel(4002, 3002)));
+    EXPECT_EQ(2u, manager.mChannelGroups.size());
+}
+
 }  // namespace aidl::google::hardware::power::impl::pixel
@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <condition_variable>
+#include <future>
+
+#include "disp-power/DisplayEventLoop.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+using std::literals::chrono_literals::operator""h;
+using std::literals::chrono_literals::operator""s;
+using std::literals::chrono_literals::operator""ms;
+
+// Long enough to never expire on a loaded device, waits end on notify
+constexpr auto kWaitTimeout = 10s;
+
+class DisplayEventLoopTest : public ::testing::Test {
+  protected:
+    void SetUp() override { ASSERT_TRUE(mLoop.Start()); }
+
+    void TearDown() override {
+        mLoop.Stop();
+        for (int fd : mFds) {
+            close(fd);
+        }
+    }
+
+    int NewEventFd() {
+        int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        mFds.push_back(fd);
+        return fd;
+    }
+
+    static void Signal(int fd) {
+        uint64_t val = 1;
+        ASSERT_EQ(sizeof(val), write(fd, &val, sizeof(val)));
+    }
+
+    static void Drain(int fd) {
+        uint64_t val;
+        (void)read(fd, &val, sizeof(val));
+    }
+
+    // Handler counting calls and draining fd so it does not fire again
+    DisplayEventLoop::FdHandler Counter(int fd, int *count) {
+        return [this, fd, count](uint32_t) {
+            Drain(fd);
+            std::lock_guard<std::mutex> lk(mMutex);
+            (*count)++;
+            mCv.notify_all();
+        };
+    }
+
+    bool WaitForCount(const int *count, int expected) {
+        std::unique_lock<std::mutex> lk(mMutex);
+        return mCv.wait_for(lk, kWaitTimeout, [&]() { return *count >= expected; });
+    }
+
+    DisplayEventLoop mLoop;
+    std::vector<int> mFds;
+    std::mutex mMutex;
+    std::condition_variable mCv;
+};
+
+TEST_F(DisplayEventLoopTest, FdHandlerRuns) {
+    int fd = NewEventFd();
+    int count = 0;
+    ASSERT_TRUE(mLoop.AddFd(fd, EPOLLIN, Counter(fd, &count)));
+
+    Signal(fd);
+    EXPECT_TRUE(WaitForCount(&count, 1));
+    Signal(fd);
+    EXPECT_TRUE(WaitForCount(&count, 2));
+    mLoop.RemoveFd(fd);
+}
+
+TEST_F(DisplayEventLoopTest, RemoveFdWaitsForRunningHandler) {
+    int fd = NewEventFd();
+    std::promise<void> entered;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<bool> done = false;
+    ASSERT_TRUE(mLoop.AddFd(fd, EPOLLIN, [&](uint32_t) {
+        Drain(fd);
+        entered.set_value();
+        released.wait();
+        done = true;
+    }));
+
+    Signal(fd);
+    ASSERT_EQ(std::future_status::ready, entered.get_future().wait_for(kWaitTimeout));
+    // The handler is blocked inside the loop, RemoveFd must not return before it does
+    auto removed = std::async(std::launch::async, [&]() {
+        mLoop.RemoveFd(fd);
+        return done.load();
+    });
+    release.set_value();
+    EXPECT_TRUE(removed.get());
+}
+
+TEST_F(DisplayEventLoopTest, AddAndRemoveFdFromHandler) {
+    int first = NewEventFd();
+    int second = NewEventFd();
+    int firstCount = 0;
+    int secondCount = 0;
+    ASSERT_TRUE(mLoop.AddFd(first, EPOLLIN, [&](uint32_t) {
+        Drain(first);
+        // Both run on the loop thread and must not wait on the dispatch
+        mLoop.RemoveFd(first);
+        ASSERT_TRUE(mLoop.AddFd(second, EPOLLIN, Counter(second, &secondCount)));
+        std::lock_guard<std::mutex> lk(mMutex);
+        firstCount++;
+        mCv.notify_all();
+    }));
+
+    Signal(first);
+    ASSERT_TRUE(WaitForCount(&firstCount, 1));
+    Signal(second);
+    EXPECT_TRUE(WaitForCount(&secondCount, 1));
+
+    // first is no longer watched, second still is
+    Signal(first);
+    Signal(second);
+    EXPECT_TRUE(WaitForCount(&secondCount, 2));
+    mLoop.RemoveFd(second);
+    std::lock_guard<std::mutex> lk(mMutex);
+    EXPECT_EQ(1, firstCount);
+}
+
+TEST_F(DisplayEventLoopTest, DisarmedFdIsNotPolled) {
+    int fd = NewEventFd();
+    int sentinel = NewEventFd();
+    int count = 0;
+    int sentinelCount = 0;
+    ASSERT_TRUE(mLoop.AddFd(fd, EPOLLIN, Counter(fd, &count), /*armed*/ false));
+    ASSERT_TRUE(mLoop.AddFd(sentinel, EPOLLIN, Counter(sentinel, &sentinelCount)));
+
+    Signal(fd);
+    Signal(sentinel);
+    ASSERT_TRUE(WaitForCount(&sentinelCount, 1));
+    {
+        std::lock_guard<std::mutex> lk(mMutex);
+        EXPECT_EQ(0, count);
+    }
+
+    // Arming picks up the pending event
+    ASSERT_TRUE(mLoop.SetFdArmed(fd, true));
+    EXPECT_TRUE(WaitForCount(&count, 1));
+
+    ASSERT_TRUE(mLoop.SetFdArmed(fd, false));
+    ASSERT_TRUE(mLoop.SetFdArmed(fd, false));
+    Signal(fd);
+    Signal(sentinel);
+    ASSERT_TRUE(WaitForCount(&sentinelCount, 2));
+    {
+        std::lock_guard<std::mutex> lk(mMutex);
+        EXPECT_EQ(1, count);
+    }
+
+    // A disarmed fd can still be removed
+    mLoop.RemoveFd(fd);
+    EXPECT_FALSE(mLoop.SetFdArmed(fd, true));
+    mLoop.RemoveFd(sentinel);
+}
+
+TEST_F(DisplayEventLoopTest, TimerRearm) {
+    int count = 0;
+    int timer = mLoop.AddTimer([&]() {
+        std::lock_guard<std::mutex> lk(mMutex);
+        count++;
+        mCv.notify_all();
+    });
+    ASSERT_GE(timer, 0);
+
+    // Rearming replaces the pending expiration
+    ASSERT_TRUE(mLoop.ArmTimer(timer, 1h));
+    ASSERT_TRUE(mLoop.ArmTimer(timer, 1ms));
+    EXPECT_TRUE(WaitForCount(&count, 1));
+
+    // A fired timer can be armed again
+    ASSERT_TRUE(mLoop.ArmTimer(timer, 1ms));
+    EXPECT_TRUE(WaitForCount(&count, 2));
+
+    // Disarmed, so only the rearm below fires
+    ASSERT_TRUE(mLoop.ArmTimer(timer, 1h));
+    ASSERT_TRUE(mLoop.ArmTimer(timer, 0ms));
+    ASSERT_TRUE(mLoop.ArmTimer(timer, 1ms));
+    EXPECT_TRUE(WaitForCount(&count, 3));
+    mLoop.RemoveTimer(timer);
+    std::lock_guard<std::mutex> lk(mMutex);
+    EXPECT_EQ(3, count);
+}
+
+TEST_F(DisplayEventLoopTest, StopAndRestart) {
+    int fd = NewEventFd();
+    int count = 0;
+    ASSERT_TRUE(mLoop.AddFd(fd, EPOLLIN, Counter(fd, &count)));
+
+    mLoop.Stop();
+    // Stopping twice is harmless
+    mLoop.Stop();
+
+    // Nothing is dispatched while stopped, the fd stays watched
+    Signal(fd);
+    ASSERT_TRUE(mLoop.Start());
+    EXPECT_TRUE(WaitForCount(&count, 1));
+    mLoop.RemoveFd(fd);
+}
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "aidl/GpuVoteAggregator.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+using namespace std::chrono_literals;
+using ::testing::Optional;
+
+TEST(GpuVoteAggregatorTest, tracksMaxAcrossSessions) {
+    const auto now = std::chrono::steady_clock::now();
+    GpuVoteAggregator agg(now);
+
+    EXPECT_THAT(agg.update(1, Cycles(100), now + 100ms, now, Cycles(0)), Optional(Cycles(100)));
+    EXPECT_THAT(agg.update(2, Cycles(300), now + 50ms, now, Cycles(0)), Optional(Cycles(300)));
+    // Below the aggregate, nothing to write
+    EXPECT_EQ(agg.update(3, Cycles(200), now + 200ms, now, Cycles(0)), std::nullopt);
+    EXPECT_EQ(agg.aggregate(now + 1ms), Cycles(300));
+
+    // Session 2 expired, then session 1
+    EXPECT_EQ(agg.aggregate(now + 60ms), Cycles(200));
+    EXPECT_EQ(agg.aggregate(now + 300ms), Cycles(0));
+}
+
+TEST(GpuVoteAggregatorTest, newerVoteReplacesOlder) {
+    const auto now = std::chrono::steady_clock::now();
+    GpuVoteAggregator agg(now);
+
+    agg.update(1, Cycles(500), now + 100ms, now, Cycles(0));
+    agg.update(2, Cycles(200), now + 100ms, now, Cycles(0));
+    // The drop of the largest vote is written at once
+    EXPECT_THAT(agg.update(1, Cycles(100), now + 100ms, now + 1ms, Cycles(0)),
+                Optional(Cycles(200)));
+    EXPECT_THAT(agg.update(2, Cycles(0), now + 100ms, now + 2ms, Cycles(0)),
+                Optional(Cycles(100)));
+    EXPECT_THAT(agg.remove(1, now + 3ms, Cycles(0)), Optional(Cycles(0)));
+    EXPECT_EQ(agg.remove(1, now + 4ms, Cycles(0)), std::nullopt);
+}
+
+TEST(GpuVoteAggregatorTest, hysteresisSkipsSmallRises) {
+    const auto now = std::chrono::steady_clock::now();
+    GpuVoteAggregator agg(now);
+    const Cycles hysteresis(50);
+
+    EXPECT_THAT(agg.update(1, Cycles(1000), now + 1s, now, hysteresis), Optional(Cycles(1000)));
+    EXPECT_EQ(agg.update(1, Cycles(1030), now + 1s, now, hysteresis), std::nullopt);
+    EXPECT_EQ(agg.update(1, Cycles(1050), now + 1s, now, hysteresis), std::nullopt);
+    EXPECT_THAT(agg.update(1, Cycles(1051), now + 1s, now, hysteresis), Optional(Cycles(1051)));
+    // Any drop below the written capacity is written
+    EXPECT_THAT(agg.update(1, Cycles(1050), now + 1s, now, hysteresis), Optional(Cycles(1050)));
+    EXPECT_EQ(agg.writes(), 3U);
+    EXPECT_EQ(agg.updates(), 5U);
+}
+
+TEST(GpuVoteAggregatorTest, steadyReportsWriteOnce) {
+    const auto now = std::chrono::steady_clock::now();
+    GpuVoteAggregator agg(now);
+
+    // Three sessions reporting every frame for a second, as a game, its
+    // render thread and SurfaceFlinger would
+    for (int frame = 0; frame < 120; frame++) {
+        const auto t = now + frame * 8ms;
+        for (int64_t session = 1; session <= 3; session++) {
+            agg.update(session, Cycles(100 * session), t + 100ms, t, Cycles(0));
+        }
+    }
+    EXPECT_EQ(agg.updates(), 360U);
+    EXPECT_EQ(agg.writes(), 3U);
+    EXPECT_EQ(agg.aggregate(now + 1s), Cycles(300));
+
+    std::ostringstream dump;
+    agg.dump(dump, now + 1s);
+    EXPECT_NE(dump.str().find("GPU capacity updates: 360 (360/s), node writes: 3 (3/s)"),
+              std::string::npos)
+            << dump.str();
+}
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <android-base/properties.h>
+#include <android-base/unique_fd.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// define private as public to expose the private members for test.
+#define private public
+#include "disp-power/InteractionHandler.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+using ::android::base::unique_fd;
+using std::literals::chrono_literals::operator""s;
+using std::literals::chrono_literals::operator""ms;
+
+// Long enough to never expire on a loaded device, waits end on state changes
+constexpr auto kWaitTimeout = 10s;
+
+// Stands in for the sysfs idle node. sysfs_notify() shows up as EPOLLPRI,
+// which TCP urgent data raises as well, so the idle fd is one end of a
+// loopback connection and the other end notifies.
+class FakeIdleInteractionHandler : public InteractionHandler {
+  public:
+    FakeIdleInteractionHandler(std::shared_ptr<DisplayEventLoop> loop,
+                               std::chrono::milliseconds coalesceWindow)
+        : InteractionHandler(std::move(loop)) {
+        mCoalesceWindow = coalesceWindow;
+    }
+
+    // Handlers call the overrides below, remove them before this is gone
+    ~FakeIdleInteractionHandler() override { Exit(); }
+
+    void SetDisplayIdle(bool idle) {
+        mIdle = idle;
+        const char c = 0;
+        ASSERT_EQ(1, send(mNotifier.get(), &c, 1, MSG_OOB)) << strerror(errno);
+    }
+
+  protected:
+    int OpenIdleFd() override {
+        unique_fd server(socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0));
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (server.get() < 0 || bind(server.get(), reinterpret_cast<sockaddr *>(&addr), len) ||
+            listen(server.get(), 1) ||
+            getsockname(server.get(), reinterpret_cast<sockaddr *>(&addr), &len)) {
+            return -1;
+        }
+        mNotifier.reset(socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0));
+        if (mNotifier.get() < 0 ||
+            connect(mNotifier.get(), reinterpret_cast<sockaddr *>(&addr), len)) {
+            return -1;
+        }
+        mNode = accept4(server.get(), nullptr, nullptr, SOCK_CLOEXEC);
+        return mNode;
+    }
+
+    bool IsDisplayIdle() override {
+        // Consume the notification, like reading the sysfs node rearms it
+        char c;
+        (void)recv(mNode, &c, 1, MSG_OOB | MSG_DONTWAIT);
+        return mIdle;
+    }
+
+  private:
+    unique_fd mNotifier;
+    int mNode = -1;
+    std::atomic<bool> mIdle = false;
+};
+
+class InteractionHandlerTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        if (!::android::base::GetBoolProperty("vendor.powerhal.disp.idle_support", true)) {
+            GTEST_SKIP() << "Display idle wait is off on this device";
+        }
+        mLoop = std::make_shared<DisplayEventLoop>();
+        ASSERT_TRUE(mLoop->Start());
+    }
+
+    void TearDown() override {
+        mHandler.reset();
+        if (mLoop) {
+            mLoop->Stop();
+        }
+    }
+
+    void CreateHandler(std::chrono::milliseconds coalesceWindow) {
+        mHandler = std::make_unique<FakeIdleInteractionHandler>(mLoop, coalesceWindow);
+        ASSERT_TRUE(mHandler->Init());
+    }
+
+    bool WaitForState(InteractionState state) {
+        const auto deadline = std::chrono::steady_clock::now() + kWaitTimeout;
+        while (std::chrono::steady_clock::now() < deadline) {
+            {
+                std::lock_guard<std::mutex> lk(mHandler->mLock);
+                if (mHandler->mState == state) {
+                    return true;
+                }
+            }
+            std::this_thread::sleep_for(5ms);
+        }
+        return false;
+    }
+
+    void ExpectCounters(uint64_t boosts, uint64_t coalesced, uint64_t releases) {
+        std::lock_guard<std::mutex> lk(mHandler->mLock);
+        EXPECT_EQ(boosts, mHandler->mBoosts);
+        EXPECT_EQ(coalesced, mHandler->mCoalesced);
+        EXPECT_EQ(releases, mHandler->mReleases);
+    }
+
+    std::shared_ptr<DisplayEventLoop> mLoop;
+    std::unique_ptr<FakeIdleInteractionHandler> mHandler;
+};
+
+TEST_F(InteractionHandlerTest, releasesOnIdleWithoutCoalesceWindow) {
+    CreateHandler(0ms);
+    mHandler->Acquire(0);
+    ASSERT_TRUE(WaitForState(INTERACTION_STATE_WAITING));
+    mHandler->SetDisplayIdle(true);
+    ASSERT_TRUE(WaitForState(INTERACTION_STATE_IDLE));
+    ExpectCounters(1, 0, 1);
+
+    // The next interaction takes a new boost
+    mHandler->Acquire(0);
+    ExpectCounters(2, 0, 1);
+    ASSERT_TRUE(WaitForState(INTERACTION_STATE_IDLE));
+    ExpectCounters(2, 0, 2);
+}
+
+TEST_F(InteractionHandlerTest, foldsInteractionIntoLingeringBoost) {
+    // Long enough for the second interaction to land inside it
+    CreateHandler(1s);
+    mHandler->Acquire(0);
+    ASSERT_TRUE(WaitForState(INTERACTION_STATE_WAITING));
+    mHandler->SetDisplayIdle(true);
+    ASSERT_TRUE(WaitForState(INTERACTION_STATE_LINGER));
+    ExpectCounters(1, 0, 0);
+
+    // Inside the window, the boost held is extended rather than released
+    // and taken again
+    mHandler->Acquire(0);
+    ExpectCounters(1, 1, 0);
+
+    // Still idle, so the boost lingers once more and is then released
+    ASSERT_TRUE(WaitForState(INTERACTION_STATE_LINGER));
+    ASSERT_TRUE(WaitForState(INTERACTION_STATE_IDLE));
+    ExpectCounters(1, 1, 1);
+
+    TemporaryFile dump;
+    mHandler->DumpToFd(dump.fd);
+    std::string out;
+    ASSERT_TRUE(::android::base::ReadFileToString(dump.path, &out));
+    EXPECT_NE(std::string::npos, out.find("Interaction boosts: 1, coalesced: 1,")) << out;
+    EXPECT_NE(std::string::npos, out.find("display idle wait: on")) << out;
+}
+
+TEST_F(InteractionHandlerTest, releasesAfterWaitingTimesOut) {
+    CreateHandler(0ms);
+    mHandler->Acquire(0);
+    ASSERT_TRUE(WaitForState(INTERACTION_STATE_WAITING));
+    // No idle notification, the boost is released once its duration runs out
+    ASSERT_TRUE(WaitForState(INTERACTION_STATE_IDLE));
+    ExpectCounters(1, 0, 1);
+}
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
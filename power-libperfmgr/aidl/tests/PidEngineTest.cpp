@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <random>
+#include <vector>
+
+#include "aidl/PidEngine.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+namespace {
+
+struct FakeWorkDuration {
+    int64_t timeStampNanos;
+    int64_t durationNanos;
+};
+
+// Per sample PID loop the engine replaced, kept as the reference.
+PidOutput referencePid(const PidParams &params, const std::vector<int64_t> &durations,
+                       double pidPu, int64_t *integral, int64_t *previous) {
+    PidOutput out;
+    int64_t length = durations.size();
+    auto start = [length](uint64_t window) -> int64_t {
+        return window == 0 || window > static_cast<uint64_t>(length) ? 0 : length - window;
+    };
+    int64_t p_start = start(params.samplingWindowP);
+    int64_t i_start = start(params.samplingWindowI);
+    int64_t d_start = start(params.samplingWindowD);
+    int64_t dt = params.targetNs / 100000;
+    int64_t err_sum = 0;
+    int64_t derivative_sum = 0;
+    for (int64_t i = std::min({p_start, i_start, d_start}); i < length; i++) {
+        int64_t error = (durations[i] - params.targetNs) / 100000;
+        if (i >= d_start) {
+            derivative_sum += error - *previous;
+        }
+        if (i >= p_start) {
+            err_sum += error;
+        }
+        if (i >= i_start) {
+            *integral += error * dt;
+            *integral = std::min(params.integralHigh, *integral);
+            *integral = std::max(params.integralLow, *integral);
+        }
+        *previous = error;
+    }
+    out.err = err_sum / (length - p_start);
+    out.integral = *integral;
+    out.derivative = derivative_sum / dt / (length - d_start);
+    out.pOut = static_cast<int64_t>((err_sum > 0 ? params.pidPo : pidPu) * err_sum /
+                                    (length - p_start));
+    out.iOut = static_cast<int64_t>(params.pidI * *integral);
+    out.dOut = static_cast<int64_t>((derivative_sum > 0 ? params.pidDo : params.pidDu) *
+                                    derivative_sum / dt / (length - d_start));
+    out.output = out.pOut + out.iOut + out.dOut;
+    return out;
+}
+
+PidParams testParams(uint64_t windowP, uint64_t windowI, uint64_t windowD) {
+    PidParams params;
+    params.targetNs = 16666666;
+    params.dt = params.targetNs / PidParams::kErrorUnitNs;
+    params.outlierNs = params.targetNs * PidParams::kOutlierTargetFactor;
+    params.integralHigh = 512;
+    params.integralLow = -30;
+    params.samplingWindowP = windowP;
+    params.samplingWindowI = windowI;
+    params.samplingWindowD = windowD;
+    params.pidPo = 2.0;
+    params.pidI = 0.001;
+    params.pidDo = 500.0;
+    params.pidDu = 0.0;
+    return params;
+}
+
+void expectSameOutput(const PidOutput &expected, const PidOutput &actual) {
+    EXPECT_EQ(expected.err, actual.err);
+    EXPECT_EQ(expected.integral, actual.integral);
+    EXPECT_EQ(expected.derivative, actual.derivative);
+    EXPECT_EQ(expected.pOut, actual.pOut);
+    EXPECT_EQ(expected.iOut, actual.iOut);
+    EXPECT_EQ(expected.dOut, actual.dOut);
+    EXPECT_EQ(expected.output, actual.output);
+}
+
+}  // namespace
+
+TEST(PidEngineTest, matchesReferenceLoop) {
+    std::mt19937_64 rng(0);
+    std::uniform_int_distribution<int64_t> duration(0, 40000000);
+    for (const auto &windows : std::vector<std::array<uint64_t, 3>>{
+                 {0, 0, 0}, {0, 1, 0}, {1, 1, 1}, {3, 8, 2}, {64, 1, 32}, {100, 100, 100}}) {
+        const PidParams params = testParams(windows[0], windows[1], windows[2]);
+        int64_t integral = 0, previous = 0;
+        int64_t refIntegral = 0, refPrevious = 0;
+        for (size_t batch = 1; batch <= 64; batch++) {
+            std::vector<int64_t> durations(batch);
+            for (auto &d : durations) {
+                d = duration(rng);
+            }
+            double pidPu = batch % 2 ? 1.0 : 0.5;
+            PidOutput expected = referencePid(params, durations, pidPu, &refIntegral, &refPrevious);
+            PidOutput actual = PidEngine::update(params, durations.data(), durations.size(), pidPu,
+                                                 &integral, &previous);
+            expectSameOutput(expected, actual);
+            ASSERT_EQ(refIntegral, integral);
+            ASSERT_EQ(refPrevious, previous);
+        }
+    }
+}
+
+TEST(PidEngineTest, integralIsClampedPerSample) {
+    const PidParams params = testParams(0, 0, 0);
+    // Way over target then way under: without per sample clamping the
+    // integral would come back to 0 instead of hitting the low bound.
+    std::vector<int64_t> durations{params.targetNs * 10, params.targetNs * 10, 0};
+    int64_t integral = 0, previous = 0;
+    PidOutput out = PidEngine::update(params, durations.data(), durations.size(), 1.0, &integral,
+                                      &previous);
+    EXPECT_EQ(params.integralLow, integral);
+    EXPECT_EQ(params.integralLow, out.integral);
+    EXPECT_EQ(-params.dt, previous);
+}
+
+TEST(PidEngineTest, workDurationSamples) {
+    const PidParams params = testParams(1, 0, 1);
+    std::vector<FakeWorkDuration> samples{{0, 10000000}, {0, 20000000}};
+    std::vector<int64_t> durations{10000000, 20000000};
+    int64_t integral = 0, previous = 0;
+    int64_t refIntegral = 0, refPrevious = 0;
+    expectSameOutput(
+            PidEngine::update(params, durations.data(), durations.size(), 1.0, &refIntegral,
+                              &refPrevious),
+            PidEngine::update(params, samples.data(), samples.size(), 1.0, &integral, &previous));
+    EXPECT_EQ(refIntegral, integral);
+    EXPECT_EQ(refPrevious, previous);
+}
+
+TEST(PidEngineTest, reportsOutlier) {
+    const PidParams params = testParams(0, 0, 0);
+    std::vector<int64_t> durations{params.targetNs, params.targetNs * 21, params.targetNs * 30};
+    int64_t integral = 0, previous = 0;
+    EXPECT_EQ(params.targetNs * 21,
+              PidEngine::update(params, durations.data(), durations.size(), 1.0, &integral,
+                                &previous)
+                      .outlierNs);
+    durations.resize(1);
+    EXPECT_EQ(0, PidEngine::update(params, durations.data(), durations.size(), 1.0, &integral,
+                                   &previous)
+                         .outlierNs);
+}
+
+TEST(PidEngineTest, emptyBatchKeepsState) {
+    const PidParams params = testParams(0, 0, 0);
+    int64_t integral = 7, previous = 3;
+    PidOutput out = PidEngine::update(params, static_cast<const int64_t *>(nullptr), 0, 1.0,
+                                      &integral, &previous);
+    EXPECT_EQ(0, out.output);
+    EXPECT_EQ(7, integral);
+    EXPECT_EQ(3, previous);
+}
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
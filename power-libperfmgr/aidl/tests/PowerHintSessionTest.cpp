@@ -216,18 +216,16 @@ class PowerHintSessionMockedTest : public Test {
 TEST_F(PowerHintSessionTest, removeDeadThread) {
     ALOGI("Running dead thread test for hint sessions.");
     auto sessManager = sess1->mPSManager;
-    ASSERT_EQ(2, sessManager->mSessionTaskMap.mSessions.size());
+    ASSERT_EQ(2, sessManager->mSessionTaskMap.sizeSessions());
 
     // The sessions' thread list doesn't change after thread died until the uclamp
     // min update is triggered.
     int deadThreadInd = numOfThreads / 2;
     auto deadThreadID = threadIds[deadThreadInd];
     closeThread(deadThreadInd);
-    ASSERT_EQ(sessManager->mSessionTaskMap.mSessions[sess1->mSessionId].linkedTasks,
-              session1Threads);
-    ASSERT_EQ(sessManager->mSessionTaskMap.mSessions[sess2->mSessionId].linkedTasks,
-              session2Threads);
-    ASSERT_EQ(sessManager->mSessionTaskMap.mTasks[deadThreadID].size(), 2);
+    ASSERT_EQ(sessManager->mSessionTaskMap.getTaskIds(sess1->mSessionId), session1Threads);
+    ASSERT_EQ(sessManager->mSessionTaskMap.getTaskIds(sess2->mSessionId), session2Threads);
+    ASSERT_EQ(sessManager->mSessionTaskMap.getSessionIds(deadThreadID).size(), 2);
 
     // Trigger an update of uclamp min.
     auto tNow = std::chrono::duration_cast<std::chrono::nanoseconds>(
@@ -235,15 +233,13 @@ TEST_F(PowerHintSessionTest, removeDeadThread) {
                         .count();
     WorkDuration wDur(tNow, 1100000);
     sess1->reportActualWorkDuration(std::vector<WorkDuration>{wDur});
-    ASSERT_EQ(sessManager->mSessionTaskMap.mTasks[deadThreadID].size(), 1);
+    ASSERT_EQ(sessManager->mSessionTaskMap.getSessionIds(deadThreadID).size(), 1);
     sess2->reportActualWorkDuration(std::vector<WorkDuration>{wDur});
-    ASSERT_EQ(sessManager->mSessionTaskMap.mTasks.count(deadThreadID), 0);
+    ASSERT_EQ(sessManager->mSessionTaskMap.getSessionIds(deadThreadID).size(), 0);
     std::erase(session1Threads, deadThreadID);
     std::erase(session2Threads, deadThreadID);
-    ASSERT_EQ(sessManager->mSessionTaskMap.mSessions[sess1->mSessionId].linkedTasks,
-              session1Threads);
-    ASSERT_EQ(sessManager->mSessionTaskMap.mSessions[sess2->mSessionId].linkedTasks,
-              session2Threads);
+    ASSERT_EQ(sessManager->mSessionTaskMap.getTaskIds(sess1->mSessionId), session1Threads);
+    ASSERT_EQ(sessManager->mSessionTaskMap.getTaskIds(sess2->mSessionId), session2Threads);
 
     // Close all the threads in session 1.
     for (int i = 0; i <= numOfThreads / 2; i++) {
@@ -253,24 +249,42 @@ TEST_F(PowerHintSessionTest, removeDeadThread) {
                    std::chrono::high_resolution_clock::now().time_since_epoch())
                    .count();
     sess1->reportActualWorkDuration(std::vector<WorkDuration>{wDur});
-    ASSERT_EQ(2, sessManager->mSessionTaskMap.mSessions.size());  // Session still alive
-    ASSERT_EQ(sessManager->mSessionTaskMap.mSessions[sess1->mSessionId].linkedTasks.size(), 0);
+    ASSERT_EQ(2, sessManager->mSessionTaskMap.sizeSessions());  // Session still alive
+    ASSERT_EQ(sessManager->mSessionTaskMap.getTaskIds(sess1->mSessionId).size(), 0);
+}
+
+TEST_F(PowerHintSessionTest, unchangedUclampSkipsSyscall) {
+    auto sessManager = sess1->mPSManager;
+    const auto tNow = std::chrono::steady_clock::now();
+    sessManager->voteSet(sess1->mSessionId, AdpfVoteType::CPU_LOAD_UP, 300, 1024, tNow, 1s);
+    const uint64_t syscalls = sessManager->mUclampSyscalls;
+    const uint64_t skipped = sessManager->mUclampSkipped;
+
+    // Same vote again, every thread of the session keeps its range
+    sessManager->voteSet(sess1->mSessionId, AdpfVoteType::CPU_LOAD_UP, 300, 1024, tNow, 1s);
+    ASSERT_EQ(syscalls, sessManager->mUclampSyscalls);
+    ASSERT_EQ(skipped + session1Threads.size(), sessManager->mUclampSkipped);
+
+    // A new range is written
+    sessManager->voteSet(sess1->mSessionId, AdpfVoteType::CPU_LOAD_UP, 400, 1024, tNow, 1s);
+    ASSERT_EQ(syscalls + session1Threads.size(), sessManager->mUclampSyscalls);
+
+    sess1->close();
+    sess2->close();
 }
 
 TEST_F(PowerHintSessionTest, setThreads) {
     auto sessManager = sess1->mPSManager;
-    ASSERT_EQ(2, sessManager->mSessionTaskMap.mSessions.size());
+    ASSERT_EQ(2, sessManager->mSessionTaskMap.sizeSessions());
 
-    ASSERT_EQ(sessManager->mSessionTaskMap.mSessions[sess1->mSessionId].linkedTasks,
-              session1Threads);
+    ASSERT_EQ(sessManager->mSessionTaskMap.getTaskIds(sess1->mSessionId), session1Threads);
 
     std::vector<int32_t> newSess1Threads;
     for (auto tid : threadIds) {
         newSess1Threads.emplace_back(tid.second);
     }
     sess1->setThreads(newSess1Threads);
-    ASSERT_EQ(sessManager->mSessionTaskMap.mSessions[sess1->mSessionId].linkedTasks,
-              newSess1Threads);
+    ASSERT_EQ(sessManager->mSessionTaskMap.getTaskIds(sess1->mSessionId), newSess1Threads);
 
     sess1->close();
     sess2->close();
@@ -278,16 +292,15 @@ TEST_F(PowerHintSessionTest, setThreads) {
 
 TEST_F(PowerHintSessionTest, pauseResumeSession) {
     auto sessManager = sess1->mPSManager;
-    ASSERT_EQ(2, sessManager->mSessionTaskMap.mSessions.size());
-    ASSERT_EQ(2, sessManager->mSessionTaskMap.mSessions[sess1->mSessionId].linkedTasks.size());
+    ASSERT_EQ(2, sessManager->mSessionTaskMap.sizeSessions());
+    ASSERT_EQ(2, sessManager->mSessionTaskMap.getTaskIds(sess1->mSessionId).size());
 
     sess1->pause();
-    ASSERT_EQ(2, sessManager->mSessionTaskMap.mSessions.size());
-    ASSERT_EQ(0, sessManager->mSessionTaskMap.mSessions[sess1->mSessionId].linkedTasks.size());
+    ASSERT_EQ(2, sessManager->mSessionTaskMap.sizeSessions());
+    ASSERT_EQ(0, sessManager->mSessionTaskMap.getTaskIds(sess1->mSessionId).size());
 
     sess1->resume();
-    ASSERT_EQ(sessManager->mSessionTaskMap.mSessions[sess1->mSessionId].linkedTasks,
-              session1Threads);
+    ASSERT_EQ(sessManager->mSessionTaskMap.getTaskIds(sess1->mSessionId), session1Threads);
     ASSERT_EQ(session1Threads, sess1->mDescriptor->thread_ids);
     ASSERT_EQ(SessionTag::OTHER, sess1->mDescriptor->tag);
 
@@ -300,9 +313,9 @@ TEST_F(PowerHintSessionTest, checkPauseResumeTag) {
     bool isActive;
 
     // Check we actually start with two PIDs.
-    ASSERT_EQ(2, sessManager->mSessionTaskMap.mSessions[sess1->mSessionId].linkedTasks.size());
-    pid_t threadOnePid = sessManager->mSessionTaskMap.mSessions[sess1->mSessionId].linkedTasks[0];
-    pid_t threadTwoPid = sessManager->mSessionTaskMap.mSessions[sess1->mSessionId].linkedTasks[1];
+    ASSERT_EQ(2, sessManager->mSessionTaskMap.getTaskIds(sess1->mSessionId).size());
+    pid_t threadOnePid = sessManager->mSessionTaskMap.getTaskIds(sess1->mSessionId)[0];
+    pid_t threadTwoPid = sessManager->mSessionTaskMap.getTaskIds(sess1->mSessionId)[1];
 
     // Start the powerhint session and check the powerhint tags are on.
     std::this_thread::sleep_for(10ms);
@@ -370,6 +383,45 @@ TEST_F(PowerHintSessionMockedTest, updateSessionJankState) {
               mHintSession->updateSessionJankState(SessionJankyLevel::LIGHT, 9, 5.0, false));
 }
 
+TEST_F(PowerHintSessionMockedTest, predictiveBoostVotesAheadOfSpikes) {
+    WorkDurationTrace trace;
+    ASSERT_TRUE(loadTraceFixture("physics_step_trace.txt", &trace));
+    auto config = std::make_shared<::android::perfmgr::AdpfConfig>(*mTestConfig);
+    config->mHeuristicBoostOn = false;
+    config->mGpuBoostOn = false;
+    config->mPredictiveBoostOn = true;
+    config->mPredictiveBoostHeavyFactor = 1.5;
+    config->mPredictiveBoostUclampMin = 600;
+    mHintSession->setAdpfProfile(config);
+    ASSERT_TRUE(mHintSession->updateTargetWorkDuration(trace.targetNs).isOk());
+
+    // Frames after which a heavy frame was predicted
+    std::vector<size_t> predictedAfter;
+    size_t frame = 0;
+    EXPECT_CALL(*mMockPowerSessionManager, voteSet(_, _, An<int>(), An<int>(), _, _))
+            .Times(AnyNumber());
+    EXPECT_CALL(*mMockPowerSessionManager,
+                voteSet(_, AdpfVoteType::CPU_PREDICTED, 600, kUclampMax, _,
+                        std::chrono::nanoseconds(trace.targetNs * 2)))
+            .WillRepeatedly([&](int64_t, AdpfVoteType, int, int,
+                                std::chrono::steady_clock::time_point,
+                                std::chrono::nanoseconds) { predictedAfter.push_back(frame); });
+    for (; frame < trace.frames.size(); frame++) {
+        ASSERT_TRUE(mHintSession->reportActualWorkDuration({trace.frames[frame]}).isOk());
+    }
+
+    const int64_t heavyNs = trace.targetNs * 3 / 2;
+    size_t correct = 0;
+    for (size_t i : predictedAfter) {
+        if (i + 1 < trace.frames.size() && trace.frames[i + 1].durationNanos > heavyNs) {
+            correct++;
+        }
+    }
+    // Every step but the late one is boosted ahead, once the period is learned
+    EXPECT_EQ(26U, predictedAfter.size());
+    EXPECT_EQ(25U, correct);
+}
+
 using TestingPowerHintSessionHintMocked =
         PowerHintSession<testing::NiceMock<mock::pixel::MockHintManager>,
                          PowerSessionManager<testing::NiceMock<mock::pixel::MockHintManager>>>;
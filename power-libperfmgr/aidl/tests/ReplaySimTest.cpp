@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+#include <perfmgr/HintManager.h>
+
+#include <chrono>
+
+#include "aidl/tools/ReplaySim.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+using ::android::perfmgr::AdpfConfig;
+using ::android::perfmgr::HintManager;
+using std::literals::chrono_literals::operator""ms;
+
+// A P controller only, its gains are set by each test
+constexpr char kConfig[] = R"(
+{
+    "Nodes": [
+        {
+            "Name": "OTHER",
+            "Paths": ["<AdpfConfig>:OTHER"],
+            "Values": ["ADPF_SIM"],
+            "Type": "Event"
+        }
+    ],
+    "Actions": [],
+    "AdpfConfig": [
+        {
+            "Name": "ADPF_SIM",
+            "PID_On": true,
+            "PID_Po": 0.0,
+            "PID_Pu": 0.0,
+            "PID_I": 0.0,
+            "PID_I_Init": 0,
+            "PID_I_High": 0,
+            "PID_I_Low": 0,
+            "PID_Do": 0.0,
+            "PID_Du": 0.0,
+            "SamplingWindow_P": 1,
+            "SamplingWindow_I": 0,
+            "SamplingWindow_D": 1,
+            "UclampMin_On": true,
+            "UclampMin_Init": 0,
+            "UclampMin_LoadUp": 0,
+            "UclampMin_LoadReset": 0,
+            "UclampMin_High": 1024,
+            "UclampMin_Low": 0,
+            "ReportingRateLimitNs": 166666660,
+            "TargetTimeFactor": 1.0,
+            "StaleTimeFactor": 1000.0
+        }
+    ]
+}
+)";
+
+constexpr int64_t kTargetNs = std::chrono::nanoseconds(10ms).count();
+
+class ReplaySimTest : public ::testing::Test {
+  protected:
+    static void SetUpTestSuite() {
+        TemporaryFile config;
+        ASSERT_TRUE(::android::base::WriteStringToFile(kConfig, config.path));
+        ASSERT_NE(nullptr, HintManager::GetFromJSON(config.path, false));
+    }
+
+    void SetUp() override {
+        mProfile = HintManager::GetInstance()->GetAdpfProfile("OTHER");
+        ASSERT_NE(nullptr, mProfile);
+        // Every frame takes 16ms of CPU at the base capacity, and 8ms at the
+        // full capacity
+        mTrace.targetNs = kTargetNs;
+        mTrace.frames.assign(100, WorkDuration{.durationNanos = 16000000,
+                                               .cpuDurationNanos = 16000000});
+        mModel.baseCapacity = 512;
+        mModel.traceCapacity = 512;
+    }
+
+    std::shared_ptr<AdpfConfig> mProfile;
+    WorkDurationTrace mTrace;
+    CapacityModel mModel;
+};
+
+TEST_F(ReplaySimTest, parseTrace) {
+    WorkDurationTrace trace;
+    ASSERT_TRUE(parseWorkDurationTrace("# target_ns 8000000\n"
+                                       "# a comment\n"
+                                       "9000000\n"
+                                       "\n"
+                                       "12000000, 7000000, 5000000\n",
+                                       &trace));
+    EXPECT_EQ(8000000, trace.targetNs);
+    ASSERT_EQ(2, trace.frames.size());
+    EXPECT_EQ(9000000, trace.frames[0].durationNanos);
+    // A frame without a split is all CPU
+    EXPECT_EQ(9000000, trace.frames[0].cpuDurationNanos);
+    EXPECT_EQ(12000000, trace.frames[1].durationNanos);
+    EXPECT_EQ(7000000, trace.frames[1].cpuDurationNanos);
+    EXPECT_EQ(5000000, trace.frames[1].gpuDurationNanos);
+
+    EXPECT_FALSE(parseWorkDurationTrace("9000000 7000000\n", &trace));
+    EXPECT_FALSE(parseWorkDurationTrace("-1\n", &trace));
+    EXPECT_FALSE(parseWorkDurationTrace("# target_ns 8000000\n", &trace));
+}
+
+TEST_F(ReplaySimTest, capacityModelScalesCpuPart) {
+    const WorkDuration recorded{.durationNanos = 12000000,
+                                .cpuDurationNanos = 8000000,
+                                .gpuDurationNanos = 4000000};
+    // Below the base capacity the scheduler's choice stands
+    EXPECT_EQ(12000000, mModel.durationNs(recorded, 100));
+    // Twice the capacity halves the CPU part only
+    EXPECT_EQ(4000000, mModel.cpuDurationNs(recorded, 1024));
+    EXPECT_EQ(8000000, mModel.durationNs(recorded, 1024));
+    EXPECT_DOUBLE_EQ(4.0 * mModel.energy(recorded, 0), mModel.energy(recorded, 1024));
+}
+
+TEST_F(ReplaySimTest, simulateWithoutGainsNeverBoosts) {
+    const SimResult result = simulate(mProfile, mTrace, mModel);
+    EXPECT_DOUBLE_EQ(1.0, result.jankRate);
+    EXPECT_DOUBLE_EQ(0.0, result.meanUclampMin);
+    EXPECT_DOUBLE_EQ(1.0, result.energy);
+    // One run of late frames, the whole trace
+    EXPECT_DOUBLE_EQ(100.0, result.controlLatencyFrames);
+}
+
+TEST_F(ReplaySimTest, simulateWithGainBoostsLateFrames) {
+    const SimResult result =
+            simulate(applyGains(*mProfile, Gains{.pidPo = 10.0, .pidPu = 10.0}), mTrace, mModel);
+    // The first late frames raise uclamp.min until frames finish on time,
+    // where it then settles
+    EXPECT_LT(result.jankRate, 0.1);
+    EXPECT_GT(result.meanUclampMin, 512.0);
+    EXPECT_GT(result.energy, 1.0);
+    EXPECT_LE(result.controlLatencyFrames, 3.0);
+}
+
+TEST_F(ReplaySimTest, sweepKeepsGridOrder) {
+    const std::vector<Gains> grid = {
+            Gains{.pidPo = 10.0, .pidPu = 10.0},
+            Gains{},
+            Gains{.pidPo = 10.0, .pidPu = 10.0},
+            Gains{},
+    };
+    const auto results = sweep(*mProfile, grid, mTrace, mModel, 2);
+    ASSERT_EQ(grid.size(), results.size());
+    const SimResult boosted = simulate(applyGains(*mProfile, grid[0]), mTrace, mModel);
+    for (size_t i = 0; i < grid.size(); i++) {
+        if (grid[i].pidPo > 0) {
+            EXPECT_DOUBLE_EQ(boosted.jankRate, results[i].jankRate);
+            EXPECT_DOUBLE_EQ(boosted.energy, results[i].energy);
+        } else {
+            EXPECT_DOUBLE_EQ(1.0, results[i].jankRate);
+        }
+    }
+}
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include "aidl/SessionEventRecorder.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+TEST(SessionEventRecorderTest, keepsLatestEvents) {
+    SessionEventRecorder recorder("test");
+    std::vector<SessionEvent> events;
+    recorder.snapshot(&events);
+    EXPECT_TRUE(events.empty());
+
+    const int total = SessionEventRecorder::kCapacity + 10;
+    for (int i = 0; i < total; i++) {
+        recorder.record(SessionEventType::UCLAMP_MIN_VOTE, i, i * 2);
+    }
+    EXPECT_EQ(static_cast<uint64_t>(total), recorder.recorded());
+
+    recorder.snapshot(&events);
+    ASSERT_EQ(SessionEventRecorder::kCapacity - 1, events.size());
+    for (size_t i = 0; i < events.size(); i++) {
+        EXPECT_EQ(static_cast<uint16_t>(SessionEventType::UCLAMP_MIN_VOTE), events[i].type);
+        EXPECT_EQ(static_cast<int32_t>(i + 11), events[i].arg);
+        EXPECT_EQ(static_cast<int64_t>(i + 11) * 2, events[i].values[0]);
+    }
+    EXPECT_LE(events.front().timestampNs, events.back().timestampNs);
+}
+
+TEST(SessionEventRecorderTest, ringIsSharedMemory) {
+    SessionEventRecorder recorder("test");
+    ASSERT_GE(recorder.fd(), 0);
+    recorder.record(SessionEventType::PID, 7, 1, 2, 3);
+
+    // Another mapping of the fd, as a reader in another process would have
+    const size_t size = sizeof(std::atomic<uint64_t>) +
+                        SessionEventRecorder::kCapacity * sizeof(SessionEvent);
+    void *addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, recorder.fd(), 0);
+    ASSERT_NE(MAP_FAILED, addr);
+    SessionEvent event;
+    memcpy(&event, static_cast<const char *>(addr) + sizeof(std::atomic<uint64_t>), sizeof(event));
+    EXPECT_EQ(static_cast<uint16_t>(SessionEventType::PID), event.type);
+    EXPECT_EQ(7, event.arg);
+    EXPECT_EQ(3, event.values[2]);
+    munmap(addr, size);
+}
+
+TEST(SessionEventRecorderTest, snapshotDropsTornEvents) {
+    SessionEventRecorder recorder("test");
+    std::atomic<bool> stop{false};
+    std::thread writer([&]() {
+        for (int32_t i = 0; !stop; i++) {
+            recorder.record(SessionEventType::REPORT, i, i, i, i);
+        }
+    });
+    std::vector<SessionEvent> events;
+    for (int round = 0; round < 1000; round++) {
+        recorder.snapshot(&events);
+        for (size_t i = 0; i < events.size(); i++) {
+            // Every field of an event was written together, and the events
+            // are consecutive
+            ASSERT_EQ(events[i].arg, events[i].values[0]);
+            ASSERT_EQ(events[i].arg, events[i].values[2]);
+            if (i > 0) {
+                ASSERT_EQ(events[i - 1].arg + 1, events[i].arg);
+            }
+        }
+    }
+    stop = true;
+    writer.join();
+}
+
+TEST(SessionEventRecorderTest, binaryDump) {
+    SessionEventRecorder recorder("test");
+    recorder.record(SessionEventType::REPORT, 1, 16000000, 16666666, 0);
+    recorder.record(SessionEventType::JANK_LEVEL, 2, 5, 9000, 21000);
+
+    TemporaryFile file;
+    ASSERT_TRUE(SessionEventRecorder::writeDumpHeader(file.fd));
+    ASSERT_TRUE(recorder.writeDump(file.fd, 42, "1-2-42-OTHER-0"));
+    std::string dump;
+    ASSERT_TRUE(::android::base::ReadFileToString(file.path, &dump));
+
+    const std::string name = "1-2-42-OTHER-0";
+    ASSERT_EQ(16 + 16 + name.size() + 2 * sizeof(SessionEvent), dump.size());
+    EXPECT_EQ(0, memcmp(dump.data(), "ADPFEVT1", 8));
+    uint32_t version, eventSize, nameLen, count;
+    int64_t sessionId;
+    memcpy(&version, dump.data() + 8, 4);
+    memcpy(&eventSize, dump.data() + 12, 4);
+    memcpy(&sessionId, dump.data() + 16, 8);
+    memcpy(&nameLen, dump.data() + 24, 4);
+    memcpy(&count, dump.data() + 28, 4);
+    EXPECT_EQ(SessionEventRecorder::kDumpVersion, version);
+    EXPECT_EQ(sizeof(SessionEvent), eventSize);
+    EXPECT_EQ(42, sessionId);
+    EXPECT_EQ(name.size(), nameLen);
+    EXPECT_EQ(2U, count);
+    EXPECT_EQ(name, dump.substr(32, nameLen));
+
+    SessionEvent jank;
+    memcpy(&jank, dump.data() + 32 + nameLen + sizeof(SessionEvent), sizeof(jank));
+    EXPECT_EQ(static_cast<uint16_t>(SessionEventType::JANK_LEVEL), jank.type);
+    EXPECT_EQ(2, jank.arg);
+    EXPECT_EQ(21000, jank.values[2]);
+}
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
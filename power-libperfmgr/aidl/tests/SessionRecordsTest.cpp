@@ -88,6 +88,7 @@ TEST_F(SessionRecordsTest, addReportedDurations) {
     mRecords->addReportedDurations(fakeWorkDurations({2, 1, 2}), MS_TO_NS(3), buckets);
     ASSERT_EQ(5, mRecords->getNumOfRecords());
     ASSERT_EQ(MS_TO_US(3), mRecords->getMaxDuration().value());
+    ASSERT_EQ(MS_TO_US(3), mRecords->getPercentileDuration(90).value());
     ASSERT_EQ(MS_TO_US(2), mRecords->getAvgDuration().value());
     ASSERT_EQ(0, mRecords->getNumOfMissedCycles());
     ASSERT_TRUE(mRecords->areAllRecordsInitialized());
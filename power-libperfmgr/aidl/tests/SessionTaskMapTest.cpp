@@ -16,6 +16,8 @@
 
 #include <gtest/gtest.h>
 
+#include <thread>
+
 #include "aidl/SessionTaskMap.h"
 
 using std::literals::chrono_literals::operator""ms;
@@ -430,6 +432,64 @@ TEST(SessionTaskMapTest, usesPowerEfficiencyValues) {
     EXPECT_EQ(range.uclampMax, baseVote.uclampMax);
 }
 
+TEST(SessionTaskMapTest, removeDeadTask) {
+    SessionTaskMap m;
+    EXPECT_TRUE(m.add(1, makeSession(1000), {10, 20}));
+    EXPECT_TRUE(m.add(2, makeSession(2000), {20, 30}));
+
+    EXPECT_TRUE(m.removeDeadTaskSessionMap(1, 20));
+    EXPECT_EQ(std::vector<pid_t>({10}), m.getTaskIds(1));
+    EXPECT_EQ(std::vector<int64_t>({2}), getSessions(20, m));
+    EXPECT_FALSE(m.removeDeadTaskSessionMap(1, 20));
+
+    EXPECT_TRUE(m.removeDeadTaskSessionMap(2, 20));
+    EXPECT_EQ(std::vector<pid_t>({30}), m.getTaskIds(2));
+    EXPECT_EQ(2, m.sizeTasks());
+    EXPECT_FALSE(m.removeDeadTaskSessionMap(3, 10));
+}
+
+TEST(SessionTaskMapTest, concurrentVotesAndReplace) {
+    constexpr int kNumSessions = 8;
+    constexpr int kNumIterations = 1000;
+    SessionTaskMap m;
+    for (int i = 0; i < kNumSessions; i++) {
+        // Every session shares task 1 with all others
+        EXPECT_TRUE(m.add(i, makeSession(1000 + i), {1, 100 + i}));
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kNumSessions; i++) {
+        threads.emplace_back([&m, &t0, i]() {
+            std::optional<int32_t> fakeEfficiencyParam;
+            for (int j = 0; j < kNumIterations; j++) {
+                m.addVote(i, 1, i + 1, 1024, t0, 1000ms);
+                UclampRange range;
+                m.getTaskVoteRange(1, t0 + 10ns, range, fakeEfficiencyParam, fakeEfficiencyParam);
+                EXPECT_LE(i + 1, range.uclampMin);
+            }
+        });
+    }
+    threads.emplace_back([&m]() {
+        for (int j = 0; j < kNumIterations; j++) {
+            m.replace(0, {1, 100, 200 + j % 2}, nullptr, nullptr);
+        }
+    });
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(kNumSessions, m.sizeSessions());
+    EXPECT_EQ(kNumSessions, getSessions(1, m).size());
+    EXPECT_EQ(std::vector<int64_t>({0}), getSessions(201, m));
+    EXPECT_TRUE(getSessions(200, m).empty());
+
+    UclampRange range;
+    std::optional<int32_t> fakeEfficiencyParam;
+    m.getTaskVoteRange(1, t0 + 10ns, range, fakeEfficiencyParam, fakeEfficiencyParam);
+    EXPECT_EQ(kNumSessions, range.uclampMin);
+}
+
 }  // namespace pixel
 }  // namespace impl
 }  // namespace power
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <deque>
+#include <random>
+
+#include "aidl/SlidingWindowStats.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+TEST(SlidingWindowStatsTest, empty) {
+    SlidingWindowStats stats(4);
+    EXPECT_EQ(0, stats.size());
+    EXPECT_FALSE(stats.max().has_value());
+    EXPECT_FALSE(stats.mean().has_value());
+    EXPECT_FALSE(stats.percentile(90).has_value());
+    EXPECT_EQ(0, stats.missedCount());
+    EXPECT_EQ(-1, stats.slotOf(0));
+}
+
+TEST(SlidingWindowStatsTest, evictsOldest) {
+    SlidingWindowStats stats(3);
+    stats.push(9, true);
+    stats.push(2, false);
+    stats.push(4, true);
+    EXPECT_TRUE(stats.full());
+    EXPECT_EQ(9, stats.max().value());
+    EXPECT_EQ(5, stats.mean().value());
+    EXPECT_EQ(2, stats.missedCount());
+
+    // 9 drops out of the window
+    stats.push(3, false);
+    EXPECT_EQ(3, stats.size());
+    EXPECT_EQ(4, stats.max().value());
+    EXPECT_EQ(3, stats.mean().value());
+    EXPECT_EQ(1, stats.missedCount());
+    EXPECT_EQ(3, stats.value(stats.slotOf(0)));
+    EXPECT_EQ(4, stats.value(stats.slotOf(1)));
+
+    stats.reset();
+    EXPECT_EQ(0, stats.size());
+    EXPECT_FALSE(stats.max().has_value());
+}
+
+TEST(SlidingWindowStatsTest, percentileOfSmallValuesIsExact) {
+    SlidingWindowStats stats(10);
+    for (int32_t v = 1; v <= 10; v++) {
+        stats.push(v > 7 ? 7 : v % 4, false);
+    }
+    // Window is {1, 2, 3, 0, 1, 2, 3, 7, 7, 7}
+    EXPECT_EQ(0, stats.percentile(0).value());
+    EXPECT_EQ(2, stats.percentile(50).value());
+    EXPECT_EQ(7, stats.percentile(90).value());
+    EXPECT_EQ(7, stats.percentile(100).value());
+}
+
+TEST(SlidingWindowStatsTest, matchesBruteForce) {
+    constexpr int32_t kWindow = 50;
+    SlidingWindowStats stats(kWindow);
+    std::deque<int32_t> window;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int32_t> dist(1000, 40000);
+    for (int i = 0; i < 1000; i++) {
+        const int32_t v = dist(rng);
+        stats.push(v, v > 20000);
+        window.push_back(v);
+        if (window.size() > kWindow) {
+            window.pop_front();
+        }
+
+        std::vector<int32_t> sorted(window.begin(), window.end());
+        std::sort(sorted.begin(), sorted.end());
+        int64_t sum = 0;
+        for (auto s : sorted) {
+            sum += s;
+        }
+        ASSERT_EQ(sorted.back(), stats.max().value());
+        ASSERT_EQ(sum / static_cast<int64_t>(sorted.size()), stats.mean().value());
+        ASSERT_EQ(std::count_if(sorted.begin(), sorted.end(), [](auto s) { return s > 20000; }),
+                  stats.missedCount());
+        const int32_t p90 = sorted[(sorted.size() * 90 + 99) / 100 - 1];
+        ASSERT_GE(stats.percentile(90).value(), p90);
+        ASSERT_LE(stats.percentile(90).value(), p90 + p90 / 4);
+    }
+}
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
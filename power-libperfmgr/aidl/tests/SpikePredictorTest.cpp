@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <aidl/android/hardware/power/WorkDuration.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include "TestHelper.h"
+#include "aidl/SpikePredictor.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+using aidl::android::hardware::power::WorkDuration;
+
+static constexpr int64_t kTargetNs = 16666666;
+static constexpr int64_t kHeavyNs = kTargetNs * 3 / 2;
+
+// A synthetic frame with durationMs in total, gpuMs of it on the GPU
+static WorkDuration frame(int64_t durationMs, int64_t gpuMs = 0) {
+    WorkDuration d;
+    d.durationNanos = durationMs * 1000000;
+    d.cpuDurationNanos = (durationMs - gpuMs) * 1000000;
+    d.gpuDurationNanos = gpuMs * 1000000;
+    return d;
+}
+
+struct ReplayResult {
+    int predictions{0};
+    // Predictions followed by a batch with a heavy frame
+    int correct{0};
+};
+
+// Replays a trace the way PowerHintSession reports it, in batches of
+// batchSize frames. A prediction is correct if the next batch has a heavy frame.
+static ReplayResult replay(SpikePredictor &predictor, const std::vector<WorkDuration> &trace,
+                           size_t batchSize = 1) {
+    ReplayResult result;
+    for (size_t i = 0; i < trace.size(); i += batchSize) {
+        const size_t count = std::min(batchSize, trace.size() - i);
+        if (predictor.update(trace.data() + i, count, kHeavyNs)) {
+            result.predictions++;
+            const size_t end = std::min(i + 2 * count, trace.size());
+            if (std::any_of(trace.begin() + i + count, trace.begin() + end,
+                            [](const auto &d) { return d.durationNanos > kHeavyNs; })) {
+                result.correct++;
+            }
+        }
+    }
+    return result;
+}
+
+static std::vector<WorkDuration> periodicTrace(int period, int frames) {
+    std::vector<WorkDuration> trace;
+    for (int i = 0; i < frames; i++) {
+        trace.push_back((i % period == period - 1) ? frame(30, 12) : frame(9 + i % 3, 3));
+    }
+    return trace;
+}
+
+TEST(SpikePredictorTest, predictsPeriodicSpikes) {
+    SpikePredictor predictor;
+    auto result = replay(predictor, periodicTrace(4, 100));
+
+    EXPECT_NEAR(4.0, predictor.period(), 0.01);
+    // Every spike after the ones needed to learn the period is predicted
+    EXPECT_EQ(result.predictions, result.correct);
+    EXPECT_GE(result.correct, 100 / 4 - SpikePredictor::kMinSpikes);
+    EXPECT_EQ(0U, predictor.misses());
+    EXPECT_LE(predictor.unpredicted(), static_cast<uint64_t>(SpikePredictor::kMinSpikes));
+    EXPECT_EQ(30000000, predictor.heavyDurationNs());
+    EXPECT_EQ(12000000, predictor.heavyGpuDurationNs());
+}
+
+TEST(SpikePredictorTest, predictsSpikesInFixtureTrace) {
+    // A physics step every 4th frame with noisy durations, one step a frame late
+    WorkDurationTrace trace;
+    ASSERT_TRUE(loadTraceFixture("physics_step_trace.txt", &trace));
+    ASSERT_EQ(kTargetNs, trace.targetNs);
+    SpikePredictor predictor;
+    auto result = replay(predictor, trace.frames);
+
+    EXPECT_NEAR(4.0, predictor.period(), 0.1);
+    // Only the late step is mispredicted, and it does not break the pattern
+    EXPECT_EQ(1U, predictor.misses());
+    EXPECT_EQ(result.predictions - 1, result.correct);
+    EXPECT_GE(result.correct, 25);
+}
+
+TEST(SpikePredictorTest, predictsAcrossBatches) {
+    SpikePredictor predictor;
+    // A spike lands at the end of every third batch of two frames
+    auto result = replay(predictor, periodicTrace(6, 120), 2);
+    EXPECT_GT(result.predictions, 0);
+    EXPECT_EQ(result.predictions, result.correct);
+    EXPECT_EQ(0U, predictor.misses());
+}
+
+TEST(SpikePredictorTest, toleratesOneFrameJitter) {
+    // Spikes every 8 frames, every 5th of them a frame late
+    std::vector<WorkDuration> trace(160, frame(10));
+    for (int spike = 0; spike < 20; spike++) {
+        trace[spike * 8 + 7 + (spike % 5 == 2)] = frame(28);
+    }
+    SpikePredictor predictor;
+    auto result = replay(predictor, trace);
+    EXPECT_GT(result.correct, 0);
+    EXPECT_GT(predictor.hits(), predictor.misses());
+}
+
+TEST(SpikePredictorTest, noPredictionWithoutPattern) {
+    // Heavy frames at irregular intervals, like app launches
+    const std::vector<int> heavyFrames = {3, 4, 11, 13, 29, 30, 31, 47, 52, 70, 71, 90};
+    std::vector<WorkDuration> trace;
+    for (int i = 0; i < 100; i++) {
+        const bool heavy =
+                std::find(heavyFrames.begin(), heavyFrames.end(), i) != heavyFrames.end();
+        trace.push_back(heavy ? frame(40) : frame(8));
+    }
+    SpikePredictor predictor;
+    auto result = replay(predictor, trace);
+    EXPECT_EQ(0, result.predictions);
+    EXPECT_EQ(heavyFrames.size(), predictor.unpredicted());
+}
+
+TEST(SpikePredictorTest, noPredictionForSteadyLoad) {
+    SpikePredictor predictor;
+    // Every frame is heavy: nothing to predict ahead of
+    std::vector<WorkDuration> heavy(50, frame(30));
+    EXPECT_EQ(0, replay(predictor, heavy).predictions);
+    // No frame is heavy
+    predictor.reset();
+    std::vector<WorkDuration> light(50, frame(10));
+    EXPECT_EQ(0, replay(predictor, light).predictions);
+}
+
+TEST(SpikePredictorTest, stopsPredictingWhenPatternEnds) {
+    SpikePredictor predictor;
+    auto trace = periodicTrace(4, 40);
+    std::vector<WorkDuration> light(40, frame(10));
+    trace.insert(trace.end(), light.begin(), light.end());
+    auto result = replay(predictor, trace);
+
+    // Only the first overdue spike is mispredicted
+    EXPECT_EQ(1U, predictor.misses());
+    EXPECT_EQ(result.predictions - 1, result.correct);
+
+    std::ostringstream dump;
+    predictor.dump(dump);
+    EXPECT_NE(std::string::npos, dump.str().find("Predict.Period.Hit.Miss.Unpredicted"));
+}
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
@@ -16,6 +16,8 @@
 
 #include "TestHelper.h"
 
+#include <android-base/file.h>
+
 namespace aidl::google::hardware::power::impl::pixel {
 
 ::android::perfmgr::AdpfConfig makeMockConfig() {
@@ -43,9 +45,11 @@ namespace aidl::google::hardware::power::impl::pixel {
             true,                     /* GpuBoost */
             25000,                    /* GpuCapacityBoostMax */
             0,                        /* GpuCapacityLoadUpHeadroom */
+            0,                        /* GpuCapacityWriteHysteresis */
             true,                     /* HeuristicBoost_On */
             2,                        /* HBoostModerateJankThreshold */
             4.0,                      /* HBoostOffMaxAvgDurRatio */
+            std::nullopt,             /* HBoostOffP90AvgDurRatio */
             0.5,                      /* HBoostSevereJankPidPu */
             8,                        /* HBoostSevereJankThreshold */
             std::make_pair(480, 800), /* HBoostUclampMinCeilingRange */
@@ -56,9 +60,17 @@ namespace aidl::google::hardware::power::impl::pixel {
             true,                     /* HeuristicRampup */
             1,                        /* DefaultRampupMult */
             4,                        /* HighRampupMult */
+            std::nullopt,             /* PredictiveBoost_On */
+            std::nullopt,             /* PredictiveBoostHeavyFactor */
+            std::nullopt,             /* PredictiveBoostUclampMin */
             480,                      /* UclampMin_LoadUp */
             480,                      /* UclampMin_LoadReset */
             500,                      /* UclampMax_EfficientBase */
             200);                     /* UclampMax_EfficientOffset */
 }
+
+bool loadTraceFixture(const std::string &name, WorkDurationTrace *trace) {
+    return loadWorkDurationTrace(
+            ::android::base::GetExecutableDirectory() + "/aidl/tests/data/" + name, trace);
+}
 }  // namespace aidl::google::hardware::power::impl::pixel
@@ -18,8 +18,15 @@
 
 #include <perfmgr/AdpfConfig.h>
 
+#include <string>
+
+#include "aidl/tools/WorkDurationTrace.h"
+
 namespace aidl::google::hardware::power::impl::pixel {
 
 ::android::perfmgr::AdpfConfig makeMockConfig();
 
+// Loads a trace from aidl/tests/data, installed next to the test binary
+bool loadTraceFixture(const std::string &name, WorkDurationTrace *trace);
+
 }  // namespace aidl::google::hardware::power::impl::pixel
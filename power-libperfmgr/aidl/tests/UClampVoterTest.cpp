@@ -271,6 +271,18 @@ TEST(GpuCapacityVoter, testBasicVoteTimeouts) {
     EXPECT_FALSE(capacity2);
 }
 
+TEST(GpuCapacityVoter, testCapacityDeadline) {
+    auto const now = std::chrono::steady_clock::now();
+    Votes votes;
+    EXPECT_FALSE(votes.getGpuCapacityDeadline(now));
+
+    votes.add(static_cast<int>(AdpfVoteType::GPU_CAPACITY), GpuVote(true, now, 1s, Cycles(100)));
+    votes.add(static_cast<int>(AdpfVoteType::GPU_LOAD_UP), GpuVote(true, now, 200ms, Cycles(50)));
+    EXPECT_THAT(votes.getGpuCapacityDeadline(now + 1ms), Optional(now + 200ms));
+    EXPECT_THAT(votes.getGpuCapacityDeadline(now + 300ms), Optional(now + 1s));
+    EXPECT_FALSE(votes.getGpuCapacityDeadline(now + 2s));
+}
+
 TEST(GpuCapacityVoter, testVoteTimeouts) {
     auto const now = std::chrono::steady_clock::now();
     auto const timeout = 1s;
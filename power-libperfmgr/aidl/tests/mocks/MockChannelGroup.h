@@ -34,6 +34,8 @@ class MockChannelGroup {
     MOCK_METHOD(std::shared_ptr<impl::pixel::SessionChannel>, getChannel, (size_t channelId));
     MOCK_METHOD(void, getFlagDesc, (std::optional<impl::pixel::FlagQueueDesc> * _return_desc),
                 (const));
+    MOCK_METHOD(void, dumpToFd, (int fd), (const));
+    MOCK_METHOD(bool, isCongested, (), (const));
 };
 
 }  // namespace aidl::google::hardware::power::mock::pixel
@@ -45,6 +45,7 @@ class MockPowerSessionManager {
     MOCK_METHOD(void, pause, (int64_t sessionId), ());
     MOCK_METHOD(void, resume, (int64_t sessionId), ());
     MOCK_METHOD(void, dumpToFd, (int fd), ());
+    MOCK_METHOD(void, dumpEventsToFd, (int fd), ());
     MOCK_METHOD(void, updateTargetWorkDuration,
                 (int64_t sessionId, impl::pixel::AdpfVoteType voteId,
                  std::chrono::nanoseconds durationNs),
@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/logging.h>
+#include <android-base/parsedouble.h>
+#include <android-base/parseint.h>
+#include <android-base/strings.h>
+#include <getopt.h>
+#include <perfmgr/HintManager.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "aidl/tools/ReplaySim.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+// "1,2.5,4" to its values
+template <typename T>
+static bool parseList(const std::string &arg, std::vector<T> *values) {
+    values->clear();
+    for (const auto &field : ::android::base::Split(arg, ",")) {
+        T value;
+        bool ok;
+        if constexpr (std::is_floating_point_v<T>) {
+            ok = ::android::base::ParseDouble(field.c_str(), &value);
+        } else {
+            ok = ::android::base::ParseUint(field, &value);
+        }
+        if (!ok) {
+            LOG(ERROR) << "Invalid value '" << field << "' in " << arg;
+            return false;
+        }
+        values->push_back(value);
+    }
+    return !values->empty();
+}
+
+template <typename T>
+static std::vector<std::optional<T>> orDefault(const std::vector<T> &values) {
+    if (values.empty()) {
+        return {std::nullopt};
+    }
+    return {values.begin(), values.end()};
+}
+
+static std::vector<double> orDefault(const std::vector<double> &values, double base) {
+    return values.empty() ? std::vector<double>{base} : values;
+}
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
+
+namespace android {
+namespace perfmgr {
+
+class ProfileLoader : public HintManager {
+  public:
+    // Pins the OTHER tag, which simulated sessions use, to `profile`
+    static std::shared_ptr<AdpfConfig> Load(const std::string &config_path,
+                                            const std::string &profile) {
+        HintManager *hm = HintManager::GetFromJSON(config_path, false);
+        if (!hm) {
+            LOG(ERROR) << "Failed to parse JSON config from " << config_path;
+            return nullptr;
+        }
+        if (!profile.empty() && !hm->SetAdpfProfile("OTHER", profile)) {
+            LOG(ERROR) << "Failed to use ADPF profile " << profile;
+            return nullptr;
+        }
+        return hm->GetAdpfProfile("OTHER");
+    }
+
+  private:
+    ProfileLoader() = delete;
+    ProfileLoader(ProfileLoader const &) = delete;
+    ProfileLoader &operator=(ProfileLoader const &) = delete;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+static void printUsage(const char *exec_name) {
+    std::string usage = exec_name;
+    usage = usage +
+            " replays recorded WorkDuration traces through PowerHintSession against a CPU\n"
+            "capacity model, for a grid of ADPF gains.\n"
+            "Usages:\n"
+            "    " +
+            exec_name +
+            " --config [PATH] --trace [PATH] [options]\n"
+            "\n"
+            "Options:\n"
+            "   --config, -c  [PATH]\n"
+            "       path to Json config file\n\n"
+            "   --profile, -p  [NAME]\n"
+            "       ADPF profile to start from, defaults to the one of the OTHER tag\n\n"
+            "   --trace, -t  [PATH]\n"
+            "       recorded frames, one \"duration_ns [cpu_ns gpu_ns]\" per line\n\n"
+            "   --target_ns, -T  [NS]\n"
+            "       target work duration, overrides the trace's \"# target_ns\" line\n\n"
+            "   --base_capacity, -b  [0-1024]\n"
+            "       capacity the scheduler picks without boost, default 512\n\n"
+            "   --trace_capacity, -r  [0-1024]\n"
+            "       capacity the trace was recorded at, defaults to --base_capacity\n\n"
+            "   --pid_po, --pid_pu, --pid_i, --pid_do, --pid_du  [V1,V2,...]\n"
+            "   --hboost_moderate, --hboost_severe  [V1,V2,...]\n"
+            "       values to sweep, the profile's value if not given\n\n"
+            "   --jobs, -j  [N]\n"
+            "       threads to sweep with, defaults to the number of cores\n\n"
+            "   --help, -h\n"
+            "       print this message\n\n";
+
+    LOG(INFO) << usage;
+}
+
+int main(int argc, char *argv[]) {
+    using namespace aidl::google::hardware::power::impl::pixel;
+    android::base::InitLogging(argv, android::base::StdioLogger);
+
+    std::string config_path;
+    std::string profile;
+    std::string trace_path;
+    int64_t target_ns = 0;
+    int trace_capacity = -1;
+    unsigned jobs = std::thread::hardware_concurrency();
+    CapacityModel model;
+    std::vector<double> po, pu, pi, pdo, pdu;
+    std::vector<uint32_t> moderate, severe;
+
+    enum { kPidPo = 256, kPidPu, kPidI, kPidDo, kPidDu, kHBoostModerate, kHBoostSevere };
+    while (true) {
+        static struct option opts[] = {
+                {"config", required_argument, nullptr, 'c'},
+                {"profile", required_argument, nullptr, 'p'},
+                {"trace", required_argument, nullptr, 't'},
+                {"target_ns", required_argument, nullptr, 'T'},
+                {"base_capacity", required_argument, nullptr, 'b'},
+                {"trace_capacity", required_argument, nullptr, 'r'},
+                {"pid_po", required_argument, nullptr, kPidPo},
+                {"pid_pu", required_argument, nullptr, kPidPu},
+                {"pid_i", required_argument, nullptr, kPidI},
+                {"pid_do", required_argument, nullptr, kPidDo},
+                {"pid_du", required_argument, nullptr, kPidDu},
+                {"hboost_moderate", required_argument, nullptr, kHBoostModerate},
+                {"hboost_severe", required_argument, nullptr, kHBoostSevere},
+                {"jobs", required_argument, nullptr, 'j'},
+                {"help", no_argument, nullptr, 'h'},
+                {0, 0, 0, 0}  // termination of the option list
+        };
+
+        int option_index = 0;
+        int c = getopt_long(argc, argv, "c:p:t:T:b:r:j:h", opts, &option_index);
+        if (c == -1) {
+            break;
+        }
+
+        bool ok = true;
+        switch (c) {
+            case 'c':
+                config_path = optarg;
+                break;
+            case 'p':
+                profile = optarg;
+                break;
+            case 't':
+                trace_path = optarg;
+                break;
+            case 'T':
+                ok = android::base::ParseInt(optarg, &target_ns, int64_t{1});
+                break;
+            case 'b':
+                ok = android::base::ParseInt(optarg, &model.baseCapacity, 1, kUclampMax);
+                break;
+            case 'r':
+                ok = android::base::ParseInt(optarg, &trace_capacity, 1, kUclampMax);
+                break;
+            case 'j':
+                ok = android::base::ParseUint(optarg, &jobs);
+                break;
+            case kPidPo:
+                ok = parseList(optarg, &po);
+                break;
+            case kPidPu:
+                ok = parseList(optarg, &pu);
+                break;
+            case kPidI:
+                ok = parseList(optarg, &pi);
+                break;
+            case kPidDo:
+                ok = parseList(optarg, &pdo);
+                break;
+            case kPidDu:
+                ok = parseList(optarg, &pdu);
+                break;
+            case kHBoostModerate:
+                ok = parseList(optarg, &moderate);
+                break;
+            case kHBoostSevere:
+                ok = parseList(optarg, &severe);
+                break;
+            case 'h':
+                printUsage(argv[0]);
+                return 0;
+            default:
+                // getopt already prints "invalid option -- %c" for us.
+                return 1;
+        }
+        if (!ok) {
+            LOG(ERROR) << "Invalid option value: " << optarg;
+            return 1;
+        }
+    }
+
+    if (config_path.empty() || trace_path.empty()) {
+        LOG(ERROR) << "Need specify JSON config and trace";
+        printUsage(argv[0]);
+        return 1;
+    }
+    model.traceCapacity = trace_capacity > 0 ? trace_capacity : model.baseCapacity;
+
+    WorkDurationTrace trace;
+    if (!loadWorkDurationTrace(trace_path, &trace)) {
+        return 1;
+    }
+    if (target_ns > 0) {
+        trace.targetNs = target_ns;
+    }
+    if (trace.targetNs <= 0) {
+        LOG(ERROR) << "Need a target duration, in the trace or with --target_ns";
+        return 1;
+    }
+
+    auto base = android::perfmgr::ProfileLoader::Load(config_path, profile);
+    if (!base) {
+        return 1;
+    }
+
+    std::vector<Gains> grid;
+    for (double vpo : orDefault(po, base->mPidPo)) {
+        for (double vpu : orDefault(pu, base->mPidPu)) {
+            for (double vi : orDefault(pi, base->mPidI)) {
+                for (double vdo : orDefault(pdo, base->mPidDo)) {
+                    for (double vdu : orDefault(pdu, base->mPidDu)) {
+                        for (auto vmod : orDefault(moderate)) {
+                            for (auto vsev : orDefault(severe)) {
+                                grid.push_back({vpo, vpu, vi, vdo, vdu, vmod, vsev});
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    LOG(INFO) << "Replaying " << trace.frames.size() << " frames for " << grid.size()
+              << " gain sets of profile " << base->mName << " on " << jobs << " threads";
+
+    auto results = sweep(*base, grid, trace, model, jobs);
+
+    // Fewest late frames first, then the cheapest
+    std::vector<size_t> order(grid.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (results[a].jankRate != results[b].jankRate) {
+            return results[a].jankRate < results[b].jankRate;
+        }
+        return results[a].energy < results[b].energy;
+    });
+
+    printf("pid_po,pid_pu,pid_i,pid_do,pid_du,hboost_moderate,hboost_severe,"
+           "jank_rate,mean_uclamp_min,energy,control_latency_frames\n");
+    for (size_t i : order) {
+        const auto &g = grid[i];
+        const auto &r = results[i];
+        printf("%g,%g,%g,%g,%g,%s,%s,%.4f,%.1f,%.3f,%.2f\n", g.pidPo, g.pidPu, g.pidI, g.pidDo,
+               g.pidDu,
+               g.hBoostModerateJankThreshold
+                       ? std::to_string(*g.hBoostModerateJankThreshold).c_str()
+                       : "-",
+               g.hBoostSevereJankThreshold ? std::to_string(*g.hBoostSevereJankThreshold).c_str()
+                                           : "-",
+               r.jankRate, r.meanUclampMin, r.energy, r.controlLatencyFrames);
+    }
+    return 0;
+}
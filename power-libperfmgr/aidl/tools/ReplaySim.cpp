@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ReplaySim.h"
+
+#include <aidl/android/hardware/power/SessionConfig.h>
+#include <aidl/android/hardware/power/SessionTag.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+
+#include "aidl/PowerHintSession.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+using aidl::android::hardware::power::SessionConfig;
+using aidl::android::hardware::power::SessionTag;
+using ::android::perfmgr::AdpfConfig;
+
+// The session logic is the real one, the PowerSessionManager only records
+// votes
+using SimPowerHintSession = PowerHintSession<SimHintManager, SimPowerSessionManager>;
+
+void SimPowerSessionManager::removePowerSession(int64_t sessionId) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mVotes.erase(sessionId);
+}
+
+void SimPowerSessionManager::voteSet(int64_t sessionId, AdpfVoteType voteId, int uclampMin, int,
+                                     std::chrono::steady_clock::time_point,
+                                     std::chrono::nanoseconds) {
+    const auto vid = static_cast<size_t>(voteId);
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (vid < mVotes[sessionId].size()) {
+        mVotes[sessionId][vid] = uclampMin;
+    }
+}
+
+void SimPowerSessionManager::disableBoosts(int64_t sessionId) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto &votes = mVotes[sessionId];
+    const int pidVote = votes[static_cast<size_t>(AdpfVoteType::CPU_VOTE_DEFAULT)];
+    votes.fill(0);
+    votes[static_cast<size_t>(AdpfVoteType::CPU_VOTE_DEFAULT)] = pidVote;
+}
+
+int SimPowerSessionManager::uclampMin(int64_t sessionId) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    const auto &votes = mVotes[sessionId];
+    return *std::max_element(votes.begin(), votes.end());
+}
+
+SimResult simulate(const std::shared_ptr<AdpfConfig> &profile, const WorkDurationTrace &trace,
+                   const CapacityModel &model) {
+    auto session = ndk::SharedRefBase::make<SimPowerHintSession>(
+            getpid(), getuid(), std::vector<int32_t>{gettid()}, trace.targetNs,
+            SessionTag::OTHER);
+    session->setAdpfProfile(profile);
+    session->updateTargetWorkDuration(trace.targetNs);
+    SessionConfig config;
+    session->getSessionConfig(&config);
+
+    auto psm = SimPowerSessionManager::getInstance();
+    SimResult result;
+    double energy = 0;
+    double energyUnboosted = 0;
+    double uclampTime = 0;
+    double totalTime = 0;
+    int64_t lateFrames = 0;
+    int64_t lateRuns = 0;
+    bool late = false;
+    int64_t startNs = 0;
+    for (const auto &recorded : trace.frames) {
+        // The vote of the last report applies to this frame
+        const int uclampMin = psm->uclampMin(config.id);
+        WorkDuration frame = recorded;
+        frame.durationNanos = model.durationNs(recorded, uclampMin);
+        frame.cpuDurationNanos = model.cpuDurationNs(recorded, uclampMin);
+        frame.workPeriodStartTimestampNanos = startNs;
+        frame.timeStampNanos = startNs + frame.durationNanos;
+        startNs += std::max(frame.durationNanos, trace.targetNs);
+
+        energy += model.energy(recorded, uclampMin);
+        energyUnboosted += model.energy(recorded, 0);
+        uclampTime += static_cast<double>(uclampMin) * frame.durationNanos;
+        totalTime += frame.durationNanos;
+        if (frame.durationNanos > trace.targetNs) {
+            lateFrames++;
+            lateRuns += !late;
+            late = true;
+        } else {
+            late = false;
+        }
+        session->reportActualWorkDuration({frame});
+    }
+    session->close();
+
+    result.jankRate = static_cast<double>(lateFrames) / trace.frames.size();
+    result.meanUclampMin = totalTime > 0 ? uclampTime / totalTime : 0;
+    result.energy = energyUnboosted > 0 ? energy / energyUnboosted : 1;
+    result.controlLatencyFrames = lateRuns > 0 ? static_cast<double>(lateFrames) / lateRuns : 0;
+    return result;
+}
+
+std::shared_ptr<AdpfConfig> applyGains(const AdpfConfig &base, const Gains &gains) {
+    auto config = std::make_shared<AdpfConfig>(base);
+    config->mPidPo = gains.pidPo;
+    config->mPidPu = gains.pidPu;
+    config->mPidI = gains.pidI;
+    config->mPidDo = gains.pidDo;
+    config->mPidDu = gains.pidDu;
+    if (config->mHeuristicBoostOn.value_or(false)) {
+        if (gains.hBoostModerateJankThreshold) {
+            config->mHBoostModerateJankThreshold = gains.hBoostModerateJankThreshold;
+        }
+        if (gains.hBoostSevereJankThreshold) {
+            config->mHBoostSevereJankThreshold = gains.hBoostSevereJankThreshold;
+        }
+    }
+    return config;
+}
+
+std::vector<SimResult> sweep(const AdpfConfig &base, const std::vector<Gains> &grid,
+                             const WorkDurationTrace &trace, const CapacityModel &model,
+                             unsigned jobs) {
+    std::vector<SimResult> results(grid.size());
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < std::max(1u, jobs); i++) {
+        workers.emplace_back([&]() {
+            for (size_t point = next++; point < grid.size(); point = next++) {
+                results[point] = simulate(applyGains(base, grid[point]), trace, model);
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    return results;
+}
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
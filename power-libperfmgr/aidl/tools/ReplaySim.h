@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <aidl/AdpfTypes.h>
+#include <aidl/AppDescriptorTrace.h>
+#include <aidl/AppHintDesc.h>
+#include <aidl/PhysicalQuantityTypes.h>
+#include <aidl/SessionMetrics.h>
+#include <android-base/thread_annotations.h>
+#include <perfmgr/AdpfConfig.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "WorkDurationTrace.h"
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+// Stands in for HintManager where PowerHintSession reaches it through its
+// template parameter. Boost hints are not simulated.
+class SimHintManager {
+  public:
+    bool IsHintSupported(const std::string &) const { return false; }
+    bool DoHint(const std::string &) { return false; }
+    bool DoHint(const std::string &, std::chrono::milliseconds) { return false; }
+
+    static SimHintManager *GetInstance() {
+        static SimHintManager instance{};
+        return &instance;
+    }
+};
+
+// Stands in for PowerSessionManager, keeping only the uclamp.min votes of
+// every simulated session
+class SimPowerSessionManager {
+  public:
+    void addPowerSession(const std::string &, const std::shared_ptr<AppHintDesc> &,
+                         const std::shared_ptr<AppDescriptorTrace> &, const bool,
+                         const std::vector<int32_t> &) {}
+    void removePowerSession(int64_t sessionId);
+    void setThreadsFromPowerSession(int64_t, const std::vector<int32_t> &) {}
+    void pause(int64_t) {}
+    void resume(int64_t) {}
+    void updateTargetWorkDuration(int64_t, AdpfVoteType, std::chrono::nanoseconds) {}
+    void voteSet(int64_t sessionId, AdpfVoteType voteId, int uclampMin, int uclampMax,
+                 std::chrono::steady_clock::time_point startTime,
+                 std::chrono::nanoseconds durationNs);
+    void voteSet(int64_t, AdpfVoteType, Cycles, std::chrono::steady_clock::time_point,
+                 std::chrono::nanoseconds) {}
+    // Like PowerSessionManager::disableBoosts(), only the PID vote survives
+    // a new report
+    void disableBoosts(int64_t sessionId);
+    void setPreferPowerEfficiency(int64_t, bool) {}
+    std::optional<Frequency> gpuFrequency() const { return {}; }
+    void updateHboostStatistics(int64_t, SessionJankyLevel, int32_t) {}
+    bool getGameModeEnableState() { return false; }
+    bool hasValidTaskRampupMultNode() { return false; }
+    void updateFrameMetrics(int64_t, const FrameTimingMetrics &) {}
+    void updateRampupBoostMode(int64_t, SessionJankyLevel, int32_t, int32_t) {}
+    void updateCollectedSessionMetrics(int64_t) {}
+    bool areAllSessionsTimeout() { return false; }
+
+    // Highest uclamp.min the session votes for
+    int uclampMin(int64_t sessionId);
+
+    static SimPowerSessionManager *getInstance() {
+        static SimPowerSessionManager instance{};
+        return &instance;
+    }
+
+  private:
+    std::mutex mMutex;
+    std::unordered_map<int64_t, std::array<int, static_cast<size_t>(AdpfVoteType::VOTE_TYPE_SIZE)>>
+            mVotes GUARDED_BY(mMutex);
+};
+
+// The CPU part of a frame scales with the capacity it runs at, the rest (GPU,
+// waiting) does not. Without a uclamp.min vote the scheduler picks
+// baseCapacity; the trace was recorded at traceCapacity.
+struct CapacityModel {
+    int baseCapacity{512};
+    int traceCapacity{512};
+
+    int capacity(int uclampMin) const { return std::clamp(uclampMin, baseCapacity, kUclampMax); }
+
+    int64_t cpuWork(const WorkDuration &recorded) const {
+        return std::min(recorded.cpuDurationNanos, recorded.durationNanos) * traceCapacity;
+    }
+
+    int64_t cpuDurationNs(const WorkDuration &recorded, int uclampMin) const {
+        return cpuWork(recorded) / capacity(uclampMin);
+    }
+
+    int64_t durationNs(const WorkDuration &recorded, int uclampMin) const {
+        const int64_t otherNs =
+                recorded.durationNanos - std::min(recorded.cpuDurationNanos, recorded.durationNanos);
+        return otherNs + cpuDurationNs(recorded, uclampMin);
+    }
+
+    // Dynamic power grows about with the square of the voltage, which tracks
+    // the frequency: the energy of some work is proportional to capacity^2.
+    double energy(const WorkDuration &recorded, int uclampMin) const {
+        const double scale = static_cast<double>(capacity(uclampMin)) / kUclampMax;
+        return static_cast<double>(cpuWork(recorded)) * scale * scale;
+    }
+};
+
+// A point of the gain grid. Unset thresholds keep the profile's.
+struct Gains {
+    double pidPo;
+    double pidPu;
+    double pidI;
+    double pidDo;
+    double pidDu;
+    std::optional<uint32_t> hBoostModerateJankThreshold;
+    std::optional<uint32_t> hBoostSevereJankThreshold;
+};
+
+struct SimResult {
+    // Frames over the target
+    double jankRate{0};
+    // Average uclamp.min over time
+    double meanUclampMin{0};
+    // CPU energy relative to running the trace without any boost
+    double energy{0};
+    // Average frames from a late frame to the next frame on time
+    double controlLatencyFrames{0};
+};
+
+// Replay trace through a new PowerHintSession running profile, feeding each
+// frame the capacity the previous report voted for
+SimResult simulate(const std::shared_ptr<::android::perfmgr::AdpfConfig> &profile,
+                   const WorkDurationTrace &trace, const CapacityModel &model);
+std::shared_ptr<::android::perfmgr::AdpfConfig> applyGains(
+        const ::android::perfmgr::AdpfConfig &base, const Gains &gains);
+// Runs every grid point on its own session, spread over jobs threads. The
+// results are in the order of grid.
+std::vector<SimResult> sweep(const ::android::perfmgr::AdpfConfig &base,
+                             const std::vector<Gains> &grid, const WorkDurationTrace &trace,
+                             const CapacityModel &model, unsigned jobs);
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
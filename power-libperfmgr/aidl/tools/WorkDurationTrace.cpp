@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WorkDurationTrace.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/parseint.h>
+#include <android-base/strings.h>
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+bool parseWorkDurationTrace(const std::string &content, WorkDurationTrace *trace) {
+    trace->frames.clear();
+    for (auto &line : ::android::base::Split(content, "\n")) {
+        line = ::android::base::Trim(line);
+        if (line.empty()) {
+            continue;
+        }
+        if (line[0] == '#') {
+            auto fields = ::android::base::Tokenize(line, "# \t");
+            if (fields.size() == 2 && fields[0] == "target_ns" &&
+                !::android::base::ParseInt(fields[1], &trace->targetNs, int64_t{1})) {
+                LOG(ERROR) << "Invalid target in trace: " << line;
+                return false;
+            }
+            continue;
+        }
+        auto fields = ::android::base::Tokenize(line, ", \t");
+        WorkDuration frame;
+        if (fields.empty() || fields.size() == 2 ||
+            !::android::base::ParseInt(fields[0], &frame.durationNanos, int64_t{1}) ||
+            (fields.size() >= 3 &&
+             (!::android::base::ParseInt(fields[1], &frame.cpuDurationNanos, int64_t{0}) ||
+              !::android::base::ParseInt(fields[2], &frame.gpuDurationNanos, int64_t{0})))) {
+            LOG(ERROR) << "Invalid frame in trace: " << line;
+            return false;
+        }
+        if (fields.size() == 1) {
+            frame.cpuDurationNanos = frame.durationNanos;
+        }
+        trace->frames.push_back(frame);
+    }
+    return !trace->frames.empty();
+}
+
+bool loadWorkDurationTrace(const std::string &path, WorkDurationTrace *trace) {
+    std::string content;
+    if (!::android::base::ReadFileToString(path, &content)) {
+        LOG(ERROR) << "Failed to read trace from " << path;
+        return false;
+    }
+    return parseWorkDurationTrace(content, trace);
+}
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
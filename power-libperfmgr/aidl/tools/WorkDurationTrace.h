@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <aidl/android/hardware/power/WorkDuration.h>
+
+#include <string>
+#include <vector>
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+using aidl::android::hardware::power::WorkDuration;
+
+// WorkDurations of a session as recorded on a device, one per frame
+struct WorkDurationTrace {
+    int64_t targetNs{0};
+    std::vector<WorkDuration> frames;
+};
+
+// One line per frame: "duration_ns [cpu_duration_ns gpu_duration_ns]",
+// separated by spaces or commas. A "# target_ns N" line sets the target,
+// other lines starting with '#' are comments. Only the durations are set in
+// the frames, the timestamps are left to whoever replays them.
+bool parseWorkDurationTrace(const std::string &content, WorkDurationTrace *trace);
+bool loadWorkDurationTrace(const std::string &path, WorkDurationTrace *trace);
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "powerhal-libperfmgr"
+
+#include "DisplayEventLoop.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <log/log.h>
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+namespace {
+
+constexpr int kMaxEvents = 8;
+
+}  // namespace
+
+DisplayEventLoop::DisplayEventLoop() {
+    mEpollFd.reset(epoll_create1(EPOLL_CLOEXEC));
+    mWakeFd.reset(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+    if (mEpollFd.get() < 0 || mWakeFd.get() < 0) {
+        ALOGE("Unable to create display event loop (%s)", strerror(errno));
+        return;
+    }
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = mWakeFd.get();
+    if (epoll_ctl(mEpollFd.get(), EPOLL_CTL_ADD, mWakeFd.get(), &ev) < 0) {
+        ALOGE("Unable to watch display event loop wake fd (%s)", strerror(errno));
+    }
+}
+
+DisplayEventLoop::~DisplayEventLoop() {
+    Stop();
+}
+
+bool DisplayEventLoop::Start() {
+    if (mEpollFd.get() < 0 || mWakeFd.get() < 0) {
+        return false;
+    }
+    if (mThread.joinable()) {
+        return true;
+    }
+    mStop = false;
+    mThread = std::thread(&DisplayEventLoop::Loop, this);
+    return true;
+}
+
+void DisplayEventLoop::Stop() {
+    if (!mThread.joinable()) {
+        return;
+    }
+    mStop = true;
+    uint64_t val = 1;
+    if (write(mWakeFd.get(), &val, sizeof(val)) != sizeof(val)) {
+        ALOGW("Unable to wake display event loop (%s)", strerror(errno));
+    }
+    mThread.join();
+}
+
+bool DisplayEventLoop::AddFd(int fd, uint32_t events, FdHandler handler, bool armed) {
+    std::lock_guard<std::mutex> lk(mLock);
+    if (armed) {
+        struct epoll_event ev = {};
+        ev.events = events;
+        ev.data.fd = fd;
+        if (epoll_ctl(mEpollFd.get(), EPOLL_CTL_ADD, fd, &ev) < 0) {
+            ALOGE("Unable to watch fd %d in display event loop (%s)", fd, strerror(errno));
+            return false;
+        }
+    }
+    mWatches[fd] = {std::make_shared<FdHandler>(std::move(handler)), events, armed};
+    return true;
+}
+
+bool DisplayEventLoop::SetFdArmed(int fd, bool armed) {
+    std::lock_guard<std::mutex> lk(mLock);
+    auto it = mWatches.find(fd);
+    if (it == mWatches.end()) {
+        return false;
+    }
+    if (it->second.armed == armed) {
+        return true;
+    }
+    // EPOLLERR is always reported, so removing the fd is the only way to
+    // stop a sysfs node from waking the loop
+    struct epoll_event ev = {};
+    ev.events = it->second.events;
+    ev.data.fd = fd;
+    if (epoll_ctl(mEpollFd.get(), armed ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, fd, &ev) < 0) {
+        ALOGE("Unable to %s fd %d in display event loop (%s)", armed ? "arm" : "disarm", fd,
+              strerror(errno));
+        return false;
+    }
+    it->second.armed = armed;
+    return true;
+}
+
+void DisplayEventLoop::RemoveFd(int fd) {
+    {
+        std::lock_guard<std::mutex> lk(mLock);
+        auto it = mWatches.find(fd);
+        if (it == mWatches.end()) {
+            return;
+        }
+        if (it->second.armed) {
+            epoll_ctl(mEpollFd.get(), EPOLL_CTL_DEL, fd, nullptr);
+        }
+        mWatches.erase(it);
+    }
+    // Wait out a handler the loop may be running for fd
+    if (std::this_thread::get_id() != mThread.get_id()) {
+        std::lock_guard<std::mutex> dispatch(mDispatchLock);
+    }
+}
+
+int DisplayEventLoop::AddTimer(TimerHandler handler) {
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer < 0) {
+        ALOGE("Unable to create timer fd (%s)", strerror(errno));
+        return -1;
+    }
+    auto fired = [timer, handler = std::move(handler)](uint32_t) {
+        uint64_t expirations;
+        // Disarmed or rearmed since the event was queued
+        if (read(timer, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+            return;
+        }
+        handler();
+    };
+    if (!AddFd(timer, EPOLLIN, std::move(fired))) {
+        close(timer);
+        return -1;
+    }
+    return timer;
+}
+
+bool DisplayEventLoop::ArmTimer(int timer, std::chrono::milliseconds delay) {
+    struct itimerspec spec = {};
+    const auto secs = std::chrono::duration_cast<std::chrono::seconds>(delay);
+    spec.it_value.tv_sec = secs.count();
+    spec.it_value.tv_nsec = std::chrono::nanoseconds(delay - secs).count();
+    if (timerfd_settime(timer, 0, &spec, nullptr) < 0) {
+        ALOGE("Unable to arm timer fd %d (%s)", timer, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void DisplayEventLoop::RemoveTimer(int timer) {
+    if (timer < 0) {
+        return;
+    }
+    RemoveFd(timer);
+    close(timer);
+}
+
+void DisplayEventLoop::Loop() {
+    pthread_setname_np(pthread_self(), "DispEvent");
+    struct epoll_event events[kMaxEvents];
+
+    while (!mStop) {
+        int n = epoll_wait(mEpollFd.get(), events, kMaxEvents, -1);
+        if (n < 0) {
+            if (errno != EINTR) {
+                ALOGE("Display event loop wait failed (%s)", strerror(errno));
+                return;
+            }
+            continue;
+        }
+        for (int i = 0; i < n && !mStop; i++) {
+            const int fd = events[i].data.fd;
+            if (fd == mWakeFd.get()) {
+                uint64_t val;
+                ssize_t ret = read(fd, &val, sizeof(val));
+                ALOGW_IF(ret < 0, "%s: failed to clear wake fd (%zd, %d)", __func__, ret, errno);
+                continue;
+            }
+            std::lock_guard<std::mutex> dispatch(mDispatchLock);
+            std::shared_ptr<FdHandler> handler;
+            {
+                std::lock_guard<std::mutex> lk(mLock);
+                auto it = mWatches.find(fd);
+                if (it == mWatches.end() || !it->second.armed) {
+                    continue;
+                }
+                handler = it->second.handler;
+            }
+            (*handler)(events[i].events);
+        }
+    }
+}
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
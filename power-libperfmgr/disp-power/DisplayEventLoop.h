@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <android-base/unique_fd.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace impl {
+namespace pixel {
+
+// A single epoll thread for the display side of the HAL. Fds and timerfds
+// are watched here and their handlers run on the loop thread, so nothing
+// sleeps in poll() on its own thread between display events.
+class DisplayEventLoop {
+  public:
+    using FdHandler = std::function<void(uint32_t events)>;
+    using TimerHandler = std::function<void()>;
+
+    DisplayEventLoop();
+    ~DisplayEventLoop();
+    DisplayEventLoop(const DisplayEventLoop &) = delete;
+    DisplayEventLoop &operator=(const DisplayEventLoop &) = delete;
+
+    bool Start();
+    void Stop();
+
+    // Watch fd for epoll events. The fd stays owned by the caller, who must
+    // remove it before closing it. An fd added disarmed is not polled until
+    // SetFdArmed() arms it.
+    bool AddFd(int fd, uint32_t events, FdHandler handler, bool armed = true);
+    // Start or stop polling fd, keeping its handler. Events already queued
+    // for a disarmed fd are dropped.
+    bool SetFdArmed(int fd, bool armed);
+    // On return the handler of fd is not running and will not run again,
+    // unless called from that handler.
+    void RemoveFd(int fd);
+
+    // One-shot timers, returning -1 on failure
+    int AddTimer(TimerHandler handler);
+    // Arm the timer to fire once after delay, replacing any pending
+    // expiration. A zero delay disarms it.
+    bool ArmTimer(int timer, std::chrono::milliseconds delay);
+    void RemoveTimer(int timer);
+
+  private:
+    struct Watch {
+        std::shared_ptr<FdHandler> handler;
+        uint32_t events;
+        bool armed;
+    };
+
+    void Loop();
+
+    ::android::base::unique_fd mEpollFd;
+    ::android::base::unique_fd mWakeFd;
+    std::mutex mLock;
+    std::unordered_map<int, Watch> mWatches GUARDED_BY(mLock);
+    // Held by the loop thread while a handler runs
+    std::mutex mDispatchLock;
+    std::thread mThread;
+    std::atomic<bool> mStop{false};
+};
+
+}  // namespace pixel
+}  // namespace impl
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
@@ -19,17 +19,20 @@
 
 #include "InteractionHandler.h"
 
+#include <android-base/file.h>
 #include <android-base/properties.h>
+#include <android-base/stringprintf.h>
 #include <fcntl.h>
 #include <perfmgr/HintManager.h>
-#include <poll.h>
-#include <sys/eventfd.h>
+#include <sys/epoll.h>
 #include <time.h>
 #include <unistd.h>
 #include <utils/Log.h>
 #include <utils/Trace.h>
 
 #include <array>
+#include <cinttypes>
+#include <cstring>
 #include <memory>
 
 #define MAX_LENGTH 64
@@ -59,6 +62,9 @@ static const uint32_t kMaxDurationMs =
         ::android::base::GetUintProperty("vendor.powerhal.interaction.max", /*default*/ 5650U);
 static const uint32_t kDurationOffsetMs =
         ::android::base::GetUintProperty("vendor.powerhal.interaction.offset", /*default*/ 650U);
+// 0 releases the boost as soon as the display goes idle
+static const uint32_t kCoalesceMs =
+        ::android::base::GetUintProperty("vendor.powerhal.interaction.coalesce", /*default*/ 0U);
 
 static size_t CalcTimespecDiffMs(struct timespec start, struct timespec end) {
     size_t diff_in_ms = 0;
@@ -82,8 +88,17 @@ static int FbIdleOpen(void) {
 
 using ::android::perfmgr::HintManager;
 
-InteractionHandler::InteractionHandler()
-    : mState(INTERACTION_STATE_UNINITIALIZED), mDurationMs(0) {}
+InteractionHandler::InteractionHandler(std::shared_ptr<DisplayEventLoop> loop)
+    : mCoalesceWindow(kCoalesceMs),
+      mLoop(std::move(loop)),
+      mState(INTERACTION_STATE_UNINITIALIZED),
+      mIdleFd(-1),
+      mTimer(-1),
+      mDurationMs(0),
+      mBoosts(0),
+      mCoalesced(0),
+      mReleases(0),
+      mBoostTime(0) {}
 
 InteractionHandler::~InteractionHandler() {
     Exit();
@@ -95,37 +110,43 @@ bool InteractionHandler::Init() {
     if (mState != INTERACTION_STATE_UNINITIALIZED)
         return true;
 
-    int fd = FbIdleOpen();
+    if (!mLoop)
+        return false;
+
+    int fd = OpenIdleFd();
     if (fd < 0)
         return false;
     mIdleFd = fd;
 
-    mEventFd = eventfd(0, EFD_NONBLOCK);
-    if (mEventFd < 0) {
-        ALOGE("Unable to create event fd (%d)", errno);
+    mTimer = mLoop->AddTimer([this]() { OnTimer(); });
+    if (mTimer < 0) {
+        close(mIdleFd);
+        return false;
+    }
+    // sysfs_notify() on the idle node shows up as EPOLLPRI | EPOLLERR. It is
+    // only armed while waiting for idle.
+    if (!mLoop->AddFd(mIdleFd, EPOLLPRI | EPOLLERR, [this](uint32_t) { OnIdleEvent(); },
+                      /*armed*/ false)) {
+        mLoop->RemoveTimer(mTimer);
         close(mIdleFd);
         return false;
     }
 
     mState = INTERACTION_STATE_IDLE;
-    mThread = std::unique_ptr<std::thread>(new std::thread(&InteractionHandler::Routine, this));
-
     return true;
 }
 
 void InteractionHandler::Exit() {
-    std::unique_lock<std::mutex> lk(mLock);
-    if (mState == INTERACTION_STATE_UNINITIALIZED)
-        return;
-
-    AbortWaitLocked();
-    mState = INTERACTION_STATE_UNINITIALIZED;
-    lk.unlock();
-
-    mCond.notify_all();
-    mThread->join();
+    {
+        std::lock_guard<std::mutex> lk(mLock);
+        if (mState == INTERACTION_STATE_UNINITIALIZED)
+            return;
+        mState = INTERACTION_STATE_UNINITIALIZED;
+    }
 
-    close(mEventFd);
+    // Handlers take mLock, remove them without it
+    mLoop->RemoveTimer(mTimer);
+    mLoop->RemoveFd(mIdleFd);
     close(mIdleFd);
 }
 
@@ -167,7 +188,8 @@ void InteractionHandler::Acquire(int32_t duration) {
 
     struct timespec cur_timespec;
     clock_gettime(CLOCK_MONOTONIC, &cur_timespec);
-    if (mState != INTERACTION_STATE_IDLE && finalDuration <= mDurationMs) {
+    if (mState != INTERACTION_STATE_IDLE && mState != INTERACTION_STATE_LINGER &&
+        finalDuration <= mDurationMs) {
         size_t elapsed_time = CalcTimespecDiffMs(mLastTimespec, cur_timespec);
         // don't hint if previous hint's duration covers this hint's duration
         if (elapsed_time <= (mDurationMs - finalDuration)) {
@@ -182,97 +204,107 @@ void InteractionHandler::Acquire(int32_t duration) {
 
     ALOGV("%s: input: %d final duration: %d", __func__, duration, finalDuration);
 
-    if (mState == INTERACTION_STATE_WAITING)
-        AbortWaitLocked();
-    else if (mState == INTERACTION_STATE_IDLE)
+    if (mState == INTERACTION_STATE_IDLE) {
         PerfLock();
-
-    mState = INTERACTION_STATE_INTERACTION;
-    mCond.notify_one();
-}
-
-void InteractionHandler::Release() {
-    std::lock_guard<std::mutex> lk(mLock);
-    if (mState == INTERACTION_STATE_WAITING) {
-        ATRACE_CALL();
-        PerfRel();
-        mState = INTERACTION_STATE_IDLE;
+        mBoosts++;
+        mBoostStart = std::chrono::steady_clock::now();
     } else {
-        // clear any wait aborts pending in event fd
-        uint64_t val;
-        ssize_t ret = read(mEventFd, &val, sizeof(val));
-
-        ALOGW_IF(ret < 0, "%s: failed to clear eventfd (%zd, %d)", __func__, ret, errno);
+        // Extend the boost held, rather than releasing it and taking it again
+        mCoalesced++;
     }
+
+    // Give the display kWaitMs to start updating before watching for idle
+    SetStateLocked(INTERACTION_STATE_INTERACTION);
+    mLoop->ArmTimer(mTimer, std::chrono::milliseconds(kWaitMs));
 }
 
-// should be called while locked
-void InteractionHandler::AbortWaitLocked() {
-    uint64_t val = 1;
-    ssize_t ret = write(mEventFd, &val, sizeof(val));
-    if (ret != sizeof(val))
-        ALOGW("Unable to write to event fd (%zd)", ret);
+int InteractionHandler::OpenIdleFd() {
+    return FbIdleOpen();
 }
 
-void InteractionHandler::WaitForIdle(int32_t wait_ms, int32_t timeout_ms) {
+bool InteractionHandler::IsDisplayIdle() {
     char data[MAX_LENGTH];
-    ssize_t ret;
-    struct pollfd pfd[2];
+    // Reading also rearms the sysfs notification
+    ssize_t ret = pread(mIdleFd, data, sizeof(data), 0);
+    if (ret <= 0) {
+        ALOGE("%s: Unexpected EOF!", __func__);
+        return false;
+    }
+    return !strncmp(data, "idle", 4);
+}
 
+void InteractionHandler::OnTimer() {
     ATRACE_CALL();
-
-    ALOGV("%s: wait:%d timeout:%d", __func__, wait_ms, timeout_ms);
-
-    pfd[0].fd = mEventFd;
-    pfd[0].events = POLLIN;
-    pfd[1].fd = mIdleFd;
-    pfd[1].events = POLLPRI | POLLERR;
-
-    ret = poll(pfd, 1, wait_ms);
-    if (ret > 0) {
-        ALOGV("%s: wait aborted", __func__);
-        return;
-    } else if (ret < 0) {
-        ALOGE("%s: error in poll while waiting", __func__);
-        return;
+    std::lock_guard<std::mutex> lk(mLock);
+    switch (mState) {
+        case INTERACTION_STATE_INTERACTION:
+            if (IsDisplayIdle()) {
+                ALOGV("%s: already idle", __func__);
+                StartLingerLocked();
+                break;
+            }
+            SetStateLocked(INTERACTION_STATE_WAITING);
+            mLoop->ArmTimer(mTimer, std::chrono::milliseconds(mDurationMs));
+            break;
+        case INTERACTION_STATE_WAITING:
+            ALOGV("%s: timed out waiting for idle", __func__);
+            StartLingerLocked();
+            break;
+        case INTERACTION_STATE_LINGER:
+            ReleaseLocked();
+            break;
+        default:
+            break;
     }
+}
 
-    ret = pread(mIdleFd, data, sizeof(data), 0);
-    if (!ret) {
-        ALOGE("%s: Unexpected EOF!", __func__);
+void InteractionHandler::OnIdleEvent() {
+    std::lock_guard<std::mutex> lk(mLock);
+    if (mState != INTERACTION_STATE_WAITING)
         return;
+    if (IsDisplayIdle()) {
+        ALOGV("%s: idle detected", __func__);
+        StartLingerLocked();
     }
+}
 
-    if (!strncmp(data, "idle", 4)) {
-        ALOGV("%s: already idle", __func__);
+void InteractionHandler::StartLingerLocked() {
+    if (mCoalesceWindow.count() == 0) {
+        ReleaseLocked();
         return;
     }
-
-    ret = poll(pfd, 2, timeout_ms);
-    if (ret < 0)
-        ALOGE("%s: Error on waiting for idle (%zd)", __func__, ret);
-    else if (ret == 0)
-        ALOGV("%s: timed out waiting for idle", __func__);
-    else if (pfd[0].revents)
-        ALOGV("%s: wait for idle aborted", __func__);
-    else if (pfd[1].revents)
-        ALOGV("%s: idle detected", __func__);
+    SetStateLocked(INTERACTION_STATE_LINGER);
+    mLoop->ArmTimer(mTimer, mCoalesceWindow);
 }
 
-void InteractionHandler::Routine() {
-    pthread_setname_np(pthread_self(), "DispIdle");
-    std::unique_lock<std::mutex> lk(mLock, std::defer_lock);
+void InteractionHandler::ReleaseLocked() {
+    ATRACE_CALL();
+    PerfRel();
+    mReleases++;
+    mBoostTime += std::chrono::steady_clock::now() - mBoostStart;
+    SetStateLocked(INTERACTION_STATE_IDLE);
+}
 
-    while (true) {
-        lk.lock();
-        mCond.wait(lk, [&] { return mState != INTERACTION_STATE_IDLE; });
-        if (mState == INTERACTION_STATE_UNINITIALIZED)
-            return;
-        mState = INTERACTION_STATE_WAITING;
-        lk.unlock();
+void InteractionHandler::SetStateLocked(InteractionState state) {
+    const bool waiting = state == INTERACTION_STATE_WAITING;
+    if (waiting != (mState == INTERACTION_STATE_WAITING)) {
+        mLoop->SetFdArmed(mIdleFd, waiting);
+    }
+    mState = state;
+}
 
-        WaitForIdle(kWaitMs, mDurationMs);
-        Release();
+void InteractionHandler::DumpToFd(int fd) {
+    std::lock_guard<std::mutex> lk(mLock);
+    const double avgMs =
+            mReleases ? std::chrono::duration<double, std::milli>(mBoostTime).count() / mReleases
+                      : 0.0;
+    std::string buf(::android::base::StringPrintf(
+            "Interaction boosts: %" PRIu64 ", coalesced: %" PRIu64 ", avg length: %.1fms, "
+            "display idle wait: %s\n",
+            mBoosts, mCoalesced, avgMs,
+            (kDisplayIdleSupport && mState != INTERACTION_STATE_UNINITIALIZED) ? "on" : "off"));
+    if (!::android::base::WriteStringToFd(buf, fd)) {
+        ALOGE("Failed to dump interaction stats to fd:%d", fd);
     }
 }
 
@@ -16,11 +16,12 @@
 
 #pragma once
 
-#include <condition_variable>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <string>
-#include <thread>
+
+#include "DisplayEventLoop.h"
 
 namespace aidl {
 namespace google {
@@ -34,33 +35,58 @@ enum InteractionState {
     INTERACTION_STATE_IDLE,
     INTERACTION_STATE_INTERACTION,
     INTERACTION_STATE_WAITING,
+    // Display went idle, the boost is held for the coalesce window in case
+    // another interaction follows
+    INTERACTION_STATE_LINGER,
 };
 
+// Holds the INTERACTION hint from an interaction until the display goes idle
+// or the interaction's duration runs out. Timeouts and idle notifications
+// are handled on the shared DisplayEventLoop.
 class InteractionHandler {
   public:
-    InteractionHandler();
-    ~InteractionHandler();
+    explicit InteractionHandler(std::shared_ptr<DisplayEventLoop> loop);
+    virtual ~InteractionHandler();
     bool Init();
     void Exit();
     void Acquire(int32_t duration);
+    void DumpToFd(int fd);
+
+  protected:
+    // The display idle node, overridden by tests. The fd is watched for
+    // EPOLLPRI | EPOLLERR and closed by Exit().
+    virtual int OpenIdleFd();
+    virtual bool IsDisplayIdle();
+
+    // How long the boost is held once the display goes idle, 0 releases it
+    // right away
+    std::chrono::milliseconds mCoalesceWindow;
 
   private:
-    void Release();
-    void WaitForIdle(int32_t wait_ms, int32_t timeout_ms);
-    void AbortWaitLocked();
-    void Routine();
+    void OnTimer();
+    void OnIdleEvent();
+    void StartLingerLocked();
+    void ReleaseLocked();
+    // Arms the idle fd while in INTERACTION_STATE_WAITING only
+    void SetStateLocked(InteractionState state);
 
     void PerfLock();
     void PerfRel();
 
+    const std::shared_ptr<DisplayEventLoop> mLoop;
     enum InteractionState mState;
     int mIdleFd;
-    int mEventFd;
+    int mTimer;
     int32_t mDurationMs;
     struct timespec mLastTimespec;
-    std::unique_ptr<std::thread> mThread;
     std::mutex mLock;
-    std::condition_variable mCond;
+
+    // Boosts taken and interactions folded into a boost already held
+    uint64_t mBoosts;
+    uint64_t mCoalesced;
+    uint64_t mReleases;
+    std::chrono::steady_clock::time_point mBoostStart;
+    std::chrono::steady_clock::duration mBoostTime;
 };
 
 }  // namespace pixel
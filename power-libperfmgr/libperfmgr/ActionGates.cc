@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/ActionGates.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+#include <pthread.h>
+#if defined(__BIONIC__)
+#include <sys/system_properties.h>
+#endif
+
+#include <algorithm>
+#include <cinttypes>
+#include <thread>
+
+namespace android {
+namespace perfmgr {
+
+ActionGates &ActionGates::GetInstance() {
+    // Never destroyed, the watcher thread may outlive static destruction.
+    static ActionGates *sInstance = new ActionGates();
+    return *sInstance;
+}
+
+bool ActionGates::Evaluate(const std::string &enable_property, FlagGetterPtr enable_flag,
+                           FlagGetterPtr disable_flag) {
+    if (!enable_property.empty() && !android::base::GetBoolProperty(enable_property, true)) {
+        return false;
+    }
+    return !(enable_flag != nullptr && !enable_flag()) &&
+           !(disable_flag != nullptr && disable_flag());
+}
+
+GateId ActionGates::Intern(const std::string &enable_property, FlagGetterPtr enable_flag,
+                           FlagGetterPtr disable_flag) {
+    if (enable_property.empty() && enable_flag == nullptr && disable_flag == nullptr) {
+        return kOpenGate;
+    }
+    std::lock_guard<std::mutex> lock(lock_);
+    std::size_t property = kNoProperty;
+    if (!enable_property.empty()) {
+        auto it = std::find(property_names_.begin(), property_names_.end(), enable_property);
+        property = it - property_names_.begin();
+        if (it == property_names_.end()) {
+            property_names_.push_back(enable_property);
+            properties_.emplace_back(
+                    std::make_unique<android::base::CachedBoolProperty>(enable_property));
+        }
+    }
+    for (std::size_t i = 0; i < gates_.size(); i++) {
+        const Gate &gate = gates_[i];
+        if (gate.property == property && gate.enable_flag == enable_flag &&
+            gate.disable_flag == disable_flag) {
+            return static_cast<GateId>(i);
+        }
+    }
+    if (gates_.size() == kMaxGates) {
+        LOG(ERROR) << "Too many action enable conditions, " << enable_property
+                   << " is read on every check";
+        return kUncachedGate;
+    }
+    GateId id = static_cast<GateId>(gates_.size());
+    gates_.push_back({property, enable_flag, disable_flag});
+    SetBit(id, EvaluateLocked(gates_.back()));
+    if (property != kNoProperty && !watching_) {
+        std::thread(&ActionGates::WatchProperties, this).detach();
+        watching_ = true;
+    }
+    return id;
+}
+
+bool ActionGates::EvaluateLocked(const Gate &gate) {
+    if (gate.property != kNoProperty && !properties_[gate.property]->GetBool().value_or(true)) {
+        return false;
+    }
+    return !(gate.enable_flag != nullptr && !gate.enable_flag()) &&
+           !(gate.disable_flag != nullptr && gate.disable_flag());
+}
+
+void ActionGates::SetBit(GateId id, bool open) {
+    const uint64_t mask = uint64_t{1} << (id % 64);
+    if (open) {
+        bits_[id / 64].fetch_or(mask, std::memory_order_relaxed);
+    } else {
+        bits_[id / 64].fetch_and(~mask, std::memory_order_relaxed);
+    }
+}
+
+void ActionGates::Refresh() {
+    std::lock_guard<std::mutex> lock(lock_);
+    for (std::size_t i = 0; i < gates_.size(); i++) {
+        SetBit(static_cast<GateId>(i), EvaluateLocked(gates_[i]));
+    }
+    refreshes_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ActionGates::WatchProperties() {
+    pthread_setname_np(pthread_self(), "ActionGates");
+#if defined(__BIONIC__)
+    // Sample the serial before refreshing so a change made in between is
+    // not missed.
+    uint32_t serial = __system_property_area_serial();
+    Refresh();
+    while (true) {
+        // Wake on any property change, the cached properties only re-read
+        // the ones whose own serial moved.
+        if (!__system_property_wait(nullptr, serial, &serial, nullptr)) {
+            LOG(ERROR) << "Failed to wait for property change, action gates stop refreshing";
+            return;
+        }
+        Refresh();
+    }
+#else
+    // No property service to wait on off device, e.g. when the config blob
+    // compiler runs on the build host.
+    Refresh();
+#endif
+}
+
+void ActionGates::DumpToFd(int fd) {
+    std::lock_guard<std::mutex> lock(lock_);
+    std::string result = android::base::StringPrintf(
+            "ActionGates: %zu gates, %zu properties, %" PRIu64 " refreshes\n", gates_.size(),
+            properties_.size(), refreshes_.load(std::memory_order_relaxed));
+    for (std::size_t i = 0; i < gates_.size(); i++) {
+        const Gate &gate = gates_[i];
+        result += android::base::StringPrintf(
+                "  [%zu] %s property:%s enable:%s disable:%s\n", i,
+                IsOpen(static_cast<GateId>(i)) ? "open" : "closed",
+                gate.property == kNoProperty ? "-" : property_names_[gate.property].c_str(),
+                gate.enable_flag == nullptr
+                        ? "-"
+                        : FlagProvider::GetInstance().StringFromGetter(gate.enable_flag).c_str(),
+                gate.disable_flag == nullptr
+                        ? "-"
+                        : FlagProvider::GetInstance().StringFromGetter(gate.disable_flag).c_str());
+    }
+    if (!android::base::WriteStringToFd(result, fd)) {
+        LOG(ERROR) << "Failed to dump fd: " << fd;
+    }
+}
+
+}  // namespace perfmgr
+}  // namespace android
@@ -27,13 +27,13 @@
 namespace android {
 namespace perfmgr {
 
-int64_t AdpfConfig::getPidIInitDivI() {
+int64_t AdpfConfig::getPidIInitDivI() const {
     return (mPidI == 0) ? 0 : static_cast<int64_t>(mPidIInit / mPidI);
 }
-int64_t AdpfConfig::getPidIHighDivI() {
+int64_t AdpfConfig::getPidIHighDivI() const {
     return (mPidI == 0) ? 0 : static_cast<int64_t>(mPidIHigh / mPidI);
 }
-int64_t AdpfConfig::getPidILowDivI() {
+int64_t AdpfConfig::getPidILowDivI() const {
     return (mPidI == 0) ? 0 : static_cast<int64_t>(mPidILow / mPidI);
 }
 
@@ -64,10 +64,14 @@ void AdpfConfig::dumpToFd(int fd) {
     dump_buf << "GpuBoostOn: " << mGpuBoostOn.value_or(false) << "\n";
     dump_buf << "GpuBoostCapacityMax: " << mGpuBoostCapacityMax.value_or(0) << "\n";
     dump_buf << "mGpuCapacityLoadUpHeadroom: " << mGpuCapacityLoadUpHeadroom << "\n";
+    dump_buf << "GpuCapacityWriteHysteresis: " << mGpuCapacityWriteHysteresis << "\n";
     if (mHeuristicBoostOn.has_value()) {
         dump_buf << "HeuristicBoost_On: " << mHeuristicBoostOn.value() << "\n";
         dump_buf << "HBoostModerateJankThreshold: " << mHBoostModerateJankThreshold.value() << "\n";
         dump_buf << "HBoostOffMaxAvgDurRatio: " << mHBoostOffMaxAvgDurRatio.value() << "\n";
+        if (mHBoostOffP90AvgDurRatio.has_value()) {
+            dump_buf << "HBoostOffP90AvgDurRatio: " << mHBoostOffP90AvgDurRatio.value() << "\n";
+        }
         dump_buf << "HBoostSevereJankPidPu: " << mHBoostSevereJankPidPu.value() << "\n";
         dump_buf << "HBoostSevereJankThreshold: " << mHBoostSevereJankThreshold.value() << "\n";
         dump_buf << "HBoostUclampMinCeilingRange: [" << mHBoostUclampMinCeilingRange.value().first;
@@ -83,6 +87,11 @@ void AdpfConfig::dumpToFd(int fd) {
             dump_buf << "HighRampupMult: " << mHighRampupMult.value() << "\n";
         }
     }
+    if (mPredictiveBoostOn.has_value()) {
+        dump_buf << "PredictiveBoost_On: " << mPredictiveBoostOn.value() << "\n";
+        dump_buf << "PredictiveBoostHeavyFactor: " << mPredictiveBoostHeavyFactor.value() << "\n";
+        dump_buf << "PredictiveBoostUclampMin: " << mPredictiveBoostUclampMin.value() << "\n";
+    }
     if (mUclampMaxEfficientBase.has_value()) {
         dump_buf << "UclampMax_EfficientBase: " << *mUclampMaxEfficientBase << "\n";
         dump_buf << "UclampMax_EfficientOffset: " << *mUclampMaxEfficientOffset << "\n";
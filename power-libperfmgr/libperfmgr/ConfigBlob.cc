@@ -0,0 +1,541 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG (ATRACE_TAG_POWER | ATRACE_TAG_HAL)
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/ConfigBlob.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/properties.h>
+#include <android-base/unique_fd.h>
+#include <fcntl.h>
+#include <json/reader.h>
+#include <json/value.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <cstdio>
+
+#include "perfmgr/EventNode.h"
+#include "perfmgr/FileNode.h"
+#include "perfmgr/HintManager.h"
+#include "perfmgr/PropertyNode.h"
+
+namespace android {
+namespace perfmgr {
+
+namespace {
+
+constexpr char kPowerHalTruncateProp[] = "vendor.powerhal.truncate";
+
+// Node type tag in the blob
+enum class BlobNodeType : uint8_t { File = 0, Property = 1, Event = 2 };
+// FileNode truncate in the blob; Default follows kPowerHalTruncateProp on load
+// like the JSON parser does when "Truncate" is not set.
+enum class BlobTruncate : uint8_t { False = 0, True = 1, Default = 2 };
+
+void WriteFlag(ConfigBlobWriter *writer, FlagGetterPtr getter) {
+    writer->Write(getter ? FlagProvider::GetInstance().StringFromGetter(getter) : std::string());
+}
+
+void WriteAdpfConfig(ConfigBlobWriter *writer, const AdpfConfig &adpf) {
+    writer->Write(adpf.mName);
+    writer->Write(adpf.mPidOn);
+    writer->Write(adpf.mPidPo);
+    writer->Write(adpf.mPidPu);
+    writer->Write(adpf.mPidI);
+    writer->Write(adpf.mPidIInit);
+    writer->Write(adpf.mPidIHigh);
+    writer->Write(adpf.mPidILow);
+    writer->Write(adpf.mPidDo);
+    writer->Write(adpf.mPidDu);
+    writer->Write(adpf.mUclampMinOn);
+    writer->Write(adpf.mUclampMinInit);
+    writer->Write(adpf.mUclampMinHigh);
+    writer->Write(adpf.mUclampMinLow);
+    writer->Write(adpf.mSamplingWindowP);
+    writer->Write(adpf.mSamplingWindowI);
+    writer->Write(adpf.mSamplingWindowD);
+    writer->Write(adpf.mReportingRateLimitNs);
+    writer->Write(adpf.mTargetTimeFactor);
+    writer->Write(adpf.mStaleTimeFactor);
+    writer->Write(adpf.mGpuBoostOn);
+    writer->Write(adpf.mGpuBoostCapacityMax);
+    writer->Write(adpf.mGpuCapacityLoadUpHeadroom);
+    writer->Write(adpf.mGpuCapacityWriteHysteresis);
+    writer->Write(adpf.mHeuristicBoostOn);
+    writer->Write(adpf.mHBoostModerateJankThreshold);
+    writer->Write(adpf.mHBoostOffMaxAvgDurRatio);
+    writer->Write(adpf.mHBoostOffP90AvgDurRatio);
+    writer->Write(adpf.mHBoostSevereJankPidPu);
+    writer->Write(adpf.mHBoostSevereJankThreshold);
+    writer->Write(adpf.mHBoostUclampMinCeilingRange);
+    writer->Write(adpf.mHBoostUclampMinFloorRange);
+    writer->Write(adpf.mJankCheckTimeFactor);
+    writer->Write(adpf.mLowFrameRateThreshold);
+    writer->Write(adpf.mMaxRecordsNum);
+    writer->Write(adpf.mHeuristicRampup);
+    writer->Write(adpf.mDefaultRampupMult);
+    writer->Write(adpf.mHighRampupMult);
+    writer->Write(adpf.mPredictiveBoostOn);
+    writer->Write(adpf.mPredictiveBoostHeavyFactor);
+    writer->Write(adpf.mPredictiveBoostUclampMin);
+    writer->Write(adpf.mUclampMinLoadUp);
+    writer->Write(adpf.mUclampMinLoadReset);
+    writer->Write(adpf.mUclampMaxEfficientBase);
+    writer->Write(adpf.mUclampMaxEfficientOffset);
+}
+
+// Field order must match WriteAdpfConfig.
+#define ADPF_READ(FIELD)                 \
+    decltype(AdpfConfig::FIELD) FIELD{}; \
+    reader->Read(&FIELD)
+
+std::shared_ptr<AdpfConfig> ReadAdpfConfig(ConfigBlobReader *reader) {
+    ADPF_READ(mName);
+    ADPF_READ(mPidOn);
+    ADPF_READ(mPidPo);
+    ADPF_READ(mPidPu);
+    ADPF_READ(mPidI);
+    ADPF_READ(mPidIInit);
+    ADPF_READ(mPidIHigh);
+    ADPF_READ(mPidILow);
+    ADPF_READ(mPidDo);
+    ADPF_READ(mPidDu);
+    ADPF_READ(mUclampMinOn);
+    ADPF_READ(mUclampMinInit);
+    ADPF_READ(mUclampMinHigh);
+    ADPF_READ(mUclampMinLow);
+    ADPF_READ(mSamplingWindowP);
+    ADPF_READ(mSamplingWindowI);
+    ADPF_READ(mSamplingWindowD);
+    ADPF_READ(mReportingRateLimitNs);
+    ADPF_READ(mTargetTimeFactor);
+    ADPF_READ(mStaleTimeFactor);
+    ADPF_READ(mGpuBoostOn);
+    ADPF_READ(mGpuBoostCapacityMax);
+    ADPF_READ(mGpuCapacityLoadUpHeadroom);
+    ADPF_READ(mGpuCapacityWriteHysteresis);
+    ADPF_READ(mHeuristicBoostOn);
+    ADPF_READ(mHBoostModerateJankThreshold);
+    ADPF_READ(mHBoostOffMaxAvgDurRatio);
+    ADPF_READ(mHBoostOffP90AvgDurRatio);
+    ADPF_READ(mHBoostSevereJankPidPu);
+    ADPF_READ(mHBoostSevereJankThreshold);
+    ADPF_READ(mHBoostUclampMinCeilingRange);
+    ADPF_READ(mHBoostUclampMinFloorRange);
+    ADPF_READ(mJankCheckTimeFactor);
+    ADPF_READ(mLowFrameRateThreshold);
+    ADPF_READ(mMaxRecordsNum);
+    ADPF_READ(mHeuristicRampup);
+    ADPF_READ(mDefaultRampupMult);
+    ADPF_READ(mHighRampupMult);
+    ADPF_READ(mPredictiveBoostOn);
+    ADPF_READ(mPredictiveBoostHeavyFactor);
+    ADPF_READ(mPredictiveBoostUclampMin);
+    ADPF_READ(mUclampMinLoadUp);
+    ADPF_READ(mUclampMinLoadReset);
+    ADPF_READ(mUclampMaxEfficientBase);
+    ADPF_READ(mUclampMaxEfficientOffset);
+    if (!reader->Ok()) {
+        return nullptr;
+    }
+    return std::make_shared<AdpfConfig>(
+            mName, mPidOn, mPidPo, mPidPu, mPidI, mPidIInit, mPidIHigh, mPidILow, mPidDo, mPidDu,
+            mUclampMinOn, mUclampMinInit, mUclampMinHigh, mUclampMinLow, mSamplingWindowP,
+            mSamplingWindowI, mSamplingWindowD, mReportingRateLimitNs, mTargetTimeFactor,
+            mStaleTimeFactor, mGpuBoostOn, mGpuBoostCapacityMax, mGpuCapacityLoadUpHeadroom,
+            mGpuCapacityWriteHysteresis, mHeuristicBoostOn, mHBoostModerateJankThreshold,
+            mHBoostOffMaxAvgDurRatio, mHBoostOffP90AvgDurRatio, mHBoostSevereJankPidPu,
+            mHBoostSevereJankThreshold, mHBoostUclampMinCeilingRange, mHBoostUclampMinFloorRange,
+            mJankCheckTimeFactor, mLowFrameRateThreshold, mMaxRecordsNum, mHeuristicRampup,
+            mDefaultRampupMult, mHighRampupMult, mPredictiveBoostOn, mPredictiveBoostHeavyFactor,
+            mPredictiveBoostUclampMin, mUclampMinLoadUp, mUclampMinLoadReset,
+            mUclampMaxEfficientBase, mUclampMaxEfficientOffset);
+}
+
+#undef ADPF_READ
+
+void WriteOtherConfigs(ConfigBlobWriter *writer, const OtherConfigs &other_configs) {
+    writer->Write(other_configs.GPUSysfsPath);
+    writer->Write(other_configs.enableMetricCollection);
+    writer->Write(other_configs.maxNumOfCachedSessionMetrics);
+    writer->Write(other_configs.enableSFPreferHighCap);
+    writer->Write(other_configs.nodeWriterThreads);
+}
+
+void ReadOtherConfigs(ConfigBlobReader *reader, OtherConfigs *other_configs) {
+    reader->Read(&other_configs->GPUSysfsPath);
+    reader->Read(&other_configs->enableMetricCollection);
+    reader->Read(&other_configs->maxNumOfCachedSessionMetrics);
+    reader->Read(&other_configs->enableSFPreferHighCap);
+    reader->Read(&other_configs->nodeWriterThreads);
+}
+
+// Read-only private mapping of a blob file, unmapped on destruction.
+class MappedBlob {
+  public:
+    explicit MappedBlob(const std::string &path) {
+        android::base::unique_fd fd(TEMP_FAILURE_RETRY(open(path.c_str(), O_RDONLY | O_CLOEXEC)));
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0 || st.st_size <= 0) {
+            return;
+        }
+        void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            PLOG(ERROR) << "Failed to mmap " << path;
+            return;
+        }
+        data_ = static_cast<const char *>(addr);
+        size_ = st.st_size;
+    }
+    ~MappedBlob() {
+        if (data_) {
+            munmap(const_cast<char *>(data_), size_);
+        }
+    }
+    MappedBlob(const MappedBlob &) = delete;
+    MappedBlob &operator=(const MappedBlob &) = delete;
+
+    const char *data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+  private:
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+}  // namespace
+
+uint64_t HashConfigSource(std::string_view json_doc) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : json_doc) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool HintManager::CompileConfig(const std::string &config_path, const std::string &blob_path) {
+    std::string json_doc;
+    if (!android::base::ReadFileToString(config_path, &json_doc)) {
+        LOG(ERROR) << "Failed to read JSON config from " << config_path;
+        return false;
+    }
+
+    std::vector<std::unique_ptr<Node>> nodes = ParseNodes(json_doc);
+    if (nodes.empty()) {
+        LOG(ERROR) << "Failed to parse Nodes section from " << config_path;
+        return false;
+    }
+    std::unordered_map<std::string, Hint> actions = ParseActions(json_doc, nodes);
+    if (actions.empty()) {
+        LOG(ERROR) << "Failed to parse Actions section from " << config_path;
+        return false;
+    }
+    std::vector<std::shared_ptr<AdpfConfig>> adpfs = ParseAdpfConfigs(json_doc);
+    OtherConfigs other_configs = ParseOtherConfigs(json_doc);
+
+    // ParseNodes resolved the truncate property of the build host; record only
+    // whether the JSON set it so the device property still applies on load.
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    if (!reader->parse(&*json_doc.begin(), &*json_doc.end(), &root, nullptr)) {
+        return false;
+    }
+    const Json::Value &json_nodes = root["Nodes"];
+
+    ConfigBlobWriter writer;
+    writer.Write(static_cast<uint32_t>(nodes.size()));
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        const Node *node = nodes[i].get();
+        const FileNode *file_node = dynamic_cast<const FileNode *>(node);
+        BlobNodeType type = BlobNodeType::Property;
+        if (file_node) {
+            type = BlobNodeType::File;
+        } else if (dynamic_cast<const EventNode *>(node)) {
+            type = BlobNodeType::Event;
+        }
+        writer.Write(type);
+        writer.Write(node->GetName());
+        writer.Write(static_cast<uint32_t>(node->GetPaths().size()));
+        for (const auto &path : node->GetPaths()) {
+            writer.Write(path);
+        }
+        const std::vector<std::string> values = node->GetValues();
+        writer.Write(static_cast<uint32_t>(values.size()));
+        for (const auto &value : values) {
+            writer.Write(value);
+        }
+        writer.Write(static_cast<uint64_t>(node->GetDefaultIndex()));
+        writer.Write(node->GetResetOnInit());
+        writer.Write(node->GetDependencyClass());
+        if (file_node) {
+            const Json::Value &truncate = json_nodes[static_cast<Json::ArrayIndex>(i)]["Truncate"];
+            BlobTruncate blob_truncate = BlobTruncate::Default;
+            if (!truncate.empty() && truncate.isBool()) {
+                blob_truncate = truncate.asBool() ? BlobTruncate::True : BlobTruncate::False;
+            }
+            writer.Write(blob_truncate);
+            writer.Write(file_node->GetAllowFailure());
+            writer.Write(file_node->GetHoldFd());
+            writer.Write(file_node->GetWriteOnly());
+        }
+    }
+
+    // Sort hints so the same JSON always compiles to the same blob.
+    std::vector<const std::string *> hint_names;
+    for (const auto &[name, hint] : actions) {
+        hint_names.push_back(&name);
+    }
+    std::sort(hint_names.begin(), hint_names.end(),
+              [](const std::string *a, const std::string *b) { return *a < *b; });
+    writer.Write(static_cast<uint32_t>(hint_names.size()));
+    for (const std::string *name : hint_names) {
+        const Hint &hint = actions.at(*name);
+        writer.Write(*name);
+        writer.Write(static_cast<uint32_t>(hint.node_actions.size()));
+        for (const auto &action : hint.node_actions) {
+            writer.Write(static_cast<uint64_t>(action.node_index));
+            writer.Write(static_cast<uint64_t>(action.value_index));
+            writer.Write(static_cast<int64_t>(action.timeout_ms.count()));
+            writer.Write(action.enable_property);
+            WriteFlag(&writer, action.enable_flag);
+            WriteFlag(&writer, action.disable_flag);
+        }
+        writer.Write(static_cast<uint32_t>(hint.hint_actions.size()));
+        for (const auto &action : hint.hint_actions) {
+            writer.Write(action.type);
+            writer.Write(action.value);
+            writer.Write(action.enable_property);
+            WriteFlag(&writer, action.enable_flag);
+            WriteFlag(&writer, action.disable_flag);
+        }
+    }
+
+    writer.Write(static_cast<uint32_t>(adpfs.size()));
+    for (const auto &adpf : adpfs) {
+        WriteAdpfConfig(&writer, *adpf);
+    }
+    WriteOtherConfigs(&writer, other_configs);
+
+    ConfigBlobHeader header = {};
+    std::copy(std::begin(kConfigBlobMagic), std::end(kConfigBlobMagic), header.magic);
+    header.version = kConfigBlobVersion;
+    header.source_hash = HashConfigSource(json_doc);
+    header.payload_size = writer.GetBuffer().size();
+
+    std::string blob(reinterpret_cast<const char *>(&header), sizeof(header));
+    blob += writer.GetBuffer();
+    // Write to a temp file and rename so a reader never maps a partial blob.
+    const std::string tmp_path = blob_path + ".tmp";
+    if (!android::base::WriteStringToFile(blob, tmp_path)) {
+        PLOG(ERROR) << "Failed to write config blob " << tmp_path;
+        return false;
+    }
+    if (rename(tmp_path.c_str(), blob_path.c_str()) != 0) {
+        PLOG(ERROR) << "Failed to rename config blob to " << blob_path;
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    LOG(INFO) << "Compiled " << config_path << " to " << blob_path << " (" << blob.size()
+              << " bytes)";
+    return true;
+}
+
+bool HintManager::LoadConfigBlob(const std::string &blob_path, const std::string &json_doc,
+                                 std::vector<std::unique_ptr<Node>> *nodes,
+                                 std::unordered_map<std::string, Hint> *actions,
+                                 std::vector<std::shared_ptr<AdpfConfig>> *adpfs,
+                                 OtherConfigs *other_configs) {
+    ATRACE_CALL();
+    MappedBlob blob(blob_path);
+    if (!blob.data()) {
+        return false;
+    }
+
+    ConfigBlobHeader header;
+    if (blob.size() < sizeof(header)) {
+        LOG(ERROR) << "Config blob " << blob_path << " is truncated";
+        return false;
+    }
+    std::memcpy(&header, blob.data(), sizeof(header));
+    if (!std::equal(std::begin(kConfigBlobMagic), std::end(kConfigBlobMagic), header.magic)) {
+        LOG(ERROR) << "Config blob " << blob_path << " has bad magic";
+        return false;
+    }
+    if (header.version != kConfigBlobVersion) {
+        LOG(WARNING) << "Config blob " << blob_path << " version " << header.version
+                     << " mismatch, expected " << kConfigBlobVersion;
+        return false;
+    }
+    if (header.source_hash != HashConfigSource(json_doc)) {
+        LOG(WARNING) << "Config blob " << blob_path << " is stale";
+        return false;
+    }
+    if (header.payload_size != blob.size() - sizeof(header)) {
+        LOG(ERROR) << "Config blob " << blob_path << " payload size mismatch";
+        return false;
+    }
+
+    ConfigBlobReader reader(blob.data() + sizeof(header), header.payload_size);
+    std::vector<std::unique_ptr<Node>> nodes_loaded;
+    std::vector<std::size_t> num_values;
+    uint32_t num_nodes = 0;
+    reader.Read(&num_nodes);
+    for (uint32_t i = 0; i < num_nodes && reader.Ok(); ++i) {
+        BlobNodeType type;
+        std::string_view name;
+        uint32_t count = 0;
+        reader.Read(&type);
+        reader.Read(&name);
+        reader.Read(&count);
+        // Strings are copied once, straight from the mapping into the objects
+        // that keep them
+        std::vector<std::string> paths;
+        for (uint32_t j = 0; j < count && reader.Ok(); ++j) {
+            std::string_view path;
+            reader.Read(&path);
+            paths.emplace_back(path);
+        }
+        reader.Read(&count);
+        std::vector<RequestGroup> values;
+        for (uint32_t j = 0; j < count && reader.Ok(); ++j) {
+            std::string_view value;
+            reader.Read(&value);
+            values.emplace_back(std::string(value));
+        }
+        uint64_t default_index = 0;
+        bool reset = false;
+        std::string dependency_class;
+        reader.Read(&default_index);
+        reader.Read(&reset);
+        reader.Read(&dependency_class);
+        if (!reader.Ok() || values.empty() || default_index >= values.size()) {
+            LOG(ERROR) << "Config blob " << blob_path << " has bad Node[" << i << "]";
+            return false;
+        }
+        num_values.push_back(values.size());
+
+        switch (type) {
+            case BlobNodeType::File: {
+                BlobTruncate blob_truncate;
+                bool allow_failure, hold_fd, write_only;
+                reader.Read(&blob_truncate);
+                reader.Read(&allow_failure);
+                reader.Read(&hold_fd);
+                reader.Read(&write_only);
+                bool truncate = blob_truncate == BlobTruncate::True;
+                if (blob_truncate == BlobTruncate::Default) {
+                    truncate = android::base::GetBoolProperty(kPowerHalTruncateProp, true);
+                }
+                nodes_loaded.emplace_back(std::make_unique<FileNode>(
+                        std::string(name), std::move(paths), std::move(values), default_index,
+                        reset, truncate, allow_failure, hold_fd, write_only));
+                break;
+            }
+            case BlobNodeType::Property:
+                nodes_loaded.emplace_back(std::make_unique<PropertyNode>(
+                        std::string(name), std::move(paths), std::move(values), default_index,
+                        reset));
+                break;
+            case BlobNodeType::Event:
+                nodes_loaded.emplace_back(std::make_unique<EventNode>(
+                        std::string(name), std::move(paths), std::move(values), default_index,
+                        reset, HintManager::OnEventNodeUpdate));
+                break;
+            default:
+                LOG(ERROR) << "Config blob " << blob_path << " has bad Node[" << i << "]'s Type";
+                return false;
+        }
+        nodes_loaded.back()->SetDependencyClass(std::move(dependency_class));
+    }
+
+    std::unordered_map<std::string, Hint> actions_loaded;
+    uint32_t num_hints = 0;
+    reader.Read(&num_hints);
+    for (uint32_t i = 0; i < num_hints && reader.Ok(); ++i) {
+        std::string_view hint_type;
+        uint32_t count = 0;
+        reader.Read(&hint_type);
+        Hint &hint = actions_loaded[std::string(hint_type)];
+        reader.Read(&count);
+        for (uint32_t j = 0; j < count && reader.Ok(); ++j) {
+            uint64_t node_index = 0, value_index = 0;
+            int64_t timeout_ms = 0;
+            std::string enable_property, enable_flag, disable_flag;
+            reader.Read(&node_index);
+            reader.Read(&value_index);
+            reader.Read(&timeout_ms);
+            reader.Read(&enable_property);
+            reader.Read(&enable_flag);
+            reader.Read(&disable_flag);
+            if (!reader.Ok() || node_index >= nodes_loaded.size() ||
+                value_index >= num_values[node_index]) {
+                LOG(ERROR) << "Config blob " << blob_path << " has bad Action for " << hint_type;
+                return false;
+            }
+            hint.node_actions.emplace_back(node_index, value_index,
+                                           std::chrono::milliseconds(timeout_ms), enable_property,
+                                           enable_flag, disable_flag);
+        }
+        reader.Read(&count);
+        for (uint32_t j = 0; j < count && reader.Ok(); ++j) {
+            HintActionType type;
+            std::string value, enable_property, enable_flag, disable_flag;
+            reader.Read(&type);
+            reader.Read(&value);
+            reader.Read(&enable_property);
+            reader.Read(&enable_flag);
+            reader.Read(&disable_flag);
+            if (!reader.Ok() || type < HintActionType::DoHint || type > HintActionType::MaskHint) {
+                LOG(ERROR) << "Config blob " << blob_path << " has bad Action for " << hint_type;
+                return false;
+            }
+            hint.hint_actions.emplace_back(type, value, enable_property, enable_flag,
+                                           disable_flag);
+        }
+    }
+
+    std::vector<std::shared_ptr<AdpfConfig>> adpfs_loaded;
+    uint32_t num_adpfs = 0;
+    reader.Read(&num_adpfs);
+    for (uint32_t i = 0; i < num_adpfs && reader.Ok(); ++i) {
+        adpfs_loaded.emplace_back(ReadAdpfConfig(&reader));
+    }
+    OtherConfigs other_configs_loaded;
+    ReadOtherConfigs(&reader, &other_configs_loaded);
+
+    if (!reader.Ok() || !reader.AtEnd() || nodes_loaded.empty() || actions_loaded.empty()) {
+        LOG(ERROR) << "Config blob " << blob_path << " is malformed";
+        return false;
+    }
+
+    *nodes = std::move(nodes_loaded);
+    *actions = std::move(actions_loaded);
+    *adpfs = std::move(adpfs_loaded);
+    *other_configs = std::move(other_configs_loaded);
+    return true;
+}
+
+}  // namespace perfmgr
+}  // namespace android
@@ -66,6 +66,7 @@ std::chrono::milliseconds EventNode::Update(bool) {
             ATRACE_END();
         }
     }
+    dirty_ = value_index != current_val_index_ || reset_on_init_;
     return expire_time;
 }
 
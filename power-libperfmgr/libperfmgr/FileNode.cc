@@ -26,11 +26,42 @@
 #include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
+#include <linux/magic.h>
+#include <sys/vfs.h>
 #include <utils/Trace.h>
 
+#include <atomic>
+#include <cstring>
+
 namespace android {
 namespace perfmgr {
 
+namespace {
+
+// Upper bound of node fds kept open across Update() in the process, so that
+// large configs stay well below RLIMIT_NOFILE. Paths beyond the budget fall
+// back to open/write/close per update. HoldFd nodes are not counted.
+constexpr int kMaxCachedFds = 512;
+std::atomic<int> sCachedFds{0};
+
+bool IsPseudoFs(int fd) {
+    struct statfs buf;
+    if (fstatfs(fd, &buf) != 0) {
+        return false;
+    }
+    switch (buf.f_type) {
+        case SYSFS_MAGIC:
+        case PROC_SUPER_MAGIC:
+        case CGROUP_SUPER_MAGIC:
+        case CGROUP2_SUPER_MAGIC:
+            return true;
+        default:
+            return false;
+    }
+}
+
+}  // namespace
+
 FileNode::FileNode(std::string name, std::vector<std::string> node_paths,
                    std::vector<RequestGroup> req_sorted, std::size_t default_val_index,
                    bool reset_on_init, bool truncate, bool allow_failure, bool hold_fd, bool write_only)
@@ -40,8 +71,88 @@ FileNode::FileNode(std::string name, std::vector<std::string> node_paths,
       truncate_(truncate),
       write_only_(write_only),
       warn_timeout_(android::base::GetBoolProperty("ro.debuggable", false) ? 5ms : 50ms),
+      path_fds_(node_paths_.size()),
       allow_failure_(allow_failure) {}
 
+FileNode::~FileNode() {
+    for (std::size_t i = 0; i < path_fds_.size(); i++) {
+        ClosePath(i);
+    }
+}
+
+bool FileNode::OpenPath(std::size_t path_index) {
+    PathFd &path_fd = path_fds_[path_index];
+    int flags = O_WRONLY | O_CLOEXEC;
+    if (GetTruncate()) {
+        flags |= O_TRUNC;
+    }
+    path_fd.fd.reset(TEMP_FAILURE_RETRY(open(node_paths_[path_index].c_str(), flags)));
+    if (path_fd.fd == -1) {
+        return false;
+    }
+    path_fd.pseudo_fs = IsPseudoFs(path_fd.fd);
+    path_fd.stream = false;
+    if (!hold_fd_) {
+        path_fd.cached = sCachedFds.fetch_add(1, std::memory_order_relaxed) < kMaxCachedFds;
+        if (!path_fd.cached) {
+            sCachedFds.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    return true;
+}
+
+void FileNode::ClosePath(std::size_t path_index) {
+    PathFd &path_fd = path_fds_[path_index];
+    if (path_fd.cached) {
+        sCachedFds.fetch_sub(1, std::memory_order_relaxed);
+        path_fd.cached = false;
+    }
+    path_fd.fd.reset();
+}
+
+bool FileNode::WritePath(std::size_t path_index, const std::string &value) {
+    PathFd &path_fd = path_fds_[path_index];
+    if (path_fd.fd == -1 && !OpenPath(path_index)) {
+        return false;
+    }
+    auto write_value = [&path_fd, &value]() -> ssize_t {
+        if (!path_fd.stream) {
+            ssize_t ret = TEMP_FAILURE_RETRY(pwrite(path_fd.fd, value.data(), value.size(), 0));
+            if (ret != -1 || errno != ESPIPE) {
+                return ret;
+            }
+            // fifo or stream device
+            path_fd.stream = true;
+        }
+        return TEMP_FAILURE_RETRY(write(path_fd.fd, value.data(), value.size()));
+    };
+    ssize_t ret = write_value();
+    if (ret == -1 && (errno == EBADF || errno == ENODEV)) {
+        // The cached fd went stale, e.g. the device behind it was removed
+        // and re-added; reopen once.
+        ClosePath(path_index);
+        if (!OpenPath(path_index)) {
+            return false;
+        }
+        ret = write_value();
+    }
+    if (ret != static_cast<ssize_t>(value.size())) {
+        if (ret >= 0) {
+            errno = EIO;
+        }
+        return false;
+    }
+    if (!path_fd.pseudo_fs) {
+        // For regular file system, drop the tail of a longer previous value
+        // and fsync
+        if (GetTruncate() && ftruncate(path_fd.fd, value.size()) != 0) {
+            return false;
+        }
+        fsync(path_fd.fd);
+    }
+    return true;
+}
+
 std::chrono::milliseconds FileNode::Update(bool log_error) {
     std::size_t value_index = default_val_index_;
     std::chrono::milliseconds expire_time = std::chrono::milliseconds::max();
@@ -67,42 +178,39 @@ std::chrono::milliseconds FileNode::Update(bool log_error) {
             ATRACE_BEGIN(tag.c_str());
         }
 
-        int flags = O_WRONLY | O_CLOEXEC;
-
-        if (GetTruncate()) {
-            flags |= O_TRUNC;
-        }
-
-        for (const auto &path : node_paths_) {
-            android::base::Timer t;
-
-            fd_.reset(TEMP_FAILURE_RETRY(open(path.c_str(), flags)));
+        for (std::size_t i = 0; i < node_paths_.size(); i++) {
+            const std::string &path = node_paths_[i];
+            const auto start = std::chrono::steady_clock::now();
 
-            if (fd_ == -1 || !android::base::WriteStringToFd(req_value, fd_)) {
-                if (!allow_failure_ || fd_ != -1 || errno != ENOENT) {
+            if (!WritePath(i, req_value)) {
+                const int write_errno = errno;
+                if (!allow_failure_ || path_fds_[i].fd != -1 || write_errno != ENOENT) {
                     if (log_error) {
                         LOG(WARNING) << "Failed to write to node: " << path
-                                    << " with value: " << req_value << ", fd: " << fd_;
+                                     << " with value: " << req_value
+                                     << ", err: " << strerror(write_errno);
                     }
                     // Retry in 500ms or sooner
                     expire_time = std::min(expire_time, std::chrono::milliseconds(500));
                     successfullyUpdated = false;
                 }
             } else {
-                // For regular file system, we need fsync
-                fsync(fd_);
                 // Some dev node requires file to remain open during the entire hint
-                // duration e.g. /dev/cpu_dma_latency, so fd_ is intentionally kept
+                // duration e.g. /dev/cpu_dma_latency, so the fd is intentionally kept
                 // open during any requested value other than default one. If
                 // request a default value, node will write the value and then
-                // release the fd.
-                if ((!hold_fd_) || value_index == default_val_index_) {
-                    fd_.reset();
+                // release the fd. Other nodes keep their fd cached if budget allows.
+                if (hold_fd_ ? value_index == default_val_index_ : !path_fds_[i].cached) {
+                    ClosePath(i);
                 }
-                auto duration = t.duration();
+                const auto duration = std::chrono::steady_clock::now() - start;
+                write_latency_.Add(duration);
                 if (duration > warn_timeout_) {
                     LOG(WARNING) << "Slow writing to file: '" << path << "' with value: '"
-                                << req_value << "' took: " << duration.count() << " ms";
+                                 << req_value << "' took: "
+                                 << std::chrono::duration_cast<std::chrono::milliseconds>(duration)
+                                            .count()
+                                 << " ms";
                 }
             }
         }
@@ -118,6 +226,8 @@ std::chrono::milliseconds FileNode::Update(bool log_error) {
         }
     }
 
+    // Stay dirty on write failure so NodeLooperThread retries this node.
+    dirty_ = value_index != current_val_index_ || reset_on_init_;
     return expire_time;
 }
 
@@ -133,6 +243,10 @@ bool FileNode::GetTruncate() const {
     return truncate_;
 }
 
+bool FileNode::GetWriteOnly() const {
+    return write_only_;
+}
+
 void FileNode::DumpToFd(int fd) const {
     std::string buf("Node Name\tNode Path\tCurrent Index\tCurrent Value\tHold FD\tTruncate\n");
 
@@ -154,6 +268,11 @@ void FileNode::DumpToFd(int fd) const {
         req_sorted_[i].DumpToFd(
             fd, android::base::StringPrintf("\t\tReq%zu:\t", i));
     }
+
+    if (!android::base::WriteStringToFd("\t\tWrite latency:\t" + write_latency_.Dump() + "\n",
+                                        fd)) {
+        LOG(ERROR) << "Failed to dump fd: " << fd;
+    }
 }
 
 }  // namespace perfmgr
@@ -20,6 +20,8 @@
 #include <format>
 #include <memory>
 
+#include "perfmgr/ActionGates.h"
+
 namespace android::perfmgr {
 
 FlagProvider &FlagProvider::GetInstance() {
@@ -43,16 +45,19 @@ void FlagProvider::TearDown() {
 
 void FlagProvider::OverrideValue(FlagGetterPtr method, bool value) {
     this->*mOverriders[method] = value;
+    ActionGates::GetInstance().Refresh();
 }
 
 void FlagProvider::DropOverride(FlagGetterPtr method) {
     this->*mOverriders[method] = std::nullopt;
+    ActionGates::GetInstance().Refresh();
 }
 
 void FlagProvider::ClearOverrides() {
     for (auto &&overrider : mOverriders) {
         this->*overrider.second = std::nullopt;
     }
+    ActionGates::GetInstance().Refresh();
 }
 
 void FlagProvider::DumpToFd(int fd) {
@@ -71,6 +76,15 @@ FlagGetterPtr FlagProvider::GetterFromString(const std::string &flagName) {
     return out == mStringAssociations.end() ? nullptr : out->second;
 }
 
+std::string FlagProvider::StringFromGetter(FlagGetterPtr getter) const {
+    for (auto &&[flagName, flagGetter] : mStringAssociations) {
+        if (flagGetter == getter) {
+            return flagName;
+        }
+    }
+    return "";
+}
+
 std::unique_ptr<RawFlagProvider> FlagProvider::sOriginalProvider = nullptr;
 
 }  // namespace android::perfmgr
@@ -26,12 +26,17 @@
 #include <inttypes.h>
 #include <json/reader.h>
 #include <json/value.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
 #include <utils/Trace.h>
 
 #include <algorithm>
 #include <set>
 #include <string>
 
+#include "perfmgr/ConfigBlob.h"
 #include "perfmgr/EventNode.h"
 #include "perfmgr/FileNode.h"
 #include "perfmgr/FlagProvider.h"
@@ -58,110 +63,173 @@ constexpr char kAdpfEventNodePath[] = "<AdpfConfig>:";
 constexpr std::string_view kConfigDebugUsesFallback(
         "persist.vendor.powerhal.config.debug.usefallback");
 
-bool HintManager::ValidateHint(const std::string& hint_type) const {
+HintManager::HintManager(
+        sp<NodeLooperThread> nm, const std::unordered_map<std::string, Hint> &actions,
+        const std::vector<std::shared_ptr<AdpfConfig>> &adpfs,
+        const std::unordered_map<std::string, std::shared_ptr<AdpfConfig>> &tag_adpfs,
+        const OtherConfigs &other_configs)
+    : nm_(std::move(nm)),
+      adpf_table_(std::make_shared<const AdpfProfileTable>(AdpfProfileTable{adpfs, tag_adpfs})),
+      other_configs_(other_configs) {
+    // Intern hint names in sorted order so a given config always maps to the
+    // same ids, then lay the hints out in a flat array indexed by HintId.
+    std::vector<std::string> names;
+    names.reserve(actions.size());
+    for (const auto &action : actions) {
+        names.push_back(action.first);
+    }
+    std::sort(names.begin(), names.end());
+    HintId max_id = 0;
+    for (const auto &name : names) {
+        HintId id = HintRegistry::GetInstance().Intern(name);
+        hint_ids_.emplace(name, id);
+        max_id = std::max(max_id, id);
+    }
+    std::size_t size = actions.empty() ? 0 : static_cast<std::size_t>(max_id) + 1;
+    hint_names_.resize(size);
+    for (const auto &[name, id] : hint_ids_) {
+        hint_names_[id] = name;
+    }
+    hints_.reserve(size);
+    for (std::size_t id = 0; id < size; ++id) {
+        if (hint_names_[id].empty()) {
+            hints_.emplace_back();
+        } else {
+            hints_.emplace_back(actions.at(hint_names_[id]));
+        }
+    }
+    // Resolve the target of DoHint/EndHint/MaskHint actions once.
+    for (auto &hint : hints_) {
+        for (auto &action : hint.hint_actions) {
+            action.value_id = GetHintId(action.value);
+        }
+    }
+}
+
+HintManager::~HintManager() {
+    if (config_watcher_.joinable()) {
+        eventfd_write(config_watcher_stop_fd_, 1);
+        config_watcher_.join();
+    }
+    if (nm_.get() != nullptr) nm_->Stop();
+}
+
+HintId HintManager::GetHintId(const std::string &hint_type) const {
+    auto it = hint_ids_.find(hint_type);
+    if (it == hint_ids_.end()) {
+        LOG(DEBUG) << "Hint type not present in actions: " << hint_type;
+        return kInvalidHintId;
+    }
+    return it->second;
+}
+
+bool HintManager::ValidateHint(HintId hint_id) const {
     if (nm_.get() == nullptr) {
         LOG(ERROR) << "NodeLooperThread not present";
         return false;
     }
-    return IsHintSupported(hint_type);
+    return IsHintSupported(hint_id);
+}
+
+bool HintManager::IsHintSupported(HintId hint_id) const {
+    return hint_id < hint_names_.size() && !hint_names_[hint_id].empty();
 }
 
 bool HintManager::IsHintSupported(const std::string& hint_type) const {
-    if (actions_.find(hint_type) == actions_.end()) {
-        LOG(DEBUG) << "Hint type not present in actions: " << hint_type;
-        return false;
-    }
-    return true;
+    return GetHintId(hint_type) != kInvalidHintId;
+}
+
+bool HintManager::IsHintEnabled(HintId hint_id) const {
+    std::lock_guard<std::mutex> lock(hints_[hint_id].hint_lock);
+    return hints_[hint_id].mask_requesters.empty();
 }
 
 bool HintManager::IsHintEnabled(const std::string &hint_type) const {
-    std::lock_guard<std::mutex> lock(actions_.at(hint_type).hint_lock);
-    return actions_.at(hint_type).mask_requesters.empty();
+    return IsHintEnabled(hint_ids_.at(hint_type));
 }
 
 bool HintManager::InitHintStatus(const std::unique_ptr<HintManager> &hm) {
     if (hm.get() == nullptr) {
         return false;
     }
-    for (auto &a : hm->actions_) {
+    for (auto &hint : hm->hints_) {
         // timeout_ms equaling kMilliSecondZero means forever until cancelling.
         // As a result, if there's one NodeAction has timeout_ms of 0, we will store
         // 0 instead of max. Also node actions could be empty, set to 0 in that case.
         std::chrono::milliseconds timeout = kMilliSecondZero;
-        if (a.second.node_actions.size()) {
-            auto [min, max] =
-                    std::minmax_element(a.second.node_actions.begin(), a.second.node_actions.end(),
-                                        [](const auto act1, const auto act2) {
-                                            return act1.timeout_ms < act2.timeout_ms;
-                                        });
+        if (hint.node_actions.size()) {
+            auto [min, max] = std::minmax_element(hint.node_actions.begin(),
+                                                  hint.node_actions.end(),
+                                                  [](const auto act1, const auto act2) {
+                                                      return act1.timeout_ms < act2.timeout_ms;
+                                                  });
             timeout = min->timeout_ms == kMilliSecondZero ? kMilliSecondZero : max->timeout_ms;
         }
-        a.second.status.reset(new HintStatus(timeout));
+        hint.status.reset(new HintStatus(timeout));
     }
     return true;
 }
 
-void HintManager::DoHintStatus(const std::string &hint_type, std::chrono::milliseconds timeout_ms) {
-    std::lock_guard<std::mutex> lock(actions_.at(hint_type).hint_lock);
-    actions_.at(hint_type).status->stats.count.fetch_add(1);
+void HintManager::DoHintStatus(HintId hint_id, std::chrono::milliseconds timeout_ms) {
+    Hint &hint = hints_[hint_id];
+    std::lock_guard<std::mutex> lock(hint.hint_lock);
+    hint.status->stats.count.fetch_add(1);
     auto now = std::chrono::steady_clock::now();
-    ATRACE_INT(("H:" + hint_type).c_str(), (timeout_ms == kMilliSecondZero)
-                                                   ? std::numeric_limits<int>::max()
-                                                   : timeout_ms.count());
-    ATRACE_NAME(("H:" + hint_type + ":" + std::to_string((timeout_ms == kMilliSecondZero)
-                                                   ? std::numeric_limits<int>::max()
-                                                   : timeout_ms.count())).c_str());
-    if (now > actions_.at(hint_type).status->end_time) {
-        actions_.at(hint_type).status->stats.duration_ms.fetch_add(
-                std::chrono::duration_cast<std::chrono::milliseconds>(
-                        actions_.at(hint_type).status->end_time -
-                        actions_.at(hint_type).status->start_time)
+    if (ATRACE_ENABLED()) {
+        const std::string &hint_type = hint_names_[hint_id];
+        int timeout = (timeout_ms == kMilliSecondZero) ? std::numeric_limits<int>::max()
+                                                       : static_cast<int>(timeout_ms.count());
+        ATRACE_INT(("H:" + hint_type).c_str(), timeout);
+        ATRACE_NAME(("H:" + hint_type + ":" + std::to_string(timeout)).c_str());
+    }
+    if (now > hint.status->end_time) {
+        hint.status->stats.duration_ms.fetch_add(
+                std::chrono::duration_cast<std::chrono::milliseconds>(hint.status->end_time -
+                                                                      hint.status->start_time)
                         .count());
-        actions_.at(hint_type).status->start_time = now;
+        hint.status->start_time = now;
     }
-    actions_.at(hint_type).status->end_time =
-            (timeout_ms == kMilliSecondZero) ? kTimePointMax : now + timeout_ms;
+    hint.status->end_time = (timeout_ms == kMilliSecondZero) ? kTimePointMax : now + timeout_ms;
 }
 
-void HintManager::EndHintStatus(const std::string &hint_type) {
-    std::lock_guard<std::mutex> lock(actions_.at(hint_type).hint_lock);
+void HintManager::EndHintStatus(HintId hint_id) {
+    Hint &hint = hints_[hint_id];
+    std::lock_guard<std::mutex> lock(hint.hint_lock);
     // Update HintStats if the hint ends earlier than expected end_time
     auto now = std::chrono::steady_clock::now();
-    ATRACE_INT(("H:" + hint_type).c_str(), 0);
-    ATRACE_NAME(("H:" + hint_type + ":0").c_str());
-    if (now < actions_.at(hint_type).status->end_time) {
-        actions_.at(hint_type).status->stats.duration_ms.fetch_add(
-                std::chrono::duration_cast<std::chrono::milliseconds>(
-                        now - actions_.at(hint_type).status->start_time)
+    if (ATRACE_ENABLED()) {
+        const std::string &hint_type = hint_names_[hint_id];
+        ATRACE_INT(("H:" + hint_type).c_str(), 0);
+        ATRACE_NAME(("H:" + hint_type + ":0").c_str());
+    }
+    if (now < hint.status->end_time) {
+        hint.status->stats.duration_ms.fetch_add(
+                std::chrono::duration_cast<std::chrono::milliseconds>(now -
+                                                                      hint.status->start_time)
                         .count());
-        actions_.at(hint_type).status->end_time = now;
+        hint.status->end_time = now;
     }
 }
 
-void HintManager::DoHintAction(const std::string &hint_type) {
-    for (auto &action : actions_.at(hint_type).hint_actions) {
-        if (!action.enable_property.empty() &&
-            !android::base::GetBoolProperty(action.enable_property, true)) {
-            // Disabled action based on its control property
-            continue;
-        }
-        if ((action.enable_flag != nullptr && !action.enable_flag()) ||
-            (action.disable_flag != nullptr && action.disable_flag())) {
+void HintManager::DoHintAction(HintId hint_id) {
+    for (auto &action : hints_[hint_id].hint_actions) {
+        if (!action.IsEnabled()) {
+            // Disabled action based on its control property or flags
             continue;
         }
         switch (action.type) {
             case HintActionType::DoHint:
-                DoHint(action.value);
+                DoHint(action.value_id);
                 break;
             case HintActionType::EndHint:
-                EndHint(action.value);
+                EndHint(action.value_id);
                 break;
             case HintActionType::MaskHint:
-                if (actions_.find(action.value) == actions_.end()) {
+                if (!IsHintSupported(action.value_id)) {
                     LOG(ERROR) << "Failed to find " << action.value << " action";
                 } else {
-                    std::lock_guard<std::mutex> lock(actions_.at(hint_type).hint_lock);
-                    actions_.at(action.value).mask_requesters.insert(hint_type);
+                    std::lock_guard<std::mutex> lock(hints_[action.value_id].hint_lock);
+                    hints_[action.value_id].mask_requesters.insert(hint_id);
                 }
                 break;
             default:
@@ -173,76 +241,95 @@ void HintManager::DoHintAction(const std::string &hint_type) {
     }
 }
 
-void HintManager::EndHintAction(const std::string &hint_type) {
-    for (auto &action : actions_.at(hint_type).hint_actions) {
-        if (action.type == HintActionType::MaskHint &&
-            actions_.find(action.value) != actions_.end()) {
-            std::lock_guard<std::mutex> lock(actions_.at(hint_type).hint_lock);
-            actions_.at(action.value).mask_requesters.erase(hint_type);
+void HintManager::EndHintAction(HintId hint_id) {
+    for (auto &action : hints_[hint_id].hint_actions) {
+        if (action.type == HintActionType::MaskHint && IsHintSupported(action.value_id)) {
+            std::lock_guard<std::mutex> lock(hints_[action.value_id].hint_lock);
+            hints_[action.value_id].mask_requesters.erase(hint_id);
         }
     }
 }
 
-bool HintManager::DoHint(const std::string& hint_type) {
-    LOG(VERBOSE) << "Do Powerhint: " << hint_type;
-    if (!ValidateHint(hint_type) || !IsHintEnabled(hint_type) ||
-        !nm_->Request(actions_.at(hint_type).node_actions, hint_type)) {
+bool HintManager::DoHint(HintId hint_id) {
+    if (!ValidateHint(hint_id)) {
         return false;
     }
-    DoHintStatus(hint_type, actions_.at(hint_type).status->max_timeout);
-    DoHintAction(hint_type);
+    LOG(VERBOSE) << "Do Powerhint: " << hint_names_[hint_id];
+    if (!IsHintEnabled(hint_id) || !nm_->Request(hints_[hint_id].node_actions, hint_id)) {
+        return false;
+    }
+    DoHintStatus(hint_id, hints_[hint_id].status->max_timeout);
+    DoHintAction(hint_id);
     return true;
 }
 
-bool HintManager::DoHint(const std::string& hint_type,
-                         std::chrono::milliseconds timeout_ms_override) {
-    LOG(VERBOSE) << "Do Powerhint: " << hint_type << " for "
+bool HintManager::DoHint(const std::string& hint_type) {
+    return DoHint(GetHintId(hint_type));
+}
+
+bool HintManager::DoHint(HintId hint_id, std::chrono::milliseconds timeout_ms_override) {
+    if (!ValidateHint(hint_id)) {
+        return false;
+    }
+    LOG(VERBOSE) << "Do Powerhint: " << hint_names_[hint_id] << " for "
                  << timeout_ms_override.count() << "ms";
-    if (!ValidateHint(hint_type) || !IsHintEnabled(hint_type)) {
+    if (!IsHintEnabled(hint_id)) {
         return false;
     }
-    std::vector<NodeAction> actions_override = actions_.at(hint_type).node_actions;
+    std::vector<NodeAction> actions_override = hints_[hint_id].node_actions;
     for (auto& action : actions_override) {
         action.timeout_ms = timeout_ms_override;
     }
-    if (!nm_->Request(actions_override, hint_type)) {
+    if (!nm_->Request(actions_override, hint_id)) {
         return false;
     }
-    DoHintStatus(hint_type, timeout_ms_override);
-    DoHintAction(hint_type);
+    DoHintStatus(hint_id, timeout_ms_override);
+    DoHintAction(hint_id);
     return true;
 }
 
-bool HintManager::EndHint(const std::string& hint_type) {
-    LOG(VERBOSE) << "End Powerhint: " << hint_type;
-    if (!ValidateHint(hint_type) || !nm_->Cancel(actions_.at(hint_type).node_actions, hint_type)) {
+bool HintManager::DoHint(const std::string& hint_type,
+                         std::chrono::milliseconds timeout_ms_override) {
+    return DoHint(GetHintId(hint_type), timeout_ms_override);
+}
+
+bool HintManager::EndHint(HintId hint_id) {
+    if (!ValidateHint(hint_id)) {
         return false;
     }
-    EndHintStatus(hint_type);
-    EndHintAction(hint_type);
+    LOG(VERBOSE) << "End Powerhint: " << hint_names_[hint_id];
+    if (!nm_->Cancel(hints_[hint_id].node_actions, hint_id)) {
+        return false;
+    }
+    EndHintStatus(hint_id);
+    EndHintAction(hint_id);
     return true;
 }
 
+bool HintManager::EndHint(const std::string& hint_type) {
+    return EndHint(GetHintId(hint_type));
+}
+
 bool HintManager::IsRunning() const {
     return (nm_.get() == nullptr) ? false : nm_->isRunning();
 }
 
 std::vector<std::string> HintManager::GetHints() const {
     std::vector<std::string> hints;
-    for (auto const& action : actions_) {
-        hints.push_back(action.first);
+    for (auto const& hint : hint_ids_) {
+        hints.push_back(hint.first);
     }
     return hints;
 }
 
 HintStats HintManager::GetHintStats(const std::string &hint_type) const {
     HintStats hint_stats;
-    if (ValidateHint(hint_type)) {
-        std::lock_guard<std::mutex> lock(actions_.at(hint_type).hint_lock);
-        hint_stats.count =
-                actions_.at(hint_type).status->stats.count.load(std::memory_order_relaxed);
-        hint_stats.duration_ms =
-                actions_.at(hint_type).status->stats.duration_ms.load(std::memory_order_relaxed);
+    HintId hint_id = GetHintId(hint_type);
+    if (ValidateHint(hint_id)) {
+        const Hint &hint = hints_[hint_id];
+        std::lock_guard<std::mutex> lock(hint.hint_lock);
+        hint_stats.count = hint.status->stats.count.load(std::memory_order_relaxed);
+        hint_stats.duration_ms = hint.status->stats.duration_ms.load(std::memory_order_relaxed);
     }
     return hint_stats;
 }
@@ -281,19 +368,21 @@ void HintManager::DumpToFd(int fd) {
     }
 
     // Dump current ADPF profiles
-    if (IsAdpfSupported()) {
+    auto adpf_table = adpf_table_.Load();
+    if (!adpf_table->adpfs.empty()) {
         header = "========== ADPF Tag Profile begin ==========\n";
         if (!android::base::WriteStringToFd(header, fd)) {
             LOG(ERROR) << "Failed to dump fd: " << fd;
         }
 
-        header = "---- Default non-tagged adpf profile ----\n";
+        header = StringPrintf("Generation: %" PRIu32 "\n", adpf_table->generation);
+        header += "---- Default non-tagged adpf profile ----\n";
         if (!android::base::WriteStringToFd(header, fd)) {
             LOG(ERROR) << "Failed to dump fd: " << fd;
         }
-        GetAdpfProfileFromDoHint()->dumpToFd(fd);
+        adpf_table->adpfs[adpf_table->default_index]->dumpToFd(fd);
 
-        for (const auto &tag_profile : tag_profile_map_) {
+        for (const auto &tag_profile : adpf_table->tag_profiles) {
             header = StringPrintf("---- Tagged ADPF Profile: %s ----\n", tag_profile.first.c_str());
             if (!android::base::WriteStringToFd(header, fd)) {
                 LOG(ERROR) << "Failed to dump fd: " << fd;
@@ -314,6 +403,7 @@ void HintManager::DumpToFd(int fd) {
 
     DumpOtherConfigs(fd);
 
+    ActionGates::GetInstance().DumpToFd(fd);
     FlagProvider::GetInstance().DumpToFd(fd);
 
     fsync(fd);
@@ -371,6 +461,7 @@ void HintManager::Reload(bool start) {
         } else {
             LOG(WARNING) << "Pixel Power HAL AIDL Service successfully loaded debug config: "
                          << debug_config_path;
+            sInstance->WatchAdpfProfiles();
             return;
         }
     }
@@ -433,6 +524,10 @@ OtherConfigs HintManager::ParseOtherConfigs(const std::string &json_doc) {
         extraOtherConf["EnableSFPreferHighCap"].isBool()) {
         otherConf.enableSFPreferHighCap = extraOtherConf["EnableSFPreferHighCap"].asBool();
     }
+    if (!extraOtherConf["NodeWriterThreads"].empty() &&
+        extraOtherConf["NodeWriterThreads"].isUInt()) {
+        otherConf.nodeWriterThreads = extraOtherConf["NodeWriterThreads"].asUInt();
+    }
     return otherConf;
 }
 
@@ -444,18 +539,27 @@ HintManager *HintManager::GetFromJSON(const std::string &config_path, bool start
         return nullptr;
     }
 
-    std::vector<std::unique_ptr<Node>> nodes = ParseNodes(json_doc);
-    if (nodes.empty()) {
-        LOG(ERROR) << "Failed to parse Nodes section from " << config_path;
-        return nullptr;
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::unordered_map<std::string, Hint> actions;
+    std::vector<std::shared_ptr<AdpfConfig>> adpfs;
+    OtherConfigs other_configs;
+    const std::string blob_path = config_path + kConfigBlobSuffix;
+    if (LoadConfigBlob(blob_path, json_doc, &nodes, &actions, &adpfs, &other_configs)) {
+        LOG(INFO) << "Loaded precompiled config from " << blob_path;
+    } else {
+        nodes = ParseNodes(json_doc);
+        if (nodes.empty()) {
+            LOG(ERROR) << "Failed to parse Nodes section from " << config_path;
+            return nullptr;
+        }
+        adpfs = HintManager::ParseAdpfConfigs(json_doc);
+        actions = HintManager::ParseActions(json_doc, nodes);
+        other_configs = ParseOtherConfigs(json_doc);
     }
-    std::vector<std::shared_ptr<AdpfConfig>> adpfs = HintManager::ParseAdpfConfigs(json_doc);
     if (adpfs.empty()) {
         LOG(INFO) << "No AdpfConfig section in the " << config_path;
     }
 
-    std::unordered_map<std::string, Hint> actions = HintManager::ParseActions(json_doc, nodes);
-
     // Parse ADPF Event Node
     std::unordered_map<std::string, std::shared_ptr<AdpfConfig>> tag_adpfs;
     LOG(VERBOSE) << "Parse ADPF Hint Event Table from all nodes.";
@@ -490,11 +594,11 @@ HintManager *HintManager::GetFromJSON(const std::string &config_path, bool start
         return nullptr;
     }
 
-    auto const other_configs = ParseOtherConfigs(json_doc);
-
-    sp<NodeLooperThread> nm = new NodeLooperThread(std::move(nodes));
+    sp<NodeLooperThread> nm =
+            new NodeLooperThread(std::move(nodes), other_configs.nodeWriterThreads.value_or(0));
     sInstance =
             std::make_unique<HintManager>(std::move(nm), actions, adpfs, tag_adpfs, other_configs);
+    sInstance->config_path_ = config_path;
 
     if (!HintManager::InitHintStatus(sInstance)) {
         LOG(ERROR) << "Failed to initialize hint status";
@@ -664,13 +768,9 @@ std::vector<std::unique_ptr<Node>> HintManager::ParseNodes(const std::string &js
                      << reset << std::noboolalpha;
 
         if (is_event_node) {
-            auto update_callback = [](const std::string &name, const std::vector<std::string> &path,
-                                      const std::string &val) {
-                HintManager::GetInstance()->OnNodeUpdate(name, path, val);
-            };
             nodes_parsed.emplace_back(std::make_unique<EventNode>(
                     name, paths_parsed, values_parsed, static_cast<std::size_t>(default_index),
-                    reset, update_callback));
+                    reset, HintManager::OnEventNodeUpdate));
         } else if (is_file) {
             bool truncate = android::base::GetBoolProperty(kPowerHalTruncateProp, true);
             if (nodes[i]["Truncate"].empty() || !nodes[i]["Truncate"].isBool()) {
@@ -719,6 +819,10 @@ std::vector<std::unique_ptr<Node>> HintManager::ParseNodes(const std::string &js
                     std::make_unique<PropertyNode>(name, paths_parsed, values_parsed,
                                                    static_cast<std::size_t>(default_index), reset));
         }
+
+        std::string dependency_class = nodes[i]["DependencyClass"].asString();
+        LOG(VERBOSE) << "Node[" << i << "]'s DependencyClass: " << dependency_class;
+        nodes_parsed.back()->SetDependencyClass(std::move(dependency_class));
     }
     LOG(INFO) << nodes_parsed.size() << " Nodes parsed successfully";
     return nodes_parsed;
@@ -909,6 +1013,7 @@ std::vector<std::shared_ptr<AdpfConfig>> HintManager::ParseAdpfConfigs(
         std::optional<bool> gpuBoost;
         std::optional<uint64_t> gpuBoostCapacityMax;
         uint64_t gpuCapacityLoadUpHeadroom = 0;
+        uint64_t gpuCapacityWriteHysteresis = 0;
         std::string name = adpfs[i]["Name"].asString();
         LOG(VERBOSE) << "AdpfConfig[" << i << "]'s Name: " << name;
         if (name.empty()) {
@@ -928,6 +1033,7 @@ std::vector<std::shared_ptr<AdpfConfig>> HintManager::ParseAdpfConfigs(
         std::optional<bool> heuristicBoostOn;
         std::optional<uint32_t> hBoostModerateJankThreshold;
         std::optional<double> hBoostOffMaxAvgDurRatio;
+        std::optional<double> hBoostOffP90AvgDurRatio;
         std::optional<double> hBoostSevereJankPidPu;
         std::optional<uint32_t> hBoostSevereJankThreshold;
         std::optional<std::pair<uint32_t, uint32_t>> hBoostUclampMinCeilingRange;
@@ -938,6 +1044,9 @@ std::vector<std::shared_ptr<AdpfConfig>> HintManager::ParseAdpfConfigs(
         std::optional<bool> heuristicRampup;
         std::optional<uint32_t> defaultRampupMult;
         std::optional<uint32_t> highRampupMult;
+        std::optional<bool> predictiveBoostOn;
+        std::optional<double> predictiveBoostHeavyFactor;
+        std::optional<uint32_t> predictiveBoostUclampMin;
 
         std::optional<uint32_t> uclampMinLoadUp;
         std::optional<uint32_t> uclampMinLoadReset;
@@ -968,6 +1077,7 @@ std::vector<std::shared_ptr<AdpfConfig>> HintManager::ParseAdpfConfigs(
         ADPF_PARSE_OPTIONAL(heuristicBoostOn, "HeuristicBoost_On", Bool);
         ADPF_PARSE_OPTIONAL(hBoostModerateJankThreshold, "HBoostModerateJankThreshold", UInt);
         ADPF_PARSE_OPTIONAL(hBoostOffMaxAvgDurRatio, "HBoostOffMaxAvgDurRatio", Double);
+        ADPF_PARSE_OPTIONAL(hBoostOffP90AvgDurRatio, "HBoostOffP90AvgDurRatio", Double);
         ADPF_PARSE_OPTIONAL(hBoostSevereJankPidPu, "HBoostSevereJankPidPu", Double);
         ADPF_PARSE_OPTIONAL(hBoostSevereJankThreshold, "HBoostSevereJankThreshold", UInt);
         ADPF_PARSE_OPTIONAL(jankCheckTimeFactor, "JankCheckTimeFactor", Double);
@@ -976,6 +1086,9 @@ std::vector<std::shared_ptr<AdpfConfig>> HintManager::ParseAdpfConfigs(
         ADPF_PARSE_OPTIONAL(heuristicRampup, "HeuristicRampup", Bool);
         ADPF_PARSE_OPTIONAL(defaultRampupMult, "DefaultRampupMult", UInt);
         ADPF_PARSE_OPTIONAL(highRampupMult, "HighRampupMult", UInt);
+        ADPF_PARSE_OPTIONAL(predictiveBoostOn, "PredictiveBoost_On", Bool);
+        ADPF_PARSE_OPTIONAL(predictiveBoostHeavyFactor, "PredictiveBoostHeavyFactor", Double);
+        ADPF_PARSE_OPTIONAL(predictiveBoostUclampMin, "PredictiveBoostUclampMin", UInt);
         ADPF_PARSE_OPTIONAL(uclampMaxEfficientBase, "UclampMax_EfficientBase", Int);
         ADPF_PARSE_OPTIONAL(uclampMaxEfficientOffset, "UclampMax_EfficientOffset", Int);
 
@@ -990,6 +1103,10 @@ std::vector<std::shared_ptr<AdpfConfig>> HintManager::ParseAdpfConfigs(
             adpfs[i]["GpuCapacityLoadUpHeadroom"].isUInt64()) {
             gpuCapacityLoadUpHeadroom = adpfs[i]["GpuCapacityLoadUpHeadroom"].asUInt64();
         }
+        if (!adpfs[i]["GpuCapacityWriteHysteresis"].empty() &&
+            adpfs[i]["GpuCapacityWriteHysteresis"].isUInt64()) {
+            gpuCapacityWriteHysteresis = adpfs[i]["GpuCapacityWriteHysteresis"].asUInt64();
+        }
 
         if (!adpfs[i]["HBoostUclampMinCeilingRange"].empty()) {
             Json::Value ceilRange = adpfs[i]["HBoostUclampMinCeilingRange"];
@@ -1029,6 +1146,13 @@ std::vector<std::shared_ptr<AdpfConfig>> HintManager::ParseAdpfConfigs(
             }
         }
 
+        if (predictiveBoostOn.has_value() &&
+            (!predictiveBoostHeavyFactor.has_value() || !predictiveBoostUclampMin.has_value())) {
+            LOG(ERROR) << "Part of the predictive boost configurations are missing!";
+            adpfs_parsed.clear();
+            return adpfs_parsed;
+        }
+
         if (uclampMaxEfficientBase.has_value() != uclampMaxEfficientBase.has_value()) {
             LOG(ERROR) << "Part of the power efficiency configuration is missing!";
             adpfs_parsed.clear();
@@ -1047,33 +1171,62 @@ std::vector<std::shared_ptr<AdpfConfig>> HintManager::ParseAdpfConfigs(
                 pidDOver, pidDUnder, adpfUclamp, uclampMinInit, uclampMinHighLimit,
                 uclampMinLowLimit, samplingWindowP, samplingWindowI, samplingWindowD, reportingRate,
                 targetTimeFactor, staleTimeFactor, gpuBoost, gpuBoostCapacityMax,
-                gpuCapacityLoadUpHeadroom, heuristicBoostOn, hBoostModerateJankThreshold,
-                hBoostOffMaxAvgDurRatio, hBoostSevereJankPidPu, hBoostSevereJankThreshold,
-                hBoostUclampMinCeilingRange, hBoostUclampMinFloorRange, jankCheckTimeFactor,
-                lowFrameRateThreshold, maxRecordsNum, heuristicRampup, defaultRampupMult,
-                highRampupMult, uclampMinLoadUp.value(), uclampMinLoadReset.value(),
-                uclampMaxEfficientBase, uclampMaxEfficientOffset));
+                gpuCapacityLoadUpHeadroom, gpuCapacityWriteHysteresis, heuristicBoostOn,
+                hBoostModerateJankThreshold, hBoostOffMaxAvgDurRatio, hBoostOffP90AvgDurRatio,
+                hBoostSevereJankPidPu, hBoostSevereJankThreshold, hBoostUclampMinCeilingRange,
+                hBoostUclampMinFloorRange, jankCheckTimeFactor, lowFrameRateThreshold,
+                maxRecordsNum, heuristicRampup, defaultRampupMult, highRampupMult,
+                predictiveBoostOn, predictiveBoostHeavyFactor, predictiveBoostUclampMin,
+                uclampMinLoadUp.value(), uclampMinLoadReset.value(), uclampMaxEfficientBase,
+                uclampMaxEfficientOffset));
     }
     LOG(INFO) << adpfs_parsed.size() << " AdpfConfigs parsed successfully";
     return adpfs_parsed;
 }
 
+std::shared_ptr<AdpfConfig> AdpfProfileTable::FindProfile(const std::string &name) const {
+    for (const auto &adpf : adpfs) {
+        if (adpf->mName == name) {
+            return adpf;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<AdpfConfig> AdpfProfileTable::GetProfile(const std::string &tag) const {
+    if (adpfs.empty())
+        return nullptr;
+    auto it = tag_profiles.find(tag);
+    if (it == tag_profiles.end()) {
+        // TODO(jimmyshiu@): `return adpfs[0]` once the GetAdpfProfileFromDoHint() retired.
+        return adpfs[default_index];
+    }
+    return it->second;
+}
+
 // TODO(jimmyshiu@): Deprecated. Remove once all powerhint.json up-to-date.
 std::shared_ptr<AdpfConfig> HintManager::GetAdpfProfileFromDoHint() const {
-    if (adpfs_.empty())
+    auto adpf_table = adpf_table_.Load();
+    if (adpf_table->adpfs.empty())
         return nullptr;
-    return adpfs_[adpf_index_];
+    return adpf_table->adpfs[adpf_table->default_index];
 }
 
 // TODO(jimmyshiu@): Deprecated. Remove once all powerhint.json up-to-date.
 bool HintManager::SetAdpfProfileFromDoHint(const std::string &profile_name) {
-    for (std::size_t i = 0; i < adpfs_.size(); ++i) {
-        if (adpfs_[i]->mName == profile_name) {
-            if (adpf_index_ != i) {
-                ATRACE_NAME(StringPrintf("%s %s:%s", __func__, adpfs_[adpf_index_]->mName.c_str(),
+    std::lock_guard<std::mutex> lock(adpf_lock_);
+    auto adpf_table = adpf_table_.Load();
+    const auto &adpfs = adpf_table->adpfs;
+    for (std::size_t i = 0; i < adpfs.size(); ++i) {
+        if (adpfs[i]->mName == profile_name) {
+            if (adpf_table->default_index != i) {
+                ATRACE_NAME(StringPrintf("%s %s:%s", __func__,
+                                         adpfs[adpf_table->default_index]->mName.c_str(),
                                          profile_name.c_str())
                                     .c_str());
-                adpf_index_ = i;
+                auto new_table = std::make_shared<AdpfProfileTable>(*adpf_table);
+                new_table->default_index = i;
+                adpf_table_.Store(std::move(new_table));
             }
             return true;
         }
@@ -1082,51 +1235,141 @@ bool HintManager::SetAdpfProfileFromDoHint(const std::string &profile_name) {
 }
 
 bool HintManager::IsAdpfSupported() const {
-    return !adpfs_.empty();
+    return !adpf_table_.Load()->adpfs.empty();
 }
 
 std::shared_ptr<AdpfConfig> HintManager::GetAdpfProfile(const std::string &tag) const {
-    if (adpfs_.empty())
-        return nullptr;
-    if (tag_profile_map_.find(tag) == tag_profile_map_.end()) {
-        // TODO(jimmyshiu@): `return adpfs_[0]` once the GetAdpfProfileFromDoHint() retired.
-        return GetAdpfProfileFromDoHint();
-    }
-    return tag_profile_map_.at(tag);
+    return adpf_table_.Load()->GetProfile(tag);
 }
 
 bool HintManager::SetAdpfProfile(const std::string &tag, const std::string &profile) {
-    if (tag_profile_map_.find(tag) == tag_profile_map_.end()) {
+    std::lock_guard<std::mutex> lock(adpf_lock_);
+    auto adpf_table = adpf_table_.Load();
+    auto it = adpf_table->tag_profiles.find(tag);
+    if (it == adpf_table->tag_profiles.end()) {
         LOG(WARNING) << "SetAdpfProfile('" << tag << "', " << profile << ") Invalidate Tag!!!";
         return false;
     }
-    if (tag_profile_map_[tag]->mName == profile) {
+    if (it->second->mName == profile) {
         LOG(VERBOSE) << "SetAdpfProfile:(" << tag << ", " << profile << ") value not changed!";
         return true;
     }
 
-    bool updated = false;
-    for (std::size_t i = 0; i < adpfs_.size(); ++i) {
-        if (adpfs_[i]->mName == profile) {
-            LOG(DEBUG) << "SetAdpfProfile('" << tag << "', '" << profile << "') Done!";
-            tag_profile_map_[tag] = adpfs_[i];
-            updated = true;
-            break;
-        }
-    }
-    if (!updated) {
+    auto adpf = adpf_table->FindProfile(profile);
+    if (!adpf) {
         LOG(WARNING) << "SetAdpfProfile(" << tag << ") failed to find profile:'" << profile << "'";
+        return false;
     }
-    return updated;
+    auto new_table = std::make_shared<AdpfProfileTable>(*adpf_table);
+    new_table->tag_profiles[tag] = std::move(adpf);
+    adpf_table_.Store(std::move(new_table));
+    LOG(DEBUG) << "SetAdpfProfile('" << tag << "', '" << profile << "') Done!";
+    return true;
 }
 
 bool HintManager::IsAdpfProfileSupported(const std::string &profile_name) const {
-    for (std::size_t i = 0; i < adpfs_.size(); ++i) {
-        if (adpfs_[i]->mName == profile_name) {
-            return true;
+    return adpf_table_.Load()->FindProfile(profile_name) != nullptr;
+}
+
+bool HintManager::ReloadAdpfProfiles() {
+    ATRACE_CALL();
+    std::string json_doc;
+    if (config_path_.empty() || !android::base::ReadFileToString(config_path_, &json_doc)) {
+        LOG(ERROR) << "Failed to read JSON config from '" << config_path_ << "'";
+        return false;
+    }
+    std::vector<std::shared_ptr<AdpfConfig>> adpfs = ParseAdpfConfigs(json_doc);
+    if (adpfs.empty()) {
+        LOG(ERROR) << "Failed to reload AdpfConfig section from " << config_path_;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(adpf_lock_);
+    auto adpf_table = adpf_table_.Load();
+    auto new_table = std::make_shared<AdpfProfileTable>();
+    new_table->adpfs = std::move(adpfs);
+    new_table->generation = adpf_table->generation + 1;
+    if (!adpf_table->adpfs.empty()) {
+        const std::string &name = adpf_table->adpfs[adpf_table->default_index]->mName;
+        for (std::size_t i = 0; i < new_table->adpfs.size(); ++i) {
+            if (new_table->adpfs[i]->mName == name) {
+                new_table->default_index = i;
+                break;
+            }
         }
     }
-    return false;
+    for (const auto &[tag, profile] : adpf_table->tag_profiles) {
+        auto adpf = new_table->FindProfile(profile->mName);
+        if (!adpf) {
+            adpf = new_table->adpfs[0];
+            LOG(WARNING) << "ReloadAdpfProfiles: [" << tag << "] '" << profile->mName
+                         << "' removed, fallback to '" << adpf->mName << "'";
+        }
+        new_table->tag_profiles[tag] = std::move(adpf);
+    }
+    adpf_table_.Store(new_table);
+
+    for (const auto &[tag, callback_list] : tag_update_callback_list_) {
+        NotifyAdpfUpdate(tag, new_table->GetProfile(tag));
+    }
+    LOG(INFO) << "Reloaded " << new_table->adpfs.size() << " AdpfConfigs from " << config_path_
+              << ", generation " << new_table->generation;
+    return true;
+}
+
+bool HintManager::WatchAdpfProfiles() {
+    if (config_path_.empty() || config_watcher_.joinable()) {
+        return false;
+    }
+    const std::size_t pos = config_path_.find_last_of('/');
+    const std::string dir = pos == std::string::npos ? "." : config_path_.substr(0, pos + 1);
+    const std::string file = pos == std::string::npos ? config_path_ : config_path_.substr(pos + 1);
+
+    // Watch the directory rather than the file so replacing the file by
+    // rename is caught as well.
+    android::base::unique_fd inotify_fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC));
+    if (inotify_fd < 0 ||
+        inotify_add_watch(inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        PLOG(ERROR) << "Failed to watch " << dir;
+        return false;
+    }
+    config_watcher_stop_fd_.reset(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+    if (config_watcher_stop_fd_ < 0) {
+        PLOG(ERROR) << "Failed to create eventfd";
+        return false;
+    }
+
+    config_watcher_ = std::thread([this, file, inotify_fd = std::move(inotify_fd)]() {
+        pthread_setname_np(pthread_self(), "AdpfWatcher");
+        struct pollfd fds[2] = {{inotify_fd, POLLIN, 0}, {config_watcher_stop_fd_, POLLIN, 0}};
+        alignas(struct inotify_event) char buf[4096];
+        while (true) {
+            if (TEMP_FAILURE_RETRY(poll(fds, 2, -1)) < 0 || fds[1].revents) {
+                return;
+            }
+            bool changed = false;
+            ssize_t len;
+            while ((len = read(inotify_fd, buf, sizeof(buf))) > 0) {
+                for (char *ptr = buf; ptr < buf + len;) {
+                    auto event = reinterpret_cast<const struct inotify_event *>(ptr);
+                    if (event->len && file == event->name) {
+                        changed = true;
+                    }
+                    ptr += sizeof(struct inotify_event) + event->len;
+                }
+            }
+            if (changed) {
+                ReloadAdpfProfiles();
+            }
+        }
+    });
+    LOG(INFO) << "Watching " << config_path_ << " for AdpfConfig changes";
+    return true;
+}
+
+void HintManager::OnEventNodeUpdate(const std::string &name, const std::vector<std::string> &paths,
+                                    const std::string &value) {
+    HintManager::GetInstance()->OnNodeUpdate(name, paths, value);
 }
 
 void HintManager::OnNodeUpdate(const std::string &name,
@@ -1141,20 +1384,31 @@ void HintManager::OnNodeUpdate(const std::string &name,
                 LOG(DEBUG) << "OnNodeUpdate:[" << name << "] failed to update '" << value << "'";
                 return;
             }
-            auto &callback_list = tag_update_callback_list_[tag];
-            for (const auto &callback : callback_list) {
-                (*callback)(tag_profile_map_[tag]);
-            }
+            std::lock_guard<std::mutex> lock(adpf_lock_);
+            NotifyAdpfUpdate(tag, adpf_table_.Load()->GetProfile(tag));
         }
     }
 }
 
+void HintManager::NotifyAdpfUpdate(const std::string &tag,
+                                   const std::shared_ptr<AdpfConfig> &profile) {
+    auto it = tag_update_callback_list_.find(tag);
+    if (it == tag_update_callback_list_.end()) {
+        return;
+    }
+    for (const auto &callback : it->second) {
+        (*callback)(profile);
+    }
+}
+
 void HintManager::RegisterAdpfUpdateEvent(const std::string &tag, AdpfCallback *update_adpf_func) {
+    std::lock_guard<std::mutex> lock(adpf_lock_);
     tag_update_callback_list_[tag].push_back(update_adpf_func);
 }
 
 void HintManager::UnregisterAdpfUpdateEvent(const std::string &tag,
                                             AdpfCallback *update_adpf_func) {
+    std::lock_guard<std::mutex> lock(adpf_lock_);
     auto &callback_list = tag_update_callback_list_[tag];
     // Use std::find to locate the function object
     auto it = std::find_if(
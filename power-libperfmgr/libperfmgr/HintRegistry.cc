@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/HintRegistry.h"
+
+namespace android {
+namespace perfmgr {
+
+HintRegistry &HintRegistry::GetInstance() {
+    static HintRegistry sInstance;
+    return sInstance;
+}
+
+HintId HintRegistry::Intern(const std::string &hint_type) {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = ids_.find(hint_type);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    HintId id = static_cast<HintId>(names_.size());
+    names_.push_back(hint_type);
+    ids_.emplace(hint_type, id);
+    return id;
+}
+
+HintId HintRegistry::Find(const std::string &hint_type) const {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = ids_.find(hint_type);
+    return it == ids_.end() ? kInvalidHintId : it->second;
+}
+
+std::string HintRegistry::GetName(HintId id) const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return id < names_.size() ? names_[id] : std::string();
+}
+
+std::size_t HintRegistry::Size() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return names_.size();
+}
+
+}  // namespace perfmgr
+}  // namespace android
@@ -29,60 +29,148 @@
 namespace android {
 namespace perfmgr {
 
-JobQueueManager::JobQueueManager(size_t poolSize) : mPoolSize(poolSize) {
+namespace {
+size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t capacity = 2;
+    while (capacity < n) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+}  // namespace
+
+JobRing::JobRing(size_t capacity)
+    : mCells(new Cell[RoundUpToPowerOfTwo(capacity)]),
+      mMask(RoundUpToPowerOfTwo(capacity) - 1) {
+    for (size_t i = 0; i <= mMask; ++i) {
+        mCells[i].sequence.store(i, std::memory_order_relaxed);
+        mCells[i].job = nullptr;
+    }
+}
+
+bool JobRing::push(Job *job) {
+    Cell *cell;
+    size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        cell = &mCells[pos & mMask];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (dif == 0) {
+            if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            return false;
+        } else {
+            pos = mEnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    cell->job = job;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+Job *JobRing::pop() {
+    Cell *cell;
+    size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        cell = &mCells[pos & mMask];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (dif == 0) {
+            if (mDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            return nullptr;
+        } else {
+            pos = mDequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+    Job *job = cell->job;
+    cell->sequence.store(pos + mMask + 1, std::memory_order_release);
+    return job;
+}
+
+JobQueueManager::JobQueueManager(size_t poolSize) : mJobPool(poolSize), mPoolSize(poolSize) {
     for (size_t i = 0; i < mPoolSize; ++i) {
         Job *job = new Job();
-        mJobPool.push_back(job);  // Add to the pool
+        mJobPool.push(job);  // Add to the pool
+    }
+}
+
+JobQueueManager::~JobQueueManager() {
+    Job *job;
+    while ((job = dequeueRequest()) != nullptr) {
+        delete job;
+    }
+    while ((job = mJobPool.pop()) != nullptr) {
+        delete job;
     }
 }
 
-void JobQueueManager::enqueueRequest(Job *job) {
-    ::android::AutoMutex _l(mQueueMutex);
-    // This is a priority_queue(automatically sort the jobs by schedule_time)
-    mJobQueue.push(job);
+bool JobQueueManager::enqueueRequest(Job *job) {
+    mSize.fetch_add(1, std::memory_order_relaxed);
+    Job *head = mPending.load(std::memory_order_relaxed);
+    do {
+        job->next = head;
+    } while (!mPending.compare_exchange_weak(head, job, std::memory_order_release,
+                                             std::memory_order_relaxed));
+    return head == nullptr;
+}
+
+void JobQueueManager::drainPending() {
+    Job *job = mPending.exchange(nullptr, std::memory_order_acquire);
+    while (job != nullptr) {
+        Job *next = job->next;
+        job->next = nullptr;
+        // This is a priority_queue(automatically sort the jobs by schedule_time)
+        mJobQueue.push(job);
+        job = next;
+    }
 }
 
 Job *JobQueueManager::dequeueRequest() {
-    ::android::AutoMutex _l(mQueueMutex);
+    drainPending();
     if (mJobQueue.empty()) {
         return nullptr;
     }
     Job *job = mJobQueue.top();
     mJobQueue.pop();
+    mSize.fetch_sub(1, std::memory_order_relaxed);
     return job;
 }
 
 Job *JobQueueManager::getFreeJob() {
-    ::android::AutoMutex _l(mQueueMutex);
-    if (mJobPool.empty()) {
+    Job *job = mJobPool.pop();
+    if (job == nullptr) {
         // If pool is empty, allocate a new job on the heap.
         // This can happen if the pool size is not sufficient, or
         // if a job is not returned to the pool correctly.
-        std::string warning = "PowerHAL:JobPoolEmpty[queue:" + std::to_string(mJobQueue.size()) +
+        std::string warning = "PowerHAL:JobPoolEmpty[queue:" + std::to_string(getSize()) +
                               ",pool: " + std::to_string(mPoolSize) +
                               ",limit:" + std::to_string(mPoolSize) + "]";
         LOG(WARNING) << warning;
         ATRACE_NAME(warning.c_str());
         return new Job();
     }
-    Job *job = mJobPool.front();
-    mJobPool.pop_front();
     return job;
 }
 
 void JobQueueManager::returnJob(Job *job) {
-    ::android::AutoMutex _l(mQueueMutex);
     job->reset();  // Reset the job's content
-    mJobPool.push_back(job);
+    if (!mJobPool.push(job)) {
+        // Pool is already full, this job was allocated on demand.
+        delete job;
+    }
 }
 
 size_t JobQueueManager::getSize() {
-    ::android::AutoMutex _l(mQueueMutex);
-    return mJobQueue.size();
+    return mSize.load(std::memory_order_relaxed);
 }
 
 void JobQueueManager::DumpToFd(int fd) {
-    ::android::AutoMutex _l(mQueueMutex);
+    drainPending();
 
     std::string buf = android::base::StringPrintf(
             "Job Queue Dump:\n"
@@ -90,7 +178,7 @@ void JobQueueManager::DumpToFd(int fd) {
             "Queue Size: %zu\n"
             "Pool Size: %zu\n"
             "-------------------\n",
-            mJobQueue.size(), mJobPool.size());
+            mJobQueue.size(), mPoolSize);
     if (!android::base::WriteStringToFd(buf, fd)) {
         LOG(ERROR) << "Failed to dump queue info to fd: " << fd;
     }
@@ -108,7 +196,8 @@ void JobQueueManager::DumpToFd(int fd) {
             Job *job = mJobQueue.top();
             mJobQueue.pop();
             buf = android::base::StringPrintf(
-                    "  Hint Type: %s, Schedule Time: %lld, Is Cancel: %d\n", job->hint_type.c_str(),
+                    "  Hint Type: %s, Schedule Time: %lld, Is Cancel: %d\n",
+                    HintRegistry::GetInstance().GetName(job->hint_id).c_str(),
                     job->schedule_time.time_since_epoch().count(), job->is_cancel);
             if (!android::base::WriteStringToFd(buf, fd)) {
                 LOG(ERROR) << "Failed to dump job info to fd: " << fd;
@@ -126,9 +215,10 @@ void JobQueueManager::DumpToFd(int fd) {
 
 void Job::reset() {
     actions.clear();
-    hint_type.clear();
+    hint_id = kInvalidHintId;
     schedule_time = std::chrono::steady_clock::now();
     is_cancel = false;
+    next = nullptr;
 }
 
 }  // namespace perfmgr
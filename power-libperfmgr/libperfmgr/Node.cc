@@ -33,29 +33,45 @@ Node::Node(std::string name, std::vector<std::string> node_paths,
       req_sorted_(std::move(req_sorted)),
       default_val_index_(default_val_index),
       reset_on_init_(reset_on_init),
-      current_val_index_(default_val_index) {}
+      current_val_index_(default_val_index),
+      dirty_(true) {}
 
-bool Node::AddRequest(std::size_t value_index, const std::string& hint_type,
-                      ReqTime end_time) {
+bool Node::AddRequest(std::size_t value_index, HintId hint_id, ReqTime end_time) {
     if (value_index >= req_sorted_.size()) {
         LOG(ERROR) << "Value index out of bound: " << value_index
                    << " ,size: " << req_sorted_.size();
         return false;
     }
     // Add/Update request to the new end_time for the specific hint_type
-    req_sorted_[value_index].AddRequest(hint_type, end_time);
+    req_sorted_[value_index].AddRequest(hint_id, end_time);
+    dirty_ = true;
     return true;
 }
 
-bool Node::RemoveRequest(const std::string& hint_type) {
+bool Node::AddRequest(std::size_t value_index, const std::string& hint_type,
+                      ReqTime end_time) {
+    return AddRequest(value_index, HintRegistry::GetInstance().Intern(hint_type), end_time);
+}
+
+bool Node::RemoveRequest(HintId hint_id) {
     bool ret = false;
     // Remove all requests for the specific hint_type
     for (auto& value : req_sorted_) {
-        ret = value.RemoveRequest(hint_type) || ret;
+        ret = value.RemoveRequest(hint_id) || ret;
     }
+    dirty_ = dirty_ || ret;
     return ret;
 }
 
+bool Node::RemoveRequest(const std::string& hint_type) {
+    HintId hint_id = HintRegistry::GetInstance().Find(hint_type);
+    return hint_id != kInvalidHintId && RemoveRequest(hint_id);
+}
+
+bool Node::IsDirty() const {
+    return dirty_;
+}
+
 const std::string& Node::GetName() const {
     return name_;
 }
@@ -84,6 +100,14 @@ bool Node::GetResetOnInit() const {
     return reset_on_init_;
 }
 
+const std::string& Node::GetDependencyClass() const {
+    return dependency_class_;
+}
+
+void Node::SetDependencyClass(std::string dependency_class) {
+    dependency_class_ = std::move(dependency_class);
+}
+
 std::vector<std::string> Node::GetValues() const {
     std::vector<std::string> values;
     for (const auto& value : req_sorted_) {
@@ -21,13 +21,156 @@
 
 #include <android-base/file.h>
 #include <android-base/logging.h>
-#include <android-base/properties.h>
+#include <android-base/stringprintf.h>
+#include <poll.h>
 #include <processgroup/processgroup.h>
+#include <sys/eventfd.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+
 namespace android {
 namespace perfmgr {
 
+NodeLooperThread::NodeLooperThread(std::vector<std::unique_ptr<Node>> nodes,
+                                   std::size_t num_writer_threads)
+    : Thread(false),
+      nodes_(std::move(nodes)),
+      update_queued_(nodes_.size(), true),
+      node_expiries_(nodes_.size(), ReqTime::max()),
+      update_timeouts_(nodes_.size(), std::chrono::milliseconds::max()),
+      wake_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+    if (wake_fd_ == -1) {
+        PLOG(ERROR) << "Failed to create wake eventfd";
+    }
+    // Every node gets updated once on the first loop for reset_on_init.
+    update_list_.reserve(nodes_.size());
+    for (std::size_t i = 0; i < nodes_.size(); i++) {
+        update_list_.push_back(i);
+    }
+
+    if (num_writer_threads > 0) {
+        std::unordered_map<std::string, std::size_t> class_groups;
+        node_groups_.reserve(nodes_.size());
+        for (const auto &n : nodes_) {
+            const std::string &dependency_class = n->GetDependencyClass();
+            std::size_t group = group_updates_.size();
+            if (!dependency_class.empty()) {
+                group = class_groups.emplace(dependency_class, group).first->second;
+            }
+            if (group == group_updates_.size()) {
+                group_updates_.emplace_back();
+            }
+            node_groups_.push_back(group);
+        }
+        // Parallel writes do not help if everything depends on each other.
+        if (group_updates_.size() > 1) {
+            writer_pool_ = std::make_unique<NodeWriterPool>(
+                    std::min(num_writer_threads, group_updates_.size() - 1));
+        }
+    }
+}
+
+void NodeLooperThread::Wake() {
+    if (eventfd_write(wake_fd_, 1) != 0) {
+        PLOG(ERROR) << "Failed to wake NodeLooperThread";
+    }
+}
+
+void NodeLooperThread::WaitForWake(nsecs_t sleep_timeout_ns) {
+    struct pollfd pfd = {.fd = wake_fd_, .events = POLLIN, .revents = 0};
+    struct timespec ts;
+    struct timespec *timeout = nullptr;
+    if (sleep_timeout_ns != std::numeric_limits<nsecs_t>::max()) {
+        ts.tv_sec = sleep_timeout_ns / 1000000000;
+        ts.tv_nsec = sleep_timeout_ns % 1000000000;
+        timeout = &ts;
+    }
+    if (TEMP_FAILURE_RETRY(ppoll(&pfd, 1, timeout, nullptr)) > 0) {
+        eventfd_t count;
+        // Reset the counter; a racing Wake() only causes one more loop.
+        eventfd_read(wake_fd_, &count);
+    }
+}
+
+void NodeLooperThread::QueueNodeUpdate(std::size_t node_index) {
+    if (!update_queued_[node_index]) {
+        update_queued_[node_index] = true;
+        update_list_.push_back(node_index);
+    }
+}
+
+void NodeLooperThread::QueueExpiredNodes(ReqTime now) {
+    while (!expiry_heap_.empty() && expiry_heap_.front().expire_time <= now) {
+        std::pop_heap(expiry_heap_.begin(), expiry_heap_.end(), std::greater<NodeExpiry>());
+        const NodeExpiry &expiry = expiry_heap_.back();
+        if (node_expiries_[expiry.node_index] == expiry.expire_time) {
+            node_expiries_[expiry.node_index] = ReqTime::max();
+            QueueNodeUpdate(expiry.node_index);
+        }
+        expiry_heap_.pop_back();
+    }
+}
+
+void NodeLooperThread::SetNodeExpiry(std::size_t node_index, std::chrono::milliseconds timeout,
+                                     ReqTime now) {
+    ReqTime expire_time = ReqTime::max();
+    // Same overflow protection as request end_time
+    if (timeout != std::chrono::milliseconds::max() &&
+        std::chrono::duration_cast<std::chrono::milliseconds>(ReqTime::max() - now) > timeout) {
+        expire_time = now + timeout;
+    }
+    if (node_expiries_[node_index] == expire_time) {
+        return;
+    }
+    node_expiries_[node_index] = expire_time;
+    if (expire_time == ReqTime::max()) {
+        return;
+    }
+    expiry_heap_.push_back({expire_time, node_index});
+    std::push_heap(expiry_heap_.begin(), expiry_heap_.end(), std::greater<NodeExpiry>());
+
+    // Frequent boosts with long timeouts leave stale entries behind, drop
+    // them before the heap grows unbounded.
+    if (expiry_heap_.size() > kExpiryHeapCompactFactor * nodes_.size()) {
+        expiry_heap_.clear();
+        for (std::size_t i = 0; i < node_expiries_.size(); i++) {
+            if (node_expiries_[i] != ReqTime::max()) {
+                expiry_heap_.push_back({node_expiries_[i], i});
+            }
+        }
+        std::make_heap(expiry_heap_.begin(), expiry_heap_.end(), std::greater<NodeExpiry>());
+    }
+}
+
+nsecs_t NodeLooperThread::GetSleepTimeout(ReqTime now) const {
+    if (expiry_heap_.empty()) {
+        return std::numeric_limits<nsecs_t>::max();
+    }
+    // A stale top entry only causes an early wakeup with nothing to update.
+    auto timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            expiry_heap_.front().expire_time - now);
+    return std::max<nsecs_t>(timeout.count(), 0);
+}
+
+void NodeLooperThread::UpdateNodes(const std::vector<std::size_t> &node_indices) {
+    // Update 2 passes: some node may have dependency in other node
+    // e.g. update cpufreq min to VAL while cpufreq max still set to
+    // a value lower than VAL, is expected to fail in first pass.
+    // Only nodes that failed in the first pass are retried.
+    for (std::size_t i : node_indices) {
+        update_timeouts_[i] = nodes_[i]->Update(false);
+    }
+    for (std::size_t i : node_indices) {
+        if (nodes_[i]->IsDirty()) {
+            update_timeouts_[i] = nodes_[i]->Update(true);
+        }
+    }
+}
+
 status_t NodeLooperThread::readyToRun() {
     // set task profile "PreferIdle" to lower scheduling latency.
     if (!SetTaskProfiles(0, {"PreferIdleSet"})) {
@@ -36,151 +179,211 @@ status_t NodeLooperThread::readyToRun() {
     return NO_ERROR;
 }
 
-bool NodeLooperThread::Request(const std::vector<NodeAction>& actions,
-                               const std::string& hint_type) {
+bool NodeLooperThread::Request(const std::vector<NodeAction>& actions, HintId hint_id) {
     if (::android::Thread::exitPending()) {
         LOG(WARNING) << "NodeLooperThread is exiting";
         return false;
     }
     if (!::android::Thread::isRunning()) {
-        LOG(WARNING) << "NodeLooperThread is not running, request " << hint_type;
+        LOG(WARNING) << "NodeLooperThread is not running, request "
+                     << HintRegistry::GetInstance().GetName(hint_id);
     }
 
     Job *job = jobmgr_.getFreeJob();
     job->is_cancel = false;
-    job->hint_type = hint_type;
+    job->hint_id = hint_id;
     job->schedule_time = std::chrono::steady_clock::now();
-    ATRACE_BEGIN(("enq:+" + hint_type).c_str());
-    for (const auto& a : actions) {
-        std::string act_name = nodes_[a.node_index]->GetName();
-        ATRACE_BEGIN(act_name.c_str());
-        job->actions.push_back(a);
-        ATRACE_END();
+    if (ATRACE_ENABLED()) {
+        ATRACE_BEGIN(("enq:+" + HintRegistry::GetInstance().GetName(hint_id)).c_str());
     }
-    jobmgr_.enqueueRequest(job);
+    job->actions = actions;
+    // Only the job that makes the queue non-empty needs to wake threadloop,
+    // which always drains the whole queue before going back to sleep.
+    bool wake = jobmgr_.enqueueRequest(job);
     LOG(VERBOSE) << "JobQueue[+].size:" << jobmgr_.getSize();
-    ATRACE_END();
-    wake_cond_.signal();
+    if (ATRACE_ENABLED()) {
+        ATRACE_END();
+    }
+    if (wake) {
+        Wake();
+    }
     return true;
 }
 
-bool NodeLooperThread::Cancel(const std::vector<NodeAction>& actions,
-                              const std::string& hint_type) {
+bool NodeLooperThread::Request(const std::vector<NodeAction>& actions,
+                               const std::string& hint_type) {
+    return Request(actions, HintRegistry::GetInstance().Intern(hint_type));
+}
+
+bool NodeLooperThread::Cancel(const std::vector<NodeAction>& actions, HintId hint_id) {
     if (::android::Thread::exitPending()) {
         LOG(WARNING) << "NodeLooperThread is exiting";
         return false;
     }
     if (!::android::Thread::isRunning()) {
-        LOG(WARNING) << "NodeLooperThread is not running, cancel " << hint_type;
+        LOG(WARNING) << "NodeLooperThread is not running, cancel "
+                     << HintRegistry::GetInstance().GetName(hint_id);
     }
 
     Job *job = jobmgr_.getFreeJob();
     job->is_cancel = true;
-    job->hint_type = hint_type;
+    job->hint_id = hint_id;
     job->schedule_time = std::chrono::steady_clock::now();
-    ATRACE_BEGIN(("enq:-" + hint_type).c_str());
-    for (const auto& a : actions) {
-        std::string act_name = nodes_[a.node_index]->GetName();
-        ATRACE_BEGIN(act_name.c_str());
-        job->actions.push_back(a);
+    if (ATRACE_ENABLED()) {
+        ATRACE_BEGIN(("enq:-" + HintRegistry::GetInstance().GetName(hint_id)).c_str());
+    }
+    job->actions = actions;
+    bool wake = jobmgr_.enqueueRequest(job);
+    if (ATRACE_ENABLED()) {
         ATRACE_END();
     }
-    jobmgr_.enqueueRequest(job);
-    ATRACE_END();
-    wake_cond_.signal();
+    if (wake) {
+        Wake();
+    }
     return true;
 }
 
+bool NodeLooperThread::Cancel(const std::vector<NodeAction>& actions,
+                              const std::string& hint_type) {
+    return Cancel(actions, HintRegistry::GetInstance().Intern(hint_type));
+}
+
 void NodeLooperThread::DumpToFd(int fd) {
     ::android::AutoMutex _l(lock_);
     for (auto& n : nodes_) {
         n->DumpToFd(fd);
     }
     jobmgr_.DumpToFd(fd);
+    if (writer_pool_ != nullptr) {
+        android::base::WriteStringToFd(
+                android::base::StringPrintf("NodeWriterPool: %zu threads, %zu groups\n",
+                                            writer_pool_->GetNumThreads(), group_updates_.size()),
+                fd);
+    }
 }
 
 bool NodeLooperThread::threadLoop() {
-    Job *job = jobmgr_.dequeueRequest();
-    ::android::AutoMutex _l(lock_);
+    nsecs_t sleep_timeout_ns;
+    {
+        // lock_ is never taken by Request/Cancel, so holding it through the
+        // node updates only serializes against DumpToFd and Stop.
+        ::android::AutoMutex _l(lock_);
+        Job *job = jobmgr_.dequeueRequest();
 
-    if (job != nullptr) {
-        ATRACE_BEGIN(("deq:" + job->hint_type + (job->is_cancel ? ":-" : ":+")).c_str());
-        for (const auto &a : job->actions) {
-            std::string node_name = nodes_[a.node_index]->GetName();
-            if (!a.enable_property.empty() &&
-                !android::base::GetBoolProperty(a.enable_property, true)) {
-                ATRACE_BEGIN((node_name + ":prop:disabled").c_str());
-                // Disabled action based on its control property
-                ATRACE_END();
-                continue;
-            }
-            if ((a.enable_flag != nullptr && !a.enable_flag()) ||
-                (a.disable_flag != nullptr && a.disable_flag())) {
-                continue;
+        if (job != nullptr) {
+            // Only format trace names when tracing is on; this runs on every boost.
+            const bool tracing = ATRACE_ENABLED();
+            if (tracing) {
+                ATRACE_BEGIN(("deq:" + HintRegistry::GetInstance().GetName(job->hint_id) +
+                              (job->is_cancel ? ":-" : ":+"))
+                                     .c_str());
             }
-            if (a.node_index >= nodes_.size()) {
-                LOG(ERROR) << "Node index out of bound: " << a.node_index
-                           << " ,size: " << nodes_.size();
-                ATRACE_NAME((node_name + ":out-of-bound").c_str());
-                continue;
-            } else if (job->is_cancel) {
-                ATRACE_BEGIN((node_name + ":disable").c_str());
-                nodes_[a.node_index]->RemoveRequest(job->hint_type);
-                ATRACE_END();
-            } else {
-                ATRACE_BEGIN((node_name + ":enable").c_str());
-                // End time set to steady time point max
-                ReqTime end_time = ReqTime::max();
-                // Timeout is non-zero
-                if (a.timeout_ms != std::chrono::milliseconds::zero()) {
-                    auto now = job->schedule_time;  // std::chrono::steady_clock::now();
-                    // Overflow protection in case timeout_ms is too big to
-                    // overflow time point which is unsigned integer
-                    if (std::chrono::duration_cast<std::chrono::milliseconds>(ReqTime::max() -
-                                                                              now) > a.timeout_ms) {
-                        end_time = now + a.timeout_ms;
+            for (const auto &a : job->actions) {
+                if (a.node_index >= nodes_.size()) {
+                    LOG(ERROR) << "Node index out of bound: " << a.node_index
+                               << " ,size: " << nodes_.size();
+                    ATRACE_NAME("node:out-of-bound");
+                    continue;
+                }
+                const std::string &node_name = nodes_[a.node_index]->GetName();
+                if (!a.IsEnabled()) {
+                    // Disabled action based on its control property or flags
+                    if (tracing) {
+                        ATRACE_NAME((node_name + ":gate:disabled").c_str());
                     }
+                    continue;
                 }
-                bool ok = nodes_[a.node_index]->AddRequest(a.value_index, job->hint_type, end_time);
-                if (!ok) {
-                    LOG(ERROR) << "Node.AddRequest err: Node[" << node_name << "][" << a.value_index
-                               << "]";
+                if (job->is_cancel) {
+                    if (tracing) {
+                        ATRACE_BEGIN((node_name + ":disable").c_str());
+                    }
+                    if (nodes_[a.node_index]->RemoveRequest(job->hint_id)) {
+                        QueueNodeUpdate(a.node_index);
+                    }
+                } else {
+                    if (tracing) {
+                        ATRACE_BEGIN((node_name + ":enable").c_str());
+                    }
+                    // End time set to steady time point max
+                    ReqTime end_time = ReqTime::max();
+                    // Timeout is non-zero
+                    if (a.timeout_ms != std::chrono::milliseconds::zero()) {
+                        auto now = job->schedule_time;  // std::chrono::steady_clock::now();
+                        // Overflow protection in case timeout_ms is too big to
+                        // overflow time point which is unsigned integer
+                        if (std::chrono::duration_cast<std::chrono::milliseconds>(
+                                    ReqTime::max() - now) > a.timeout_ms) {
+                            end_time = now + a.timeout_ms;
+                        }
+                    }
+                    bool ok = nodes_[a.node_index]->AddRequest(a.value_index, job->hint_id,
+                                                               end_time);
+                    if (ok) {
+                        QueueNodeUpdate(a.node_index);
+                    } else {
+                        LOG(ERROR) << "Node.AddRequest err: Node[" << node_name << "]["
+                                   << a.value_index << "]";
+                    }
                 }
+                if (tracing) {
+                    ATRACE_END();
+                }
+            }
+            if (tracing) {
                 ATRACE_END();
             }
+            jobmgr_.returnJob(job);
+            LOG(VERBOSE) << "JobQueue[-].size:" << jobmgr_.getSize();
+        }
+
+        // Only nodes touched by the job or past their expire time need
+        // Update(); all others keep their value and expire time.
+        ReqTime now = std::chrono::steady_clock::now();
+        QueueExpiredNodes(now);
+
+        ATRACE_BEGIN("update_nodes");
+        // Keep config order so dependent nodes are written in sequence.
+        std::sort(update_list_.begin(), update_list_.end());
+        if (writer_pool_ == nullptr) {
+            UpdateNodes(update_list_);
+        } else {
+            for (std::size_t i : update_list_) {
+                std::vector<std::size_t> &group_update = group_updates_[node_groups_[i]];
+                if (group_update.empty()) {
+                    active_groups_.push_back(node_groups_[i]);
+                }
+                group_update.push_back(i);
+            }
+            // Each group is updated by a single thread, so no node is
+            // touched concurrently.
+            writer_pool_->Run(active_groups_.size(), [this](std::size_t k) {
+                UpdateNodes(group_updates_[active_groups_[k]]);
+            });
+            for (std::size_t group : active_groups_) {
+                group_updates_[group].clear();
+            }
+            active_groups_.clear();
+        }
+        for (std::size_t i : update_list_) {
+            SetNodeExpiry(i, update_timeouts_[i], now);
+            update_queued_[i] = false;
         }
+        update_list_.clear();
         ATRACE_END();
-        jobmgr_.returnJob(job);
-        LOG(VERBOSE) << "JobQueue[-].size:" << jobmgr_.getSize();
-    }
 
-    // Update 2 passes: some node may have dependency in other node
-    // e.g. update cpufreq min to VAL while cpufreq max still set to
-    // a value lower than VAL, is expected to fail in first pass
-    std::chrono::milliseconds timeout_ms = kMaxUpdatePeriod;
-    ATRACE_BEGIN("update_nodes");
-    for (auto& n : nodes_) {
-        n->Update(false);
-    }
-    for (auto& n : nodes_) {
-        timeout_ms = std::min(n->Update(true), timeout_ms);
+        sleep_timeout_ns = GetSleepTimeout(now);
     }
-    ATRACE_END();
 
-    nsecs_t sleep_timeout_ns = std::numeric_limits<nsecs_t>::max();
-    if (timeout_ms.count() < sleep_timeout_ns / 1000 / 1000) {
-        sleep_timeout_ns = timeout_ms.count() * 1000 * 1000;
-    }
     // VERBOSE level won't print by default in user/userdebug build
     LOG(VERBOSE) << "NodeLooperThread will wait for " << sleep_timeout_ns
                  << "ns";
-    ATRACE_BEGIN("wait");
     if (jobmgr_.getSize()) {
         LOG(VERBOSE) << "JobQueue not empty, size:" << jobmgr_.getSize()
                      << ". Alter sleep_timeout_ns to 0";
-        sleep_timeout_ns = 0;
+        return true;
     }
-    wake_cond_.waitRelative(lock_, sleep_timeout_ns);
+    ATRACE_BEGIN("wait");
+    WaitForWake(sleep_timeout_ns);
     ATRACE_END();
     return true;
 }
@@ -198,11 +401,8 @@ bool NodeLooperThread::Start() {
 void NodeLooperThread::Stop() {
     if (::android::Thread::isRunning()) {
         LOG(INFO) << "NodeLooperThread stopping";
-        {
-            ::android::AutoMutex _l(lock_);
-            wake_cond_.signal();
-            ::android::Thread::requestExit();
-        }
+        ::android::Thread::requestExit();
+        Wake();
         ::android::Thread::join();
         LOG(INFO) << "NodeLooperThread stopped";
     }
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "libperfmgr"
+
+#include "perfmgr/NodeWriterPool.h"
+
+#include <android-base/logging.h>
+#include <processgroup/processgroup.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <utils/ThreadDefs.h>
+
+namespace android {
+namespace perfmgr {
+
+NodeWriterPool::NodeWriterPool(std::size_t num_threads) {
+    threads_.reserve(num_threads);
+    for (std::size_t i = 0; i < num_threads; i++) {
+        threads_.emplace_back(&NodeWriterPool::WorkerLoop, this);
+    }
+}
+
+NodeWriterPool::~NodeWriterPool() {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        exit_ = true;
+    }
+    work_cond_.notify_all();
+    for (auto &thread : threads_) {
+        thread.join();
+    }
+}
+
+std::size_t NodeWriterPool::GetNumThreads() const {
+    return threads_.size();
+}
+
+void NodeWriterPool::Run(std::size_t num_tasks, const std::function<void(std::size_t)> &task) {
+    if (num_tasks == 0) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(lock_);
+    task_ = &task;
+    num_tasks_ = num_tasks;
+    next_task_ = 0;
+    pending_tasks_ = num_tasks;
+    batch_seq_++;
+    if (num_tasks > 1) {
+        work_cond_.notify_all();
+    }
+    // The caller takes tasks as well, so a single-task batch never switches
+    // thread.
+    RunTasks(&lock);
+    done_cond_.wait(lock, [this] { return pending_tasks_ == 0; });
+    task_ = nullptr;
+}
+
+void NodeWriterPool::RunTasks(std::unique_lock<std::mutex> *lock) {
+    while (next_task_ < num_tasks_) {
+        const std::size_t index = next_task_++;
+        const std::function<void(std::size_t)> *task = task_;
+        lock->unlock();
+        (*task)(index);
+        lock->lock();
+        if (--pending_tasks_ == 0) {
+            done_cond_.notify_all();
+        }
+    }
+}
+
+void NodeWriterPool::WorkerLoop() {
+    pthread_setname_np(pthread_self(), "NodeWriter");
+    // Same scheduling as NodeLooperThread, which is waiting on the batch.
+    if (setpriority(PRIO_PROCESS, 0, PRIORITY_HIGHEST) != 0) {
+        PLOG(WARNING) << "Failed to set NodeWriter priority";
+    }
+    if (!SetTaskProfiles(0, {"PreferIdleSet"})) {
+        LOG(WARNING) << "Device does not support 'PreferIdleSet' task profile.";
+    }
+
+    uint64_t seen_seq = 0;
+    std::unique_lock<std::mutex> lock(lock_);
+    while (true) {
+        work_cond_.wait(lock, [this, &seen_seq] { return exit_ || batch_seq_ != seen_seq; });
+        if (exit_) {
+            return;
+        }
+        seen_seq = batch_seq_;
+        RunTasks(&lock);
+    }
+}
+
+}  // namespace perfmgr
+}  // namespace android
@@ -74,6 +74,8 @@ std::chrono::milliseconds PropertyNode::Update(bool) {
             ATRACE_END();
         }
     }
+    // A failed SetProperty leaves the node dirty.
+    dirty_ = value_index != current_val_index_ || reset_on_init_;
     return expire_time;
 }
 
@@ -26,20 +26,25 @@
 namespace android {
 namespace perfmgr {
 
-bool RequestGroup::AddRequest(const std::string& hint_type, ReqTime end_time) {
-    if (request_map_.find(hint_type) == request_map_.end()) {
-        request_map_.emplace(hint_type, end_time);
-        return true;
-    } else {
-        if (request_map_[hint_type] < end_time) {
-            request_map_[hint_type] = end_time;
-        }
-        return false;
+bool RequestGroup::AddRequest(HintId hint_id, ReqTime end_time) {
+    auto [it, inserted] = request_map_.emplace(hint_id, end_time);
+    if (!inserted && it->second < end_time) {
+        it->second = end_time;
     }
+    return inserted;
+}
+
+bool RequestGroup::AddRequest(const std::string& hint_type, ReqTime end_time) {
+    return AddRequest(HintRegistry::GetInstance().Intern(hint_type), end_time);
+}
+
+bool RequestGroup::RemoveRequest(HintId hint_id) {
+    return request_map_.erase(hint_id);
 }
 
 bool RequestGroup::RemoveRequest(const std::string& hint_type) {
-    return request_map_.erase(hint_type);
+    HintId hint_id = HintRegistry::GetInstance().Find(hint_type);
+    return hint_id != kInvalidHintId && RemoveRequest(hint_id);
 }
 
 const std::string& RequestGroup::GetRequestValue() const {
@@ -76,8 +81,8 @@ void RequestGroup::DumpToFd(int fd, const std::string& prefix) const {
         auto remaining_duration =
             std::chrono::duration_cast<std::chrono::milliseconds>(it->second -
                                                                   now);
-        dump_buf << prefix << it->first << "\t" << remaining_duration.count()
-                 << "\t" << request_value_ << "\n";
+        dump_buf << prefix << HintRegistry::GetInstance().GetName(it->first) << "\t"
+                 << remaining_duration.count() << "\t" << request_value_ << "\n";
     }
     if (!android::base::WriteStringToFd(dump_buf.str(), fd)) {
         LOG(ERROR) << "Failed to dump fd: " << fd;
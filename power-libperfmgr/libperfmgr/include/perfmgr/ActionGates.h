@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_ACTIONGATES_H_
+#define ANDROID_LIBPERFMGR_ACTIONGATES_H_
+
+#include <android-base/properties.h>
+#include <android-base/thread_annotations.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "perfmgr/FlagProvider.h"
+
+namespace android {
+namespace perfmgr {
+
+// GateId is a dense handle of an action enable condition: an EnableProperty
+// and an EnableFlag/DisableFlag pair. Actions sharing a condition share a
+// gate.
+using GateId = uint32_t;
+// Action without any condition, always enabled.
+constexpr GateId kOpenGate = std::numeric_limits<GateId>::max();
+// Condition that did not fit in the gate table, evaluated on every check.
+constexpr GateId kUncachedGate = kOpenGate - 1;
+
+// ActionGates is the process-wide table of action enable conditions. The
+// state of every gate is kept as one bit, so checking an action on the
+// DoHint and NodeLooperThread hot paths is a relaxed load and a bit test
+// instead of a property area lookup. Properties are re-read by a watcher
+// thread when any system property changes, and flags are re-read when a
+// FlagProvider override changes.
+class ActionGates {
+  public:
+    static constexpr std::size_t kMaxGates = 1024;
+    static constexpr std::size_t kNoProperty = std::numeric_limits<std::size_t>::max();
+
+    static ActionGates &GetInstance();
+
+    // Return the gate of the condition, registering it on first use.
+    GateId Intern(const std::string &enable_property, FlagGetterPtr enable_flag,
+                  FlagGetterPtr disable_flag);
+    // Return the cached state of a gate from Intern(), never for kUncachedGate.
+    bool IsOpen(GateId id) const {
+        if (id == kOpenGate) {
+            return true;
+        }
+        return (bits_[id / 64].load(std::memory_order_relaxed) >> (id % 64)) & 1;
+    }
+    // Re-evaluate every gate now.
+    void Refresh();
+    void DumpToFd(int fd);
+
+    // Read the condition directly, as done before it was cached.
+    static bool Evaluate(const std::string &enable_property, FlagGetterPtr enable_flag,
+                         FlagGetterPtr disable_flag);
+
+  private:
+    ActionGates() = default;
+    ActionGates(ActionGates const &) = delete;
+    ActionGates &operator=(ActionGates const &) = delete;
+
+    struct Gate {
+        // Index into properties_, or kNoProperty
+        std::size_t property;
+        FlagGetterPtr enable_flag;
+        FlagGetterPtr disable_flag;
+    };
+
+    bool EvaluateLocked(const Gate &gate) REQUIRES(lock_);
+    void SetBit(GateId id, bool open);
+    void WatchProperties();
+
+    mutable std::mutex lock_;
+    std::vector<Gate> gates_ GUARDED_BY(lock_);
+    std::vector<std::string> property_names_ GUARDED_BY(lock_);
+    std::vector<std::unique_ptr<android::base::CachedBoolProperty>> properties_
+            GUARDED_BY(lock_);
+    std::array<std::atomic<uint64_t>, kMaxGates / 64> bits_{};
+    std::atomic<uint64_t> refreshes_{0};
+    // Watcher thread is started on the first gate with a property and never
+    // stopped.
+    bool watching_ GUARDED_BY(lock_) = false;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_ACTIONGATES_H_
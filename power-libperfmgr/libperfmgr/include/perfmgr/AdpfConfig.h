@@ -51,11 +51,17 @@ struct AdpfConfig {
     std::optional<bool> mGpuBoostOn;
     std::optional<uint64_t> mGpuBoostCapacityMax;
     uint64_t mGpuCapacityLoadUpHeadroom;
+    // The capacity node is written when the aggregate GPU vote drops, or
+    // rises by more than this
+    uint64_t mGpuCapacityWriteHysteresis;
 
     // Heuristic boost control
     std::optional<bool> mHeuristicBoostOn;
     std::optional<uint32_t> mHBoostModerateJankThreshold;
     std::optional<double> mHBoostOffMaxAvgDurRatio;
+    // When set, heuristic boost compares p90 rather than max duration to the
+    // average, against this ratio
+    std::optional<double> mHBoostOffP90AvgDurRatio;
     std::optional<double> mHBoostSevereJankPidPu;
     std::optional<uint32_t> mHBoostSevereJankThreshold;
     std::optional<std::pair<uint32_t, uint32_t>> mHBoostUclampMinCeilingRange;
@@ -69,6 +75,13 @@ struct AdpfConfig {
     std::optional<uint32_t> mDefaultRampupMult;
     std::optional<uint32_t> mHighRampupMult;
 
+    // Predictive boost control: frames over PredictiveBoostHeavyFactor times
+    // the target are heavy, and a heavy frame predicted from their period is
+    // boosted to at least PredictiveBoostUclampMin ahead of time
+    std::optional<bool> mPredictiveBoostOn;
+    std::optional<double> mPredictiveBoostHeavyFactor;
+    std::optional<uint32_t> mPredictiveBoostUclampMin;
+
     uint32_t mUclampMinLoadUp;
     uint32_t mUclampMinLoadReset;
 
@@ -76,9 +89,9 @@ struct AdpfConfig {
     std::optional<int32_t> mUclampMaxEfficientBase;
     std::optional<int32_t> mUclampMaxEfficientOffset;
 
-    int64_t getPidIInitDivI();
-    int64_t getPidIHighDivI();
-    int64_t getPidILowDivI();
+    int64_t getPidIInitDivI() const;
+    int64_t getPidIHighDivI() const;
+    int64_t getPidILowDivI() const;
     void dumpToFd(int fd);
 
     AdpfConfig(std::string name, bool pidOn, double pidPo, double pidPu, double pidI,
@@ -88,9 +101,11 @@ struct AdpfConfig {
                uint64_t samplingWindowD, int64_t reportingRateLimitNs, double targetTimeFactor,
                double staleTimeFactor, std::optional<bool> gpuBoostOn,
                std::optional<uint64_t> gpuBoostCapacityMax, uint64_t gpuCapacityLoadUpHeadroom,
+               uint64_t gpuCapacityWriteHysteresis,
                std::optional<bool> heuristicBoostOn,
                std::optional<uint32_t> hBoostModerateJankThreshold,
                std::optional<double> hBoostOffMaxAvgDurRatio,
+               std::optional<double> hBoostOffP90AvgDurRatio,
                std::optional<double> hBoostSevereJankPidPu,
                std::optional<uint32_t> hBoostSevereJankThreshold,
                std::optional<std::pair<uint32_t, uint32_t>> hBoostUclampMinCeilingRange,
@@ -98,7 +113,9 @@ struct AdpfConfig {
                std::optional<double> jankCheckTimeFactor,
                std::optional<uint32_t> lowFrameRateThreshold, std::optional<uint32_t> maxRecordsNum,
                std::optional<bool> heuristicRampup, std::optional<uint32_t> defaultRampupMult,
-               std::optional<uint32_t> highRampupMult, uint32_t uclampMinLoadUp,
+               std::optional<uint32_t> highRampupMult, std::optional<bool> predictiveBoostOn,
+               std::optional<double> predictiveBoostHeavyFactor,
+               std::optional<uint32_t> predictiveBoostUclampMin, uint32_t uclampMinLoadUp,
                uint32_t uclampMinLoadReset, std::optional<int32_t> uclampMaxEfficientBase,
                std::optional<int32_t> uclampMaxEfficientOffset)
         : mName(std::move(name)),
@@ -124,9 +141,11 @@ struct AdpfConfig {
           mGpuBoostOn(gpuBoostOn),
           mGpuBoostCapacityMax(gpuBoostCapacityMax),
           mGpuCapacityLoadUpHeadroom(gpuCapacityLoadUpHeadroom),
+          mGpuCapacityWriteHysteresis(gpuCapacityWriteHysteresis),
           mHeuristicBoostOn(heuristicBoostOn),
           mHBoostModerateJankThreshold(hBoostModerateJankThreshold),
           mHBoostOffMaxAvgDurRatio(hBoostOffMaxAvgDurRatio),
+          mHBoostOffP90AvgDurRatio(hBoostOffP90AvgDurRatio),
           mHBoostSevereJankPidPu(hBoostSevereJankPidPu),
           mHBoostSevereJankThreshold(hBoostSevereJankThreshold),
           mHBoostUclampMinCeilingRange(hBoostUclampMinCeilingRange),
@@ -137,6 +156,9 @@ struct AdpfConfig {
           mHeuristicRampup(heuristicRampup),
           mDefaultRampupMult(defaultRampupMult),
           mHighRampupMult(highRampupMult),
+          mPredictiveBoostOn(predictiveBoostOn),
+          mPredictiveBoostHeavyFactor(predictiveBoostHeavyFactor),
+          mPredictiveBoostUclampMin(predictiveBoostUclampMin),
           mUclampMinLoadUp(uclampMinLoadUp),
           mUclampMinLoadReset(uclampMinLoadReset),
           mUclampMaxEfficientBase(uclampMaxEfficientBase),
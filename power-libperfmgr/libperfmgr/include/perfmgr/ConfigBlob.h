@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_CONFIGBLOB_H_
+#define ANDROID_LIBPERFMGR_CONFIGBLOB_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace android {
+namespace perfmgr {
+
+// A config blob is the precompiled binary form of powerhint.json, placed
+// next to it as "<config>.bin". It holds the parsed Nodes, Actions,
+// AdpfConfig and OtherConfigs sections so HintManager can skip JSON parsing
+// at boot. The blob records a hash of the JSON text it was compiled from and
+// is ignored when the JSON changed or the format version differs.
+//
+// Layout: ConfigBlobHeader followed by payload_size bytes of records encoded
+// by ConfigBlobWriter in host byte order.
+constexpr char kConfigBlobSuffix[] = ".bin";
+constexpr char kConfigBlobMagic[8] = {'P', 'W', 'R', 'H', 'I', 'N', 'T', '\0'};
+// Bump whenever the record layout changes.
+constexpr uint32_t kConfigBlobVersion = 4;
+
+struct ConfigBlobHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t source_hash;
+    uint64_t payload_size;
+};
+
+// FNV-1a hash of the JSON text a blob is compiled from.
+uint64_t HashConfigSource(std::string_view json_doc);
+
+// ConfigBlobWriter appends fixed size scalars, length prefixed strings and
+// presence prefixed optionals to a byte buffer.
+class ConfigBlobWriter {
+  public:
+    template <typename T>
+    void Write(T value) {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "scalar only");
+        buf_.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+    void Write(const std::string &value) {
+        Write(static_cast<uint32_t>(value.size()));
+        buf_.append(value);
+    }
+    template <typename T>
+    void Write(const std::optional<T> &value) {
+        Write(value.has_value());
+        if (value.has_value()) {
+            Write(*value);
+        }
+    }
+    template <typename T, typename U>
+    void Write(const std::pair<T, U> &value) {
+        Write(value.first);
+        Write(value.second);
+    }
+
+    const std::string &GetBuffer() const { return buf_; }
+
+  private:
+    std::string buf_;
+};
+
+// ConfigBlobReader decodes records written by ConfigBlobWriter directly from
+// the mapped blob. Reading past the end sets a sticky error and yields
+// value-initialized data, so callers check Ok() once per record.
+class ConfigBlobReader {
+  public:
+    ConfigBlobReader(const char *data, std::size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    void Read(T *value) {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "scalar only");
+        *value = T();
+        if (!Consume(sizeof(T))) {
+            return;
+        }
+        if constexpr (std::is_same_v<T, bool>) {
+            // Any byte other than 0/1 is not a valid bool representation.
+            uint8_t byte;
+            std::memcpy(&byte, data_ + pos_ - sizeof(T), sizeof(byte));
+            ok_ = byte <= 1;
+            *value = byte == 1;
+        } else {
+            std::memcpy(value, data_ + pos_ - sizeof(T), sizeof(T));
+        }
+    }
+    // The view points into the blob and is only valid while it stays mapped.
+    void Read(std::string_view *value) {
+        uint32_t size = 0;
+        Read(&size);
+        if (!Consume(size)) {
+            *value = {};
+            return;
+        }
+        *value = std::string_view(data_ + pos_ - size, size);
+    }
+    void Read(std::string *value) {
+        std::string_view view;
+        Read(&view);
+        value->assign(view);
+    }
+    template <typename T>
+    void Read(std::optional<T> *value) {
+        bool has_value = false;
+        Read(&has_value);
+        value->reset();
+        if (has_value) {
+            T v;
+            Read(&v);
+            *value = std::move(v);
+        }
+    }
+    template <typename T, typename U>
+    void Read(std::pair<T, U> *value) {
+        Read(&value->first);
+        Read(&value->second);
+    }
+
+    bool Ok() const { return ok_; }
+    bool AtEnd() const { return pos_ == size_; }
+
+  private:
+    bool Consume(std::size_t size) {
+        if (!ok_ || size > size_ - pos_) {
+            ok_ = false;
+            return false;
+        }
+        pos_ += size;
+        return true;
+    }
+
+    const char *data_;
+    const std::size_t size_;
+    std::size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_CONFIGBLOB_H_
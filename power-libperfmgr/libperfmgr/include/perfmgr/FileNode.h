@@ -23,6 +23,7 @@
 #include <string>
 #include <vector>
 
+#include "perfmgr/LatencyHistogram.h"
 #include "perfmgr/Node.h"
 
 namespace android {
@@ -34,12 +35,14 @@ class FileNode : public Node {
     FileNode(std::string name, std::vector<std::string> node_paths,
              std::vector<RequestGroup> req_sorted, std::size_t default_val_index,
              bool reset_on_init, bool truncate, bool allow_failure, bool hold_fd = false, bool write_only = false);
+    ~FileNode() override;
 
     std::chrono::milliseconds Update(bool log_error) override;
 
     bool GetAllowFailure() const;
     bool GetHoldFd() const;
     bool GetTruncate() const;
+    bool GetWriteOnly() const;
 
     void DumpToFd(int fd) const override;
 
@@ -47,13 +50,34 @@ class FileNode : public Node {
     FileNode(const Node& other) = delete;
     FileNode& operator=(Node const&) = delete;
 
+    // Open fd of one node path. It is kept across Update() so a value change
+    // costs a single pwrite() instead of open/write/fsync/close.
+    struct PathFd {
+        android::base::unique_fd fd;
+        // sysfs/procfs/cgroupfs file where fsync and truncate are meaningless
+        bool pseudo_fs = false;
+        // fd does not support pwrite(), e.g. a fifo
+        bool stream = false;
+        // fd counts against the process wide cache budget
+        bool cached = false;
+    };
+
+    // Return true when value is fully written to node_paths_[path_index],
+    // otherwise return false with errno set.
+    bool WritePath(std::size_t path_index, const std::string& value);
+    bool OpenPath(std::size_t path_index);
+    void ClosePath(std::size_t path_index);
+
     const bool hold_fd_;
     const bool truncate_;
     // node will be read in DumpToFd
     const bool write_only_;
     const std::chrono::milliseconds warn_timeout_;
-    android::base::unique_fd fd_;
+    // one entry per node_paths_
+    std::vector<PathFd> path_fds_;
     bool allow_failure_;
+    // time spent writing a value to a path, including reopen and fsync
+    LatencyHistogram write_latency_;
 };
 
 }  // namespace perfmgr
@@ -73,6 +73,8 @@ class FlagProvider : public RawFlagProvider {
     void ClearOverrides();
     void DumpToFd(int fd);
     FlagGetterPtr GetterFromString(const std::string &flagName);
+    // Reverse of GetterFromString, return empty string for unknown getter.
+    std::string StringFromGetter(FlagGetterPtr getter) const;
 
     ADD_FLAG(test_flag)
     ADD_FLAG(gpu_load_up_for_blurs)
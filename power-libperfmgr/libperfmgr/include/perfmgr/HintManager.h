@@ -18,6 +18,7 @@
 #define ANDROID_LIBPERFMGR_HINTMANAGER_H_
 
 #include <android-base/thread_annotations.h>
+#include <android-base/unique_fd.h>
 
 #include <atomic>
 #include <cstddef>
@@ -26,12 +27,16 @@
 #include <mutex>
 #include <set>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "perfmgr/ActionGates.h"
 #include "perfmgr/AdpfConfig.h"
+#include "perfmgr/HintRegistry.h"
 #include "perfmgr/NodeLooperThread.h"
+#include "perfmgr/RcuPtr.h"
 
 namespace android {
 namespace perfmgr {
@@ -70,12 +75,22 @@ struct HintAction {
         if (!dh.empty()) {
             disable_flag = FlagProvider::GetInstance().GetterFromString(dh);
         }
+        gate = ActionGates::GetInstance().Intern(enable_property, enable_flag, disable_flag);
+    }
+    // Whether the action applies now, from its cached gate.
+    bool IsEnabled() const {
+        return gate == kUncachedGate
+                       ? ActionGates::Evaluate(enable_property, enable_flag, disable_flag)
+                       : ActionGates::GetInstance().IsOpen(gate);
     }
     HintActionType type;
     std::string value;
+    // value resolved to HintId when HintManager is constructed.
+    HintId value_id = kInvalidHintId;
     std::string enable_property;
     bool (*enable_flag)() = nullptr;
     bool (*disable_flag)() = nullptr;
+    GateId gate = kOpenGate;  // enable_property and flags resolved once.
 };
 
 struct Hint {
@@ -88,7 +103,7 @@ struct Hint {
     std::vector<NodeAction> node_actions;
     std::vector<HintAction> hint_actions;
     mutable std::mutex hint_lock;
-    std::set<std::string> mask_requesters GUARDED_BY(hint_lock);
+    std::set<HintId> mask_requesters GUARDED_BY(hint_lock);
     std::shared_ptr<HintStatus> status GUARDED_BY(hint_lock);
 };
 
@@ -97,6 +112,25 @@ struct OtherConfigs {
     std::optional<bool> enableMetricCollection;
     std::optional<uint32_t> maxNumOfCachedSessionMetrics;
     bool enableSFPreferHighCap = false;
+    // Threads writing independent nodes in parallel, see NodeLooperThread.
+    std::optional<uint32_t> nodeWriterThreads;
+};
+
+// Snapshot of the ADPF profiles and the profile selected for each tag. A
+// published table is never modified; switching or reloading profiles
+// publishes a new one, so readers get a consistent view without locking.
+struct AdpfProfileTable {
+    std::vector<std::shared_ptr<AdpfConfig>> adpfs;
+    std::unordered_map<std::string, std::shared_ptr<AdpfConfig>> tag_profiles;
+    // TODO(jimmyshiu@): Need to be removed once all powerhint.json up-to-date.
+    std::size_t default_index = 0;
+    // Bumped on every ReloadAdpfProfiles()
+    uint32_t generation = 0;
+
+    // Return the profile named name, or nullptr.
+    std::shared_ptr<AdpfConfig> FindProfile(const std::string &name) const;
+    // Return the profile selected for tag, or the default one for unknown tag.
+    std::shared_ptr<AdpfConfig> GetProfile(const std::string &tag) const;
 };
 
 // HintManager is the external interface of the library to be used by PowerHAL
@@ -108,38 +142,39 @@ class HintManager {
     HintManager(sp<NodeLooperThread> nm, const std::unordered_map<std::string, Hint> &actions,
                 const std::vector<std::shared_ptr<AdpfConfig>> &adpfs,
                 const std::unordered_map<std::string, std::shared_ptr<AdpfConfig>> &tag_adpfs,
-                const OtherConfigs &other_configs)
-        : nm_(std::move(nm)),
-          actions_(actions),
-          adpfs_(adpfs),
-          tag_profile_map_(tag_adpfs),
-          adpf_index_(0),
-          other_configs_(other_configs) {}
-    ~HintManager() {
-        if (nm_.get() != nullptr) nm_->Stop();
-    }
+                const OtherConfigs &other_configs);
+    ~HintManager();
 
     // Return true if the sysfs manager thread is running.
     bool IsRunning() const;
 
+    // Resolve hint_type to the HintId used by the id based API below. Return
+    // kInvalidHintId if hint_type is not defined in the actions section.
+    HintId GetHintId(const std::string &hint_type) const;
+
     // Do hint based on hint_type which defined as PowerHint in the actions
     // section of the JSON config. Return true with valid hint_type and also
     // NodeLooperThread::Request succeeds; otherwise return false.
+    bool DoHint(HintId hint_id);
     bool DoHint(const std::string &hint_type);
 
     // Do hint with the override time for all actions defined for the given
     // hint_type.  Return true with valid hint_type and also
     // NodeLooperThread::Request succeeds; otherwise return false.
+    bool DoHint(HintId hint_id, std::chrono::milliseconds timeout_ms_override);
     bool DoHint(const std::string &hint_type, std::chrono::milliseconds timeout_ms_override);
 
     // End hint early. Return true with valid hint_type and also
     // NodeLooperThread::Cancel succeeds; otherwise return false.
+    bool EndHint(HintId hint_id);
     bool EndHint(const std::string &hint_type);
 
     // Query if given hint supported.
+    bool IsHintSupported(HintId hint_id) const;
     bool IsHintSupported(const std::string &hint_type) const;
 
     // Query if given hint enabled.
+    bool IsHintEnabled(HintId hint_id) const;
     bool IsHintEnabled(const std::string &hint_type) const;
 
     // TODO(jimmyshiu@): Need to be removed once all powerhint.json up-to-date.
@@ -166,9 +201,24 @@ class HintManager {
     // Query if given AdpfProfile supported.
     bool IsAdpfProfileSupported(const std::string &name) const;
 
+    // Re-read the AdpfConfig section of the config file and publish it
+    // without touching nodes or in-flight hints. Each tag keeps its selected
+    // profile by name and registered callbacks get the reloaded profile.
+    // Return false and keep the current profiles if the section is invalid.
+    bool ReloadAdpfProfiles();
+
+    // Call ReloadAdpfProfiles() whenever the config file is rewritten.
+    bool WatchAdpfProfiles();
+
     // Static method to construct the global HintManager from the JSON config file.
+    // A config blob at config_path + kConfigBlobSuffix compiled from the same
+    // JSON is loaded instead of parsing the JSON.
     static HintManager *GetFromJSON(const std::string &config_path, bool start = true);
 
+    // Parse the JSON config and write its binary form to blob_path. Return
+    // false if the config is invalid or the blob cannot be written.
+    static bool CompileConfig(const std::string &config_path, const std::string &blob_path);
+
     // Return available hints managed by HintManager
     std::vector<std::string> GetHints() const;
 
@@ -190,30 +240,52 @@ class HintManager {
             const std::string &json_doc, const std::vector<std::unique_ptr<Node>> &nodes);
     static std::vector<std::shared_ptr<AdpfConfig>> ParseAdpfConfigs(const std::string &json_doc);
     static OtherConfigs ParseOtherConfigs(const std::string &json_doc);
+    // Load sections from the config blob compiled from json_doc. Return false
+    // and leave outputs untouched if the blob is missing, stale or malformed.
+    static bool LoadConfigBlob(const std::string &blob_path, const std::string &json_doc,
+                               std::vector<std::unique_ptr<Node>> *nodes,
+                               std::unordered_map<std::string, Hint> *actions,
+                               std::vector<std::shared_ptr<AdpfConfig>> *adpfs,
+                               OtherConfigs *other_configs);
+    // Update callback of EventNode
+    static void OnEventNodeUpdate(const std::string &name, const std::vector<std::string> &paths,
+                                  const std::string &value);
     static bool InitHintStatus(const std::unique_ptr<HintManager> &hm);
 
     static void Reload(bool start);
     HintManager(HintManager const&) = delete;
     HintManager &operator=(HintManager const &) = delete;
 
-    bool ValidateHint(const std::string& hint_type) const;
+    bool ValidateHint(HintId hint_id) const;
     // Helper function to update the HintStatus when DoHint
-    void DoHintStatus(const std::string &hint_type, std::chrono::milliseconds timeout_ms);
+    void DoHintStatus(HintId hint_id, std::chrono::milliseconds timeout_ms);
     // Helper function to update the HintStatus when EndHint
-    void EndHintStatus(const std::string &hint_type);
+    void EndHintStatus(HintId hint_id);
     // Helper function to take hint actions when DoHint
-    void DoHintAction(const std::string &hint_type);
+    void DoHintAction(HintId hint_id);
     // Helper function to take hint actions when EndHint
-    void EndHintAction(const std::string &hint_type);
+    void EndHintAction(HintId hint_id);
     // Dump the "OtherConfigs" parts in the parsed configuration file.
     void DumpOtherConfigs(int fd);
+    // Invoke the update callbacks registered for tag.
+    void NotifyAdpfUpdate(const std::string &tag, const std::shared_ptr<AdpfConfig> &profile)
+            REQUIRES(adpf_lock_);
 
     sp<NodeLooperThread> nm_;
-    std::unordered_map<std::string, Hint> actions_;
-    std::vector<std::shared_ptr<AdpfConfig>> adpfs_;
-    // TODO(jimmyshiu@): Need to be removed once all powerhint.json up-to-date.
-    std::unordered_map<std::string, std::shared_ptr<AdpfConfig>> tag_profile_map_;
-    uint32_t adpf_index_;
+    // Hints indexed by HintId; ids not defined in this config are left empty
+    // with an empty name in hint_names_.
+    std::vector<Hint> hints_;
+    std::vector<std::string> hint_names_;
+    std::unordered_map<std::string, HintId> hint_ids_;
+    // Current ADPF profiles, read without locking on the session report path.
+    RcuPtr<const AdpfProfileTable> adpf_table_;
+    // Serializes adpf_table_ updates and guards the update callbacks.
+    std::mutex adpf_lock_;
+    // Config file this HintManager was created from.
+    std::string config_path_;
+    // inotify watcher of config_path_ and the eventfd to stop it.
+    std::thread config_watcher_;
+    android::base::unique_fd config_watcher_stop_fd_;
 
     static std::unique_ptr<HintManager> sInstance;
 
@@ -221,7 +293,8 @@ class HintManager {
     void OnNodeUpdate(const std::string &name, const std::vector<std::string> &paths,
                       const std::string &value);
     // set ADPF config by hint name.
-    std::unordered_map<std::string, std::vector<AdpfCallback *>> tag_update_callback_list_;
+    std::unordered_map<std::string, std::vector<AdpfCallback *>> tag_update_callback_list_
+            GUARDED_BY(adpf_lock_);
     // Other configurations
     OtherConfigs other_configs_;
 };
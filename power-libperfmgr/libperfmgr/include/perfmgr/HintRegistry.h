@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_HINTREGISTRY_H_
+#define ANDROID_LIBPERFMGR_HINTREGISTRY_H_
+
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace android {
+namespace perfmgr {
+
+// HintId is a dense integer handle of a hint name. Hint names are interned
+// once (at config load or first use) so the DoHint/EndHint hot path can index
+// flat arrays instead of hashing strings.
+using HintId = uint32_t;
+constexpr HintId kInvalidHintId = std::numeric_limits<HintId>::max();
+
+// HintRegistry is the process-wide intern table between hint names and
+// HintIds. Ids are assigned in registration order starting from 0 and are
+// never recycled, so an id stays valid across HintManager reloads.
+class HintRegistry {
+  public:
+    static HintRegistry &GetInstance();
+
+    // Return the id of hint_type, assigning a new one if it is not known yet.
+    HintId Intern(const std::string &hint_type);
+    // Return the id of hint_type, or kInvalidHintId if it was never interned.
+    HintId Find(const std::string &hint_type) const;
+    // Return the name of the given id, or an empty string for unknown id.
+    std::string GetName(HintId id) const;
+    // Return the number of interned hints.
+    std::size_t Size() const;
+
+  private:
+    HintRegistry() = default;
+    HintRegistry(HintRegistry const &) = delete;
+    HintRegistry &operator=(HintRegistry const &) = delete;
+
+    mutable std::mutex lock_;
+    std::unordered_map<std::string, HintId> ids_;
+    std::vector<std::string> names_;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_HINTREGISTRY_H_
@@ -17,15 +17,17 @@
 #ifndef ANDROID_LIBPERFMGR_JOBQUEUEMANAGER_H_
 #define ANDROID_LIBPERFMGR_JOBQUEUEMANAGER_H_
 
-#include <utils/Mutex.h>
-
+#include <atomic>
 #include <chrono>
 #include <cstddef>
-#include <deque>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <queue>
 #include <vector>
 
+#include "perfmgr/HintRegistry.h"
+
 namespace android {
 namespace perfmgr {
 
@@ -41,9 +43,11 @@ struct NodeAction;  // Forward declaration
 
 struct Job {
     std::vector<NodeAction> actions;  // Replace with your action type
-    std::string hint_type;            // Replace with your hint type
+    HintId hint_id = kInvalidHintId;  // Interned hint type
     std::chrono::time_point<std::chrono::steady_clock> schedule_time;
     bool is_cancel;  // True if this is a cancel request
+    // Link of the lock-free submission list, owned by JobQueueManager.
+    Job *next = nullptr;
     void reset();
 };
 
@@ -54,12 +58,44 @@ struct JobComparator {
     }
 };
 
+// Bounded multi-producer/multi-consumer ring of Job pointers (Vyukov's
+// sequence-per-cell queue). Used as the free job pool so getFreeJob() and
+// returnJob() never take a lock.
+class JobRing {
+  public:
+    explicit JobRing(size_t capacity);
+
+    // Return false if the ring is full.
+    bool push(Job *job);
+    // Return nullptr if the ring is empty.
+    Job *pop();
+
+  private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        Job *job;
+    };
+    std::unique_ptr<Cell[]> mCells;
+    const size_t mMask;
+    alignas(64) std::atomic<size_t> mEnqueuePos{0};
+    alignas(64) std::atomic<size_t> mDequeuePos{0};
+};
+
+// JobQueueManager is a multi-producer/single-consumer job queue. Producers
+// (binder threads calling NodeLooperThread::Request/Cancel) take preallocated
+// jobs from a lock-free pool and push them onto an intrusive lock-free list.
+// The single consumer (NodeLooperThread) drains that list into a local
+// priority queue, so jobs are still processed in schedule_time order. The
+// consumer side (dequeueRequest/DumpToFd) is not thread safe and must be
+// serialized by the caller.
 class JobQueueManager {
   public:
     JobQueueManager(size_t poolSize = DEFAULT_POOL_SIZE);  // Constructor with pool size
+    ~JobQueueManager();
 
-    // Add a job to the queue
-    void enqueueRequest(Job *job);
+    // Add a job to the queue, lock-free and safe from any thread. Return true
+    // if the queue was empty before this job.
+    bool enqueueRequest(Job *job);
 
     // Get the next job from the queue
     Job *dequeueRequest();
@@ -71,10 +107,18 @@ class JobQueueManager {
     void DumpToFd(int fd);
 
   private:
+    JobQueueManager(JobQueueManager const &) = delete;
+    JobQueueManager &operator=(JobQueueManager const &) = delete;
+
+    // Move all submitted jobs into mJobQueue.
+    void drainPending();
+
+    // Head of the lock-free list of submitted jobs, newest first.
+    std::atomic<Job *> mPending{nullptr};
+    std::atomic<size_t> mSize{0};
     // Job will be auto sorted by JobComparator in priority_queue
     std::priority_queue<Job *, std::vector<Job *>, JobComparator> mJobQueue;
-    ::android::Mutex mQueueMutex;  // Mutex to protect the queue
-    std::deque<Job *> mJobPool;    // Use deque for efficient push/pop from both ends
+    JobRing mJobPool;
     size_t mPoolSize;
 };
 
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_LATENCYHISTOGRAM_H_
+#define ANDROID_LIBPERFMGR_LATENCYHISTOGRAM_H_
+
+#include <android-base/stringprintf.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace android {
+namespace perfmgr {
+
+// LatencyHistogram counts durations into power-of-two microsecond buckets:
+// bucket 0 is [0, 2us), bucket i is [2^i us, 2^(i+1) us) and the last bucket
+// is open ended. Add() is wait-free and may race with Dump(), so a dump taken
+// during updates can be off by the in-flight samples.
+class LatencyHistogram {
+  public:
+    static constexpr std::size_t kNumBuckets = 12;
+
+    void Add(std::chrono::nanoseconds latency) {
+        const uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+        std::size_t bucket = 0;
+        while (bucket + 1 < kNumBuckets && (us >> (bucket + 1)) != 0) {
+            bucket++;
+        }
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        uint64_t max = max_us_.load(std::memory_order_relaxed);
+        while (us > max && !max_us_.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t GetCount() const { return count_.load(std::memory_order_relaxed); }
+
+    uint64_t GetBucket(std::size_t bucket) const {
+        return bucket < kNumBuckets ? buckets_[bucket].load(std::memory_order_relaxed) : 0;
+    }
+
+    // Return a single line like "count:3\tmax:40us\t<2us:0\t<4us:1\t...\t>=2048us:0"
+    std::string Dump() const {
+        std::string buf = android::base::StringPrintf(
+                "count:%" PRIu64 "\tmax:%" PRIu64 "us", GetCount(),
+                max_us_.load(std::memory_order_relaxed));
+        for (std::size_t i = 0; i < kNumBuckets; i++) {
+            if (i + 1 < kNumBuckets) {
+                buf += android::base::StringPrintf("\t<%dus:%" PRIu64, 2 << i, GetBucket(i));
+            } else {
+                buf += android::base::StringPrintf("\t>=%dus:%" PRIu64, 1 << i, GetBucket(i));
+            }
+        }
+        return buf;
+    }
+
+  private:
+    std::array<std::atomic<uint64_t>, kNumBuckets> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> max_us_{0};
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_LATENCYHISTOGRAM_H_
@@ -49,12 +49,19 @@ class Node {
     virtual ~Node() {}
 
     // Return true if successfully add a request
+    bool AddRequest(std::size_t value_index, HintId hint_id, ReqTime end_time);
     bool AddRequest(std::size_t value_index, const std::string& hint_type,
                     ReqTime end_time);
 
     // Return true if successfully remove a request
+    bool RemoveRequest(HintId hint_id);
     bool RemoveRequest(const std::string& hint_type);
 
+    // Return true if requests changed since the last Update() or the last
+    // Update() failed to apply the selected value. A node that is neither
+    // dirty nor past its expire time does not need Update().
+    bool IsDirty() const;
+
     // Return the nearest expire time of active requests; return
     // std::chrono::milliseconds::max() if no active request on Node; update
     // node's controlled file node value and the current value index based on
@@ -66,6 +73,10 @@ class Node {
     std::vector<std::string> GetValues() const;
     std::size_t GetDefaultIndex() const;
     bool GetResetOnInit() const;
+    // Nodes sharing a dependency class are written in order on one thread,
+    // e.g. cpufreq min/max of a policy. Empty means independent of others.
+    const std::string& GetDependencyClass() const;
+    void SetDependencyClass(std::string dependency_class);
     bool GetValueIndex(const std::string& value, std::size_t* index) const;
     virtual void DumpToFd(int fd) const = 0;
 
@@ -83,6 +94,9 @@ class Node {
     // node will be explicitly initialized when first time called Update().
     bool reset_on_init_;
     std::size_t current_val_index_;
+    // set by AddRequest/RemoveRequest, cleared by a successful Update().
+    bool dirty_;
+    std::string dependency_class_;
 };
 
 }  // namespace perfmgr
@@ -17,17 +17,22 @@
 #ifndef ANDROID_LIBPERFMGR_NODELOOPERTHREAD_H_
 #define ANDROID_LIBPERFMGR_NODELOOPERTHREAD_H_
 
+#include <android-base/unique_fd.h>
 #include <utils/Thread.h>
 
+#include <chrono>
 #include <cstddef>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "perfmgr/ActionGates.h"
 #include "perfmgr/FlagProvider.h"
+#include "perfmgr/HintRegistry.h"
 #include "perfmgr/JobQueueManager.h"
 #include "perfmgr/Node.h"
+#include "perfmgr/NodeWriterPool.h"
 
 namespace android {
 namespace perfmgr {
@@ -48,6 +53,13 @@ struct NodeAction {
         if (!disable_flag_str.empty()) {
             disable_flag = FlagProvider::GetInstance().GetterFromString(disable_flag_str);
         }
+        gate = ActionGates::GetInstance().Intern(enable_property, enable_flag, disable_flag);
+    }
+    // Whether the action applies now, from its cached gate.
+    bool IsEnabled() const {
+        return gate == kUncachedGate
+                       ? ActionGates::Evaluate(enable_property, enable_flag, disable_flag)
+                       : ActionGates::GetInstance().IsOpen(gate);
     }
     std::size_t node_index;
     std::size_t value_index;
@@ -55,6 +67,7 @@ struct NodeAction {
     std::string enable_property;           // boolean property to control action on/off.
     bool (*enable_flag)() = nullptr;
     bool (*disable_flag)() = nullptr;
+    GateId gate = kOpenGate;  // enable_property and flags resolved once.
 };
 
 // The NodeLooperThread is responsible for managing each of the sysfs nodes
@@ -67,23 +80,28 @@ struct NodeAction {
 // powerhint requests and when the timeout expires for an in-progress powerhint.
 class NodeLooperThread : public ::android::Thread {
   public:
-    explicit NodeLooperThread(std::vector<std::unique_ptr<Node>> nodes)
-        : Thread(false), nodes_(std::move(nodes)) {}
+    // With num_writer_threads > 0, nodes of different dependency classes are
+    // written in parallel; nodes without a class are independent of all
+    // others. Otherwise all nodes are written in order on the looper thread.
+    explicit NodeLooperThread(std::vector<std::unique_ptr<Node>> nodes,
+                              std::size_t num_writer_threads = 0);
     virtual ~NodeLooperThread() { Stop(); }
 
     // Need call Stop() as the threadloop will hold a strong pointer
-    // itself and wait for Condition fired or timeout (60s) before
+    // itself and wait for wake event or timeout before
     // the out looper can call deconstructor to Stop() thread
     void Stop();
 
     // Return true when successfully adds request from actions for the hint_type
     // in each individual node. Return false if any of the actions has either
     // invalid node index or value index.
+    bool Request(const std::vector<NodeAction>& actions, HintId hint_id);
     bool Request(const std::vector<NodeAction>& actions,
                  const std::string& hint_type);
     // Return when successfully cancels request from actions for the hint_type
     // in each individual node. Return false if any of the actions has invalid
     // node index.
+    bool Cancel(const std::vector<NodeAction>& actions, HintId hint_id);
     bool Cancel(const std::vector<NodeAction>& actions,
                 const std::string& hint_type);
 
@@ -100,17 +118,61 @@ class NodeLooperThread : public ::android::Thread {
     status_t readyToRun() override;
     bool threadLoop() override;
 
-    static constexpr auto kMaxUpdatePeriod = std::chrono::milliseconds::max();
+    // Wake up threadloop from Request/Cancel/Stop.
+    void Wake();
+    // Block until woken up or sleep_timeout_ns elapsed.
+    void WaitForWake(nsecs_t sleep_timeout_ns);
+
+    // Add node to update_list_ unless it is already there.
+    void QueueNodeUpdate(std::size_t node_index);
+    // Queue nodes whose expire time has passed by now.
+    void QueueExpiredNodes(ReqTime now);
+    // Record the next time node needs Update(), timeout relative to now.
+    void SetNodeExpiry(std::size_t node_index, std::chrono::milliseconds timeout, ReqTime now);
+    // Return how long threadloop may sleep before the nearest node expiry.
+    nsecs_t GetSleepTimeout(ReqTime now) const;
+    // Update nodes in 2 passes and store their timeouts in update_timeouts_.
+    void UpdateNodes(const std::vector<std::size_t> &node_indices);
+
+    // Entry of expiry_heap_: the time a node needs Update() again.
+    struct NodeExpiry {
+        ReqTime expire_time;
+        std::size_t node_index;
+        bool operator>(const NodeExpiry &other) const { return expire_time > other.expire_time; }
+    };
+
+    // Rebuild expiry_heap_ once it holds this many stale entries per node.
+    static constexpr std::size_t kExpiryHeapCompactFactor = 4;
 
     std::vector<std::unique_ptr<Node>> nodes_;  // parsed from Config
 
-    // conditional variable from C++ standard library can be affected by wall
-    // time change as it is using CLOCK_REAL (b/35756266). The component should
-    // not be impacted by wall time, thus need use Android specific Condition
-    // class for waking up threadloop.
-    ::android::Condition wake_cond_;
-
-    // lock to protect nodes_
+    // Nodes to be updated on this loop, either dirtied by a job or expired.
+    // update_queued_[i] is true iff node i is in update_list_.
+    std::vector<std::size_t> update_list_;
+    std::vector<bool> update_queued_;
+    // Min-heap of node expire times. A node may have stale entries left from
+    // earlier updates; only the one matching node_expiries_ is live.
+    std::vector<NodeExpiry> expiry_heap_;
+    std::vector<ReqTime> node_expiries_;
+    // Result of the last Update() of each node
+    std::vector<std::chrono::milliseconds> update_timeouts_;
+
+    // Parallel writers, null when nodes are written on threadloop only.
+    std::unique_ptr<NodeWriterPool> writer_pool_;
+    // Dependency group of each node, and the queued nodes of each group that
+    // has any on this loop.
+    std::vector<std::size_t> node_groups_;
+    std::vector<std::vector<std::size_t>> group_updates_;
+    std::vector<std::size_t> active_groups_;
+
+    // eventfd for waking up threadloop. Unlike a Condition it does not need
+    // lock_, so Request/Cancel never block behind node updates, and a wake
+    // posted before threadloop goes to sleep is not lost. ppoll() measures
+    // its timeout on CLOCK_MONOTONIC so wall time change does not affect it
+    // (b/35756266).
+    android::base::unique_fd wake_fd_;
+
+    // lock to protect nodes_ and the consumer side of jobmgr_
     ::android::Mutex lock_;
 
     // Job queue for threadloop to process
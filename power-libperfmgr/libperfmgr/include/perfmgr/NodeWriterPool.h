@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_NODEWRITERPOOL_H_
+#define ANDROID_LIBPERFMGR_NODEWRITERPOOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace perfmgr {
+
+// NodeWriterPool runs a batch of independent node updates on a small set of
+// worker threads together with the calling thread, so one slow node does not
+// delay writes to unrelated nodes. Run() returns once the whole batch is done
+// and must not be called concurrently.
+class NodeWriterPool {
+  public:
+    explicit NodeWriterPool(std::size_t num_threads);
+    ~NodeWriterPool();
+
+    // Call task(0) ... task(num_tasks - 1), each exactly once, in parallel.
+    void Run(std::size_t num_tasks, const std::function<void(std::size_t)> &task);
+
+    std::size_t GetNumThreads() const;
+
+  private:
+    NodeWriterPool(NodeWriterPool const &) = delete;
+    NodeWriterPool &operator=(NodeWriterPool const &) = delete;
+
+    void WorkerLoop();
+    // Claim and run tasks of the current batch until none is left.
+    void RunTasks(std::unique_lock<std::mutex> *lock);
+
+    std::vector<std::thread> threads_;
+    std::mutex lock_;
+    std::condition_variable work_cond_;
+    std::condition_variable done_cond_;
+    // Current batch, protected by lock_
+    const std::function<void(std::size_t)> *task_ = nullptr;
+    std::size_t num_tasks_ = 0;
+    std::size_t next_task_ = 0;
+    std::size_t pending_tasks_ = 0;
+    uint64_t batch_seq_ = 0;
+    bool exit_ = false;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_NODEWRITERPOOL_H_
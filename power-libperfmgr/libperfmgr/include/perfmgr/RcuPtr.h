@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_LIBPERFMGR_RCUPTR_H_
+#define ANDROID_LIBPERFMGR_RCUPTR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace android {
+namespace perfmgr {
+
+// RcuPtr publishes a shared_ptr that is read far more often than it is
+// replaced. Load() is wait-free: it never takes a lock and never waits for a
+// writer. Store() swaps in a new value and retires the old holder; retired
+// holders are freed by a later Store() once no Load() is in flight.
+//
+// Store() is not thread safe against other Store() calls, callers serialize
+// writers themselves.
+template <typename T>
+class RcuPtr {
+  public:
+    explicit RcuPtr(std::shared_ptr<T> value = nullptr)
+        : current_(new std::shared_ptr<T>(std::move(value))) {}
+    ~RcuPtr() { delete current_.load(std::memory_order_relaxed); }
+
+    RcuPtr(const RcuPtr &) = delete;
+    RcuPtr &operator=(const RcuPtr &) = delete;
+
+    std::shared_ptr<T> Load() const {
+        // The holder loaded after announcing the reader stays alive until the
+        // reader count drops, see Store().
+        readers_.fetch_add(1, std::memory_order_seq_cst);
+        std::shared_ptr<T> value = *current_.load(std::memory_order_seq_cst);
+        readers_.fetch_sub(1, std::memory_order_release);
+        return value;
+    }
+
+    void Store(std::shared_ptr<T> value) {
+        auto holder = new std::shared_ptr<T>(std::move(value));
+        retired_.emplace_back(current_.exchange(holder, std::memory_order_seq_cst));
+        // A reader that could still see a retired holder has been counted
+        // before the exchange above, so no readers now means none is left.
+        if (readers_.load(std::memory_order_seq_cst) == 0) {
+            retired_.clear();
+        }
+    }
+
+    // Number of holders waiting to be freed, for testing and dumps.
+    std::size_t GetRetiredCount() const { return retired_.size(); }
+
+  private:
+    mutable std::atomic<uint32_t> readers_{0};
+    std::atomic<const std::shared_ptr<T> *> current_;
+    std::vector<std::unique_ptr<const std::shared_ptr<T>>> retired_;
+};
+
+}  // namespace perfmgr
+}  // namespace android
+
+#endif  // ANDROID_LIBPERFMGR_RCUPTR_H_
@@ -22,6 +22,8 @@
 #include <string>
 #include <utility>
 
+#include "perfmgr/HintRegistry.h"
+
 namespace android {
 namespace perfmgr {
 
@@ -32,8 +34,8 @@ using ReqTime = std::chrono::time_point<std::chrono::steady_clock>;
 // add requests, a function to remove requests, and a function to check for the
 // next expiration time if there is an outstanding request, and a function to
 // check the requested value. There may only be one request per PowerHint, so
-// the representation is simple: a map from PowerHint to the expiration time for
-// that hint.
+// the representation is simple: a map from the interned PowerHint id to the
+// expiration time for that hint.
 class RequestGroup {
   public:
     RequestGroup(const std::string &request_value)  // NOLINT(runtime/explicit)
@@ -48,17 +50,19 @@ class RequestGroup {
     const std::string& GetRequestValue() const;
     // Return true for adding request, false for extending expire time of
     // existing active request on given hint_type.
+    bool AddRequest(HintId hint_id, ReqTime end_time);
     bool AddRequest(const std::string& hint_type, ReqTime end_time);
     // Return true for removing request, false if request is not active on given
     // hint_type. If request exits and the new end_time is less than the active
     // time, expire time will not be updated; also returns false.
+    bool RemoveRequest(HintId hint_id);
     bool RemoveRequest(const std::string& hint_type);
     // Dump internal status to fd
     void DumpToFd(int fd, const std::string& prefix) const;
 
   private:
     const std::string request_value_;
-    std::map<std::string, ReqTime> request_map_;
+    std::map<HintId, ReqTime> request_map_;
 };
 
 }  // namespace perfmgr
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/properties.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "perfmgr/ActionGates.h"
+#include "perfmgr/NodeLooperThread.h"
+
+namespace android {
+namespace perfmgr {
+
+using std::literals::chrono_literals::operator""ms;
+
+// Wait for the watcher thread to pick up a property change
+static bool WaitForGate(GateId id, bool open) {
+    for (int i = 0; i < 100; i++) {
+        if (ActionGates::GetInstance().IsOpen(id) == open) {
+            return true;
+        }
+        std::this_thread::sleep_for(10ms);
+    }
+    return false;
+}
+
+// Test actions without condition are always enabled and share no gate
+TEST(ActionGatesTest, OpenGateTest) {
+    NodeAction action(0, 0, 0ms);
+    EXPECT_EQ(kOpenGate, action.gate);
+    EXPECT_TRUE(action.IsEnabled());
+    EXPECT_EQ(kOpenGate, ActionGates::GetInstance().Intern("", nullptr, nullptr));
+}
+
+// Test actions with the same condition share a gate
+TEST(ActionGatesTest, InternStableTest) {
+    ActionGates &gates = ActionGates::GetInstance();
+    GateId id = gates.Intern("vendor.pwhal.gates.test.a", nullptr, nullptr);
+    EXPECT_NE(kOpenGate, id);
+    EXPECT_EQ(id, gates.Intern("vendor.pwhal.gates.test.a", nullptr, nullptr));
+    EXPECT_NE(id, gates.Intern("vendor.pwhal.gates.test.a", powerhal::flags::test_flag, nullptr));
+    EXPECT_NE(id, gates.Intern("vendor.pwhal.gates.test.b", nullptr, nullptr));
+}
+
+// Test property changes reach the gate without a lookup on the check
+TEST(ActionGatesTest, PropertyChangeTest) {
+    const std::string prop = "vendor.pwhal.gates.test.c";
+    ASSERT_TRUE(android::base::SetProperty(prop, ""));
+    NodeAction action(0, 0, 0ms, prop);
+    // Unset property does not disable the action
+    EXPECT_TRUE(action.IsEnabled());
+
+    ASSERT_TRUE(android::base::SetProperty(prop, "false"));
+    EXPECT_TRUE(WaitForGate(action.gate, false));
+    EXPECT_FALSE(action.IsEnabled());
+
+    ASSERT_TRUE(android::base::SetProperty(prop, "1"));
+    EXPECT_TRUE(WaitForGate(action.gate, true));
+    EXPECT_TRUE(action.IsEnabled());
+}
+
+// Test flag overrides refresh the gates at once
+TEST(ActionGatesTest, FlagOverrideTest) {
+    NodeAction enabled(0, 0, 0ms, "", "test_flag");
+    NodeAction disabled(0, 0, 0ms, "", "", "test_flag");
+    ASSERT_NE(nullptr, enabled.enable_flag);
+
+    FlagProvider::GetInstance().OverrideValue(powerhal::flags::test_flag, true);
+    EXPECT_TRUE(enabled.IsEnabled());
+    EXPECT_FALSE(disabled.IsEnabled());
+
+    FlagProvider::GetInstance().OverrideValue(powerhal::flags::test_flag, false);
+    EXPECT_FALSE(enabled.IsEnabled());
+    EXPECT_TRUE(disabled.IsEnabled());
+    FlagProvider::GetInstance().ClearOverrides();
+}
+
+}  // namespace perfmgr
+}  // namespace android
@@ -76,7 +76,10 @@ TEST(FileNodeTest, DumpToFdTest) {
             "Truncate\n"
             "%s\t%s\t%zu\t%s\t%d\t%d\n",
             "test_dump", tf.path, static_cast<size_t>(1), "value1", 0, 1));
-    _VerifyPathValue(dumptf.path, buf);
+    std::string s;
+    EXPECT_TRUE(android::base::ReadFileToString(dumptf.path, &s)) << strerror(errno);
+    EXPECT_THAT(s, ::testing::StartsWith(buf));
+    EXPECT_THAT(s, ::testing::HasSubstr("\t\tWrite latency:\tcount:1\t"));
 }
 
 // Test GetValueIndex
@@ -252,5 +255,57 @@ TEST(FileNodeTest, AllowFailureTest) {
                 kTIMING_TOLERANCE_MS);
 }
 
+// Test shorter value fully replaces longer one with cached fd
+TEST(FileNodeTest, TruncateCachedFdTest) {
+    TemporaryFile tf;
+    FileNode t("t", {tf.path}, {{"value_long"}, {"v1"}, {"value2"}}, 2, true, true, false);
+    t.Update(false);
+    _VerifyPathValue(tf.path, "value2");
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(t.AddRequest(0, "LAUNCH", start + 500ms));
+    t.Update(true);
+    _VerifyPathValue(tf.path, "value_long");
+    EXPECT_TRUE(t.AddRequest(1, "INTERACTION", start + 500ms));
+    t.RemoveRequest("LAUNCH");
+    t.Update(true);
+    _VerifyPathValue(tf.path, "v1");
+}
+
+// Test node is dirty until requests are applied
+TEST(FileNodeTest, DirtyTest) {
+    TemporaryFile tf;
+    FileNode t("t", {tf.path}, {{"value0"}, {"value1"}, {"value2"}}, 2, true, true, false);
+    // New node needs an initial Update
+    EXPECT_TRUE(t.IsDirty());
+    t.Update(true);
+    EXPECT_FALSE(t.IsDirty());
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(t.AddRequest(1, "INTERACTION", start + 500ms));
+    EXPECT_TRUE(t.IsDirty());
+    t.Update(true);
+    _VerifyPathValue(tf.path, "value1");
+    EXPECT_FALSE(t.IsDirty());
+    // Removing a request that does not exist does not dirty node
+    EXPECT_FALSE(t.RemoveRequest("LAUNCH"));
+    EXPECT_FALSE(t.IsDirty());
+    EXPECT_TRUE(t.RemoveRequest("INTERACTION"));
+    EXPECT_TRUE(t.IsDirty());
+    t.Update(true);
+    _VerifyPathValue(tf.path, "value2");
+    EXPECT_FALSE(t.IsDirty());
+}
+
+// Test node stays dirty when write fails
+TEST(FileNodeTest, DirtyOnFailureTest) {
+    FileNode t("t", {"/sys/android/nonexist_node_test"},
+               {{"value0"}, {"value1"}, {"value2"}}, 2, true, true, false);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(t.AddRequest(0, "LAUNCH", start + 2000ms));
+    t.Update(false);
+    EXPECT_TRUE(t.IsDirty());
+    t.Update(true);
+    EXPECT_TRUE(t.IsDirty());
+}
+
 }  // namespace perfmgr
 }  // namespace android
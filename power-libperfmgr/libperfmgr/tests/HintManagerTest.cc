@@ -25,6 +25,7 @@
 #include <thread>
 
 #include "perfmgr/AdpfConfig.h"
+#include "perfmgr/ConfigBlob.h"
 #include "perfmgr/FileNode.h"
 #include "perfmgr/HintManager.h"
 #include "perfmgr/PropertyNode.h"
@@ -51,7 +52,8 @@ constexpr char kJSON_RAW[] = R"(
                 "384000"
             ],
             "DefaultIndex": 2,
-            "ResetOnInit": true
+            "ResetOnInit": true,
+            "DependencyClass": "cpufreq"
         },
         {
             "Name": "CPUCluster1MinFreq",
@@ -229,9 +231,11 @@ constexpr char kJSON_ADPF[] = R"(
             "GpuBoost": true,
             "GpuCapacityBoostMax": 325000,
             "GpuCapacityLoadUpHeadroom": 1000,
+            "GpuCapacityWriteHysteresis": 500,
             "HeuristicBoost_On": true,
             "HBoostModerateJankThreshold": 4,
             "HBoostOffMaxAvgDurRatio": 4.0,
+            "HBoostOffP90AvgDurRatio": 1.5,
             "HBoostSevereJankPidPu": 0.5,
             "HBoostSevereJankThreshold": 2,
             "HBoostUclampMinCeilingRange": [480, 800],
@@ -241,7 +245,10 @@ constexpr char kJSON_ADPF[] = R"(
             "MaxRecordsNum": 50,
             "HeuristicRampup": true,
             "DefaultRampupMult": 1,
-            "HighRampupMult": 4
+            "HighRampupMult": 4,
+            "PredictiveBoost_On": true,
+            "PredictiveBoostHeavyFactor": 1.5,
+            "PredictiveBoostUclampMin": 600
         },
         {
             "Name": "ADPF_SF",
@@ -308,7 +315,8 @@ constexpr char kJSON_ADPF[] = R"(
     "OtherConfigs": {
         "EnableMetricCollection": true,
         "MaxNumOfCachedSessionMetrics": 100,
-        "EnableSFPreferHighCap": true
+        "EnableSFPreferHighCap": true,
+        "NodeWriterThreads": 2
     }
 }
 )";
@@ -580,6 +588,8 @@ TEST_F(HintManagerTest, ParseNodesTest) {
     EXPECT_EQ("NONE", nodes[2]->GetValues()[2]);
     EXPECT_EQ(2u, nodes[2]->GetDefaultIndex());
     EXPECT_FALSE(nodes[2]->GetResetOnInit());
+    EXPECT_EQ("cpufreq", nodes[0]->GetDependencyClass());
+    EXPECT_EQ("", nodes[1]->GetDependencyClass());
 }
 
 // Test parsing nodes with duplicate name
@@ -935,6 +945,8 @@ TEST_F(HintManagerTest, ParseAdpfConfigsTest) {
     EXPECT_FALSE(adpfs[1]->mHBoostModerateJankThreshold.has_value());
     EXPECT_EQ(4.0, adpfs[0]->mHBoostOffMaxAvgDurRatio.value());
     EXPECT_FALSE(adpfs[1]->mHBoostOffMaxAvgDurRatio.has_value());
+    EXPECT_EQ(1.5, adpfs[0]->mHBoostOffP90AvgDurRatio.value());
+    EXPECT_FALSE(adpfs[1]->mHBoostOffP90AvgDurRatio.has_value());
     EXPECT_EQ(0.5, adpfs[0]->mHBoostSevereJankPidPu.value());
     EXPECT_FALSE(adpfs[1]->mHBoostSevereJankPidPu.has_value());
     EXPECT_EQ(2U, adpfs[0]->mHBoostSevereJankThreshold.value());
@@ -957,6 +969,12 @@ TEST_F(HintManagerTest, ParseAdpfConfigsTest) {
     EXPECT_FALSE(adpfs[1]->mDefaultRampupMult.has_value());
     EXPECT_EQ(4U, adpfs[0]->mHighRampupMult.value());
     EXPECT_FALSE(adpfs[1]->mHighRampupMult.has_value());
+    EXPECT_TRUE(adpfs[0]->mPredictiveBoostOn.value());
+    EXPECT_FALSE(adpfs[1]->mPredictiveBoostOn.has_value());
+    EXPECT_EQ(1.5, adpfs[0]->mPredictiveBoostHeavyFactor.value());
+    EXPECT_FALSE(adpfs[1]->mPredictiveBoostHeavyFactor.has_value());
+    EXPECT_EQ(600U, adpfs[0]->mPredictiveBoostUclampMin.value());
+    EXPECT_FALSE(adpfs[1]->mPredictiveBoostUclampMin.has_value());
 }
 
 // Test parsing adpf configs with duplicate name
@@ -1120,6 +1138,77 @@ TEST_F(HintManagerTest, RegisterAdpfUpdateEventAndUnregister) {
     EXPECT_EQ("ADPF_DEFAULT", name);
 }
 
+TEST_F(HintManagerTest, ReloadAdpfProfiles) {
+    TemporaryFile json_file;
+    std::string json_doc = kJSON_ADPF;
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc, json_file.path)) << strerror(errno);
+    HintManager *hm = HintManager::GetFromJSON(json_file.path, true);
+    ASSERT_NE(nullptr, hm);
+    EXPECT_TRUE(hm->SetAdpfProfile("SURFACEFLINGER", "SF_VIDEO_30FPS"));
+    auto old_profile = hm->GetAdpfProfile("SURFACEFLINGER");
+    EXPECT_EQ(5.0, old_profile->mPidPo);
+    int count = 0;
+    std::shared_ptr<AdpfConfig> updated;
+    AdpfCallback callback = [&](std::shared_ptr<AdpfConfig> profile) {
+        count++;
+        updated = profile;
+    };
+    hm->RegisterAdpfUpdateEvent("SURFACEFLINGER", &callback);
+
+    // Invalid AdpfConfig keeps the current profiles
+    std::string from = R"("Name": "SF_VIDEO_30FPS",
+            "PID_On": true,
+            "PID_Po": 5.0,)";
+    size_t start_pos = json_doc.find(from);
+    ASSERT_NE(std::string::npos, start_pos);
+    std::string bad_doc = json_doc;
+    bad_doc.replace(start_pos, from.length(), R"("Name": "SF_VIDEO_30FPS",
+            "PID_On": true,)");
+    ASSERT_TRUE(android::base::WriteStringToFile(bad_doc, json_file.path)) << strerror(errno);
+    EXPECT_FALSE(hm->ReloadAdpfProfiles());
+    EXPECT_EQ(0, count);
+    EXPECT_EQ(old_profile, hm->GetAdpfProfile("SURFACEFLINGER"));
+
+    // The selected profile is kept by name with the new values
+    json_doc.replace(start_pos, from.length(), R"("Name": "SF_VIDEO_30FPS",
+            "PID_On": true,
+            "PID_Po": 7.0,)");
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc, json_file.path)) << strerror(errno);
+    EXPECT_TRUE(hm->ReloadAdpfProfiles());
+    EXPECT_EQ(1, count);
+    ASSERT_NE(nullptr, updated);
+    EXPECT_EQ("SF_VIDEO_30FPS", updated->mName);
+    EXPECT_EQ(7.0, updated->mPidPo);
+    EXPECT_EQ(updated, hm->GetAdpfProfile("SURFACEFLINGER"));
+    EXPECT_EQ("ADPF_DEFAULT", hm->GetAdpfProfile()->mName);
+    // Profiles held by sessions stay valid
+    EXPECT_EQ(5.0, old_profile->mPidPo);
+    EXPECT_TRUE(hm->IsRunning());
+    hm->UnregisterAdpfUpdateEvent("SURFACEFLINGER", &callback);
+}
+
+TEST_F(HintManagerTest, WatchAdpfProfiles) {
+    TemporaryFile json_file;
+    std::string json_doc = kJSON_ADPF;
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc, json_file.path)) << strerror(errno);
+    HintManager *hm = HintManager::GetFromJSON(json_file.path, true);
+    ASSERT_NE(nullptr, hm);
+    EXPECT_TRUE(hm->WatchAdpfProfiles());
+    EXPECT_FALSE(hm->WatchAdpfProfiles());
+    std::atomic<int> count = 0;
+    AdpfCallback callback = [&](std::shared_ptr<AdpfConfig>) { count++; };
+    hm->RegisterAdpfUpdateEvent("SURFACEFLINGER", &callback);
+
+    std::string from = R"("PID_Po": 5.0,)";
+    json_doc.replace(json_doc.find(from), from.length(), R"("PID_Po": 6.0,)");
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc, json_file.path)) << strerror(errno);
+    for (int i = 0; i < 100 && count == 0; i++) {
+        std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_EQ(1, count);
+    hm->UnregisterAdpfUpdateEvent("SURFACEFLINGER", &callback);
+}
+
 TEST_F(HintManagerTest, GetAdpfProfileFromDoHint) {
     TemporaryFile json_file;
     ASSERT_TRUE(android::base::WriteStringToFile(kJSON_ADPF, json_file.path)) << strerror(errno);
@@ -1158,12 +1247,14 @@ TEST_F(HintManagerTest, GpuConfigSupport) {
     EXPECT_THAT(profile->mGpuBoostOn, Optional(true));
     EXPECT_THAT(profile->mGpuBoostCapacityMax, Optional(325000));
     EXPECT_EQ(profile->mGpuCapacityLoadUpHeadroom, 1000);
+    EXPECT_EQ(profile->mGpuCapacityWriteHysteresis, 500);
 
     ASSERT_TRUE(hm->SetAdpfProfile("OTHER", "ADPF_SF"));
     profile = hm->GetAdpfProfile();
     EXPECT_FALSE(profile->mGpuBoostOn);
     EXPECT_FALSE(profile->mGpuBoostCapacityMax);
     EXPECT_EQ(profile->mGpuCapacityLoadUpHeadroom, 0);
+    EXPECT_EQ(profile->mGpuCapacityWriteHysteresis, 0);
 }
 
 TEST_F(HintManagerTest, OtherConfigs) {
@@ -1178,6 +1269,7 @@ TEST_F(HintManagerTest, OtherConfigs) {
     EXPECT_TRUE(other_configs.enableMetricCollection);
     EXPECT_EQ(other_configs.maxNumOfCachedSessionMetrics, 100);
     EXPECT_TRUE(other_configs.enableSFPreferHighCap);
+    EXPECT_EQ(other_configs.nodeWriterThreads, 2);
 
     // Without other configurations
     ASSERT_TRUE(android::base::WriteStringToFile(kJSON_RAW, json_file.path)) << strerror(errno);
@@ -1189,6 +1281,7 @@ TEST_F(HintManagerTest, OtherConfigs) {
     EXPECT_EQ(other_configs.enableMetricCollection, std::nullopt);
     EXPECT_EQ(other_configs.maxNumOfCachedSessionMetrics, std::nullopt);
     EXPECT_FALSE(other_configs.enableSFPreferHighCap);
+    EXPECT_EQ(other_configs.nodeWriterThreads, std::nullopt);
 }
 
 TEST_F(HintManagerTest, EnableFlag) {
@@ -1231,5 +1324,191 @@ TEST_F(HintManagerTest, DisableFlag) {
     VERIFY_PROPERTY_VALUE(prop_, "LOW");
 }
 
+TEST_F(HintManagerTest, ConfigBlobTest) {
+    TemporaryFile json_file;
+    TemporaryFile blob_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc_, json_file.path)) << strerror(errno);
+    ASSERT_TRUE(HintManager::CompileConfig(json_file.path, blob_file.path));
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::unordered_map<std::string, Hint> actions;
+    std::vector<std::shared_ptr<AdpfConfig>> adpfs;
+    OtherConfigs other_configs;
+    ASSERT_TRUE(HintManager::LoadConfigBlob(blob_file.path, json_doc_, &nodes, &actions, &adpfs,
+                                            &other_configs));
+
+    std::vector<std::unique_ptr<Node>> nodes_parsed = HintManager::ParseNodes(json_doc_);
+    ASSERT_EQ(nodes_parsed.size(), nodes.size());
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+        EXPECT_EQ(nodes_parsed[i]->GetName(), nodes[i]->GetName());
+        EXPECT_EQ(nodes_parsed[i]->GetPaths(), nodes[i]->GetPaths());
+        EXPECT_EQ(nodes_parsed[i]->GetValues(), nodes[i]->GetValues());
+        EXPECT_EQ(nodes_parsed[i]->GetDefaultIndex(), nodes[i]->GetDefaultIndex());
+        EXPECT_EQ(nodes_parsed[i]->GetResetOnInit(), nodes[i]->GetResetOnInit());
+        EXPECT_EQ(nodes_parsed[i]->GetDependencyClass(), nodes[i]->GetDependencyClass());
+        auto file_node_parsed = dynamic_cast<FileNode *>(nodes_parsed[i].get());
+        auto file_node = dynamic_cast<FileNode *>(nodes[i].get());
+        ASSERT_EQ(file_node_parsed == nullptr, file_node == nullptr);
+        if (file_node) {
+            EXPECT_EQ(file_node_parsed->GetTruncate(), file_node->GetTruncate());
+            EXPECT_EQ(file_node_parsed->GetHoldFd(), file_node->GetHoldFd());
+            EXPECT_EQ(file_node_parsed->GetAllowFailure(), file_node->GetAllowFailure());
+            EXPECT_EQ(file_node_parsed->GetWriteOnly(), file_node->GetWriteOnly());
+        }
+    }
+
+    std::unordered_map<std::string, Hint> actions_parsed =
+            HintManager::ParseActions(json_doc_, nodes_parsed);
+    ASSERT_EQ(actions_parsed.size(), actions.size());
+    for (const auto &[hint_type, hint_parsed] : actions_parsed) {
+        ASSERT_EQ(1u, actions.count(hint_type)) << hint_type;
+        const Hint &hint = actions.at(hint_type);
+        ASSERT_EQ(hint_parsed.node_actions.size(), hint.node_actions.size()) << hint_type;
+        for (std::size_t i = 0; i < hint.node_actions.size(); ++i) {
+            EXPECT_EQ(hint_parsed.node_actions[i].node_index, hint.node_actions[i].node_index);
+            EXPECT_EQ(hint_parsed.node_actions[i].value_index, hint.node_actions[i].value_index);
+            EXPECT_EQ(hint_parsed.node_actions[i].timeout_ms, hint.node_actions[i].timeout_ms);
+            EXPECT_EQ(hint_parsed.node_actions[i].enable_property,
+                      hint.node_actions[i].enable_property);
+            EXPECT_EQ(hint_parsed.node_actions[i].enable_flag, hint.node_actions[i].enable_flag);
+            EXPECT_EQ(hint_parsed.node_actions[i].disable_flag,
+                      hint.node_actions[i].disable_flag);
+        }
+        ASSERT_EQ(hint_parsed.hint_actions.size(), hint.hint_actions.size()) << hint_type;
+        for (std::size_t i = 0; i < hint.hint_actions.size(); ++i) {
+            EXPECT_EQ(hint_parsed.hint_actions[i].type, hint.hint_actions[i].type);
+            EXPECT_EQ(hint_parsed.hint_actions[i].value, hint.hint_actions[i].value);
+            EXPECT_EQ(hint_parsed.hint_actions[i].enable_flag, hint.hint_actions[i].enable_flag);
+        }
+    }
+    EXPECT_EQ(HintManager::ParseOtherConfigs(json_doc_).GPUSysfsPath, other_configs.GPUSysfsPath);
+}
+
+TEST_F(HintManagerTest, ConfigBlobAdpfConfigsTest) {
+    TemporaryFile json_file;
+    TemporaryFile blob_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(kJSON_ADPF, json_file.path)) << strerror(errno);
+    ASSERT_TRUE(HintManager::CompileConfig(json_file.path, blob_file.path));
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::unordered_map<std::string, Hint> actions;
+    std::vector<std::shared_ptr<AdpfConfig>> adpfs;
+    OtherConfigs other_configs;
+    ASSERT_TRUE(HintManager::LoadConfigBlob(blob_file.path, kJSON_ADPF, &nodes, &actions, &adpfs,
+                                            &other_configs));
+
+    std::vector<std::shared_ptr<AdpfConfig>> adpfs_parsed =
+            HintManager::ParseAdpfConfigs(kJSON_ADPF);
+    ASSERT_EQ(adpfs_parsed.size(), adpfs.size());
+    for (std::size_t i = 0; i < adpfs.size(); ++i) {
+        EXPECT_EQ(adpfs_parsed[i]->mName, adpfs[i]->mName);
+        EXPECT_EQ(adpfs_parsed[i]->mPidOn, adpfs[i]->mPidOn);
+        EXPECT_EQ(adpfs_parsed[i]->mPidPo, adpfs[i]->mPidPo);
+        EXPECT_EQ(adpfs_parsed[i]->mPidIInit, adpfs[i]->mPidIInit);
+        EXPECT_EQ(adpfs_parsed[i]->mUclampMinHigh, adpfs[i]->mUclampMinHigh);
+        EXPECT_EQ(adpfs_parsed[i]->mSamplingWindowP, adpfs[i]->mSamplingWindowP);
+        EXPECT_EQ(adpfs_parsed[i]->mStaleTimeFactor, adpfs[i]->mStaleTimeFactor);
+        EXPECT_EQ(adpfs_parsed[i]->mGpuBoostCapacityMax, adpfs[i]->mGpuBoostCapacityMax);
+        EXPECT_EQ(adpfs_parsed[i]->mGpuCapacityWriteHysteresis,
+                  adpfs[i]->mGpuCapacityWriteHysteresis);
+        EXPECT_EQ(adpfs_parsed[i]->mHBoostUclampMinCeilingRange,
+                  adpfs[i]->mHBoostUclampMinCeilingRange);
+        EXPECT_EQ(adpfs_parsed[i]->mUclampMinLoadReset, adpfs[i]->mUclampMinLoadReset);
+        EXPECT_EQ(adpfs_parsed[i]->mUclampMaxEfficientOffset,
+                  adpfs[i]->mUclampMaxEfficientOffset);
+    }
+    OtherConfigs other_configs_parsed = HintManager::ParseOtherConfigs(kJSON_ADPF);
+    EXPECT_EQ(other_configs_parsed.GPUSysfsPath, other_configs.GPUSysfsPath);
+    EXPECT_EQ(other_configs_parsed.enableMetricCollection, other_configs.enableMetricCollection);
+    EXPECT_EQ(other_configs_parsed.maxNumOfCachedSessionMetrics,
+              other_configs.maxNumOfCachedSessionMetrics);
+    EXPECT_EQ(other_configs_parsed.enableSFPreferHighCap, other_configs.enableSFPreferHighCap);
+}
+
+TEST_F(HintManagerTest, ConfigBlobStaleTest) {
+    TemporaryFile json_file;
+    TemporaryFile blob_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc_, json_file.path)) << strerror(errno);
+    ASSERT_TRUE(HintManager::CompileConfig(json_file.path, blob_file.path));
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::unordered_map<std::string, Hint> actions;
+    std::vector<std::shared_ptr<AdpfConfig>> adpfs;
+    OtherConfigs other_configs;
+    std::string from = "384000";
+    size_t start_pos = json_doc_.find(from);
+    json_doc_.replace(start_pos, from.length(), "384001");
+    EXPECT_FALSE(HintManager::LoadConfigBlob(blob_file.path, json_doc_, &nodes, &actions, &adpfs,
+                                             &other_configs));
+    EXPECT_TRUE(nodes.empty());
+    EXPECT_TRUE(actions.empty());
+}
+
+TEST_F(HintManagerTest, ConfigBlobTruncatedTest) {
+    TemporaryFile json_file;
+    TemporaryFile blob_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc_, json_file.path)) << strerror(errno);
+    ASSERT_TRUE(HintManager::CompileConfig(json_file.path, blob_file.path));
+    std::string blob;
+    ASSERT_TRUE(android::base::ReadFileToString(blob_file.path, &blob));
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::unordered_map<std::string, Hint> actions;
+    std::vector<std::shared_ptr<AdpfConfig>> adpfs;
+    OtherConfigs other_configs;
+    ASSERT_TRUE(android::base::WriteStringToFile(blob.substr(0, blob.size() - 1), blob_file.path));
+    EXPECT_FALSE(HintManager::LoadConfigBlob(blob_file.path, json_doc_, &nodes, &actions, &adpfs,
+                                             &other_configs));
+    ASSERT_TRUE(android::base::WriteStringToFile(blob.substr(0, 8), blob_file.path));
+    EXPECT_FALSE(HintManager::LoadConfigBlob(blob_file.path, json_doc_, &nodes, &actions, &adpfs,
+                                             &other_configs));
+    EXPECT_TRUE(nodes.empty());
+}
+
+TEST_F(HintManagerTest, GetFromJSONConfigBlobTest) {
+    TemporaryFile json_file;
+    ASSERT_TRUE(android::base::WriteStringToFile(json_doc_, json_file.path)) << strerror(errno);
+    const std::string blob_path = std::string(json_file.path) + kConfigBlobSuffix;
+    ASSERT_TRUE(HintManager::CompileConfig(json_file.path, blob_path));
+    HintManager *hm = HintManager::GetFromJSON(json_file.path);
+    unlink(blob_path.c_str());
+    ASSERT_NE(nullptr, hm);
+    EXPECT_TRUE(hm->IsRunning());
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    VERIFY_PATH_VALUE(files_[0 + 2]->path, "384000");
+    EXPECT_TRUE(hm->DoHint("INTERACTION"));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    VERIFY_PATH_VALUE(files_[1 + 2]->path, "1134000");
+    VERIFY_PROPERTY_VALUE(prop_, "LOW");
+    EXPECT_TRUE(hm->EndHint("INTERACTION"));
+}
+
+// The blob of tests/data/powerhint_blob_test.json is compiled at build time
+// by powerhint_config_blob_defaults, the way a device compiles its config.
+TEST_F(HintManagerTest, BuildTimeConfigBlobTest) {
+    const std::string dir = android::base::GetExecutableDirectory();
+    std::string json_doc;
+    ASSERT_TRUE(android::base::ReadFileToString(dir + "/tests/data/powerhint_blob_test.json",
+                                                &json_doc));
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::unordered_map<std::string, Hint> actions;
+    std::vector<std::shared_ptr<AdpfConfig>> adpfs;
+    OtherConfigs other_configs;
+    ASSERT_TRUE(HintManager::LoadConfigBlob(dir + "/powerhint_blob_test.json.bin", json_doc,
+                                            &nodes, &actions, &adpfs, &other_configs));
+    EXPECT_EQ(HintManager::ParseNodes(json_doc).size(), nodes.size());
+    EXPECT_EQ(2u, actions.size());
+    std::vector<std::shared_ptr<AdpfConfig>> adpfs_parsed =
+            HintManager::ParseAdpfConfigs(json_doc);
+    ASSERT_EQ(adpfs_parsed.size(), adpfs.size());
+    for (std::size_t i = 0; i < adpfs.size(); ++i) {
+        EXPECT_EQ(adpfs_parsed[i]->mName, adpfs[i]->mName);
+        EXPECT_EQ(adpfs_parsed[i]->mUclampMinHigh, adpfs[i]->mUclampMinHigh);
+        EXPECT_EQ(adpfs_parsed[i]->mGpuBoostCapacityMax, adpfs[i]->mGpuBoostCapacityMax);
+    }
+    EXPECT_EQ(HintManager::ParseOtherConfigs(json_doc).GPUSysfsPath, other_configs.GPUSysfsPath);
+}
+
 }  // namespace perfmgr
 }  // namespace android
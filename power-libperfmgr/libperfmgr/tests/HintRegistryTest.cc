@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "perfmgr/HintRegistry.h"
+
+namespace android {
+namespace perfmgr {
+
+// Test interning the same name returns the same id
+TEST(HintRegistryTest, InternStableTest) {
+    HintRegistry &registry = HintRegistry::GetInstance();
+    HintId id = registry.Intern("HINT_REGISTRY_TEST_A");
+    EXPECT_NE(kInvalidHintId, id);
+    EXPECT_EQ(id, registry.Intern("HINT_REGISTRY_TEST_A"));
+    EXPECT_EQ(id, registry.Find("HINT_REGISTRY_TEST_A"));
+    EXPECT_EQ("HINT_REGISTRY_TEST_A", registry.GetName(id));
+}
+
+// Test ids are dense and distinct for different names
+TEST(HintRegistryTest, InternDenseTest) {
+    HintRegistry &registry = HintRegistry::GetInstance();
+    HintId id_b = registry.Intern("HINT_REGISTRY_TEST_B");
+    HintId id_c = registry.Intern("HINT_REGISTRY_TEST_C");
+    EXPECT_EQ(id_b + 1, id_c);
+    EXPECT_LT(id_c, registry.Size());
+}
+
+// Test lookup of unknown name and id
+TEST(HintRegistryTest, FindUnknownTest) {
+    HintRegistry &registry = HintRegistry::GetInstance();
+    EXPECT_EQ(kInvalidHintId, registry.Find("HINT_REGISTRY_TEST_NO_SUCH_HINT"));
+    EXPECT_EQ("", registry.GetName(kInvalidHintId));
+}
+
+}  // namespace perfmgr
+}  // namespace android
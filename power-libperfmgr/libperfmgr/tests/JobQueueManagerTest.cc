@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <thread>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "perfmgr/JobQueueManager.h"
 #include "perfmgr/NodeLooperThread.h"
@@ -26,7 +29,7 @@ const size_t OVER_POOL_SIZE = DEFAULT_POOL_SIZE + 4;
 // Helper function to create a Job for testing
 Job *createJob(const std::string &hint_type, int schedule_time, bool is_cancel = false) {
     Job *job = new Job();
-    job->hint_type = hint_type;
+    job->hint_id = HintRegistry::GetInstance().Intern(hint_type);
     job->schedule_time =
             std::chrono::time_point<std::chrono::steady_clock>(std::chrono::seconds(schedule_time));
     job->is_cancel = is_cancel;
@@ -60,8 +63,8 @@ TEST_F(JobQueueManagerTest, TestEnqueueAndDequeue) {
     ASSERT_NE(dequeuedJob2, nullptr);
 
     // Verify that the jobs are dequeued in the correct order (based on schedule time)
-    ASSERT_EQ(dequeuedJob1->hint_type, "type2");
-    ASSERT_EQ(dequeuedJob2->hint_type, "type1");
+    ASSERT_EQ(dequeuedJob1->hint_id, HintRegistry::GetInstance().Find("type2"));
+    ASSERT_EQ(dequeuedJob2->hint_id, HintRegistry::GetInstance().Find("type1"));
 
     delete dequeuedJob1;
     delete dequeuedJob2;
@@ -96,7 +99,7 @@ TEST_F(JobQueueManagerTest, TestJobReset) {
     jobMgr_.enqueueRequest(job);
     Job *dequeuedJob = jobMgr_.dequeueRequest();
     ASSERT_NE(dequeuedJob, nullptr);
-    ASSERT_EQ(dequeuedJob->hint_type, "test");
+    ASSERT_EQ(dequeuedJob->hint_id, HintRegistry::GetInstance().Find("test"));
     jobMgr_.returnJob(dequeuedJob);  // Return the job to the pool
 
     // Now, enqueue another job
@@ -104,7 +107,7 @@ TEST_F(JobQueueManagerTest, TestJobReset) {
     jobMgr_.enqueueRequest(job2);
     Job *dequeuedJob2 = jobMgr_.dequeueRequest();
     ASSERT_NE(dequeuedJob2, nullptr);
-    ASSERT_EQ(dequeuedJob2->hint_type, "new_test");
+    ASSERT_EQ(dequeuedJob2->hint_id, HintRegistry::GetInstance().Find("new_test"));
     jobMgr_.returnJob(dequeuedJob2);
 }
 
@@ -114,7 +117,7 @@ TEST_F(JobQueueManagerTest, TestGetFreeJobAndReturnJob) {
     ASSERT_NE(job, nullptr);
 
     // Set some data in the job
-    job->hint_type = "test_type";
+    job->hint_id = HintRegistry::GetInstance().Intern("test_type");
     job->schedule_time = std::chrono::steady_clock::now();
     job->is_cancel = true;
 
@@ -126,11 +129,42 @@ TEST_F(JobQueueManagerTest, TestGetFreeJobAndReturnJob) {
     for (int i = 0; i < OVER_POOL_SIZE; i++) {
         Job *job3 = jobMgr_.getFreeJob();
         ASSERT_NE(job3, nullptr);
-        ASSERT_EQ(job3->hint_type, "");
+        ASSERT_EQ(job3->hint_id, kInvalidHintId);
         ASSERT_EQ(job3->is_cancel, false);
         jobMgr_.returnJob(job3);
     }
 }
 
+TEST_F(JobQueueManagerTest, TestConcurrentEnqueue) {
+    constexpr int kThreads = 4;
+    constexpr int kJobsPerThread = 256;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([this, t]() {
+            for (int i = 0; i < kJobsPerThread; ++i) {
+                Job *job = jobMgr_.getFreeJob();
+                job->hint_id = HintRegistry::GetInstance().Intern("concurrent");
+                job->schedule_time = std::chrono::time_point<std::chrono::steady_clock>(
+                        std::chrono::milliseconds(i * kThreads + t));
+                jobMgr_.enqueueRequest(job);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(static_cast<size_t>(kThreads * kJobsPerThread), jobMgr_.getSize());
+
+    // Jobs from all producers come out exactly once, in schedule_time order.
+    for (int i = 0; i < kThreads * kJobsPerThread; ++i) {
+        Job *job = jobMgr_.dequeueRequest();
+        ASSERT_NE(job, nullptr);
+        ASSERT_EQ(std::chrono::milliseconds(i), job->schedule_time.time_since_epoch());
+        jobMgr_.returnJob(job);
+    }
+    ASSERT_EQ(jobMgr_.dequeueRequest(), nullptr);
+    ASSERT_EQ(0u, jobMgr_.getSize());
+}
+
 }  // namespace perfmgr
 }  // namespace android
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "perfmgr/LatencyHistogram.h"
+
+namespace android {
+namespace perfmgr {
+
+using std::literals::chrono_literals::operator""us;
+using std::literals::chrono_literals::operator""ms;
+
+// Test samples land in power-of-two buckets
+TEST(LatencyHistogramTest, BucketTest) {
+    LatencyHistogram h;
+    h.Add(0us);
+    h.Add(1us);
+    h.Add(2us);
+    h.Add(3us);
+    h.Add(4us);
+    h.Add(1000us);
+    h.Add(10ms);
+    EXPECT_EQ(7u, h.GetCount());
+    EXPECT_EQ(2u, h.GetBucket(0));
+    EXPECT_EQ(2u, h.GetBucket(1));
+    EXPECT_EQ(1u, h.GetBucket(2));
+    // [512us, 1024us)
+    EXPECT_EQ(1u, h.GetBucket(9));
+    // Open ended last bucket
+    EXPECT_EQ(1u, h.GetBucket(LatencyHistogram::kNumBuckets - 1));
+    EXPECT_EQ(0u, h.GetBucket(LatencyHistogram::kNumBuckets));
+}
+
+// Test dump format
+TEST(LatencyHistogramTest, DumpTest) {
+    LatencyHistogram h;
+    h.Add(3us);
+    h.Add(40us);
+    EXPECT_EQ(
+            "count:2\tmax:40us\t<2us:0\t<4us:1\t<8us:0\t<16us:0\t<32us:0\t<64us:1\t<128us:0"
+            "\t<256us:0\t<512us:0\t<1024us:0\t<2048us:0\t>=2048us:0",
+            h.Dump());
+}
+
+}  // namespace perfmgr
+}  // namespace android
@@ -15,9 +15,13 @@
  */
 
 #include <android-base/file.h>
+#include <android-base/unique_fd.h>
+#include <fcntl.h>
 #include <gtest/gtest.h>
+#include <sys/stat.h>
 
 #include <algorithm>
+#include <atomic>
 #include <thread>
 
 #include "perfmgr/FileNode.h"
@@ -191,5 +195,98 @@ TEST_F(NodeLooperThreadTest, MultipleRequest) {
     EXPECT_FALSE(th->isRunning());
 }
 
+// Test Request() does not block while the looper is stuck in a slow node write
+TEST_F(NodeLooperThreadTest, RequestLatencyWithSlowNode) {
+    // Writing to a FIFO blocks in open() until a reader shows up, which holds
+    // the looper in FileNode::Update for as long as the test wants.
+    TemporaryDir td;
+    std::string fifo_path = std::string(td.path) + "/slow_node";
+    ASSERT_EQ(0, mkfifo(fifo_path.c_str(), 0600)) << strerror(errno);
+    nodes_.emplace_back(new FileNode("n2", {fifo_path}, {{"n2_value0"}, {"n2_value1"}}, 1, false,
+                                     false, false));
+    sp<NodeLooperThread> th = new NodeLooperThread(std::move(nodes_));
+    EXPECT_TRUE(th->Start());
+    EXPECT_TRUE(th->isRunning());
+    std::vector<NodeAction> slow_actions{{2, 0, 0ms}};
+    EXPECT_TRUE(th->Request(slow_actions, "SLOW"));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+
+    constexpr int kThreads = 4;
+    constexpr int kRequestsPerThread = 200;
+    std::atomic<int64_t> max_latency_ns = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&th, &max_latency_ns]() {
+            std::vector<NodeAction> actions{{0, 0, 200ms}, {1, 1, 200ms}};
+            for (int i = 0; i < kRequestsPerThread; ++i) {
+                auto start = std::chrono::steady_clock::now();
+                EXPECT_TRUE(th->Request(actions, "INTERACTION"));
+                int64_t latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now() - start)
+                                             .count();
+                int64_t prev = max_latency_ns.load();
+                while (prev < latency_ns &&
+                       !max_latency_ns.compare_exchange_weak(prev, latency_ns)) {
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    // All requests were enqueued while the looper is still blocked on the slow
+    // node, none of them should have waited for it.
+    EXPECT_LT(std::chrono::nanoseconds(max_latency_ns.load()), kSLEEP_TOLERANCE_MS);
+
+    // Unblock the slow write and let the queued requests apply.
+    android::base::unique_fd reader(open(fifo_path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC));
+    ASSERT_NE(-1, reader.get()) << strerror(errno);
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[0]->path, "n0_value0");
+    _VerifyPathValue(files_[1]->path, "n1_value1");
+    // The node keeps its fd open, so read the value instead of waiting for EOF.
+    std::string fifo_value(sizeof("n2_value0") - 1, '\0');
+    EXPECT_TRUE(android::base::ReadFully(reader, fifo_value.data(), fifo_value.size()));
+    EXPECT_EQ("n2_value0", fifo_value);
+    th->Stop();
+    EXPECT_FALSE(th->isRunning());
+    unlink(fifo_path.c_str());
+}
+
+// Test a slow node does not delay independent nodes with parallel writers
+TEST_F(NodeLooperThreadTest, ParallelWriterWithSlowNode) {
+    TemporaryDir td;
+    std::string fifo_path = std::string(td.path) + "/slow_node";
+    ASSERT_EQ(0, mkfifo(fifo_path.c_str(), 0600)) << strerror(errno);
+    // Slow node goes first in config order, ahead of n0 and n1
+    nodes_.emplace(nodes_.begin(), new FileNode("n2", {fifo_path}, {{"n2_value0"}, {"n2_value1"}},
+                                                1, false, false, false));
+    // n2 and n1 are ordered, n0 is independent
+    nodes_[0]->SetDependencyClass("slow");
+    nodes_[2]->SetDependencyClass("slow");
+    sp<NodeLooperThread> th = new NodeLooperThread(std::move(nodes_), 2);
+    EXPECT_TRUE(th->Start());
+    EXPECT_TRUE(th->isRunning());
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    _VerifyPathValue(files_[1]->path, "n1_value2");
+    std::vector<NodeAction> actions{{0, 0, 0ms}, {1, 0, 0ms}, {2, 0, 0ms}};
+    EXPECT_TRUE(th->Request(actions, "LAUNCH"));
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    // n2 blocks in open(), n0 is written in parallel while n1 waits for n2
+    _VerifyPathValue(files_[0]->path, "n0_value0");
+    _VerifyPathValue(files_[1]->path, "n1_value2");
+
+    android::base::unique_fd reader(open(fifo_path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC));
+    ASSERT_NE(-1, reader.get()) << strerror(errno);
+    std::this_thread::sleep_for(kSLEEP_TOLERANCE_MS);
+    std::string fifo_value(sizeof("n2_value0") - 1, '\0');
+    EXPECT_TRUE(android::base::ReadFully(reader, fifo_value.data(), fifo_value.size()));
+    EXPECT_EQ("n2_value0", fifo_value);
+    _VerifyPathValue(files_[1]->path, "n1_value0");
+    th->Stop();
+    EXPECT_FALSE(th->isRunning());
+    unlink(fifo_path.c_str());
+}
+
 }  // namespace perfmgr
 }  // namespace android
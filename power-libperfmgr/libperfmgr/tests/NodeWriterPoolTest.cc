@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "perfmgr/NodeWriterPool.h"
+
+namespace android {
+namespace perfmgr {
+
+using std::literals::chrono_literals::operator""ms;
+
+// Test every task of every batch runs exactly once
+TEST(NodeWriterPoolTest, RunAllTasksTest) {
+    NodeWriterPool pool(3);
+    EXPECT_EQ(3u, pool.GetNumThreads());
+    std::vector<std::atomic<int>> counts(64);
+    for (int batch = 0; batch < 100; ++batch) {
+        pool.Run(counts.size(), [&counts](std::size_t i) { counts[i]++; });
+    }
+    for (const auto &count : counts) {
+        EXPECT_EQ(100, count.load());
+    }
+    // Empty batch returns right away
+    pool.Run(0, [](std::size_t) { FAIL(); });
+}
+
+// Test tasks of one batch run concurrently
+TEST(NodeWriterPoolTest, ConcurrentTasksTest) {
+    NodeWriterPool pool(1);
+    std::atomic<int> arrived = 0;
+    auto start = std::chrono::steady_clock::now();
+    // Each task waits for the other one, which only finishes if both run at
+    // the same time.
+    pool.Run(2, [&arrived, start](std::size_t) {
+        arrived++;
+        while (arrived.load() < 2 && std::chrono::steady_clock::now() - start < 1000ms) {
+            std::this_thread::yield();
+        }
+    });
+    EXPECT_EQ(2, arrived.load());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 1000ms);
+}
+
+}  // namespace perfmgr
+}  // namespace android
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "perfmgr/RcuPtr.h"
+
+namespace android {
+namespace perfmgr {
+
+// Test Load returns the last stored value
+TEST(RcuPtrTest, LoadStoreTest) {
+    RcuPtr<const std::string> ptr;
+    EXPECT_EQ(nullptr, ptr.Load());
+    ptr.Store(std::make_shared<const std::string>("a"));
+    EXPECT_EQ("a", *ptr.Load());
+    auto held = ptr.Load();
+    ptr.Store(std::make_shared<const std::string>("b"));
+    EXPECT_EQ("b", *ptr.Load());
+    // A value loaded before Store stays valid
+    EXPECT_EQ("a", *held);
+    // No reader in flight, so nothing is left to retire
+    EXPECT_EQ(0u, ptr.GetRetiredCount());
+}
+
+// Test readers always see a complete value while a writer keeps replacing it
+TEST(RcuPtrTest, ConcurrentReadTest) {
+    struct Value {
+        int a;
+        int b;
+    };
+    RcuPtr<const Value> ptr(std::make_shared<const Value>(Value{0, 0}));
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&]() {
+            while (!done.load()) {
+                auto value = ptr.Load();
+                if (value->a != value->b) {
+                    torn++;
+                }
+            }
+        });
+    }
+    for (int i = 1; i <= 10000; i++) {
+        ptr.Store(std::make_shared<const Value>(Value{i, i}));
+    }
+    done = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(0, torn.load());
+    EXPECT_EQ(10000, ptr.Load()->a);
+    // The next Store without readers frees whatever is still retired
+    ptr.Store(std::make_shared<const Value>(Value{0, 0}));
+    EXPECT_EQ(0u, ptr.GetRetiredCount());
+}
+
+}  // namespace perfmgr
+}  // namespace android
@@ -74,6 +74,8 @@ static void printUsage(const char* exec_name) {
         "       do only the specific hint\n\n"
         "   --hint_duration, -d  [duration]\n"
         "       duration in ms for each hint\n\n"
+        "   --output, -o  [PATH]\n"
+        "       compile Json config to a binary config blob at PATH\n\n"
         "   --help, -h\n"
         "       print this message\n\n"
         "   --verbose, -v\n"
@@ -110,6 +112,7 @@ int main(int argc, char* argv[]) {
 
     std::string config_path;
     std::string hint_name;
+    std::string output_path;
     bool exec_hint = false;
     uint64_t hint_duration = 100;
 
@@ -119,13 +122,14 @@ int main(int argc, char* argv[]) {
             {"exec_hint", no_argument, nullptr, 'e'},
             {"hint_name", required_argument, nullptr, 'i'},
             {"hint_duration", required_argument, nullptr, 'd'},
+            {"output", required_argument, nullptr, 'o'},
             {"help", no_argument, nullptr, 'h'},
             {"verbose", no_argument, nullptr, 'v'},
             {0, 0, 0, 0}  // termination of the option list
         };
 
         int option_index = 0;
-        int c = getopt_long(argc, argv, "c:ei:d:hv", opts, &option_index);
+        int c = getopt_long(argc, argv, "c:ei:d:o:hv", opts, &option_index);
         if (c == -1) {
             break;
         }
@@ -143,6 +147,9 @@ int main(int argc, char* argv[]) {
             case 'd':
                 hint_duration = strtoul(optarg, NULL, 10);
                 break;
+            case 'o':
+                output_path = optarg;
+                break;
             case 'v':
                 android::base::SetMinimumLogSeverity(android::base::VERBOSE);
                 break;
@@ -161,6 +168,16 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    if (!output_path.empty()) {
+        if (android::perfmgr::HintManager::CompileConfig(config_path, output_path)) {
+            LOG(INFO) << "Compiled JSON config to " << output_path;
+            return 0;
+        } else {
+            LOG(ERROR) << "Failed to compile JSON config";
+            return 1;
+        }
+    }
+
     if (exec_hint) {
         execConfig(config_path, hint_name, hint_duration);
         return 0;
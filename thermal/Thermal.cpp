@@ -40,14 +40,6 @@ ndk::ScopedAStatus readErrorStatus() {
             EX_ILLEGAL_STATE, "ThermalHal cannot read any sensor data");
 }
 
-bool interfacesEqual(const std::shared_ptr<::ndk::ICInterface> left,
-                     const std::shared_ptr<::ndk::ICInterface> right) {
-    if (left == nullptr || right == nullptr || !left->isRemote() || !right->isRemote()) {
-        return left == right;
-    }
-    return left->asBinder() == right->asBinder();
-}
-
 }  // namespace
 
 Thermal::Thermal() {
@@ -142,23 +134,7 @@ ndk::ScopedAStatus Thermal::unregisterThermalChangedCallback(
         return ndk::ScopedAStatus::fromExceptionCodeWithMessage(EX_ILLEGAL_ARGUMENT,
                                                                 "Invalid nullptr callback");
     }
-    bool removed = false;
-    std::lock_guard<std::mutex> _lock(thermal_callback_mutex_);
-    callbacks_.erase(
-            std::remove_if(
-                    callbacks_.begin(), callbacks_.end(),
-                    [&](const CallbackSetting &c) {
-                        if (interfacesEqual(c.callback, callback)) {
-                            LOG(INFO)
-                                    << "a callback has been unregistered to ThermalHAL, isFilter: "
-                                    << c.is_filter_type << " Type: " << toString(c.type);
-                            removed = true;
-                            return true;
-                        }
-                        return false;
-                    }),
-            callbacks_.end());
-    if (!removed) {
+    if (!callback_dispatcher_.removeClient(callback)) {
         return ndk::ScopedAStatus::fromExceptionCodeWithMessage(EX_ILLEGAL_ARGUMENT,
                                                                 "Callback wasn't registered");
     }
@@ -176,40 +152,16 @@ ndk::ScopedAStatus Thermal::registerThermalChangedCallback(
     if (!thermal_helper_->isInitializedOk()) {
         return initErrorStatus();
     }
-    std::lock_guard<std::mutex> _lock(thermal_callback_mutex_);
-    if (std::any_of(callbacks_.begin(), callbacks_.end(), [&](const CallbackSetting &c) {
-            return interfacesEqual(c.callback, callback);
-        })) {
+    if (!callback_dispatcher_.addClient(CallbackSetting(callback, filterType, type))) {
         return ndk::ScopedAStatus::fromExceptionCodeWithMessage(EX_ILLEGAL_ARGUMENT,
                                                                 "Callback already registered");
     }
-    auto c = callbacks_.emplace_back(callback, filterType, type);
-    LOG(INFO) << "a callback has been registered to ThermalHAL, isFilter: " << c.is_filter_type
-              << " Type: " << toString(c.type);
     // Send notification right away after successful thermal callback registration
-    std::function<void()> handler = [this, c, filterType, type]() {
+    std::function<void()> handler = [this, callback, filterType, type]() {
         std::vector<Temperature> temperatures;
         if (thermal_helper_->fillCurrentTemperatures(filterType, true, type, &temperatures)) {
-            std::lock_guard<std::mutex> _lock(thermal_callback_mutex_);
-            auto it = std::find_if(callbacks_.begin(), callbacks_.end(),
-                                   [&](const CallbackSetting &cc) {
-                                       return interfacesEqual(c.callback, cc.callback);
-                                   });
-            if (it != callbacks_.end()) {
-                if (AIBinder_isAlive(c.callback->asBinder().get())) {
-                    for (const auto &t : temperatures) {
-                        if (!filterType || t.type == type) {
-                            LOG(INFO) << "Sending notification: "
-                                      << " Type: " << toString(t.type) << " Name: " << t.name
-                                      << " CurrentValue: " << t.value
-                                      << " ThrottlingStatus: " << toString(t.throttlingStatus);
-                            c.callback->notifyThrottling(t);
-                        }
-                    }
-                } else {
-                    callbacks_.erase(it);
-                }
-            }
+            // Dropped if the callback was unregistered meanwhile
+            callback_dispatcher_.sendTo(callback, temperatures);
         }
     };
     looper_.addEvent(Looper::Event{handler});
@@ -217,28 +169,7 @@ ndk::ScopedAStatus Thermal::registerThermalChangedCallback(
 }
 
 void Thermal::sendThermalChangedCallback(const Temperature &t) {
-    ATRACE_CALL();
-    std::lock_guard<std::mutex> _lock(thermal_callback_mutex_);
-    LOG(VERBOSE) << "Sending notification: "
-                 << " Type: " << toString(t.type) << " Name: " << t.name
-                 << " CurrentValue: " << t.value
-                 << " ThrottlingStatus: " << toString(t.throttlingStatus);
-
-    callbacks_.erase(std::remove_if(callbacks_.begin(), callbacks_.end(),
-                                    [&](const CallbackSetting &c) {
-                                        if (!c.is_filter_type || t.type == c.type) {
-                                            ::ndk::ScopedAStatus ret =
-                                                    c.callback->notifyThrottling(t);
-                                            if (!ret.isOk()) {
-                                                LOG(ERROR) << "a Thermal callback is dead, removed "
-                                                              "from callback list.";
-                                                return true;
-                                            }
-                                            return false;
-                                        }
-                                        return false;
-                                    }),
-                     callbacks_.end());
+    callback_dispatcher_.send(t);
 }
 
 ndk::ScopedAStatus Thermal::registerCoolingDeviceChangedCallbackWithType(
@@ -728,13 +659,21 @@ void Thermal::dumpThermalData(int fd, const char **args, uint32_t numArgs) {
                     }
                     count_threshold_counted_log << "]";
                 }
+                std::stringstream polling_delay_log;
+                if (thermal_helper_->GetSensorInfoMap()
+                            .at(sensor_status_pair.first)
+                            .adaptive_polling_info != nullptr) {
+                    polling_delay_log << " PollingDelay: "
+                                      << sensor_status_pair.second.polling_delay.count() << "ms";
+                }
                 dump_buf << " Name: " << sensor_status_pair.first
                          << " CachedValue: " << sensor_status_pair.second.thermal_cached.temp
                          << " TimeToCache: "
                          << std::chrono::duration_cast<std::chrono::milliseconds>(
                                     now - sensor_status_pair.second.thermal_cached.timestamp)
                                     .count()
-                         << "ms" << count_threshold_counted_log.str() << std::endl;
+                         << "ms" << count_threshold_counted_log.str()
+                         << polling_delay_log.str() << std::endl;
             }
         }
         {
@@ -810,14 +749,7 @@ void Thermal::dumpThermalData(int fd, const char **args, uint32_t numArgs) {
                          << " CurrentValue: " << c.value << std::endl;
             }
         }
-        {
-            dump_buf << "getCallbacks:" << std::endl;
-            dump_buf << " Total: " << callbacks_.size() << std::endl;
-            for (const auto &c : callbacks_) {
-                dump_buf << " IsFilter: " << c.is_filter_type << " Type: " << toString(c.type)
-                         << std::endl;
-            }
-        }
+        callback_dispatcher_.dump(&dump_buf);
         {
             dump_buf << "sendCallback:" << std::endl;
             dump_buf << "  Enabled List: ";
@@ -22,6 +22,7 @@
 #include <thread>
 
 #include "thermal-helper.h"
+#include "utils/thermal_callback_dispatcher.h"
 
 namespace aidl {
 namespace android {
@@ -29,15 +30,6 @@ namespace hardware {
 namespace thermal {
 namespace implementation {
 
-struct CallbackSetting {
-    CallbackSetting(std::shared_ptr<IThermalChangedCallback> callback, bool is_filter_type,
-                    TemperatureType type)
-        : callback(std::move(callback)), is_filter_type(is_filter_type), type(type) {}
-    std::shared_ptr<IThermalChangedCallback> callback;
-    bool is_filter_type;
-    TemperatureType type;
-};
-
 struct CoolingDeviceCallbackSetting {
     CoolingDeviceCallbackSetting(std::shared_ptr<ICoolingDeviceChangedCallback> callback,
                                  bool is_filter_type, CoolingType type)
@@ -110,9 +102,10 @@ class Thermal : public BnThermal {
         void loop();
     };
 
+    // Declared before thermal_helper_ to outlive the watcher thread sending
+    // to it
+    ThermalCallbackDispatcher callback_dispatcher_;
     std::shared_ptr<ThermalHelper> thermal_helper_;
-    std::mutex thermal_callback_mutex_;
-    std::vector<CallbackSetting> callbacks_;
     std::mutex cdev_callback_mutex_;
     std::vector<CoolingDeviceCallbackSetting> cdev_callbacks_;
 
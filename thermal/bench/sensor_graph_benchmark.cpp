@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/stringprintf.h>
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <memory>
+
+#include "tests/mock_thermal_helper.h"
+#include "thermal-helper.h"
+
+namespace aidl::android::hardware::thermal::implementation {
+
+using ::android::base::StringPrintf;
+using ::testing::NiceMock;
+using ::testing::ReturnRef;
+
+// kPhysical physical sensors, and kVirtual virtual sensors each linking and
+// triggered by kLinks of them, about the size of a device config
+constexpr size_t kPhysical = 120;
+constexpr size_t kVirtual = 30;
+constexpr size_t kLinks = 4;
+
+class SensorGraphBenchmark : public benchmark::Fixture {
+  public:
+    void SetUp(const benchmark::State &) override {
+        for (size_t i = 0; i < kPhysical; i++) {
+            addSensor(StringPrintf("sensor_%zu", i));
+        }
+        for (size_t i = 0; i < kVirtual; i++) {
+            auto &sensor_info = addSensor(StringPrintf("virtual_%zu", i));
+            sensor_info.virtual_sensor_info = std::make_unique<VirtualSensorInfo>();
+            auto &virtual_sensor_info = *sensor_info.virtual_sensor_info;
+            for (size_t j = 0; j < kLinks; j++) {
+                const std::string linked =
+                        StringPrintf("sensor_%zu", (i * kLinks + j) % kPhysical);
+                virtual_sensor_info.linked_sensors.push_back(linked);
+                virtual_sensor_info.linked_sensors_type.push_back(SensorFusionType::SENSOR);
+                virtual_sensor_info.coefficients.push_back("0.25");
+                virtual_sensor_info.coefficients_type.push_back(SensorFusionType::CONSTANT);
+                virtual_sensor_info.trigger_sensors.push_back(linked);
+            }
+            virtual_sensor_info.formula = FormulaOption::WEIGHTED_AVG;
+        }
+        helper_ = std::make_unique<NiceMock<MockThermalHelper>>();
+        ON_CALL(*helper_, GetSensorInfoMap()).WillByDefault(ReturnRef(sensor_info_map_));
+        ON_CALL(*helper_, GetSensorStatusMap()).WillByDefault(ReturnRef(sensor_status_map_));
+    }
+
+    void TearDown(const benchmark::State &) override {
+        helper_.reset();
+        sensor_info_map_.clear();
+        sensor_status_map_.clear();
+    }
+
+  protected:
+    SensorInfo &addSensor(const std::string &name) {
+        auto &sensor_info = sensor_info_map_[name];
+        sensor_info.is_watch = true;
+        sensor_info.polling_delay = std::chrono::milliseconds(1000);
+        sensor_info.passive_delay = std::chrono::milliseconds(100);
+        sensor_status_map_[name].severity = ThrottlingSeverity::NONE;
+        return sensor_info;
+    }
+
+    std::unordered_map<std::string, SensorInfo> sensor_info_map_;
+    std::unordered_map<std::string, SensorStatus> sensor_status_map_;
+    std::unique_ptr<NiceMock<MockThermalHelper>> helper_;
+};
+
+// One watcher tick keyed by sensor name, as the loop walked it before the
+// sensor graph
+BENCHMARK_F(SensorGraphBenchmark, WatcherWalkByName)(benchmark::State &state) {
+    const auto &sensor_info_map = helper_->GetSensorInfoMap();
+    const auto &sensor_status_map = helper_->GetSensorStatusMap();
+    const std::unordered_map<std::string, float> uevent_sensor_map = {{"sensor_17", NAN}};
+    for (auto _ : state) {
+        size_t hits = 0;
+        for (const auto &[name, sensor_status] : sensor_status_map) {
+            const SensorInfo &sensor_info = sensor_info_map.at(name);
+            if (!sensor_info.is_watch || sensor_info.virtual_sensor_info == nullptr) {
+                hits += uevent_sensor_map.count(name);
+                continue;
+            }
+            for (const auto &trigger : sensor_info.virtual_sensor_info->trigger_sensors) {
+                hits += sensor_status_map.at(trigger).severity != ThrottlingSeverity::NONE;
+                hits += uevent_sensor_map.count(trigger);
+            }
+        }
+        benchmark::DoNotOptimize(hits);
+    }
+    state.SetItemsProcessed(state.iterations() * sensor_status_map.size());
+}
+
+// The same tick over the graph built from the helper's maps, by sensor id
+BENCHMARK_F(SensorGraphBenchmark, WatcherWalkById)(benchmark::State &state) {
+    SensorGraph graph;
+    if (!graph.build(helper_->GetSensorInfoMap(), &sensor_status_map_)) {
+        state.SkipWithError("Failed to build the sensor graph");
+        return;
+    }
+    const std::unordered_map<std::string, float> uevent_sensor_map = {{"sensor_17", NAN}};
+    std::vector<uint8_t> uevent_flags(graph.size(), 0);
+    for (auto _ : state) {
+        size_t hits = 0;
+        for (const auto &uevent : uevent_sensor_map) {
+            uevent_flags[graph.find(uevent.first)] = 1;
+        }
+        for (const size_t sensor_id : graph.watchedIds()) {
+            const SensorNode &node = graph[sensor_id];
+            if (node.info->virtual_sensor_info == nullptr) {
+                hits += uevent_flags[sensor_id];
+                continue;
+            }
+            for (const size_t trigger_id : node.trigger_ids) {
+                hits += graph[trigger_id].status->severity != ThrottlingSeverity::NONE;
+                hits += uevent_flags[trigger_id];
+            }
+        }
+        for (const auto &uevent : uevent_sensor_map) {
+            uevent_flags[graph.find(uevent.first)] = 0;
+        }
+        benchmark::DoNotOptimize(hits);
+    }
+    state.SetItemsProcessed(state.iterations() * graph.size());
+}
+
+}  // namespace aidl::android::hardware::thermal::implementation
+
+BENCHMARK_MAIN();
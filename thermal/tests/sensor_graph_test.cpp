@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/stringprintf.h>
+#include <gtest/gtest.h>
+#include <json/value.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "thermal-helper.h"
+
+namespace aidl::android::hardware::thermal::implementation {
+
+using ::android::base::StringPrintf;
+
+class SensorGraphTest : public testing::Test {
+  protected:
+    // kPhysical physical sensors, and kVirtual virtual sensors each linking
+    // and triggered by kLinks of them, about the size of a device config
+    static constexpr size_t kPhysical = 120;
+    static constexpr size_t kVirtual = 30;
+    static constexpr size_t kLinks = 4;
+
+    void SetUp() override {
+        for (size_t i = 0; i < kPhysical; i++) {
+            addSensor(StringPrintf("sensor_%zu", i));
+        }
+        for (size_t i = 0; i < kVirtual; i++) {
+            auto &sensor_info = addSensor(StringPrintf("virtual_%zu", i));
+            sensor_info.virtual_sensor_info = std::make_unique<VirtualSensorInfo>();
+            auto &virtual_sensor_info = *sensor_info.virtual_sensor_info;
+            for (size_t j = 0; j < kLinks; j++) {
+                const std::string linked =
+                        StringPrintf("sensor_%zu", (i * kLinks + j) % kPhysical);
+                virtual_sensor_info.linked_sensors.push_back(linked);
+                virtual_sensor_info.linked_sensors_type.push_back(SensorFusionType::SENSOR);
+                virtual_sensor_info.coefficients.push_back("0.25");
+                virtual_sensor_info.coefficients_type.push_back(SensorFusionType::CONSTANT);
+                virtual_sensor_info.trigger_sensors.push_back(linked);
+            }
+            virtual_sensor_info.formula = FormulaOption::WEIGHTED_AVG;
+        }
+    }
+
+    SensorInfo &addSensor(const std::string &name) {
+        auto &sensor_info = sensor_info_map_[name];
+        sensor_info.is_watch = true;
+        sensor_info.polling_delay = std::chrono::milliseconds(1000);
+        sensor_info.passive_delay = std::chrono::milliseconds(100);
+        sensor_status_map_[name].severity = ThrottlingSeverity::NONE;
+        return sensor_info;
+    }
+
+    std::unordered_map<std::string, SensorInfo> sensor_info_map_;
+    std::unordered_map<std::string, SensorStatus> sensor_status_map_;
+};
+
+TEST_F(SensorGraphTest, BuildResolvesLinks) {
+    SensorGraph graph;
+    ASSERT_TRUE(graph.build(sensor_info_map_, &sensor_status_map_));
+    ASSERT_EQ(graph.size(), kPhysical + kVirtual);
+    EXPECT_EQ(graph.watchedIds().size(), kPhysical + kVirtual);
+
+    const size_t id = graph.find("virtual_3");
+    ASSERT_NE(id, kInvalidSensorId);
+    const SensorNode &node = graph[id];
+    EXPECT_EQ(node.name, "virtual_3");
+    EXPECT_EQ(node.info, &sensor_info_map_.at("virtual_3"));
+    EXPECT_EQ(node.status, &sensor_status_map_.at("virtual_3"));
+    ASSERT_EQ(node.linked_ids.size(), kLinks);
+    ASSERT_EQ(node.trigger_ids.size(), kLinks);
+    for (size_t j = 0; j < kLinks; j++) {
+        EXPECT_EQ(graph[node.linked_ids[j]].name,
+                  node.info->virtual_sensor_info->linked_sensors[j]);
+        EXPECT_EQ(node.trigger_ids[j], node.linked_ids[j]);
+        // Constant coefficients are not sensors
+        EXPECT_EQ(node.coefficient_ids[j], kInvalidSensorId);
+    }
+    EXPECT_EQ(node.backup_id, kInvalidSensorId);
+    EXPECT_EQ(graph.find("no_such_sensor"), kInvalidSensorId);
+}
+
+TEST_F(SensorGraphTest, UnknownLinkStaysInvalid) {
+    auto &virtual_sensor_info = *sensor_info_map_.at("virtual_0").virtual_sensor_info;
+    virtual_sensor_info.linked_sensors[0] = "no_such_sensor";
+    virtual_sensor_info.backup_sensor = "sensor_7";
+
+    SensorGraph graph;
+    ASSERT_TRUE(graph.build(sensor_info_map_, &sensor_status_map_));
+    const SensorNode &node = graph[graph.find("virtual_0")];
+    EXPECT_EQ(node.linked_ids[0], kInvalidSensorId);
+    EXPECT_EQ(node.backup_id, graph.find("sensor_7"));
+}
+
+TEST_F(SensorGraphTest, ModelFormulaShortCoefficientTypes) {
+    // Model formulas list more coefficients than coefficient types
+    auto &virtual_sensor_info = *sensor_info_map_.at("virtual_2").virtual_sensor_info;
+    virtual_sensor_info.formula = FormulaOption::USE_LINEAR_MODEL;
+    virtual_sensor_info.coefficients = {"sensor_1", "0.5", "0.5", "0.5", "0.5", "0.5"};
+    virtual_sensor_info.coefficients_type = {SensorFusionType::SENSOR};
+
+    SensorGraph graph;
+    ASSERT_TRUE(graph.build(sensor_info_map_, &sensor_status_map_));
+    const SensorNode &node = graph[graph.find("virtual_2")];
+    ASSERT_EQ(node.coefficient_ids.size(), 1U);
+    EXPECT_EQ(node.coefficient_ids[0], graph.find("sensor_1"));
+}
+
+TEST_F(SensorGraphTest, MissingStatusFails) {
+    sensor_status_map_.erase("sensor_5");
+    SensorGraph graph;
+    EXPECT_FALSE(graph.build(sensor_info_map_, &sensor_status_map_));
+    EXPECT_EQ(graph.size(), 0U);
+}
+
+TEST_F(SensorGraphTest, WatchedAfterInputs) {
+    // Sorts before the virtual sensor it links, and is linked by another one
+    auto &sensor_info = addSensor("a_virtual");
+    sensor_info.virtual_sensor_info = std::make_unique<VirtualSensorInfo>();
+    auto &first = *sensor_info.virtual_sensor_info;
+    first.linked_sensors = {"virtual_5"};
+    first.linked_sensors_type = {SensorFusionType::SENSOR};
+    first.coefficients = {"sensor_2"};
+    first.coefficients_type = {SensorFusionType::SENSOR};
+    sensor_info_map_.at("virtual_0").virtual_sensor_info->backup_sensor = "a_virtual";
+
+    SensorGraph graph;
+    ASSERT_TRUE(graph.build(sensor_info_map_, &sensor_status_map_));
+    std::vector<size_t> position(graph.size(), kInvalidSensorId);
+    for (size_t i = 0; i < graph.watchedIds().size(); i++) {
+        position[graph.watchedIds()[i]] = i;
+    }
+    for (const size_t id : graph.watchedIds()) {
+        const SensorNode &node = graph[id];
+        std::vector<size_t> inputs = node.linked_ids;
+        inputs.insert(inputs.end(), node.coefficient_ids.begin(), node.coefficient_ids.end());
+        inputs.push_back(node.backup_id);
+        for (const size_t input_id : inputs) {
+            if (input_id != kInvalidSensorId) {
+                EXPECT_LT(position[input_id], position[id])
+                        << graph[input_id].name << " is watched after " << node.name;
+            }
+        }
+    }
+}
+
+TEST_F(SensorGraphTest, CycleFails) {
+    sensor_info_map_.at("virtual_0").virtual_sensor_info->linked_sensors[1] = "virtual_1";
+    sensor_info_map_.at("virtual_1").virtual_sensor_info->backup_sensor = "virtual_0";
+    SensorGraph graph;
+    EXPECT_FALSE(graph.build(sensor_info_map_, &sensor_status_map_));
+    EXPECT_EQ(graph.size(), 0U);
+}
+
+TEST_F(SensorGraphTest, TriggeredAndWatchOrder) {
+    SensorGraph graph;
+    ASSERT_TRUE(graph.build(sensor_info_map_, &sensor_status_map_));
+    for (size_t i = 0; i < graph.watchedIds().size(); i++) {
+        EXPECT_EQ(graph.watchOrder(graph.watchedIds()[i]), i);
+    }
+
+    const size_t id = graph.find("virtual_3");
+    for (const size_t trigger_id : graph[id].trigger_ids) {
+        const auto &triggered_ids = graph[trigger_id].triggered_ids;
+        EXPECT_NE(std::find(triggered_ids.begin(), triggered_ids.end(), id), triggered_ids.end())
+                << graph[trigger_id].name;
+    }
+    EXPECT_TRUE(graph[id].triggered_ids.empty());
+}
+
+TEST(SensorPollSchedulerTest, PopDueOnce) {
+    const auto now = boot_clock::now();
+    SensorPollScheduler scheduler;
+    scheduler.reset(4);
+    EXPECT_EQ(scheduler.nextDue(), boot_clock::time_point::max());
+
+    scheduler.schedule(0, now + std::chrono::seconds(3));
+    scheduler.schedule(1, now + std::chrono::seconds(1));
+    scheduler.schedule(2, now + std::chrono::seconds(2));
+    scheduler.schedule(3, boot_clock::time_point::max());
+    // Replaced entries are skipped
+    scheduler.schedule(1, now + std::chrono::seconds(5));
+    EXPECT_EQ(scheduler.nextDue(), now + std::chrono::seconds(2));
+
+    std::vector<size_t> due_ids;
+    scheduler.popDue(now + std::chrono::seconds(3), &due_ids);
+    EXPECT_EQ(due_ids, std::vector<size_t>({2, 0}));
+    EXPECT_EQ(scheduler.nextDue(), now + std::chrono::seconds(5));
+
+    due_ids.clear();
+    scheduler.popDue(now + std::chrono::seconds(10), &due_ids);
+    EXPECT_EQ(due_ids, std::vector<size_t>({1}));
+    EXPECT_EQ(scheduler.nextDue(), boot_clock::time_point::max());
+}
+
+TEST(SensorPollSchedulerTest, RescheduledOften) {
+    const auto now = boot_clock::now();
+    SensorPollScheduler scheduler;
+    scheduler.reset(2);
+    scheduler.schedule(1, now + std::chrono::seconds(1));
+    for (int i = 1000; i > 0; i--) {
+        scheduler.schedule(0, now + std::chrono::milliseconds(i));
+    }
+    std::vector<size_t> due_ids;
+    scheduler.popDue(now + std::chrono::seconds(2), &due_ids);
+    EXPECT_EQ(due_ids, std::vector<size_t>({0, 1}));
+}
+
+TEST(SensorTickCacheTest, ReadOncePerTick) {
+    SensorTickCache cache;
+    cache.reset(2);
+    float temp = NAN;
+    SensorReadStatus status;
+
+    cache.nextTick();
+    EXPECT_FALSE(cache.lookup(0, false, &temp, &status));
+    cache.store(0, false, 42.0, SensorReadStatus::OKAY);
+    ASSERT_TRUE(cache.lookup(0, false, &temp, &status));
+    EXPECT_EQ(temp, 42.0);
+    EXPECT_EQ(status, SensorReadStatus::OKAY);
+    EXPECT_FALSE(cache.lookup(1, false, &temp, &status));
+    // A cached reading does not serve a read that must bypass the cache
+    EXPECT_FALSE(cache.lookup(0, true, &temp, &status));
+    cache.store(1, true, NAN, SensorReadStatus::UNDER_COLLECTING);
+    ASSERT_TRUE(cache.lookup(1, true, &temp, &status));
+    EXPECT_EQ(status, SensorReadStatus::UNDER_COLLECTING);
+    ASSERT_TRUE(cache.lookup(1, false, &temp, &status));
+
+    cache.nextTick();
+    EXPECT_FALSE(cache.lookup(0, false, &temp, &status));
+    EXPECT_FALSE(cache.lookup(1, false, &temp, &status));
+}
+
+TEST(ThermalInfoTest, VirtualSensorCycleRejected) {
+    Json::Value config;
+    const auto add_sensor = [&config](const std::string &name, const std::string &linked) {
+        Json::Value sensor;
+        sensor["Name"] = name;
+        sensor["Type"] = "SKIN";
+        if (!linked.empty()) {
+            sensor["VirtualSensor"] = true;
+            sensor["Formula"] = "MAXIMUM";
+            sensor["Combination"].append(linked);
+            sensor["Coefficient"].append("1");
+        }
+        config["Sensors"].append(sensor);
+    };
+    add_sensor("skin", "");
+    add_sensor("virtual_a", "skin");
+    add_sensor("virtual_b", "virtual_a");
+    std::unordered_map<std::string, SensorInfo> sensors;
+    const std::unordered_map<std::string, CdevInfo> cdevs;
+    ASSERT_TRUE(ParseSensorInfo(config, &sensors, cdevs));
+    EXPECT_EQ(sensors.size(), 3U);
+
+    config["Sensors"][1]["Combination"][0] = "virtual_b";
+    EXPECT_FALSE(ParseSensorInfo(config, &sensors, cdevs));
+    EXPECT_TRUE(sensors.empty());
+}
+
+TEST(ThermalInfoTest, AdaptivePollingParsed) {
+    Json::Value config;
+    Json::Value sensor;
+    sensor["Name"] = "skin";
+    sensor["Type"] = "SKIN";
+    sensor["PollingDelay"] = 10000;
+    sensor["AdaptivePolling"]["MaxPollingDelay"] = 60000;
+    sensor["AdaptivePolling"]["FlatSlope"] = 0.5;
+    sensor["AdaptivePolling"]["ThresholdMargin"] = 5;
+    config["Sensors"].append(sensor);
+    std::unordered_map<std::string, SensorInfo> sensors;
+    const std::unordered_map<std::string, CdevInfo> cdevs;
+    ASSERT_TRUE(ParseSensorInfo(config, &sensors, cdevs));
+    const auto *adaptive_polling_info = sensors.at("skin").adaptive_polling_info.get();
+    ASSERT_NE(adaptive_polling_info, nullptr);
+    EXPECT_EQ(adaptive_polling_info->max_polling_delay, std::chrono::milliseconds(60000));
+    EXPECT_FLOAT_EQ(adaptive_polling_info->flat_slope, 0.5);
+    EXPECT_FLOAT_EQ(adaptive_polling_info->threshold_margin, 5);
+
+    // Has to stretch beyond PollingDelay
+    config["Sensors"][0]["AdaptivePolling"]["MaxPollingDelay"] = 10000;
+    EXPECT_FALSE(ParseSensorInfo(config, &sensors, cdevs));
+    config["Sensors"][0]["AdaptivePolling"]["MaxPollingDelay"] = 60000;
+    config["Sensors"][0]["AdaptivePolling"].removeMember("FlatSlope");
+    EXPECT_FALSE(ParseSensorInfo(config, &sensors, cdevs));
+}
+
+}  // namespace aidl::android::hardware::thermal::implementation
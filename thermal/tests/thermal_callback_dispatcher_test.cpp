@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <aidl/android/hardware/thermal/BnThermalChangedCallback.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+
+#include "utils/thermal_callback_dispatcher.h"
+
+namespace aidl::android::hardware::thermal::implementation {
+
+using std::chrono_literals::operator""s;
+
+// Only bounds a wait that should end on a notification
+constexpr auto kWaitTimeout = 10s;
+
+class BlockingCallback : public BnThermalChangedCallback {
+  public:
+    ndk::ScopedAStatus notifyThrottling(const Temperature &t) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (blocked_) {
+            waiting_++;
+            cv_.notify_all();
+            cv_.wait(lock, [this] { return !blocked_; });
+            waiting_--;
+        }
+        temperatures_.emplace_back(t);
+        cv_.notify_all();
+        return dead_ ? ndk::ScopedAStatus::fromStatus(STATUS_DEAD_OBJECT)
+                     : ndk::ScopedAStatus::ok();
+    }
+
+    ndk::ScopedAStatus notifyThresholdChanged(const TemperatureThreshold &) override {
+        return ndk::ScopedAStatus::ok();
+    }
+
+    void setBlocked(bool blocked) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        blocked_ = blocked;
+        cv_.notify_all();
+    }
+
+    void setDead() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dead_ = true;
+    }
+
+    // Wait until a worker is held in notifyThrottling by setBlocked(true)
+    bool waitUntilBlocked() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, kWaitTimeout, [this] { return waiting_ > 0; });
+    }
+
+    // Wait until count notifications were delivered, return them
+    std::vector<Temperature> waitFor(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, kWaitTimeout, [&] { return temperatures_.size() >= count; });
+        return temperatures_;
+    }
+
+    // Wait until value of sensor name was delivered
+    bool waitForValue(const std::string &name, float value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, kWaitTimeout, [&] {
+            return std::any_of(temperatures_.begin(), temperatures_.end(),
+                               [&](const Temperature &t) {
+                                   return t.name == name && t.value == value;
+                               });
+        });
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool blocked_ = false;
+    bool dead_ = false;
+    int waiting_ = 0;
+    std::vector<Temperature> temperatures_;
+};
+
+Temperature makeTemperature(const std::string &name, float value,
+                            TemperatureType type = TemperatureType::SKIN) {
+    Temperature t;
+    t.name = name;
+    t.type = type;
+    t.value = value;
+    return t;
+}
+
+// A client's notifications are delivered in queue order, so once a sentinel
+// sent after everything else arrives nothing else is left for the client.
+// Return what was delivered before the sentinel.
+std::vector<Temperature> drain(ThermalCallbackDispatcher *dispatcher,
+                               const std::shared_ptr<BlockingCallback> &callback,
+                               TemperatureType type = TemperatureType::SKIN) {
+    dispatcher->sendTo(callback, {makeTemperature("sentinel", 0, type)});
+    EXPECT_TRUE(callback->waitForValue("sentinel", 0));
+    auto received = callback->waitFor(0);
+    if (received.empty() || received.back().name != "sentinel") {
+        ADD_FAILURE() << "Sentinel was not delivered last";
+        return received;
+    }
+    received.pop_back();
+    return received;
+}
+
+TEST(ThermalCallbackDispatcherTest, RegisterOnce) {
+    ThermalCallbackDispatcher dispatcher;
+    auto callback = ndk::SharedRefBase::make<BlockingCallback>();
+    EXPECT_TRUE(dispatcher.addClient(CallbackSetting(callback, false, TemperatureType::UNKNOWN)));
+    EXPECT_FALSE(dispatcher.addClient(CallbackSetting(callback, true, TemperatureType::SKIN)));
+    EXPECT_EQ(dispatcher.getNumClients(), 1U);
+    EXPECT_TRUE(dispatcher.removeClient(callback));
+    EXPECT_FALSE(dispatcher.removeClient(callback));
+    EXPECT_EQ(dispatcher.getNumClients(), 0U);
+}
+
+TEST(ThermalCallbackDispatcherTest, FilterByType) {
+    ThermalCallbackDispatcher dispatcher;
+    auto skin = ndk::SharedRefBase::make<BlockingCallback>();
+    auto all = ndk::SharedRefBase::make<BlockingCallback>();
+    ASSERT_TRUE(dispatcher.addClient(CallbackSetting(skin, true, TemperatureType::SKIN)));
+    ASSERT_TRUE(dispatcher.addClient(CallbackSetting(all, false, TemperatureType::UNKNOWN)));
+
+    dispatcher.send(makeTemperature("cpu", 50, TemperatureType::CPU));
+    dispatcher.send(makeTemperature("skin", 30));
+    const auto all_received = all->waitFor(2);
+    const auto skin_received = skin->waitFor(1);
+    ASSERT_EQ(all_received.size(), 2U);
+    ASSERT_EQ(skin_received.size(), 1U);
+    EXPECT_EQ(skin_received[0].name, "skin");
+}
+
+// A hung client neither blocks send() nor the other clients, and only gets
+// the latest temperature of each sensor once it catches up.
+TEST(ThermalCallbackDispatcherTest, SlowClientCoalesced) {
+    ThermalCallbackDispatcher dispatcher;
+    auto slow = ndk::SharedRefBase::make<BlockingCallback>();
+    auto fast = ndk::SharedRefBase::make<BlockingCallback>();
+    slow->setBlocked(true);
+    ASSERT_TRUE(dispatcher.addClient(CallbackSetting(slow, false, TemperatureType::UNKNOWN)));
+    ASSERT_TRUE(dispatcher.addClient(CallbackSetting(fast, false, TemperatureType::UNKNOWN)));
+
+    // The first one is taken by a worker and blocks in the slow client
+    dispatcher.send(makeTemperature("skin", 0));
+    ASSERT_TRUE(slow->waitUntilBlocked());
+
+    for (int i = 1; i <= 10; i++) {
+        dispatcher.send(makeTemperature("skin", i));
+        dispatcher.send(makeTemperature("cpu", i, TemperatureType::CPU));
+    }
+    // Delivered by the other worker while the slow client still blocks,
+    // possibly coalesced too
+    EXPECT_TRUE(fast->waitForValue("skin", 10));
+    EXPECT_TRUE(fast->waitForValue("cpu", 10));
+
+    slow->setBlocked(false);
+    const auto received = drain(&dispatcher, slow);
+    ASSERT_EQ(received.size(), 3U);
+    EXPECT_EQ(received[0].value, 0);
+    EXPECT_EQ(received[1].name, "skin");
+    EXPECT_EQ(received[1].value, 10);
+    EXPECT_EQ(received[2].name, "cpu");
+    EXPECT_EQ(received[2].value, 10);
+
+    // The slow client is listed first, 18 of its 20 queued updates replaced
+    // a queued one
+    std::ostringstream dump_buf;
+    dispatcher.dump(&dump_buf);
+    const std::string dump = dump_buf.str();
+    const size_t slow_start = dump.find(" IsFilter");
+    ASSERT_NE(slow_start, std::string::npos) << dump;
+    const std::string slow_line = dump.substr(slow_start, dump.find('\n', slow_start) - slow_start);
+    EXPECT_NE(slow_line.find("Coalesced: 18"), std::string::npos) << dump;
+}
+
+TEST(ThermalCallbackDispatcherTest, QueueBounded) {
+    ThermalCallbackDispatcher dispatcher(1, 4);
+    auto slow = ndk::SharedRefBase::make<BlockingCallback>();
+    slow->setBlocked(true);
+    ASSERT_TRUE(dispatcher.addClient(CallbackSetting(slow, false, TemperatureType::UNKNOWN)));
+
+    dispatcher.send(makeTemperature("sensor_0", 0));
+    ASSERT_TRUE(slow->waitUntilBlocked());
+    for (int i = 1; i <= 8; i++) {
+        dispatcher.send(makeTemperature("sensor_" + std::to_string(i), i));
+    }
+    slow->setBlocked(false);
+    // Let the queue empty before the sentinel, it would drop another
+    ASSERT_EQ(slow->waitFor(5).size(), 5U);
+    const auto received = drain(&dispatcher, slow);
+    ASSERT_EQ(received.size(), 5U);
+    // The oldest queued ones were dropped
+    EXPECT_EQ(received[1].name, "sensor_5");
+    EXPECT_EQ(received[4].name, "sensor_8");
+}
+
+TEST(ThermalCallbackDispatcherTest, DeadClientRemoved) {
+    // A single worker removes the dead client before it serves the next one
+    ThermalCallbackDispatcher dispatcher(1);
+    auto dead = ndk::SharedRefBase::make<BlockingCallback>();
+    auto next = ndk::SharedRefBase::make<BlockingCallback>();
+    dead->setDead();
+    ASSERT_TRUE(dispatcher.addClient(CallbackSetting(dead, false, TemperatureType::UNKNOWN)));
+    ASSERT_TRUE(dispatcher.addClient(CallbackSetting(next, false, TemperatureType::UNKNOWN)));
+    dispatcher.send(makeTemperature("skin", 30));
+    ASSERT_EQ(dead->waitFor(1).size(), 1U);
+    ASSERT_EQ(next->waitFor(1).size(), 1U);
+    EXPECT_EQ(dispatcher.getNumClients(), 1U);
+}
+
+TEST(ThermalCallbackDispatcherTest, SendToUnregistered) {
+    ThermalCallbackDispatcher dispatcher;
+    auto callback = ndk::SharedRefBase::make<BlockingCallback>();
+    dispatcher.sendTo(callback, {makeTemperature("skin", 30)});
+    ASSERT_TRUE(dispatcher.addClient(CallbackSetting(callback, true, TemperatureType::CPU)));
+    dispatcher.sendTo(callback, {makeTemperature("skin", 30),
+                                 makeTemperature("cpu", 50, TemperatureType::CPU)});
+    const auto received = drain(&dispatcher, callback, TemperatureType::CPU);
+    ASSERT_EQ(received.size(), 1U);
+    EXPECT_EQ(received[0].name, "cpu");
+}
+
+}  // namespace aidl::android::hardware::thermal::implementation
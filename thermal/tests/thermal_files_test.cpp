@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+
+#include "utils/thermal_files.h"
+
+namespace aidl::android::hardware::thermal::implementation {
+
+using ::android::base::WriteStringToFile;
+
+class ThermalFilesTest : public testing::Test {
+  protected:
+    void SetUp() override {
+        path_ = std::string(dir_.path) + "/temp";
+        ASSERT_TRUE(thermal_files_.addThermalFile("sensor", path_));
+    }
+
+    TemporaryDir dir_;
+    std::string path_;
+    ThermalFiles thermal_files_;
+};
+
+TEST_F(ThermalFilesTest, ReadValue) {
+    float value = 0;
+    ASSERT_TRUE(WriteStringToFile("42000\n", path_));
+    ASSERT_TRUE(thermal_files_.readThermalValue("sensor", &value));
+    EXPECT_EQ(value, 42000);
+
+    // Kept fd reads the current content
+    ASSERT_TRUE(WriteStringToFile("-1500\n", path_));
+    ASSERT_TRUE(thermal_files_.readThermalValue("sensor", &value));
+    EXPECT_EQ(value, -1500);
+
+    std::string data;
+    ASSERT_TRUE(thermal_files_.readThermalFile("sensor", &data));
+    EXPECT_EQ(data, "-1500");
+}
+
+TEST_F(ThermalFilesTest, LookupByView) {
+    float value = 0;
+    ASSERT_TRUE(WriteStringToFile("25000\n", path_));
+    // The name is found by its view alone, not read past its end
+    const std::string_view name = std::string_view("sensor_1").substr(0, 6);
+    ASSERT_TRUE(thermal_files_.readThermalValue(name, &value));
+    EXPECT_EQ(value, 25000);
+    EXPECT_EQ(thermal_files_.getThermalFilePath(name).path, path_);
+    EXPECT_FALSE(thermal_files_.readThermalValue("sensor_1", &value));
+}
+
+TEST_F(ThermalFilesTest, InvalidValue) {
+    float value = 0;
+    ASSERT_TRUE(WriteStringToFile("\n", path_));
+    EXPECT_FALSE(thermal_files_.readThermalValue("sensor", &value));
+    ASSERT_TRUE(WriteStringToFile("unknown\n", path_));
+    EXPECT_FALSE(thermal_files_.readThermalValue("sensor", &value));
+    EXPECT_FALSE(thermal_files_.readThermalValue("no_such_sensor", &value));
+}
+
+TEST_F(ThermalFilesTest, FileAppearsLater) {
+    float value = 0;
+    EXPECT_FALSE(thermal_files_.readThermalValue("sensor", &value));
+    ASSERT_TRUE(WriteStringToFile("37000\n", path_));
+    ASSERT_TRUE(thermal_files_.readThermalValue("sensor", &value));
+    EXPECT_EQ(value, 37000);
+}
+
+}  // namespace aidl::android::hardware::thermal::implementation
@@ -24,6 +24,8 @@
 #include <android-base/strings.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <vector>
@@ -58,6 +60,25 @@ constexpr std::string_view kThermalDisabledProperty("vendor.disable.thermalhal.c
 namespace {
 using ::android::base::StringPrintf;
 
+// uevent_flags_ values of a sensor named in the current uevent
+constexpr uint8_t kUeventTemp = 1;
+constexpr uint8_t kUeventNoTemp = 2;
+
+// SensorGraph::visit() marks
+constexpr uint8_t kUnmarked = 0;
+constexpr uint8_t kVisiting = 1;
+constexpr uint8_t kVisited = 2;
+
+// time + delay, time_point::max() for a delay that does not fit, such as
+// the unbounded delay of PollingDelay 0
+boot_clock::time_point getDueTime(boot_clock::time_point time, std::chrono::milliseconds delay) {
+    if (delay >= std::chrono::duration_cast<std::chrono::milliseconds>(
+                         boot_clock::time_point::max() - time)) {
+        return boot_clock::time_point::max();
+    }
+    return time + delay;
+}
+
 std::unordered_map<std::string, std::string> parseThermalPathMap(std::string_view prefix) {
     std::unordered_map<std::string, std::string> path_map;
     std::unique_ptr<DIR, int (*)(DIR *)> dir(opendir(kThermalSensorsRoot.data()), closedir);
@@ -119,8 +140,152 @@ std::unordered_map<std::string, std::string> parsePowerCapPathMap(void) {
     return path_map;
 }
 
+// Sensors are read and evaluated on every watcher tick, only format the
+// trace name when tracing is on
+std::optional<::android::ScopedTrace> traceSensor(const char *func, std::string_view sensor_name) {
+    if (!ATRACE_ENABLED()) {
+        return std::nullopt;
+    }
+    return std::optional<::android::ScopedTrace>(
+            std::in_place, ATRACE_TAG,
+            StringPrintf("ThermalHelper::%s - %s", func, sensor_name.data()).c_str());
+}
+
 }  // namespace
 
+bool SensorGraph::build(const std::unordered_map<std::string, SensorInfo> &sensor_info_map,
+                        std::unordered_map<std::string, SensorStatus> *sensor_status_map) {
+    clear();
+    std::vector<std::string_view> names;
+    names.reserve(sensor_info_map.size());
+    for (const auto &[name, _] : sensor_info_map) {
+        names.emplace_back(name);
+    }
+    std::sort(names.begin(), names.end());
+
+    nodes_.reserve(names.size());
+    for (size_t id = 0; id < names.size(); id++) {
+        // Keys of the maps, so the views stay valid as long as the maps do
+        const auto &[name, sensor_info] = *sensor_info_map.find(std::string(names[id]));
+        auto status_it = sensor_status_map->find(name);
+        if (status_it == sensor_status_map->end()) {
+            LOG(ERROR) << "Sensor " << name << " has no status";
+            clear();
+            return false;
+        }
+        SensorNode &node = nodes_.emplace_back();
+        node.name = name;
+        node.info = &sensor_info;
+        node.status = &status_it->second;
+        ids_.emplace(name, id);
+    }
+
+    // Unknown sensors keep kInvalidSensorId and fail when read, as they did
+    // when looked up by name
+    const auto resolve = [this](std::string_view owner, std::string_view sensor) {
+        size_t id = find(sensor);
+        if (id == kInvalidSensorId) {
+            LOG(ERROR) << owner << " refers to unknown sensor " << sensor;
+        }
+        return id;
+    };
+    for (auto &node : nodes_) {
+        for (const auto &sensor : node.info->severity_reference) {
+            node.severity_reference_ids.push_back(resolve(node.name, sensor));
+        }
+        const auto *virtual_sensor_info = node.info->virtual_sensor_info.get();
+        if (virtual_sensor_info == nullptr) {
+            continue;
+        }
+        for (size_t i = 0; i < virtual_sensor_info->linked_sensors.size(); i++) {
+            node.linked_ids.push_back(
+                    virtual_sensor_info->linked_sensors_type[i] == SensorFusionType::SENSOR
+                            ? resolve(node.name, virtual_sensor_info->linked_sensors[i])
+                            : kInvalidSensorId);
+        }
+        // Model formulas may have more or fewer coefficients than types
+        const size_t coefficients_size = std::min(virtual_sensor_info->coefficients.size(),
+                                                  virtual_sensor_info->coefficients_type.size());
+        for (size_t i = 0; i < coefficients_size; i++) {
+            node.coefficient_ids.push_back(
+                    virtual_sensor_info->coefficients_type[i] == SensorFusionType::SENSOR
+                            ? resolve(node.name, virtual_sensor_info->coefficients[i])
+                            : kInvalidSensorId);
+        }
+        if (node.info->is_watch) {
+            for (const auto &sensor : virtual_sensor_info->trigger_sensors) {
+                const size_t trigger_id = resolve(node.name, sensor);
+                node.trigger_ids.push_back(trigger_id);
+                if (trigger_id != kInvalidSensorId) {
+                    nodes_[trigger_id].triggered_ids.push_back(
+                            static_cast<size_t>(&node - nodes_.data()));
+                }
+            }
+        }
+        if (!virtual_sensor_info->backup_sensor.empty()) {
+            node.backup_id = resolve(node.name, virtual_sensor_info->backup_sensor);
+        }
+    }
+
+    // Watch virtual sensors after their inputs, so that within a tick the
+    // inputs are read first and the virtual sensors reuse their readings
+    std::vector<uint8_t> marks(nodes_.size(), kUnmarked);
+    std::vector<size_t> order;
+    order.reserve(nodes_.size());
+    for (size_t id = 0; id < nodes_.size(); id++) {
+        if (!visit(id, &marks, &order)) {
+            clear();
+            return false;
+        }
+    }
+    watch_order_.assign(nodes_.size(), kInvalidSensorId);
+    for (const size_t id : order) {
+        if (nodes_[id].info->is_watch) {
+            watch_order_[id] = watched_ids_.size();
+            watched_ids_.push_back(id);
+        }
+    }
+    return true;
+}
+
+bool SensorGraph::visit(size_t id, std::vector<uint8_t> *marks,
+                        std::vector<size_t> *order) const {
+    if ((*marks)[id] == kVisited) {
+        return true;
+    }
+    if ((*marks)[id] == kVisiting) {
+        LOG(ERROR) << "Sensor " << nodes_[id].name << " depends on itself";
+        return false;
+    }
+    (*marks)[id] = kVisiting;
+    const SensorNode &node = nodes_[id];
+    for (const auto *ids : {&node.linked_ids, &node.coefficient_ids}) {
+        for (const size_t input_id : *ids) {
+            if (input_id != kInvalidSensorId && !visit(input_id, marks, order)) {
+                return false;
+            }
+        }
+    }
+    if (node.backup_id != kInvalidSensorId && !visit(node.backup_id, marks, order)) {
+        return false;
+    }
+    (*marks)[id] = kVisited;
+    order->push_back(id);
+    return true;
+}
+
+void SensorGraph::clear() {
+    nodes_.clear();
+    watched_ids_.clear();
+    watch_order_.clear();
+    ids_.clear();
+}
+
+size_t SensorGraph::find(std::string_view sensor_name) const {
+    auto it = ids_.find(sensor_name);
+    return it == ids_.end() ? kInvalidSensorId : it->second;
+}
+
 // dump additional traces for a given sensor
 void ThermalHelperImpl::dumpTraces(std::string_view sensor_name) {
     if (!(sensor_info_map_.count(sensor_name.data()) &&
@@ -260,6 +425,8 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
                 .count_threshold_counted = count_threshold_counted,
                 .pending_notification = false,
                 .override_status = {nullptr, false, false},
+                .polling_delay = sensor_info.polling_delay,
+                .polled_sample = {NAN, boot_clock::time_point::min()},
         };
 
         for (int i = 0; i < sensor_info.thermal_sample_count; i++) {
@@ -396,6 +563,14 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
         }
     }
 
+    if (!sensor_graph_.build(sensor_info_map_, &sensor_status_map_)) {
+        LOG(ERROR) << "Failed to build sensor graph";
+        ret = false;
+    }
+    uevent_flags_.assign(sensor_graph_.size(), 0);
+    tick_cache_.reset(sensor_graph_.size());
+    poll_scheduler_.reset(sensor_graph_.size());
+
     if (!power_hal_service_.connect()) {
         LOG(ERROR) << "Fail to connect to Power Hal";
     } else {
@@ -408,6 +583,7 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
             is_initialized_ = ret;
             return;
         } else {
+            sensor_graph_.clear();
             sensor_info_map_.clear();
             cooling_device_info_map_.clear();
             return;
@@ -494,6 +670,7 @@ bool ThermalHelperImpl::emulTemp(std::string_view target_sensor, const float tem
     sensor_status.override_status.pending_update = true;
 
     checkUpdateSensorForEmul(target_sensor.data(), max_throttling);
+    poll_all_pending_ = true;
 
     thermal_watcher_->wake();
     return true;
@@ -528,6 +705,7 @@ bool ThermalHelperImpl::emulSeverity(std::string_view target_sensor, const int s
     sensor_status.override_status.pending_update = true;
 
     checkUpdateSensorForEmul(target_sensor.data(), max_throttling);
+    poll_all_pending_ = true;
 
     thermal_watcher_->wake();
     return true;
@@ -552,6 +730,7 @@ bool ThermalHelperImpl::emulClear(std::string_view target_sensor) {
         LOG(ERROR) << "Cannot find target emul sensor: " << target_sensor.data();
         return false;
     }
+    poll_all_pending_ = true;
 
     thermal_watcher_->wake();
     return true;
@@ -579,12 +758,27 @@ bool ThermalHelperImpl::readCoolingDevice(std::string_view cooling_device,
 
 SensorReadStatus ThermalHelperImpl::readTemperature(std::string_view sensor_name, Temperature *out,
                                                     const bool force_no_cache) {
+    const size_t sensor_id = sensor_graph_.find(sensor_name);
+    if (sensor_id == kInvalidSensorId) {
+        LOG(ERROR) << "Failed to find thermal sensor " << sensor_name;
+        return SensorReadStatus::ERROR;
+    }
+    return readSensorTemperature(sensor_id, out, force_no_cache);
+}
+
+SensorReadStatus ThermalHelperImpl::readSensorTemperature(size_t sensor_id, Temperature *out,
+                                                          const bool force_no_cache,
+                                                          SensorTickCache *tick_cache) {
     // Return fail if the thermal sensor cannot be read.
     float temp = NAN;
     std::map<std::string, float> sensor_log_map;
-    auto &sensor_status = sensor_status_map_.at(sensor_name.data());
+    const SensorNode &node = sensor_graph_[sensor_id];
+    const std::string_view sensor_name = node.name;
+    const auto &sensor_info = *node.info;
+    auto &sensor_status = *node.status;
 
-    const auto ret = readThermalSensor(sensor_name, &temp, force_no_cache, &sensor_log_map);
+    const auto ret =
+            readThermalSensor(sensor_id, &temp, force_no_cache, &sensor_log_map, tick_cache);
     if (ret == SensorReadStatus::ERROR) {
         LOG(ERROR) << "Failed to read thermal sensor " << sensor_name.data();
         thermal_stats_helper_.reportThermalAbnormality(
@@ -594,15 +788,14 @@ SensorReadStatus ThermalHelperImpl::readTemperature(std::string_view sensor_name
 
     if (ret == SensorReadStatus::UNDER_COLLECTING) {
         LOG(INFO) << "Thermal sensor " << sensor_name.data() << " is under collecting";
-        const auto &sensor_info = sensor_info_map_.at(sensor_name.data());
         if (sensor_info.virtual_sensor_info == nullptr ||
             sensor_info.virtual_sensor_info->backup_sensor.empty()) {
             return SensorReadStatus::UNDER_COLLECTING;
         } else {
             LOG(INFO) << "Data under collecting, using backup sensor: "
                       << sensor_info.virtual_sensor_info->backup_sensor;
-            if (readThermalSensor(sensor_info.virtual_sensor_info->backup_sensor, &temp,
-                force_no_cache, &sensor_log_map) != SensorReadStatus::OKAY) {
+            if (readThermalSensor(node.backup_id, &temp, force_no_cache, &sensor_log_map,
+                                  tick_cache) != SensorReadStatus::OKAY) {
                 LOG(INFO) << "Failed to read backup thermal sensor: "
                            << sensor_info.virtual_sensor_info->backup_sensor;
                 return ret;
@@ -614,9 +807,8 @@ SensorReadStatus ThermalHelperImpl::readTemperature(std::string_view sensor_name
         LOG(INFO) << "Sensor " << sensor_name.data() << " temperature is nan.";
         return SensorReadStatus::ERROR;
     }
-    const auto severity_reference = getSeverityReference(sensor_name.data());
+    const auto severity_reference = getSeverityReference(sensor_id, tick_cache);
 
-    const auto &sensor_info = sensor_info_map_.at(sensor_name.data());
     out->type = sensor_info.type;
     out->name = sensor_name.data();
     out->value = TEMP_CONVERSION(temp, sensor_info);
@@ -1108,6 +1300,8 @@ void ThermalHelperImpl::initializeTrip(const std::unordered_map<std::string, std
             LOG(INFO) << "config Sensor: " << sensor_info.first
                       << " to default polling interval: " << kMinPollIntervalMs.count();
             setMinTimeout(&sensor_info.second);
+            sensor_status_map_.at(sensor_info.first).polling_delay =
+                    sensor_info.second.polling_delay;
         }
     }
 }
@@ -1181,19 +1375,18 @@ bool ThermalHelperImpl::fillCurrentCoolingDevices(
     return ret.size() > 0;
 }
 
-ThrottlingSeverity ThermalHelperImpl::getSeverityReference(std::string_view sensor_name) {
+ThrottlingSeverity ThermalHelperImpl::getSeverityReference(size_t sensor_id,
+                                                           SensorTickCache *tick_cache) {
     ThrottlingSeverity target_ref_severity = ThrottlingSeverity::NONE;
-    if (!sensor_info_map_.contains(sensor_name.data())) {
-        return target_ref_severity;
-    }
-    const auto &severity_ref_sensors = sensor_info_map_.at(sensor_name.data()).severity_reference;
+    const SensorNode &node = sensor_graph_[sensor_id];
 
-    for (size_t i = 0; i < severity_ref_sensors.size(); i++) {
+    for (const size_t ref_id : node.severity_reference_ids) {
         Temperature temp;
-        if (readTemperature(severity_ref_sensors[i], &temp, false) != SensorReadStatus::OKAY) {
+        if (ref_id == kInvalidSensorId ||
+            readSensorTemperature(ref_id, &temp, false, tick_cache) != SensorReadStatus::OKAY) {
             continue;
         }
-        LOG(VERBOSE) << sensor_name << "'s severity reference " << severity_ref_sensors[i]
+        LOG(VERBOSE) << node.name << "'s severity reference " << sensor_graph_[ref_id].name
                      << " reading:" << toString(temp.throttlingStatus);
 
         target_ref_severity = std::max(target_ref_severity, temp.throttlingStatus);
@@ -1202,13 +1395,15 @@ ThrottlingSeverity ThermalHelperImpl::getSeverityReference(std::string_view sens
     return target_ref_severity;
 }
 
-bool ThermalHelperImpl::readDataByType(std::string_view sensor_data, float *reading_value,
-                                       const SensorFusionType type, const bool force_no_cache,
-                                       std::map<std::string, float> *sensor_log_map) {
+bool ThermalHelperImpl::readDataByType(std::string_view sensor_data, size_t sensor_id,
+                                       float *reading_value, const SensorFusionType type,
+                                       const bool force_no_cache,
+                                       std::map<std::string, float> *sensor_log_map,
+                                       SensorTickCache *tick_cache) {
     switch (type) {
         case SensorFusionType::SENSOR:
-            if (readThermalSensor(sensor_data.data(), reading_value, force_no_cache,
-                                  sensor_log_map) == SensorReadStatus::ERROR) {
+            if (readThermalSensor(sensor_id, reading_value, force_no_cache, sensor_log_map,
+                                  tick_cache) == SensorReadStatus::ERROR) {
                 LOG(ERROR) << "Failed to get " << sensor_data.data() << " data";
                 return false;
             }
@@ -1239,22 +1434,19 @@ bool ThermalHelperImpl::readDataByType(std::string_view sensor_data, float *read
     return true;
 }
 
-bool ThermalHelperImpl::runVirtualTempEstimator(std::string_view sensor_name,
+bool ThermalHelperImpl::runVirtualTempEstimator(size_t sensor_id,
                                                 std::map<std::string, float> *sensor_log_map,
                                                 const bool force_no_cache,
-                                                std::vector<float> *outputs) {
+                                                std::vector<float> *outputs,
+                                                SensorTickCache *tick_cache) {
     std::vector<float> model_inputs;
     std::vector<float> model_outputs;
+    const SensorNode &node = sensor_graph_[sensor_id];
+    const std::string_view sensor_name = node.name;
 
     ATRACE_NAME(StringPrintf("ThermalHelper::runVirtualTempEstimator - %s", sensor_name.data())
                         .c_str());
-    if (!(sensor_info_map_.count(sensor_name.data()) &&
-          sensor_status_map_.count(sensor_name.data()))) {
-        LOG(ERROR) << sensor_name << " not part of sensor_info_map_ or sensor_status_map_";
-        return false;
-    }
-
-    const auto &sensor_info = sensor_info_map_.at(sensor_name.data());
+    const auto &sensor_info = *node.info;
     if (sensor_info.virtual_sensor_info == nullptr ||
         sensor_info.virtual_sensor_info->vt_estimator == nullptr) {
         LOG(ERROR) << "vt_estimator not valid for " << sensor_name;
@@ -1300,8 +1492,9 @@ bool ThermalHelperImpl::runVirtualTempEstimator(std::string_view sensor_name,
         }
         LOG(INFO) << "VT Estimator returned (ret: " << ret << ") for " << sensor_name
                   << ". Reading backup sensor [" << backup_sensor << "] data to use";
-        if (!readDataByType(backup_sensor, &backup_sensor_vt, SensorFusionType::SENSOR,
-                            force_no_cache, sensor_log_map)) {
+        if (!readDataByType(backup_sensor, node.backup_id, &backup_sensor_vt,
+                            SensorFusionType::SENSOR, force_no_cache, sensor_log_map,
+                            tick_cache)) {
             LOG(ERROR) << "Failed to read " << sensor_name.data() << "'s backup sensor "
                        << backup_sensor;
             return false;
@@ -1433,11 +1626,15 @@ bool ThermalHelperImpl::readTemperaturePredictions(std::string_view sensor_name,
 // return thermal rising trend per min
 float ThermalHelperImpl::getThermalRising(const SensorStatus &sensor_status,
                                           const ThermalSample &curr_sample) {
-    static constexpr int kMsecPerMin = 60000;
     if (sensor_status.thermal_history.size() == 0) {
         return NAN;
     }
-    const auto last_sample = sensor_status.thermal_history.front();
+    return getThermalRising(sensor_status.thermal_history.front(), curr_sample);
+}
+
+float ThermalHelperImpl::getThermalRising(const ThermalSample &last_sample,
+                                          const ThermalSample &curr_sample) const {
+    static constexpr int kMsecPerMin = 60000;
     if (std::isnan(last_sample.temp) || curr_sample.timestamp <= last_sample.timestamp) {
         return NAN;
     }
@@ -1449,21 +1646,83 @@ float ThermalHelperImpl::getThermalRising(const SensorStatus &sensor_status,
            kMsecPerMin;
 }
 
+bool ThermalHelperImpl::isSensorThrottling(const SensorNode &node) const {
+    if (node.status->severity != ThrottlingSeverity::NONE) {
+        return true;
+    }
+    for (const size_t trigger_id : node.trigger_ids) {
+        if (trigger_id != kInvalidSensorId &&
+            sensor_graph_[trigger_id].status->severity != ThrottlingSeverity::NONE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::chrono::milliseconds ThermalHelperImpl::getSleepInterval(const SensorNode &node) const {
+    return isSensorThrottling(node) ? node.info->passive_delay : node.status->polling_delay;
+}
+
+void ThermalHelperImpl::adaptPollingDelay(const SensorNode &node, float value,
+                                          boot_clock::time_point now) {
+    const SensorInfo &sensor_info = *node.info;
+    const AdaptivePollingInfo &adaptive_polling_info = *sensor_info.adaptive_polling_info;
+    SensorStatus &sensor_status = *node.status;
+    const ThermalSample curr_sample = {value, now};
+    const float dt_per_min = getThermalRising(sensor_status.polled_sample, curr_sample);
+
+    bool idle = !isSensorThrottling(node) && !std::isnan(dt_per_min) &&
+                std::fabs(dt_per_min) <= adaptive_polling_info.flat_slope;
+    for (size_t i = 0; idle && i < kThrottlingSeverityCount; i++) {
+        // NAN thresholds compare false and never block stretching
+        if (sensor_info.hot_thresholds[i] - value < adaptive_polling_info.threshold_margin ||
+            value - sensor_info.cold_thresholds[i] < adaptive_polling_info.threshold_margin) {
+            idle = false;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> _lock(sensor_status_map_mutex_);
+    sensor_status.polling_delay =
+            idle ? std::min(sensor_status.polling_delay * 2,
+                            adaptive_polling_info.max_polling_delay)
+                 : sensor_info.polling_delay;
+    sensor_status.polled_sample = curr_sample;
+}
+
 constexpr int kTranTimeoutParam = 2;
 
 SensorReadStatus ThermalHelperImpl::readThermalSensor(
-        std::string_view sensor_name, float *temp, const bool force_no_cache,
-        std::map<std::string, float> *sensor_log_map) {
-    std::string file_reading;
-    boot_clock::time_point now = boot_clock::now();
-    ATRACE_NAME(StringPrintf("ThermalHelper::readThermalSensor - %s", sensor_name.data()).c_str());
-    if (!(sensor_info_map_.count(sensor_name.data()) &&
-          sensor_status_map_.count(sensor_name.data()))) {
+        size_t sensor_id, float *temp, const bool force_no_cache,
+        std::map<std::string, float> *sensor_log_map, SensorTickCache *tick_cache) {
+    if (sensor_id == kInvalidSensorId) {
         return SensorReadStatus::ERROR;
     }
+    if (tick_cache == nullptr) {
+        return evaluateThermalSensor(sensor_id, temp, force_no_cache, sensor_log_map, nullptr);
+    }
 
-    const auto &sensor_info = sensor_info_map_.at(sensor_name.data());
-    auto &sensor_status = sensor_status_map_.at(sensor_name.data());
+    SensorReadStatus ret;
+    if (tick_cache->lookup(sensor_id, force_no_cache, temp, &ret)) {
+        if (ret == SensorReadStatus::OKAY) {
+            (*sensor_log_map)[sensor_graph_[sensor_id].name.data()] = *temp;
+        }
+        return ret;
+    }
+    ret = evaluateThermalSensor(sensor_id, temp, force_no_cache, sensor_log_map, tick_cache);
+    tick_cache->store(sensor_id, force_no_cache, *temp, ret);
+    return ret;
+}
+
+SensorReadStatus ThermalHelperImpl::evaluateThermalSensor(
+        size_t sensor_id, float *temp, const bool force_no_cache,
+        std::map<std::string, float> *sensor_log_map, SensorTickCache *tick_cache) {
+    boot_clock::time_point now = boot_clock::now();
+    const SensorNode &node = sensor_graph_[sensor_id];
+    const std::string_view sensor_name = node.name;
+    const auto trace = traceSensor("readThermalSensor", sensor_name);
+
+    const auto &sensor_info = *node.info;
+    auto &sensor_status = *node.status;
 
     {
         std::shared_lock<std::shared_mutex> _lock(sensor_status_map_mutex_);
@@ -1490,12 +1749,10 @@ SensorReadStatus ThermalHelperImpl::readThermalSensor(
 
     // Reading thermal sensor according to it's composition
     if (sensor_info.virtual_sensor_info == nullptr) {
-        if (!thermal_sensors_.readThermalFile(sensor_name.data(), &file_reading) ||
-            file_reading.empty()) {
+        if (!thermal_sensors_.readThermalValue(sensor_name, temp)) {
             LOG(ERROR) << "failed to read sensor: " << sensor_name;
             return SensorReadStatus::ERROR;
         }
-        *temp = std::atof(::android::base::Trim(file_reading).c_str());
     } else {
         const auto &linked_sensors_size = sensor_info.virtual_sensor_info->linked_sensors.size();
         std::vector<bool> count_threshold_counted(linked_sensors_size, false);
@@ -1504,9 +1761,9 @@ SensorReadStatus ThermalHelperImpl::readThermalSensor(
         // Calculate temperature of each of the linked sensor
         for (size_t i = 0; i < linked_sensors_size; i++) {
             if (!readDataByType(sensor_info.virtual_sensor_info->linked_sensors[i],
-                                &sensor_readings[i],
+                                node.linked_ids[i], &sensor_readings[i],
                                 sensor_info.virtual_sensor_info->linked_sensors_type[i],
-                                force_no_cache, sensor_log_map)) {
+                                force_no_cache, sensor_log_map, tick_cache)) {
                 LOG(ERROR) << "Failed to read " << sensor_name.data() << "'s linked sensor "
                            << sensor_info.virtual_sensor_info->linked_sensors[i];
                 return SensorReadStatus::ERROR;
@@ -1525,8 +1782,8 @@ SensorReadStatus ThermalHelperImpl::readThermalSensor(
         } else if ((sensor_info.virtual_sensor_info->formula == FormulaOption::USE_ML_MODEL) ||
                    (sensor_info.virtual_sensor_info->formula == FormulaOption::USE_LINEAR_MODEL)) {
             std::vector<float> vt_estimator_out;
-            if (!runVirtualTempEstimator(sensor_name, sensor_log_map, force_no_cache,
-                                         &vt_estimator_out)) {
+            if (!runVirtualTempEstimator(sensor_id, sensor_log_map, force_no_cache,
+                                         &vt_estimator_out, tick_cache)) {
                 LOG(ERROR) << "Failed running VirtualEstimator for " << sensor_name;
                 return SensorReadStatus::ERROR;
             }
@@ -1535,9 +1792,10 @@ SensorReadStatus ThermalHelperImpl::readThermalSensor(
             float temp_val = 0.0;
             for (size_t i = 0; i < linked_sensors_size; i++) {
                 float coefficient = NAN;
-                if (!readDataByType(sensor_info.virtual_sensor_info->coefficients[i], &coefficient,
+                if (!readDataByType(sensor_info.virtual_sensor_info->coefficients[i],
+                                    node.coefficient_ids[i], &coefficient,
                                     sensor_info.virtual_sensor_info->coefficients_type[i],
-                                    force_no_cache, sensor_log_map)) {
+                                    force_no_cache, sensor_log_map, tick_cache)) {
                     LOG(ERROR) << "Failed to read " << sensor_name.data() << "'s coefficient "
                                << sensor_info.virtual_sensor_info->coefficients[i];
                     return SensorReadStatus::ERROR;
@@ -1627,53 +1885,63 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
     std::vector<Temperature> temps;
     std::vector<std::string> cooling_devices_to_update;
     boot_clock::time_point now = boot_clock::now();
-    auto min_sleep_ms = std::chrono::milliseconds::max();
     bool power_data_is_updated = false;
     bool shutdown_severity_reached = false;
+    std::vector<size_t> notified_ids;
+    tick_cache_.nextTick();
 
+    // Resolve the uevent sensors once, the loop below only checks their flags
+    std::vector<size_t> uevent_ids;
     for (const auto &[sensor, temp] : uevent_sensor_map) {
+        const size_t sensor_id = sensor_graph_.find(sensor);
+        if (sensor_id == kInvalidSensorId) {
+            LOG(ERROR) << "Unknown uevent sensor " << sensor;
+            continue;
+        }
+        uevent_ids.push_back(sensor_id);
+        uevent_flags_[sensor_id] = std::isnan(temp) ? kUeventNoTemp : kUeventTemp;
         if (!std::isnan(temp)) {
             std::unique_lock<std::shared_mutex> _lock(sensor_status_map_mutex_);
-            sensor_status_map_[sensor].thermal_cached.temp = temp;
-            sensor_status_map_[sensor].thermal_cached.timestamp = now;
+            sensor_graph_[sensor_id].status->thermal_cached.temp = temp;
+            sensor_graph_[sensor_id].status->thermal_cached.timestamp = now;
         }
     }
 
+    // Check every watched sensor on uevents, emul overrides and the first
+    // tick, otherwise only the ones whose polling delay is up
+    bool poll_all = !uevent_sensor_map.empty();
+    {
+        std::lock_guard<std::shared_mutex> _lock(sensor_status_map_mutex_);
+        poll_all |= poll_all_pending_;
+        poll_all_pending_ = false;
+    }
+    if (poll_all) {
+        due_ids_ = sensor_graph_.watchedIds();
+    } else {
+        due_ids_.clear();
+        poll_scheduler_.popDue(now, &due_ids_);
+        std::sort(due_ids_.begin(), due_ids_.end(), [this](size_t left, size_t right) {
+            return sensor_graph_.watchOrder(left) < sensor_graph_.watchOrder(right);
+        });
+    }
+
     ATRACE_CALL();
-    // Go through all virtual and physical sensor and update if needed
-    for (auto &name_status_pair : sensor_status_map_) {
+    // Go through the due virtual and physical sensors in watch order and update if needed
+    for (const size_t sensor_id : due_ids_) {
         bool force_update = false;
         bool force_no_cache = false;
         Temperature temp;
-        SensorStatus &sensor_status = name_status_pair.second;
-        const SensorInfo &sensor_info = sensor_info_map_.at(name_status_pair.first);
+        const SensorNode &node = sensor_graph_[sensor_id];
+        const std::string_view sensor_name = node.name;
+        SensorStatus &sensor_status = *node.status;
+        const SensorInfo &sensor_info = *node.info;
         bool max_throttling = false;
+        bool severity_changed = false;
 
-        // Only handle the sensors in allow list
-        if (!sensor_info.is_watch) {
-            continue;
-        }
-
-        ATRACE_NAME(StringPrintf("ThermalHelper::thermalWatcherCallbackFunc - %s",
-                                 name_status_pair.first.data())
-                            .c_str());
+        const auto trace = traceSensor("thermalWatcherCallbackFunc", sensor_name);
 
         std::chrono::milliseconds time_elapsed_ms = std::chrono::milliseconds::zero();
-        auto sleep_ms = (sensor_status.severity != ThrottlingSeverity::NONE)
-                                ? sensor_info.passive_delay
-                                : sensor_info.polling_delay;
-
-        if (sensor_info.virtual_sensor_info != nullptr &&
-            !sensor_info.virtual_sensor_info->trigger_sensors.empty()) {
-            for (size_t i = 0; i < sensor_info.virtual_sensor_info->trigger_sensors.size(); i++) {
-                const auto &trigger_sensor_status =
-                        sensor_status_map_.at(sensor_info.virtual_sensor_info->trigger_sensors[i]);
-                if (trigger_sensor_status.severity != ThrottlingSeverity::NONE) {
-                    sleep_ms = sensor_info.passive_delay;
-                    break;
-                }
-            }
-        }
+        auto sleep_ms = getSleepInterval(node);
         // Force update if it's first time we update temperature value after device boot
         if (sensor_status.last_update_time == boot_clock::time_point::min()) {
             force_update = true;
@@ -1682,24 +1950,23 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
             // Handle other update event
             time_elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
                     now - sensor_status.last_update_time);
-            // Update triggered from genlink or uevent
-            if (uevent_sensor_map.size()) {
+            if (!poll_all) {
+                // Popped from poll_scheduler_, the polling delay is up
+                force_update = true;
+            } else if (uevent_sensor_map.size()) {
+                // Update triggered from genlink or uevent
                 // Checking virtual sensor
                 if (sensor_info.virtual_sensor_info != nullptr) {
-                    for (size_t i = 0; i < sensor_info.virtual_sensor_info->trigger_sensors.size();
-                         i++) {
-                        if (uevent_sensor_map.find(
-                                    sensor_info.virtual_sensor_info->trigger_sensors[i]) !=
-                            uevent_sensor_map.end()) {
+                    for (const size_t trigger_id : node.trigger_ids) {
+                        if (trigger_id != kInvalidSensorId && uevent_flags_[trigger_id]) {
                             force_update = true;
                             break;
                         }
                     }
-                } else if (uevent_sensor_map.find(name_status_pair.first) !=
-                           uevent_sensor_map.end()) {
+                } else if (uevent_flags_[sensor_id]) {
                     // Checking physical sensor
                     force_update = true;
-                    if (std::isnan(uevent_sensor_map.at(name_status_pair.first))) {
+                    if (uevent_flags_[sensor_id] == kUeventNoTemp) {
                         // Handle the case that uevent does not contain temperature
                         force_no_cache = true;
                     }
@@ -1717,18 +1984,16 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
                 sensor_status.override_status.pending_update = false;
             }
         }
-        LOG(VERBOSE) << "sensor " << name_status_pair.first
+        LOG(VERBOSE) << "sensor " << sensor_name
                      << ": time_elapsed=" << time_elapsed_ms.count()
                      << ", sleep_ms=" << sleep_ms.count() << ", force_update = " << force_update
                      << ", force_no_cache = " << force_no_cache;
 
         if (!force_update) {
-            auto timeout_remaining = sleep_ms - time_elapsed_ms;
-            if (min_sleep_ms > timeout_remaining) {
-                min_sleep_ms = timeout_remaining;
-            }
-            LOG(VERBOSE) << "sensor " << name_status_pair.first
-                         << ": timeout_remaining=" << timeout_remaining.count();
+            poll_scheduler_.schedule(sensor_id,
+                                     getDueTime(sensor_status.last_update_time, sleep_ms));
+            LOG(VERBOSE) << "sensor " << sensor_name
+                         << ": timeout_remaining=" << (sleep_ms - time_elapsed_ms).count();
             continue;
         }
 
@@ -1737,16 +2002,20 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
             power_data_is_updated = true;
         }
 
-        const auto ret = readTemperature(name_status_pair.first, &temp, force_no_cache);
+        const auto ret = readSensorTemperature(sensor_id, &temp, force_no_cache, &tick_cache_);
+        if (ret != SensorReadStatus::OKAY) {
+            // Retry after the polling delay instead of on every tick
+            poll_scheduler_.schedule(sensor_id, getDueTime(now, sleep_ms));
+        }
         if (ret == SensorReadStatus::ERROR) {
             LOG(ERROR) << __func__
-                       << ": error reading temperature for sensor: " << name_status_pair.first;
+                       << ": error reading temperature for sensor: " << sensor_name;
             continue;
         }
 
         if (ret == SensorReadStatus::UNDER_COLLECTING) {
             LOG(INFO) << __func__
-                      << ": data under collecting for sensor: " << name_status_pair.first;
+                      << ": data under collecting for sensor: " << sensor_name;
             continue;
         }
 
@@ -1754,14 +2023,16 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
             std::unique_lock<std::shared_mutex> _lock(sensor_status_map_mutex_);
             if (sensor_status.pending_notification) {
                 temps.push_back(temp);
+                notified_ids.push_back(sensor_id);
                 sleep_ms = (sensor_status.severity != ThrottlingSeverity::NONE)
                                    ? sensor_info.passive_delay
-                                   : sensor_info.polling_delay;
+                                   : sensor_status.polling_delay;
                 sensor_status.pending_notification = false;
+                severity_changed = true;
 
-                if (power_rail_switch_map_.contains(name_status_pair.first)) {
-                    const auto &target_rails = power_rail_switch_map_.at(name_status_pair.first);
-                    for (const auto &target_rail : target_rails) {
+                auto rails_it = power_rail_switch_map_.find(std::string(sensor_name));
+                if (rails_it != power_rail_switch_map_.end()) {
+                    for (const auto &target_rail : rails_it->second) {
                         power_files_.powerSamplingSwitch(
                                 target_rail, sensor_status.severity != ThrottlingSeverity::NONE);
                     }
@@ -1769,8 +2040,26 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
             }
         }
 
+        if (severity_changed) {
+            // The sensors it triggers switch between polling and passive delay
+            for (const size_t triggered_id : node.triggered_ids) {
+                const SensorStatus &triggered_status = *sensor_graph_[triggered_id].status;
+                if (triggered_status.last_update_time == boot_clock::time_point::min()) {
+                    continue;
+                }
+                const auto due = getDueTime(triggered_status.last_update_time,
+                                            getSleepInterval(sensor_graph_[triggered_id]));
+                poll_scheduler_.schedule(triggered_id, std::max(now, due));
+            }
+        }
+
+        if (sensor_info.adaptive_polling_info != nullptr) {
+            adaptPollingDelay(node, temp.value, now);
+            sleep_ms = getSleepInterval(node);
+        }
+
         if (sensor_status.severity == ThrottlingSeverity::NONE) {
-            thermal_throttling_.clearThrottlingData(name_status_pair.first);
+            thermal_throttling_.clearThrottlingData(sensor_name);
         } else {
             if (sensor_status.severity == ThrottlingSeverity::SHUTDOWN) {
                 shutdown_severity_reached = true;
@@ -1779,8 +2068,8 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
             std::vector<float> sensor_predictions;
             if (sensor_info.predictor_info != nullptr &&
                 sensor_info.predictor_info->support_pid_compensation) {
-                if (!readTemperaturePredictions(name_status_pair.first, &sensor_predictions)) {
-                    LOG(ERROR) << "Failed to read predictions of " << name_status_pair.first
+                if (!readTemperaturePredictions(sensor_name, &sensor_predictions)) {
+                    LOG(ERROR) << "Failed to read predictions of " << sensor_name
                                << " for throttling compensation";
                 }
             }
@@ -1794,7 +2083,7 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
                     sensor_status.thermal_history.pop();
                     sensor_status.thermal_history.push(curr_sample);
                 } else {
-                    LOG(ERROR) << "Sensor " << name_status_pair.first
+                    LOG(ERROR) << "Sensor " << sensor_name
                                << ": thermal_history size should not be zero";
                 }
             }
@@ -1807,26 +2096,26 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
         }
 
         thermal_throttling_.computeCoolingDevicesRequest(
-                name_status_pair.first, sensor_info, sensor_status.severity,
+                sensor_name, sensor_info, sensor_status.severity,
                 &cooling_devices_to_update, &thermal_stats_helper_);
-        if (min_sleep_ms > sleep_ms) {
-            min_sleep_ms = sleep_ms;
-        }
+        poll_scheduler_.schedule(sensor_id, getDueTime(now, sleep_ms));
 
-        LOG(VERBOSE) << "Sensor " << name_status_pair.first << ": sleep_ms=" << sleep_ms.count()
-                     << ", min_sleep_ms voting result=" << min_sleep_ms.count();
+        LOG(VERBOSE) << "Sensor " << sensor_name << ": sleep_ms=" << sleep_ms.count();
         sensor_status.last_update_time = now;
     }
 
-    if (!temps.empty()) {
-        for (const auto &t : temps) {
-            if (sensor_info_map_.at(t.name).send_cb && cb_) {
-                cb_(t);
-            }
+    for (const size_t sensor_id : uevent_ids) {
+        uevent_flags_[sensor_id] = 0;
+    }
 
-            if (sensor_info_map_.at(t.name).send_powerhint) {
-                power_hal_service_.sendPowerExtHint(t);
-            }
+    for (size_t i = 0; i < temps.size(); i++) {
+        const SensorInfo &sensor_info = *sensor_graph_[notified_ids[i]].info;
+        if (sensor_info.send_cb && cb_) {
+            cb_(temps[i]);
+        }
+
+        if (sensor_info.send_powerhint) {
+            power_hal_service_.sendPowerExtHint(temps[i]);
         }
     }
 
@@ -1848,6 +2137,16 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
         log_status_.prev_log_time = now;
     }
 
+    // Sleep until the next sensor is due, rounded up so the watcher does not
+    // wake a little early and find nothing to do
+    const auto next_due = poll_scheduler_.nextDue();
+    if (next_due == boot_clock::time_point::max()) {
+        return std::chrono::milliseconds::max();
+    }
+    const auto min_sleep_ms =
+            std::max(std::chrono::milliseconds::zero(),
+                     std::chrono::ceil<std::chrono::milliseconds>(next_due - now));
+    LOG(VERBOSE) << "min_sleep_ms voting result=" << min_sleep_ms.count();
     return min_sleep_ms;
 }
 
@@ -18,8 +18,12 @@
 
 #include <aidl/android/hardware/thermal/IThermal.h>
 
+#include <algorithm>
 #include <array>
 #include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
 #include <map>
 #include <mutex>
 #include <shared_mutex>
@@ -27,6 +31,7 @@
 #include <string_view>
 #include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "utils/power_files.h"
@@ -84,6 +89,161 @@ struct SensorStatus {
     std::queue<ThermalSample> thermal_history;
     bool pending_notification;
     OverrideStatus override_status;
+    // PollingDelay, stretched while AdaptivePolling finds the sensor idle
+    std::chrono::milliseconds polling_delay;
+    // Reading of the last update, for the AdaptivePolling slope
+    ThermalSample polled_sample;
+};
+
+constexpr size_t kInvalidSensorId = std::numeric_limits<size_t>::max();
+
+// Entry of SensorGraph. The sensors a virtual sensor depends on are resolved
+// to ids once, so the polling path never looks a sensor up by name.
+struct SensorNode {
+    std::string_view name;
+    const SensorInfo *info;
+    SensorStatus *status;
+    // Id of each linked sensor and coefficient of SENSOR type,
+    // kInvalidSensorId for the other fusion types
+    std::vector<size_t> linked_ids;
+    std::vector<size_t> coefficient_ids;
+    std::vector<size_t> trigger_ids;
+    // Watched virtual sensors which have this sensor in their trigger_ids
+    std::vector<size_t> triggered_ids;
+    std::vector<size_t> severity_reference_ids;
+    size_t backup_id = kInvalidSensorId;
+};
+
+// Dense, integer indexed view of the parsed sensor config. SensorInfo and
+// SensorStatus stay owned by their maps, whose entries do not move once the
+// graph is built, so the nodes point straight at them.
+class SensorGraph {
+  public:
+    // Ids follow the sorted sensor names. Return false if a sensor has no
+    // status entry, or if virtual sensors depend on each other in a cycle.
+    bool build(const std::unordered_map<std::string, SensorInfo> &sensor_info_map,
+               std::unordered_map<std::string, SensorStatus> *sensor_status_map);
+    void clear();
+    size_t find(std::string_view sensor_name) const;
+    size_t size() const { return nodes_.size(); }
+    const SensorNode &operator[](size_t id) const { return nodes_[id]; }
+    // Ids of the sensors in the watch list in topological order, each after
+    // the linked sensors, coefficients and backup sensor it is computed from
+    const std::vector<size_t> &watchedIds() const { return watched_ids_; }
+    // Position of id in watchedIds(), kInvalidSensorId if not watched
+    size_t watchOrder(size_t id) const { return watch_order_[id]; }
+
+  private:
+    // Append id to order after the sensors it is computed from, depth first.
+    // Return false on a cycle.
+    bool visit(size_t id, std::vector<uint8_t> *marks, std::vector<size_t> *order) const;
+
+    std::vector<SensorNode> nodes_;
+    std::vector<size_t> watched_ids_;
+    std::vector<size_t> watch_order_;
+    std::unordered_map<std::string_view, size_t> ids_;
+};
+
+// Readings taken during one watcher tick, indexed by sensor id. A sensor
+// linked by several virtual sensors is read and filtered once per tick, the
+// later reads reuse the result.
+class SensorTickCache {
+  public:
+    void reset(size_t size) {
+        entries_.assign(size, Entry());
+        tick_ = 0;
+    }
+    void nextTick() { tick_++; }
+    // A reading taken with the cache allowed does not serve a force_no_cache
+    // read, which has to reach the sensor
+    bool lookup(size_t sensor_id, const bool force_no_cache, float *temp,
+                SensorReadStatus *status) const {
+        const Entry &entry = entries_[sensor_id];
+        if (entry.tick != tick_ || (force_no_cache && !entry.no_cache)) {
+            return false;
+        }
+        *temp = entry.temp;
+        *status = entry.status;
+        return true;
+    }
+    void store(size_t sensor_id, const bool force_no_cache, float temp, SensorReadStatus status) {
+        entries_[sensor_id] = {tick_, force_no_cache, status, temp};
+    }
+
+  private:
+    struct Entry {
+        // Tick 0 is never current, nextTick() runs before the first lookup
+        uint64_t tick = 0;
+        bool no_cache = false;
+        SensorReadStatus status = SensorReadStatus::ERROR;
+        float temp = NAN;
+    };
+    std::vector<Entry> entries_;
+    uint64_t tick_ = 0;
+};
+
+// Next update time of each watched sensor, indexed by sensor id, so that a
+// watcher tick only visits the sensors that are due. The heap keeps the
+// entries replaced by a later schedule() until they surface, and skips them.
+class SensorPollScheduler {
+  public:
+    void reset(size_t size) {
+        due_.assign(size, boot_clock::time_point::max());
+        heap_.clear();
+    }
+    // Replace the due time of sensor_id, time_point::max() unschedules it
+    void schedule(size_t sensor_id, boot_clock::time_point due) {
+        if (due_[sensor_id] == due) {
+            return;
+        }
+        due_[sensor_id] = due;
+        if (due == boot_clock::time_point::max()) {
+            return;
+        }
+        if (heap_.size() >= 2 * due_.size() + kMinCompactSize) {
+            compact();
+        }
+        heap_.emplace_back(due, sensor_id);
+        std::push_heap(heap_.begin(), heap_.end(), std::greater<>());
+    }
+    // Unschedule the sensors due by now and append them to due_ids
+    void popDue(boot_clock::time_point now, std::vector<size_t> *due_ids) {
+        while (!heap_.empty() && heap_.front().first <= now) {
+            const auto [due, sensor_id] = heap_.front();
+            std::pop_heap(heap_.begin(), heap_.end(), std::greater<>());
+            heap_.pop_back();
+            if (due_[sensor_id] == due) {
+                due_[sensor_id] = boot_clock::time_point::max();
+                due_ids->push_back(sensor_id);
+            }
+        }
+    }
+    // Earliest due time, time_point::max() if no sensor is scheduled
+    boot_clock::time_point nextDue() {
+        while (!heap_.empty() && due_[heap_.front().second] != heap_.front().first) {
+            std::pop_heap(heap_.begin(), heap_.end(), std::greater<>());
+            heap_.pop_back();
+        }
+        return heap_.empty() ? boot_clock::time_point::max() : heap_.front().first;
+    }
+
+  private:
+    static constexpr size_t kMinCompactSize = 64;
+
+    // Drop the replaced entries, so sensors rescheduled far more often than
+    // they come due do not grow the heap
+    void compact() {
+        heap_.clear();
+        for (size_t sensor_id = 0; sensor_id < due_.size(); sensor_id++) {
+            if (due_[sensor_id] != boot_clock::time_point::max()) {
+                heap_.emplace_back(due_[sensor_id], sensor_id);
+            }
+        }
+        std::make_heap(heap_.begin(), heap_.end(), std::greater<>());
+    }
+
+    std::vector<boot_clock::time_point> due_;
+    std::vector<std::pair<boot_clock::time_point, size_t>> heap_;
 };
 
 class ThermalHelper {
@@ -226,26 +386,45 @@ class ThermalHelperImpl : public ThermalHelper {
             const ThrottlingArray &hot_hysteresis, const ThrottlingArray &cold_hysteresis,
             ThrottlingSeverity prev_hot_severity, ThrottlingSeverity prev_cold_severity,
             float value) const;
-    // Read sensor data according to the type
-    bool readDataByType(std::string_view sensor_data, float *reading_value,
+    // Read sensor data according to the type, sensor_id is used for SENSOR type.
+    // tick_cache is only passed on the watcher thread, other callers read
+    // the sensors directly.
+    bool readDataByType(std::string_view sensor_data, size_t sensor_id, float *reading_value,
                         const SensorFusionType type, const bool force_no_cache,
-                        std::map<std::string, float> *sensor_log_map);
-    SensorReadStatus readThermalSensor(std::string_view sensor_name, float *temp,
-                                       const bool force_sysfs,
-                                       std::map<std::string, float> *sensor_log_map);
-    bool runVirtualTempEstimator(std::string_view sensor_name,
-                                 std::map<std::string, float> *sensor_log_map,
-                                 const bool force_no_cache, std::vector<float> *outputs);
+                        std::map<std::string, float> *sensor_log_map,
+                        SensorTickCache *tick_cache);
+    SensorReadStatus readSensorTemperature(size_t sensor_id, Temperature *out,
+                                           const bool force_no_cache,
+                                           SensorTickCache *tick_cache = nullptr);
+    SensorReadStatus readThermalSensor(size_t sensor_id, float *temp, const bool force_sysfs,
+                                       std::map<std::string, float> *sensor_log_map,
+                                       SensorTickCache *tick_cache);
+    SensorReadStatus evaluateThermalSensor(size_t sensor_id, float *temp,
+                                           const bool force_no_cache,
+                                           std::map<std::string, float> *sensor_log_map,
+                                           SensorTickCache *tick_cache);
+    bool runVirtualTempEstimator(size_t sensor_id, std::map<std::string, float> *sensor_log_map,
+                                 const bool force_no_cache, std::vector<float> *outputs,
+                                 SensorTickCache *tick_cache);
     size_t getPredictionMaxWindowMs(std::string_view sensor_name);
     float readPredictionAfterTimeMs(std::string_view sensor_name, const size_t time_ms);
     bool readTemperaturePredictions(std::string_view sensor_name, std::vector<float> *predictions);
     float getThermalRising(const SensorStatus &sensor_status, const ThermalSample &curr_sample);
+    float getThermalRising(const ThermalSample &last_sample,
+                           const ThermalSample &curr_sample) const;
+    // True while the sensor or one of its trigger sensors throttles
+    bool isSensorThrottling(const SensorNode &node) const;
+    // Passive delay while the sensor throttles, its polling delay otherwise
+    std::chrono::milliseconds getSleepInterval(const SensorNode &node) const;
+    // Stretch or reset the polling delay of an AdaptivePolling sensor after
+    // an update read value at now
+    void adaptPollingDelay(const SensorNode &node, float value, boot_clock::time_point now);
     void updateCoolingDevices(const std::vector<std::string> &cooling_devices_to_update);
     // Check the max throttling for binded cooling device
     void maxCoolingRequestCheck(
             std::unordered_map<std::string, BindedCdevInfo> *binded_cdev_info_map);
     void checkUpdateSensorForEmul(std::string_view target_sensor, const bool max_throttling);
-    ThrottlingSeverity getSeverityReference(std::string_view sensor_name);
+    ThrottlingSeverity getSeverityReference(size_t sensor_id, SensorTickCache *tick_cache);
 
     sp<ThermalWatcher> thermal_watcher_;
     LogStatus log_status_;
@@ -266,6 +445,19 @@ class ThermalHelperImpl : public ThermalHelper {
     ThermalPredictionsHelper thermal_predictions_helper_;
     mutable std::shared_mutex sensor_status_map_mutex_;
     std::unordered_map<std::string, SensorStatus> sensor_status_map_;
+    // Built once both maps above are final
+    SensorGraph sensor_graph_;
+    // Sensors of the current uevent, only used on the watcher thread
+    std::vector<uint8_t> uevent_flags_;
+    // Readings of the current tick, only used on the watcher thread
+    SensorTickCache tick_cache_;
+    // Next update of each watched sensor, only used on the watcher thread
+    SensorPollScheduler poll_scheduler_;
+    // Sensors visited by the current tick, only used on the watcher thread
+    std::vector<size_t> due_ids_;
+    // Guarded by sensor_status_map_mutex_. Set until the first tick and by
+    // the emul overrides, the next tick then checks every watched sensor.
+    bool poll_all_pending_ = true;
 };
 
 }  // namespace implementation
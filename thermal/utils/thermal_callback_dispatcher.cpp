@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG (ATRACE_TAG_THERMAL | ATRACE_TAG_HAL)
+
+#include "thermal_callback_dispatcher.h"
+
+#include <android-base/logging.h>
+#include <pthread.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+bool interfacesEqual(const std::shared_ptr<::ndk::ICInterface> left,
+                     const std::shared_ptr<::ndk::ICInterface> right) {
+    if (left == nullptr || right == nullptr || !left->isRemote() || !right->isRemote()) {
+        return left == right;
+    }
+    return left->asBinder() == right->asBinder();
+}
+
+ThermalCallbackDispatcher::ThermalCallbackDispatcher(size_t workers, size_t queue_depth)
+    : queue_depth_(std::max<size_t>(queue_depth, 1)) {
+    workers = std::max<size_t>(workers, 1);
+    workers_.reserve(workers);
+    for (size_t i = 0; i < workers; i++) {
+        workers_.emplace_back([this] { work(); });
+    }
+}
+
+ThermalCallbackDispatcher::~ThermalCallbackDispatcher() {
+    {
+        std::lock_guard<std::mutex> _lock(mutex_);
+        stopped_ = true;
+    }
+    cv_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+bool ThermalCallbackDispatcher::addClient(const CallbackSetting &setting) {
+    std::lock_guard<std::mutex> _lock(mutex_);
+    if (std::any_of(clients_.begin(), clients_.end(), [&](const auto &client) {
+            return interfacesEqual(client->setting.callback, setting.callback);
+        })) {
+        return false;
+    }
+    clients_.emplace_back(std::make_shared<Client>(setting));
+    LOG(INFO) << "a callback has been registered to ThermalHAL, isFilter: "
+              << setting.is_filter_type << " Type: " << toString(setting.type);
+    return true;
+}
+
+bool ThermalCallbackDispatcher::removeClient(
+        const std::shared_ptr<IThermalChangedCallback> &callback) {
+    std::lock_guard<std::mutex> _lock(mutex_);
+    auto it = std::find_if(clients_.begin(), clients_.end(), [&](const auto &client) {
+        return interfacesEqual(client->setting.callback, callback);
+    });
+    if (it == clients_.end()) {
+        return false;
+    }
+    LOG(INFO) << "a callback has been unregistered to ThermalHAL, isFilter: "
+              << (*it)->setting.is_filter_type << " Type: " << toString((*it)->setting.type);
+    // A worker may still hold the client, it stops delivering once removed
+    (*it)->removed = true;
+    (*it)->queue.clear();
+    clients_.erase(it);
+    return true;
+}
+
+void ThermalCallbackDispatcher::enqueueLocked(const std::shared_ptr<Client> &client,
+                                              const Temperature &t,
+                                              boot_clock::time_point now) {
+    if (client->setting.is_filter_type && t.type != client->setting.type) {
+        return;
+    }
+    auto it = std::find_if(client->queue.begin(), client->queue.end(),
+                           [&](const Notification &n) { return n.temperature.name == t.name; });
+    if (it != client->queue.end()) {
+        // Keep the queued time, the latency counts from the first change not
+        // yet delivered
+        it->temperature = t;
+        client->coalesced++;
+        return;
+    }
+    if (client->queue.size() >= queue_depth_) {
+        LOG(WARNING) << "Thermal callback queue full, dropped notification of "
+                     << client->queue.front().temperature.name;
+        client->queue.pop_front();
+        client->dropped++;
+    }
+    client->queue.push_back({t, now});
+    client->max_queue_depth = std::max(client->max_queue_depth, client->queue.size());
+    if (!client->scheduled) {
+        client->scheduled = true;
+        ready_.push_back(client);
+        cv_.notify_one();
+    }
+}
+
+void ThermalCallbackDispatcher::send(const Temperature &t) {
+    ATRACE_CALL();
+    LOG(VERBOSE) << "Sending notification: "
+                 << " Type: " << toString(t.type) << " Name: " << t.name
+                 << " CurrentValue: " << t.value
+                 << " ThrottlingStatus: " << toString(t.throttlingStatus);
+    const auto now = boot_clock::now();
+    std::lock_guard<std::mutex> _lock(mutex_);
+    for (const auto &client : clients_) {
+        enqueueLocked(client, t, now);
+    }
+}
+
+void ThermalCallbackDispatcher::sendTo(const std::shared_ptr<IThermalChangedCallback> &callback,
+                                       const std::vector<Temperature> &temperatures) {
+    const auto now = boot_clock::now();
+    std::lock_guard<std::mutex> _lock(mutex_);
+    auto it = std::find_if(clients_.begin(), clients_.end(), [&](const auto &client) {
+        return interfacesEqual(client->setting.callback, callback);
+    });
+    if (it == clients_.end()) {
+        return;
+    }
+    for (const auto &t : temperatures) {
+        LOG(INFO) << "Sending notification: "
+                  << " Type: " << toString(t.type) << " Name: " << t.name
+                  << " CurrentValue: " << t.value
+                  << " ThrottlingStatus: " << toString(t.throttlingStatus);
+        enqueueLocked(*it, t, now);
+    }
+}
+
+void ThermalCallbackDispatcher::work() {
+    pthread_setname_np(pthread_self(), "ThermalCallback");
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return stopped_ || !ready_.empty(); });
+        if (stopped_) {
+            return;
+        }
+        std::shared_ptr<Client> client = std::move(ready_.front());
+        ready_.pop_front();
+        if (client->removed || client->queue.empty()) {
+            client->scheduled = false;
+            continue;
+        }
+        const Notification notification = std::move(client->queue.front());
+        client->queue.pop_front();
+
+        lock.unlock();
+        const ::ndk::ScopedAStatus ret =
+                client->setting.callback->notifyThrottling(notification.temperature);
+        const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                boot_clock::now() - notification.queued_time);
+        lock.lock();
+
+        if (!ret.isOk()) {
+            LOG(ERROR) << "a Thermal callback is dead, removed from callback list.";
+            client->removed = true;
+            client->queue.clear();
+            clients_.erase(std::remove(clients_.begin(), clients_.end(), client), clients_.end());
+        } else {
+            client->delivered++;
+            client->total_latency += latency;
+            client->max_latency = std::max(client->max_latency, latency);
+        }
+        // Back of the line, so a client with a long queue does not starve
+        // the others
+        if (!client->removed && !client->queue.empty()) {
+            ready_.push_back(std::move(client));
+        } else {
+            client->scheduled = false;
+        }
+    }
+}
+
+size_t ThermalCallbackDispatcher::getNumClients() const {
+    std::lock_guard<std::mutex> _lock(mutex_);
+    return clients_.size();
+}
+
+void ThermalCallbackDispatcher::dump(std::ostringstream *dump_buf) const {
+    std::lock_guard<std::mutex> _lock(mutex_);
+    *dump_buf << "getCallbacks:" << std::endl;
+    *dump_buf << " Total: " << clients_.size() << " Workers: " << workers_.size()
+              << " QueueLimit: " << queue_depth_ << std::endl;
+    for (const auto &client : clients_) {
+        const auto avg_latency_us =
+                client->delivered ? client->total_latency.count() / client->delivered : 0;
+        *dump_buf << " IsFilter: " << client->setting.is_filter_type
+                  << " Type: " << toString(client->setting.type)
+                  << " QueueDepth: " << client->queue.size()
+                  << " MaxQueueDepth: " << client->max_queue_depth
+                  << " Delivered: " << client->delivered << " Coalesced: " << client->coalesced
+                  << " Dropped: " << client->dropped << " AvgLatencyUs: " << avg_latency_us
+                  << " MaxLatencyUs: " << client->max_latency.count() << std::endl;
+    }
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
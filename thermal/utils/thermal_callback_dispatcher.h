@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <aidl/android/hardware/thermal/IThermal.h>
+#include <android-base/chrono_utils.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+using ::android::base::boot_clock;
+
+struct CallbackSetting {
+    CallbackSetting(std::shared_ptr<IThermalChangedCallback> callback, bool is_filter_type,
+                    TemperatureType type)
+        : callback(std::move(callback)), is_filter_type(is_filter_type), type(type) {}
+    std::shared_ptr<IThermalChangedCallback> callback;
+    bool is_filter_type;
+    TemperatureType type;
+};
+
+// Return true if both interfaces are the same local object or proxy the same
+// remote binder.
+bool interfacesEqual(const std::shared_ptr<::ndk::ICInterface> left,
+                     const std::shared_ptr<::ndk::ICInterface> right);
+
+// Delivers throttling notifications to the registered IThermalChangedCallback
+// clients from a pool of worker threads, so a slow or hung client never holds
+// up the thermal watcher or the other clients. Each client has a bounded
+// queue. A notification of a sensor already queued for the client replaces
+// the queued one, so a client that falls behind only gets the latest
+// Temperature of each sensor. Clients whose notifyThrottling fails are
+// removed.
+class ThermalCallbackDispatcher {
+  public:
+    static constexpr size_t kDefaultWorkers = 2;
+    static constexpr size_t kDefaultQueueDepth = 32;
+
+    explicit ThermalCallbackDispatcher(size_t workers = kDefaultWorkers,
+                                       size_t queue_depth = kDefaultQueueDepth);
+    ~ThermalCallbackDispatcher();
+
+    // Disallow copy and assign.
+    ThermalCallbackDispatcher(const ThermalCallbackDispatcher &) = delete;
+    void operator=(const ThermalCallbackDispatcher &) = delete;
+
+    // Return false if the callback is already registered.
+    bool addClient(const CallbackSetting &setting);
+    // Return false if the callback was not registered.
+    bool removeClient(const std::shared_ptr<IThermalChangedCallback> &callback);
+    // Queue t for every client interested in its type, never blocks on a client.
+    void send(const Temperature &t);
+    // Queue temperatures for one client, dropped if it is no longer registered.
+    void sendTo(const std::shared_ptr<IThermalChangedCallback> &callback,
+                const std::vector<Temperature> &temperatures);
+    size_t getNumClients() const;
+    void dump(std::ostringstream *dump_buf) const;
+
+  private:
+    struct Notification {
+        Temperature temperature;
+        boot_clock::time_point queued_time;
+    };
+
+    struct Client {
+        explicit Client(const CallbackSetting &setting) : setting(setting) {}
+        const CallbackSetting setting;
+        std::deque<Notification> queue;
+        // On ready_ or being delivered to by a worker, so that one client is
+        // never called from two workers at once
+        bool scheduled = false;
+        bool removed = false;
+        size_t max_queue_depth = 0;
+        uint64_t delivered = 0;
+        uint64_t coalesced = 0;
+        uint64_t dropped = 0;
+        std::chrono::microseconds total_latency{0};
+        std::chrono::microseconds max_latency{0};
+    };
+
+    // Queue t for client, with mutex_ held.
+    void enqueueLocked(const std::shared_ptr<Client> &client, const Temperature &t,
+                       boot_clock::time_point now);
+    void work();
+
+    const size_t queue_depth_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::shared_ptr<Client>> clients_;
+    // Clients with queued notifications, served round robin one
+    // notification at a time
+    std::deque<std::shared_ptr<Client>> ready_;
+    bool stopped_ = false;
+    std::vector<std::thread> workers_;
+};
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -23,8 +23,12 @@
 #include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <utils/Trace.h>
 
+#include <cstdlib>
+#include <optional>
 #include <string_view>
 
 namespace aidl {
@@ -36,48 +40,90 @@ namespace implementation {
 using ::android::base::StringPrintf;
 
 constexpr std::string_view kDefaultFileValue("0");
+// Sensor and cooling device files hold a single number
+constexpr size_t kMaxReadSize = 64;
+
+namespace {
+
+// Thermal files are read on every poll, only format the trace name when
+// tracing is on
+std::optional<::android::ScopedTrace> traceThermalFile(const char *op,
+                                                       std::string_view thermal_name) {
+    if (!ATRACE_ENABLED()) {
+        return std::nullopt;
+    }
+    return std::optional<::android::ScopedTrace>(
+            std::in_place, ATRACE_TAG,
+            StringPrintf("ThermalFiles::%s - %s", op, thermal_name.data()).c_str());
+}
+
+}  // namespace
 
 PathInfo ThermalFiles::getThermalFilePath(std::string_view thermal_name) const {
-    auto sensor_itr = thermal_name_to_path_map_.find(thermal_name.data());
+    auto sensor_itr = thermal_name_to_path_map_.find(thermal_name);
     if (sensor_itr == thermal_name_to_path_map_.end()) {
         return PathInfo();
     }
-    return sensor_itr->second;
+    return sensor_itr->second.path_info;
 }
 
 bool ThermalFiles::addThermalFile(std::string_view thermal_name, std::string_view path,
                                   TempPathType temp_path_type) {
-    return thermal_name_to_path_map_
-            .emplace(thermal_name,
-                     PathInfo{
-                             .path = std::string(path),
-                             .temp_path_type = temp_path_type,
-                     })
-            .second;
+    auto [file_itr, inserted] = thermal_name_to_path_map_.try_emplace(std::string(thermal_name));
+    if (inserted) {
+        file_itr->second.path_info = {
+                .path = std::string(path),
+                .temp_path_type = temp_path_type,
+        };
+    }
+    return inserted;
+}
+
+ssize_t ThermalFiles::readSysfsFile(const ThermalFile &file, char *buf, size_t size) const {
+    std::lock_guard<std::mutex> _lock(file.fd_lock);
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (file.fd.get() < 0) {
+            file.fd.reset(TEMP_FAILURE_RETRY(
+                    open(file.path_info.path.c_str(), O_RDONLY | O_CLOEXEC)));
+            if (file.fd.get() < 0) {
+                return -1;
+            }
+        }
+        const ssize_t len = TEMP_FAILURE_RETRY(pread(file.fd.get(), buf, size - 1, 0));
+        if (len >= 0) {
+            buf[len] = '\0';
+            return len;
+        }
+        file.fd.reset();
+    }
+    return -1;
 }
 
 bool ThermalFiles::readThermalFile(std::string_view thermal_name, std::string *data) const {
     std::string sensor_reading;
-    const auto path_info = getThermalFilePath(thermal_name);
     *data = "";
 
-    ATRACE_NAME(StringPrintf("ThermalFiles::readThermalFile - %s", thermal_name.data()).c_str());
-    if (path_info.path.empty()) {
+    const auto trace = traceThermalFile("readThermalFile", thermal_name);
+    auto file_itr = thermal_name_to_path_map_.find(thermal_name);
+    if (file_itr == thermal_name_to_path_map_.end() || file_itr->second.path_info.path.empty()) {
         PLOG(WARNING) << "Failed to find " << thermal_name << "'s path";
         return false;
     }
+    const auto &path_info = file_itr->second.path_info;
 
     if (path_info.temp_path_type == TempPathType::SYSFS) {
-        if (!::android::base::ReadFileToString(path_info.path, &sensor_reading)) {
+        char buf[kMaxReadSize];
+        const ssize_t len = readSysfsFile(file_itr->second, buf, sizeof(buf));
+        if (len < 0) {
             PLOG(WARNING) << "Failed to read sensor: " << thermal_name;
             return false;
         }
 
-        if (sensor_reading.size() <= 1) {
-            LOG(ERROR) << thermal_name << "'s return size:" << sensor_reading.size()
-                       << " is invalid";
+        if (len <= 1) {
+            LOG(ERROR) << thermal_name << "'s return size:" << len << " is invalid";
             return false;
         }
+        sensor_reading.assign(buf, len);
     } else if (path_info.temp_path_type == TempPathType::DEVICE_PROPERTY) {
         sensor_reading = ::android::base::GetProperty(path_info.path, kDefaultFileValue.data());
     } else {
@@ -92,11 +138,49 @@ bool ThermalFiles::readThermalFile(std::string_view thermal_name, std::string *d
     return true;
 }
 
+bool ThermalFiles::readThermalValue(std::string_view thermal_name, float *value) const {
+    const auto trace = traceThermalFile("readThermalValue", thermal_name);
+    auto file_itr = thermal_name_to_path_map_.find(thermal_name);
+    if (file_itr == thermal_name_to_path_map_.end() || file_itr->second.path_info.path.empty()) {
+        PLOG(WARNING) << "Failed to find " << thermal_name << "'s path";
+        return false;
+    }
+
+    if (file_itr->second.path_info.temp_path_type != TempPathType::SYSFS) {
+        std::string data;
+        if (!readThermalFile(thermal_name, &data) || data.empty()) {
+            return false;
+        }
+        *value = std::atof(data.c_str());
+        return true;
+    }
+
+    char buf[kMaxReadSize];
+    const ssize_t len = readSysfsFile(file_itr->second, buf, sizeof(buf));
+    if (len < 0) {
+        PLOG(WARNING) << "Failed to read sensor: " << thermal_name;
+        return false;
+    }
+    if (len <= 1) {
+        LOG(ERROR) << thermal_name << "'s return size:" << len << " is invalid";
+        return false;
+    }
+
+    char *end = nullptr;
+    *value = std::strtof(buf, &end);
+    if (end == buf) {
+        LOG(ERROR) << thermal_name << "'s reading:" << ::android::base::Trim(buf)
+                   << " is invalid";
+        return false;
+    }
+    return true;
+}
+
 bool ThermalFiles::writeCdevFile(std::string_view cdev_name, std::string_view data) {
     const auto path_info =
             getThermalFilePath(::android::base::StringPrintf("%s_%s", cdev_name.data(), "w"));
 
-    ATRACE_NAME(StringPrintf("ThermalFiles::writeCdevFile - %s", cdev_name.data()).c_str());
+    const auto trace = traceThermalFile("writeCdevFile", cdev_name);
     if (!::android::base::WriteStringToFile(data.data(), path_info.path)) {
         PLOG(WARNING) << "Failed to write cdev: " << cdev_name << " to " << data.data();
         return false;
@@ -16,7 +16,13 @@
 
 #pragma once
 
+#include <android-base/unique_fd.h>
+#include <sys/types.h>
+
+#include <mutex>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 #include "thermal_info.h"
@@ -47,11 +53,36 @@ class ThermalFiles {
     // data to empty and return false. If the thermal_name is found and its content
     // is read, this function will fill in data accordingly then return true.
     bool readThermalFile(std::string_view thermal_name, std::string *data) const;
+    // Read the content of thermal_name as a number, without allocating for
+    // SYSFS files. Return false if it cannot be read or holds no number.
+    bool readThermalValue(std::string_view thermal_name, float *value) const;
     bool writeCdevFile(std::string_view thermal_name, std::string_view data);
     size_t getNumThermalFiles() const { return thermal_name_to_path_map_.size(); }
 
   private:
-    std::unordered_map<std::string, PathInfo> thermal_name_to_path_map_;
+    struct ThermalFile {
+        PathInfo path_info;
+        // SYSFS files are opened on the first read and kept open, every read
+        // is a pread from offset 0. fd is guarded by fd_lock.
+        mutable std::mutex fd_lock;
+        mutable ::android::base::unique_fd fd;
+    };
+
+    // Lets the map be searched by string_view without building a std::string
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+
+    // Read up to size - 1 bytes of a SYSFS file into buf and NUL terminate
+    // it. Reopen the file once if the kept fd fails, as when the thermal
+    // zone was removed and added back. Return the length read, -1 on error.
+    ssize_t readSysfsFile(const ThermalFile &file, char *buf, size_t size) const;
+
+    std::unordered_map<std::string, ThermalFile, NameHash, std::equal_to<>>
+            thermal_name_to_path_map_;
 };
 
 }  // namespace implementation
@@ -733,6 +733,50 @@ bool ParsePredictorInfo(const std::string_view name, const Json::Value &sensor,
     return true;
 }
 
+bool ParseAdaptivePollingInfo(const std::string_view name, const Json::Value &sensor,
+                              const std::chrono::milliseconds polling_delay,
+                              std::unique_ptr<AdaptivePollingInfo> *adaptive_polling_info) {
+    Json::Value adaptive_polling = sensor["AdaptivePolling"];
+    if (adaptive_polling.empty()) {
+        return true;
+    }
+    LOG(INFO) << "Start to parse Sensor[" << name << "]'s AdaptivePolling";
+
+    if (adaptive_polling["MaxPollingDelay"].empty()) {
+        LOG(ERROR) << "Sensor[" << name << "]'s AdaptivePolling has no MaxPollingDelay";
+        return false;
+    }
+    const std::chrono::milliseconds max_polling_delay(
+            getIntFromValue(adaptive_polling["MaxPollingDelay"]));
+    if (polling_delay == std::chrono::milliseconds::max() ||
+        max_polling_delay <= polling_delay) {
+        LOG(ERROR) << "Sensor[" << name << "]'s AdaptivePolling MaxPollingDelay "
+                   << max_polling_delay.count() << " should be larger than PollingDelay "
+                   << polling_delay.count();
+        return false;
+    }
+
+    const float flat_slope = adaptive_polling["FlatSlope"].empty()
+                                     ? NAN
+                                     : getFloatFromValue(adaptive_polling["FlatSlope"]);
+    const float threshold_margin =
+            adaptive_polling["ThresholdMargin"].empty()
+                    ? NAN
+                    : getFloatFromValue(adaptive_polling["ThresholdMargin"]);
+    if (!(flat_slope >= 0) || !(threshold_margin >= 0)) {
+        LOG(ERROR) << "Sensor[" << name
+                   << "]'s AdaptivePolling needs non-negative FlatSlope and ThresholdMargin";
+        return false;
+    }
+
+    LOG(INFO) << "Sensor[" << name << "]'s AdaptivePolling: MaxPollingDelay "
+              << max_polling_delay.count() << " FlatSlope " << flat_slope << " ThresholdMargin "
+              << threshold_margin;
+    adaptive_polling_info->reset(
+            new AdaptivePollingInfo{max_polling_delay, flat_slope, threshold_margin});
+    return true;
+}
+
 bool ParseBindedCdevInfo(
         const Json::Value &values,
         std::unordered_map<std::string, BindedCdevInfo> *binded_cdev_info_map,
@@ -1217,6 +1261,61 @@ bool ParseSensorThrottlingInfo(
     return true;
 }
 
+// Depth first walk over the sensors a virtual sensor is computed from, return
+// false if the walk comes back to a sensor still on the path.
+bool CheckVirtualSensorInputs(const std::string &name,
+                              const std::unordered_map<std::string, SensorInfo> &sensors_parsed,
+                              std::unordered_map<std::string, bool> *visited,
+                              std::vector<std::string> *path) {
+    const auto visited_it = visited->find(name);
+    if (visited_it != visited->end()) {
+        if (visited_it->second) {
+            return true;
+        }
+        std::string cycle;
+        for (auto it = std::find(path->begin(), path->end(), name); it != path->end(); ++it) {
+            cycle += *it + " -> ";
+        }
+        LOG(ERROR) << "Sensor[" << name << "] depends on itself: " << cycle << name;
+        return false;
+    }
+    const auto sensor_it = sensors_parsed.find(name);
+    if (sensor_it == sensors_parsed.end() || sensor_it->second.virtual_sensor_info == nullptr) {
+        (*visited)[name] = true;
+        return true;
+    }
+
+    // false while name is on the path
+    (*visited)[name] = false;
+    path->push_back(name);
+    const auto &virtual_sensor_info = *sensor_it->second.virtual_sensor_info;
+    for (size_t i = 0; i < virtual_sensor_info.linked_sensors.size(); ++i) {
+        if (virtual_sensor_info.linked_sensors_type[i] == SensorFusionType::SENSOR &&
+            !CheckVirtualSensorInputs(virtual_sensor_info.linked_sensors[i], sensors_parsed,
+                                      visited, path)) {
+            return false;
+        }
+    }
+    // Model formulas may have more or fewer coefficients than types
+    const size_t coefficients_size = std::min(virtual_sensor_info.coefficients.size(),
+                                              virtual_sensor_info.coefficients_type.size());
+    for (size_t i = 0; i < coefficients_size; ++i) {
+        if (virtual_sensor_info.coefficients_type[i] == SensorFusionType::SENSOR &&
+            !CheckVirtualSensorInputs(virtual_sensor_info.coefficients[i], sensors_parsed,
+                                      visited, path)) {
+            return false;
+        }
+    }
+    if (!virtual_sensor_info.backup_sensor.empty() &&
+        !CheckVirtualSensorInputs(virtual_sensor_info.backup_sensor, sensors_parsed, visited,
+                                  path)) {
+        return false;
+    }
+    path->pop_back();
+    (*visited)[name] = true;
+    return true;
+}
+
 bool ParseSensorInfo(const Json::Value &config,
                      std::unordered_map<std::string, SensorInfo> *sensors_parsed,
                      const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map_) {
@@ -1599,6 +1698,13 @@ bool ParseSensorInfo(const Json::Value &config,
             return false;
         }
 
+        std::unique_ptr<AdaptivePollingInfo> adaptive_polling_info;
+        if (!ParseAdaptivePollingInfo(name, sensors[i], polling_delay, &adaptive_polling_info)) {
+            LOG(ERROR) << "Sensor[" << name << "]: failed to parse adaptive polling info";
+            sensors_parsed->clear();
+            return false;
+        }
+
         bool support_throttling = false;  // support pid or hard limit
         std::shared_ptr<ThrottlingInfo> throttling_info;
         if (!ParseSensorThrottlingInfo(name, sensors[i], &support_throttling, &throttling_info,
@@ -1642,10 +1748,22 @@ bool ParseSensorInfo(const Json::Value &config,
                 .throttling_info = std::move(throttling_info),
                 .predictor_info = std::move(predictor_info),
                 .thermal_sample_count = thermal_sample_count,
+                .adaptive_polling_info = std::move(adaptive_polling_info),
         };
 
         ++total_parsed;
     }
+
+    // Virtual sensors are evaluated after their inputs, which needs the
+    // inputs to form a DAG
+    std::unordered_map<std::string, bool> visited;
+    std::vector<std::string> path;
+    for (const auto &[name, sensor_info] : *sensors_parsed) {
+        if (!CheckVirtualSensorInputs(name, *sensors_parsed, &visited, &path)) {
+            sensors_parsed->clear();
+            return false;
+        }
+    }
     LOG(INFO) << total_parsed << " Sensors parsed successfully";
     return true;
 }
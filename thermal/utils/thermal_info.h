@@ -165,6 +165,15 @@ struct PredictorInfo {
     int prediction_duration;         // Prediction duration for a PREDICTED sensor
 };
 
+// Stretch the polling delay of an idle sensor: while its temperature stays
+// flat and far from every threshold, each poll doubles the delay up to
+// max_polling_delay. Any other reading falls back to PollingDelay.
+struct AdaptivePollingInfo {
+    std::chrono::milliseconds max_polling_delay;
+    float flat_slope;        // Max temperature change per minute considered flat
+    float threshold_margin;  // Min distance to the hot and cold thresholds
+};
+
 struct VirtualPowerRailInfo {
     std::vector<std::string> linked_power_rails;
     std::vector<float> coefficients;
@@ -256,6 +265,7 @@ struct SensorInfo {
     std::shared_ptr<ThrottlingInfo> throttling_info;
     std::unique_ptr<PredictorInfo> predictor_info;
     int thermal_sample_count;
+    std::unique_ptr<AdaptivePollingInfo> adaptive_polling_info;
 };
 
 struct CdevInfo {